@@ -0,0 +1,83 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 10:12:40
+ * @FilePath: \xn_esp32_audio\components\xn_audio_bench\include\audio_bench.h
+ * @Description: 音频管线基准/浸泡测试 - 用已知信号驱动缓冲区、DSP 内核与播放管线，输出机器可读报告
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "audio_manager.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 报告中内核条目数上限 */
+#define AUDIO_BENCH_MAX_KERNELS     12
+
+/** 基准配置 */
+typedef struct {
+    uint32_t kernel_frames;                     ///< 每个内核的迭代帧数（每帧 AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES 个采样）
+    uint32_t soak_seconds;                      ///< 管线浸泡时长（秒，0 跳过管线测试）
+    uint32_t tone_hz;                           ///< 浸泡期间播放的正弦测试音频率
+    const audio_mgr_config_t *pipeline_config;  ///< 管线配置（NULL 跳过管线测试；由基准初始化并反初始化）
+} audio_bench_config_t;
+
+#define AUDIO_BENCH_DEFAULT_CONFIG()                                 \
+    (audio_bench_config_t){                                          \
+        .kernel_frames = 2000,                                       \
+        .soak_seconds = 60,                                          \
+        .tone_hz = 1000,                                             \
+        .pipeline_config = NULL,                                     \
+    }
+
+/** 单个内核的耗时 */
+typedef struct {
+    const char *name;                           ///< 内核名称
+    uint32_t frames;                            ///< 迭代帧数
+    uint32_t cycles_avg;                        ///< 每帧平均 CPU 周期
+    uint32_t cycles_max;                        ///< 每帧最大 CPU 周期（含中断干扰）
+} audio_bench_kernel_t;
+
+/** 基准报告 */
+typedef struct {
+    audio_bench_kernel_t kernels[AUDIO_BENCH_MAX_KERNELS]; ///< 内核耗时
+    size_t kernel_count;                        ///< 有效内核条目数
+    bool pipeline_ran;                          ///< 是否完成管线浸泡
+    uint32_t soak_seconds;                      ///< 实际浸泡时长（秒）
+    int cpu_load[2];                            ///< 浸泡期间各核负载（%，-1 表示未启用 FreeRTOS 运行时统计）
+    size_t internal_min_free;                   ///< 内部 RAM 历史最低空闲（字节）
+    size_t internal_total;                      ///< 内部 RAM 总量（字节）
+    size_t psram_min_free;                      ///< PSRAM 历史最低空闲（字节）
+    size_t psram_total;                         ///< PSRAM 总量（字节）
+    uint32_t tone_rejected;                     ///< 测试音写入被拒绝的次数（背压）
+    audio_mgr_stats_t pipeline;                 ///< 播放/回采缓冲区统计（溢出、欠载、高水位）
+    audio_mgr_latency_stats_t latency;          ///< 管线延迟与每帧 feed/fetch 耗时
+} audio_bench_report_t;
+
+/**
+ * @brief 运行基准：先测内核，再按配置初始化管线浸泡
+ * @param config 配置参数
+ * @param report 输出报告
+ * @return ESP_OK 成功；ESP_ERR_NO_MEM 测试缓冲区分配失败；管线初始化失败时返回对应错误（内核结果仍有效）
+ * @note 在调用任务中运行，内核测试期间独占当前核；浸泡结束后反初始化音频管理器
+ */
+esp_err_t audio_bench_run(const audio_bench_config_t *config, audio_bench_report_t *report);
+
+/**
+ * @brief 以单行 JSON 打印报告（前缀 "AUDIO_BENCH:"，便于脚本从串口日志提取）
+ * @param report 基准报告
+ */
+void audio_bench_print_json(const audio_bench_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
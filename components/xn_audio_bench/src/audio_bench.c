@@ -0,0 +1,417 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 10:12:40
+ * @FilePath: \xn_esp32_audio\components\xn_audio_bench\src\audio_bench.c
+ * @Description: 音频管线基准/浸泡测试实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_bench.h"
+#include "ring_buffer.h"
+#include "audio_dsp.h"
+#include "audio_arena.h"
+#include "audio_resampler.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_idf_version.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "AUDIO_BENCH";
+
+#define BENCH_FRAME         AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES  ///< 每帧采样点数
+#define BENCH_MAX_IN_FRAMES (BENCH_FRAME * 3)                     ///< 重采样输入帧数上限（48kHz -> 16kHz）
+#define BENCH_RING_SAMPLES  (BENCH_FRAME * 8)                     ///< 缓冲区测试容量
+#define BENCH_SOAK_CHUNK    256                                   ///< 浸泡期间每次写入的测试音采样数
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#define BENCH_IDLE_TASK(core)   xTaskGetIdleTaskHandleForCore(core)
+#else
+#define BENCH_IDLE_TASK(core)   xTaskGetIdleTaskHandleForCPU(core)
+#endif
+
+/** 测试缓冲区（内部 RAM，避免 PSRAM 缓存未命中干扰内核耗时） */
+typedef struct {
+    int16_t *pcm;                   ///< 单声道测试信号（BENCH_FRAME）
+    int16_t *stereo;                ///< 立体声测试信号（BENCH_MAX_IN_FRAMES * 2）
+    int32_t *pcm32;                 ///< 32 位双声道 I2S 数据（BENCH_FRAME * 2）
+    int16_t *out;                   ///< 输出（BENCH_FRAME * 2）
+    int32_t *acc;                   ///< 混音累加（BENCH_FRAME）
+} bench_buffers_t;
+
+/** 单个内核的计时累加 */
+typedef struct {
+    uint64_t total;
+    uint32_t max;
+    uint32_t frames;
+} bench_timer_t;
+
+static inline void bench_timer_add(bench_timer_t *t, uint32_t start)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    t->total += cycles;
+    if (cycles > t->max) {
+        t->max = cycles;
+    }
+    t->frames++;
+}
+
+static void bench_report_kernel(audio_bench_report_t *report, const char *name, const bench_timer_t *t)
+{
+    if (report->kernel_count >= AUDIO_BENCH_MAX_KERNELS || t->frames == 0) {
+        return;
+    }
+    audio_bench_kernel_t *k = &report->kernels[report->kernel_count++];
+    k->name = name;
+    k->frames = t->frames;
+    k->cycles_avg = (uint32_t)(t->total / t->frames);
+    k->cycles_max = t->max;
+    ESP_LOGI(TAG, "%-18s avg %6u  max %6u cycles/frame", name, (unsigned)k->cycles_avg, (unsigned)k->cycles_max);
+}
+
+/**
+ * @brief 生成已知测试信号：单声道正弦、左右声道不同频率的立体声、32 位 I2S 数据
+ */
+static void bench_fill_signals(bench_buffers_t *buf, uint32_t tone_hz)
+{
+    const float w = 2.0f * (float)M_PI * (float)tone_hz / 16000.0f;
+    for (size_t i = 0; i < BENCH_FRAME; i++) {
+        buf->pcm[i] = (int16_t)(12000.0f * sinf(w * (float)i));
+        buf->pcm32[i * 2] = (int32_t)buf->pcm[i] << 16;
+        buf->pcm32[i * 2 + 1] = -((int32_t)buf->pcm[i] << 16);
+    }
+    const float w48 = 2.0f * (float)M_PI * (float)tone_hz / 48000.0f;
+    for (size_t i = 0; i < BENCH_MAX_IN_FRAMES; i++) {
+        buf->stereo[i * 2] = (int16_t)(12000.0f * sinf(w48 * (float)i));
+        buf->stereo[i * 2 + 1] = (int16_t)(8000.0f * sinf(w48 * 3.0f * (float)i));
+    }
+}
+
+/**
+ * @brief 缓冲区内核：拷贝写读（无锁/互斥锁）与零拷贝写读
+ */
+static void bench_ring(const audio_bench_config_t *config, bench_buffers_t *buf, audio_bench_report_t *report)
+{
+    static const struct {
+        const char *name;
+        bool lock_free;
+        bool zero_copy;
+    } cases[] = {
+        { "ring_copy_lockfree", true, false },
+        { "ring_copy_mutex", false, false },
+        { "ring_zero_copy", true, true },
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        ring_buffer_config_t cfg = RING_BUFFER_DEFAULT_CONFIG(BENCH_RING_SAMPLES);
+        cfg.lock_free = cases[c].lock_free;
+        ring_buffer_handle_t rb = ring_buffer_create_with_config(&cfg);
+        if (!rb) {
+            ESP_LOGW(TAG, "%s: 缓冲区创建失败", cases[c].name);
+            continue;
+        }
+
+        bench_timer_t t = {0};
+        for (uint32_t i = 0; i < config->kernel_frames; i++) {
+            uint32_t start = esp_cpu_get_cycle_count();
+            if (cases[c].zero_copy) {
+                ring_buffer_span_t span;
+                if (ring_buffer_acquire_write(rb, BENCH_FRAME, &span) == ESP_OK) {
+                    memcpy(span.data[0], buf->pcm, span.len[0] * sizeof(int16_t));
+                    if (span.len[1] > 0) {
+                        memcpy(span.data[1], buf->pcm + span.len[0], span.len[1] * sizeof(int16_t));
+                    }
+                    ring_buffer_commit_write(rb, BENCH_FRAME);
+                }
+                if (ring_buffer_peek_read(rb, BENCH_FRAME, &span, 0) == ESP_OK) {
+                    ring_buffer_release_read(rb, span.total);
+                }
+            } else {
+                ring_buffer_write(rb, buf->pcm, BENCH_FRAME);
+                ring_buffer_read(rb, buf->out, BENCH_FRAME, 0);
+            }
+            bench_timer_add(&t, start);
+        }
+        bench_report_kernel(report, cases[c].name, &t);
+        ring_buffer_destroy(rb);
+    }
+}
+
+/**
+ * @brief DSP 内核：I2S 位宽转换/解交织、扬声器立体声展开、混音、重采样
+ */
+static void bench_dsp(const audio_bench_config_t *config, bench_buffers_t *buf, audio_bench_report_t *report)
+{
+    static const int32_t gains[2] = { AUDIO_DSP_Q15_UNITY, AUDIO_DSP_Q15_UNITY / 2 };
+    bench_timer_t t_s32 = {0}, t_deint = {0}, t_stereo = {0}, t_mix = {0};
+
+    for (uint32_t i = 0; i < config->kernel_frames; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        audio_dsp_s32_to_s16_sat(buf->pcm32, buf->out, BENCH_FRAME, 16);
+        bench_timer_add(&t_s32, start);
+
+        start = esp_cpu_get_cycle_count();
+        audio_dsp_s32_deinterleave_s16(buf->pcm32, buf->out, BENCH_FRAME, 2, BENCH_FRAME, 14, gains);
+        bench_timer_add(&t_deint, start);
+
+        start = esp_cpu_get_cycle_count();
+        audio_dsp_mono_to_stereo_q15(buf->pcm, buf->out, BENCH_FRAME, AUDIO_DSP_Q15_UNITY * 3 / 4);
+        bench_timer_add(&t_stereo, start);
+
+        start = esp_cpu_get_cycle_count();
+        memset(buf->acc, 0, BENCH_FRAME * sizeof(int32_t));
+        audio_dsp_mix_ramp_q15(buf->pcm, buf->acc, BENCH_FRAME, AUDIO_DSP_Q15_UNITY, AUDIO_DSP_Q15_UNITY / 4);
+        audio_dsp_mix_ramp_q15(buf->pcm, buf->acc, BENCH_FRAME, AUDIO_DSP_Q15_UNITY, AUDIO_DSP_Q15_UNITY);
+        audio_dsp_s32_to_s16_sat(buf->acc, buf->out, BENCH_FRAME, 0);
+        bench_timer_add(&t_mix, start);
+    }
+    bench_report_kernel(report, "i2s_s32_to_s16", &t_s32);
+    bench_report_kernel(report, "i2s_deinterleave2", &t_deint);
+    bench_report_kernel(report, "spk_mono_to_stereo", &t_stereo);
+    bench_report_kernel(report, "mix_2_streams", &t_mix);
+
+    // 重采样：每帧输出 BENCH_FRAME 个 16kHz 采样
+    static const struct {
+        const char *name;
+        uint32_t rate;
+    } rates[] = {
+        { "resample_48k_st", 48000 },
+        { "resample_44k1_st", 44100 },
+    };
+    audio_resampler_config_t rs_cfg = AUDIO_RESAMPLER_DEFAULT_CONFIG(16000);
+    audio_resampler_handle_t rs = audio_resampler_create(&rs_cfg);
+    if (!rs) {
+        ESP_LOGW(TAG, "重采样器创建失败");
+        return;
+    }
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        if (audio_resampler_set_input(rs, rates[r].rate, 2) != ESP_OK) {
+            continue;
+        }
+        size_t in_frames = (size_t)((uint64_t)BENCH_FRAME * rates[r].rate / 16000);
+        bench_timer_t t = {0};
+        for (uint32_t i = 0; i < config->kernel_frames; i++) {
+            uint32_t start = esp_cpu_get_cycle_count();
+            audio_resampler_process(rs, buf->stereo, in_frames, NULL, buf->out, BENCH_FRAME * 2);
+            bench_timer_add(&t, start);
+        }
+        bench_report_kernel(report, rates[r].name, &t);
+    }
+    audio_resampler_destroy(rs);
+}
+
+/**
+ * @brief 读取各核空闲任务累计运行时间（FreeRTOS 运行时统计）
+ * @return true 运行时统计可用
+ */
+static bool bench_idle_runtime(uint32_t idle[2], uint32_t *total)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+    UBaseType_t count = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *tasks = heap_caps_malloc(count * sizeof(TaskStatus_t), MALLOC_CAP_DEFAULT);
+    if (!tasks) {
+        return false;
+    }
+    count = uxTaskGetSystemState(tasks, count, total);
+    idle[0] = idle[1] = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+            if (tasks[i].xHandle == BENCH_IDLE_TASK(core)) {
+                idle[core] = tasks[i].ulRunTimeCounter;
+            }
+        }
+    }
+    heap_caps_free(tasks);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 管线浸泡：初始化音频管理器，按实时速率持续播放测试音，结束后收集统计
+ *
+ * 麦克风侧由实际硬件驱动（AFE 同时处理扬声器测试音的回声），
+ * 播放侧以已知正弦驱动播放缓冲区 -> I2S TX -> 回采对齐整条路径。
+ */
+static esp_err_t bench_pipeline(const audio_bench_config_t *config, audio_bench_report_t *report)
+{
+    esp_err_t ret = audio_manager_init(config->pipeline_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "音频管理器初始化失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    audio_manager_set_trace_enabled(true);
+    audio_manager_reset_latency_stats();
+    audio_manager_start();
+    audio_manager_start_playback();
+
+    uint32_t idle0[2] = {0}, idle1[2] = {0};
+    uint32_t total0 = 0, total1 = 0;
+    bool have_runtime = bench_idle_runtime(idle0, &total0);
+
+    ESP_LOGI(TAG, "管线浸泡 %u 秒（%u Hz 测试音）", (unsigned)config->soak_seconds, (unsigned)config->tone_hz);
+    const float w = 2.0f * (float)M_PI * (float)config->tone_hz / 16000.0f;
+    const int64_t end_us = esp_timer_get_time() + (int64_t)config->soak_seconds * 1000000;
+    int16_t chunk[BENCH_SOAK_CHUNK];
+    uint32_t phase = 0;
+
+    while (esp_timer_get_time() < end_us) {
+        // 按缓冲区空间写入，保持播放缓冲区内约数帧数据，由 I2S 时钟决定实际速率
+        if (audio_manager_get_playback_free_space() < BENCH_SOAK_CHUNK) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+        for (size_t i = 0; i < BENCH_SOAK_CHUNK; i++, phase++) {
+            chunk[i] = (int16_t)(8000.0f * sinf(w * (float)(phase % 16000)));
+        }
+        if (audio_manager_play_audio(chunk, BENCH_SOAK_CHUNK) != ESP_OK) {
+            report->tone_rejected++;
+        }
+        if (audio_manager_get_playback_free_space() < BENCH_FRAME * 4) {
+            vTaskDelay(pdMS_TO_TICKS(BENCH_SOAK_CHUNK * 1000 / 16000));
+        }
+    }
+
+    if (have_runtime && bench_idle_runtime(idle1, &total1) && total1 > total0) {
+        for (int core = 0; core < 2; core++) {
+            uint32_t busy = 100 - (uint32_t)((uint64_t)(idle1[core] - idle0[core]) * 100 / (total1 - total0));
+            report->cpu_load[core] = core < portNUM_PROCESSORS ? (int)busy : -1;
+        }
+    }
+
+    audio_manager_get_stats(&report->pipeline);
+    audio_manager_get_latency_stats(&report->latency);
+    // 满负载运行后的栈高水位最能反映真实余量
+    audio_manager_dump_task_report();
+    report->soak_seconds = config->soak_seconds;
+    report->pipeline_ran = true;
+
+    audio_manager_stop_playback();
+    audio_manager_stop();
+    audio_manager_deinit();
+    return ESP_OK;
+}
+
+/**
+ * @brief 运行基准
+ *
+ * 内核测试使用内部 RAM 中的固定测试信号，逐帧用 CPU 周期计数器计时；
+ * 内存高水位取自 heap_caps 的历史最低空闲量，涵盖浸泡期间管线的全部分配。
+ */
+esp_err_t audio_bench_run(const audio_bench_config_t *config, audio_bench_report_t *report)
+{
+    if (!config || !report) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(report, 0, sizeof(*report));
+    report->cpu_load[0] = report->cpu_load[1] = -1;
+
+    bench_buffers_t buf = {
+        .pcm = heap_caps_malloc(BENCH_FRAME * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+        .stereo = heap_caps_malloc(BENCH_MAX_IN_FRAMES * 2 * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+        // 与内存区分配一致按 16 字节对齐，使 ESP32-S3 的 PIE 向量路径参与计时
+        .pcm32 = heap_caps_aligned_alloc(AUDIO_ARENA_ALIGN, BENCH_FRAME * 2 * sizeof(int32_t), MALLOC_CAP_INTERNAL),
+        .out = heap_caps_aligned_alloc(AUDIO_ARENA_ALIGN, BENCH_FRAME * 2 * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+        .acc = heap_caps_aligned_alloc(AUDIO_ARENA_ALIGN, BENCH_FRAME * sizeof(int32_t), MALLOC_CAP_INTERNAL),
+    };
+    esp_err_t ret = ESP_OK;
+    if (!buf.pcm || !buf.stereo || !buf.pcm32 || !buf.out || !buf.acc) {
+        ESP_LOGE(TAG, "测试缓冲区分配失败");
+        ret = ESP_ERR_NO_MEM;
+        goto done;
+    }
+
+    bench_fill_signals(&buf, config->tone_hz);
+
+    ESP_LOGI(TAG, "内核基准：%u 帧 x %u 采样", (unsigned)config->kernel_frames, (unsigned)BENCH_FRAME);
+    bench_ring(config, &buf, report);
+    bench_dsp(config, &buf, report);
+
+    if (config->pipeline_config && config->soak_seconds > 0) {
+        ret = bench_pipeline(config, report);
+    }
+
+done:
+    report->internal_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    report->internal_total = heap_caps_get_total_size(MALLOC_CAP_INTERNAL);
+    report->psram_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+    report->psram_total = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+
+    heap_caps_free(buf.pcm);
+    heap_caps_free(buf.stereo);
+    heap_caps_free(buf.pcm32);
+    heap_caps_free(buf.out);
+    heap_caps_free(buf.acc);
+    return ret;
+}
+
+static void bench_print_latency(const char *name, const audio_mgr_latency_t *lat, bool last)
+{
+    printf("\"%s\":{\"count\":%u,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u}%s",
+           name, (unsigned)lat->count, (unsigned)lat->p50_us, (unsigned)lat->p99_us, (unsigned)lat->max_us,
+           last ? "" : ",");
+}
+
+static void bench_print_buffer(const char *name, const audio_mgr_buffer_stats_t *b, bool last)
+{
+    printf("\"%s\":{\"overrun\":%u,\"rejected\":%u,\"underrun_reads\":%u,\"lock_timeouts\":%u,"
+           "\"high_water\":%u,\"capacity\":%u}%s",
+           name, (unsigned)b->overrun_samples, (unsigned)b->rejected_samples, (unsigned)b->underrun_reads,
+           (unsigned)b->lock_timeouts, (unsigned)b->high_water, (unsigned)b->capacity, last ? "" : ",");
+}
+
+/**
+ * @brief 打印单行 JSON 报告
+ *
+ * 键名稳定，版本间可直接比较；整行一次输出，不被其他任务日志打断。
+ */
+void audio_bench_print_json(const audio_bench_report_t *report)
+{
+    if (!report) {
+        return;
+    }
+
+    flockfile(stdout);
+    printf("AUDIO_BENCH:{\"frame_samples\":%u,\"cpu_mhz\":%u,\"kernels\":{",
+           (unsigned)BENCH_FRAME, (unsigned)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    for (size_t i = 0; i < report->kernel_count; i++) {
+        const audio_bench_kernel_t *k = &report->kernels[i];
+        printf("\"%s\":{\"frames\":%u,\"cycles_avg\":%u,\"cycles_max\":%u}%s",
+               k->name, (unsigned)k->frames, (unsigned)k->cycles_avg, (unsigned)k->cycles_max,
+               i + 1 < report->kernel_count ? "," : "");
+    }
+    printf("},\"memory\":{\"internal_min_free\":%u,\"internal_total\":%u,\"psram_min_free\":%u,\"psram_total\":%u}",
+           (unsigned)report->internal_min_free, (unsigned)report->internal_total,
+           (unsigned)report->psram_min_free, (unsigned)report->psram_total);
+
+    if (report->pipeline_ran) {
+        printf(",\"pipeline\":{\"soak_seconds\":%u,\"cpu_load\":[%d,%d],\"tone_rejected\":%u,",
+               (unsigned)report->soak_seconds, report->cpu_load[0], report->cpu_load[1],
+               (unsigned)report->tone_rejected);
+        bench_print_buffer("playback", &report->pipeline.playback, false);
+        bench_print_buffer("reference", &report->pipeline.reference, false);
+        printf("\"aec\":{\"ref_offset_us\":%d,\"padded\":%u,\"dropped\":%u},",
+               (int)report->pipeline.aec.ref_offset_us, (unsigned)report->pipeline.aec.padded_samples,
+               (unsigned)report->pipeline.aec.dropped_samples);
+        printf("\"latency\":{");
+        bench_print_latency("mic_to_callback", &report->latency.mic_to_callback, false);
+        bench_print_latency("play_to_speaker", &report->latency.play_to_speaker, false);
+        bench_print_latency("event_dispatch", &report->latency.event_dispatch, false);
+        bench_print_latency("feed_cpu", &report->latency.feed_cpu, false);
+        bench_print_latency("fetch_cpu", &report->latency.fetch_cpu, true);
+        printf("}}");
+    }
+    printf("}\n");
+    fflush(stdout);
+    funlockfile(stdout);
+}
@@ -0,0 +1,130 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-05 15:40:26
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-05 15:40:26
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\aec_reference.h
+ * @Description: AEC 回采对齐 - 在 I2S TX 边界采集回采并标注播出时间，按麦克风采集时间取出对齐的回采
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "ring_buffer.h"
+#include "audio_arena.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 回采对齐句柄 */
+typedef struct aec_reference_s *aec_reference_handle_t;
+
+/** 回采对齐配置 */
+typedef struct {
+    size_t buffer_samples;          ///< 回采缓冲区大小（采样点数）
+    uint32_t sample_rate;           ///< 采样率（扬声器与麦克风须一致）
+    size_t tx_queue_samples;        ///< I2S TX DMA 队列深度（写入返回到播出的延迟）
+    int lead_ms;                    ///< 回采相对回声的提前量（毫秒），保证回声落在 AEC 滤波器窗口内
+    bool auto_delay;                ///< 是否按麦克风/回采包络互相关自动修正残余延迟
+    audio_arena_handle_t arena;     ///< 内存区（可选，NULL 使用堆分配）
+} aec_reference_config_t;
+
+#define AEC_REFERENCE_DEFAULT_CONFIG(samples)                       \
+    (aec_reference_config_t){                                        \
+        .buffer_samples = (samples),                                 \
+        .sample_rate = 16000,                                        \
+        .tx_queue_samples = 0,                                       \
+        .lead_ms = 2,                                                \
+        .auto_delay = true,                                          \
+        .arena = NULL,                                               \
+    }
+
+/** 一帧对齐后的回采：lead 个静音 + span + 剩余静音 */
+typedef struct {
+    size_t lead;                    ///< 帧首补静音的采样数（对应回采尚未播出）
+    ring_buffer_span_t span;        ///< 可直接读取的回采区间
+} aec_reference_frame_t;
+
+/** 对齐统计 */
+typedef struct {
+    int32_t offset_us;              ///< 当前补偿量：回采播出时刻相对麦克风采集时刻的偏移
+    uint32_t padded_samples;        ///< 回采不足补静音的采样数
+    uint32_t dropped_samples;       ///< 已过期丢弃的回采采样数
+    uint32_t delay_updates;         ///< 自动延迟修正次数
+} aec_reference_stats_t;
+
+/**
+ * @brief 创建回采对齐
+ * @param config 配置参数
+ * @return 句柄，失败返回 NULL
+ */
+aec_reference_handle_t aec_reference_create(const aec_reference_config_t *config);
+
+/**
+ * @brief 累加创建回采对齐所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void aec_reference_get_footprint(const aec_reference_config_t *config, audio_arena_footprint_t *fp);
+
+/**
+ * @brief 销毁回采对齐
+ * @param ref 句柄
+ */
+void aec_reference_destroy(aec_reference_handle_t ref);
+
+/**
+ * @brief 写入刚送入 I2S TX 的音频（生产者，在 i2s_channel_write 返回后立即调用）
+ * @param ref 句柄
+ * @param samples 16bit 单声道 PCM
+ * @param count 采样点数
+ * @return ESP_OK 成功
+ */
+esp_err_t aec_reference_write(aec_reference_handle_t ref, const int16_t *samples, size_t count);
+
+/**
+ * @brief 丢弃全部回采（生产者调用）
+ * @param ref 句柄
+ * @return ESP_OK 成功
+ */
+esp_err_t aec_reference_clear(aec_reference_handle_t ref);
+
+/**
+ * @brief 取出与一帧麦克风数据对齐的回采（消费者，零拷贝）
+ * @param ref 句柄
+ * @param samples 麦克风帧采样点数
+ * @param capture_end_us 麦克风帧最后一个采样的采集时刻（esp_timer_get_time）
+ * @param frame 输出对齐结果，使用后调用 aec_reference_release()
+ * @return ESP_OK 成功
+ */
+esp_err_t aec_reference_fetch(aec_reference_handle_t ref, size_t samples, int64_t capture_end_us,
+                              aec_reference_frame_t *frame);
+
+/**
+ * @brief 释放已取出的回采，并用本帧数据更新自动延迟估计
+ * @param ref 句柄
+ * @param mic 本帧麦克风数据
+ * @param samples 麦克风帧采样点数
+ * @param frame aec_reference_fetch() 的输出
+ */
+void aec_reference_release(aec_reference_handle_t ref, const int16_t *mic, size_t samples,
+                           const aec_reference_frame_t *frame);
+
+/**
+ * @brief 获取回采缓冲区与对齐统计
+ * @param ref 句柄
+ * @param ring 输出缓冲区统计（可为 NULL）
+ * @param stats 输出对齐统计（可为 NULL）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t aec_reference_get_stats(aec_reference_handle_t ref, ring_buffer_stats_t *ring,
+                                  aec_reference_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:00:00
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\afe_models.h
+ * @Description: 模型映射 - 从原始模型分区按需只读映射选中的 WakeNet/VADNet/NSNet 模型
+ *
+ * 模型分区内容为 esp-sr 打包的 srmodels.bin：
+ *   int model_num;
+ *   model_num 个 { char name[32]; int file_num; file_num 个 { char name[32]; int start; int len; } }
+ * start 为相对分区起始的偏移。每个选中模型只映射其文件所在的连续区间，数据直接在 Flash 缓存中使用。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "model_path.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 模型名称最大长度（与 srmodels.bin 中的名称字段一致） */
+#define AFE_MODELS_NAME_LEN     32
+
+/** 模型映射句柄 */
+typedef struct afe_models_s *afe_models_handle_t;
+
+/** 模型选择 */
+typedef struct {
+    const char *partition;          ///< 模型分区名称
+    const char *wake_model;         ///< WakeNet 模型名（如 "wn9_xiaoyaxiaoya_tts2"，NULL 为分区中第一个 WakeNet）
+    bool wakenet;                   ///< 是否映射 WakeNet
+    bool vadnet;                    ///< 是否映射 VADNet（分区中没有时跳过，AFE 使用 WebRTC VAD）
+    bool nsnet;                     ///< 是否映射 NSNet（分区中没有时跳过，AFE 使用 WebRTC NS）
+} afe_models_select_t;
+
+/**
+ * @brief 映射选中的模型
+ * @param select 模型选择
+ * @param out 输出映射句柄
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_NOT_FOUND 分区或 WakeNet 模型不存在；
+ *         ESP_ERR_INVALID_SIZE 分区内容不是有效的 srmodels.bin；ESP_ERR_NO_MEM 内存不足；其他为映射失败
+ */
+esp_err_t afe_models_map(const afe_models_select_t *select, afe_models_handle_t *out);
+
+/**
+ * @brief 解除映射并释放句柄
+ * @param models 映射句柄（NULL 时忽略）
+ * @note 调用前须销毁使用这些模型的 AFE
+ */
+void afe_models_unmap(afe_models_handle_t models);
+
+/**
+ * @brief 获取 esp-sr 模型列表（仅含已映射的模型，可直接传给 afe_config_init）
+ * @param models 映射句柄
+ * @return 模型列表，句柄无效返回 NULL
+ */
+srmodel_list_t *afe_models_get_list(afe_models_handle_t models);
+
+/**
+ * @brief 判断已映射的模型是否满足选择（满足时无需重新映射）
+ * @param models 映射句柄
+ * @param select 模型选择
+ * @return true 选择一致
+ */
+bool afe_models_matches(afe_models_handle_t models, const afe_models_select_t *select);
+
+/**
+ * @brief 获取映射的 Flash 总字节数
+ * @param models 映射句柄
+ * @return 字节数，句柄无效返回 0
+ */
+size_t afe_models_get_mapped_bytes(afe_models_handle_t models);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,6 +13,7 @@
 #include "esp_err.h"
 #include "audio_bsp.h"
 #include "ring_buffer.h"
+#include "aec_reference.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -20,6 +21,16 @@
 extern "C" {
 #endif
 
+/** Feed 单帧最大每声道采样数 */
+#define AFE_WRAPPER_MAX_FRAME_SAMPLES   512
+/** AFE 输入最大声道数（如 "MMNR"） */
+#define AFE_WRAPPER_MAX_CHANNELS        4
+/** Feed / Fetch 任务栈大小（字节，由 esp_gmf_afe_manager 创建） */
+#define AFE_WRAPPER_FEED_STACK_SIZE     (10 * 1024)
+#define AFE_WRAPPER_FETCH_STACK_SIZE    (10 * 1024)
+/** AFE 处理采样率（esp-sr 固定 16kHz） */
+#define AFE_WRAPPER_SAMPLE_RATE         16000
+
 /** AFE 事件类型 */
 typedef enum {
     AFE_EVENT_WAKEUP_DETECTED,  ///< 唤醒词检测到
@@ -30,6 +41,8 @@ typedef enum {
 /** AFE 事件数据 */
 typedef struct {
     afe_event_type_t type;
+    int64_t timestamp_us;       ///< 检测到事件时的时间戳（esp_timer_get_time）
+    uint64_t sample_pos;        ///< 事件所在帧结束时的 AFE 输出流位置（采样点数，自创建起累计）
     union {
         struct {
             int wake_word_index;
@@ -44,10 +57,21 @@ typedef void (*afe_event_callback_t)(const afe_event_t *event, void *user_ctx);
 /** 录音数据回调 */
 typedef void (*afe_record_callback_t)(const int16_t *pcm_data, size_t samples, void *user_ctx);
 
+/**
+ * @brief 全双工扬声器数据源（Feed 任务每帧写扬声器前调用）
+ * @param pcm 输出缓冲区（16bit 单声道，未应用音量）
+ * @param samples 期望采样点数
+ * @param volume 输出音量（0-100）
+ * @param user_ctx 用户上下文
+ * @return 实际填充的采样点数，其余补静音
+ */
+typedef size_t (*afe_speaker_pull_t)(int16_t *pcm, size_t samples, uint8_t *volume, void *user_ctx);
+
 /** AFE 唤醒词配置 */
 typedef struct {
     bool enabled;
     const char *wake_word_name;
+    const char *wake_model_name;    ///< WakeNet 模型名（NULL 为模型列表中第一个 WakeNet）
     const char *model_partition;
     int sensitivity;
 } afe_wakeup_config_t;
@@ -68,21 +92,57 @@ typedef struct {
     int afe_mode;
 } afe_feature_config_t;
 
+/** AFE 运行档位 */
+typedef enum {
+    AFE_PROFILE_FULL = 0,       ///< 完整管线：按配置启用 AEC/NS/AGC/VAD/WakeNet，锁定 CPU 最高频率
+    AFE_PROFILE_LOW_POWER,      ///< 低功耗监听：仅 WakeNet，释放 CPU 频率锁，I2S RX 使用大 DMA 帧
+} afe_profile_t;
+
+/** 低功耗监听配置 */
+typedef struct {
+    bool enabled;               ///< 是否允许切换到低功耗档位
+    uint32_t rx_dma_frame_num;  ///< 低功耗档位下 I2S RX 每个 DMA 帧的采样数（0 保持默认）
+} afe_low_power_config_t;
+
 /** AFE 包装器配置 */
 typedef struct {
     audio_bsp_handle_t bsp_handle;             ///< BSP 句柄
-    ring_buffer_handle_t reference_rb;          ///< 回采缓冲区
+    aec_reference_handle_t reference;           ///< 回采对齐（Feed 任务按采集时刻零拷贝读取）
+    uint8_t mic_num;                            ///< 麦克风数（与 BSP 一致，0 按 1 处理）
+    const char *input_format;                   ///< AFE 输入声道排列（M 麦克风/R 回采/N 空，NULL 为 mic_num 个 M 加 R）
     afe_wakeup_config_t wakeup_config;          ///< 唤醒词配置
     afe_vad_config_t vad_config;                ///< VAD 配置
     afe_feature_config_t feature_config;        ///< 功能配置
+    afe_low_power_config_t low_power_config;    ///< 低功耗监听配置
     afe_event_callback_t event_callback;        ///< 事件回调
     void *event_ctx;                            ///< 事件回调上下文
     afe_record_callback_t record_callback;      ///< 录音回调
     void *record_ctx;                           ///< 录音回调上下文
+    afe_speaker_pull_t speaker_pull;            ///< 全双工扬声器数据源（非 NULL 时 Feed 任务每帧先写扬声器再读麦克风，BSP 须为全双工）
+    void *speaker_ctx;                          ///< 扬声器数据源上下文
     bool *running_ptr;                          ///< 运行状态指针（外部管理）
     bool *recording_ptr;                        ///< 录音状态指针（外部管理）
+    size_t preroll_samples;                     ///< 预录缓冲区大小（采样点数，0 表示不预录）
+    int8_t feed_core;                           ///< Feed 任务运行核心
+    int8_t fetch_core;                          ///< Fetch 任务运行核心（AFE 内部任务同此核心）
+    audio_arena_handle_t arena;                 ///< 内存区（可选，NULL 使用堆分配；AFE 内部缓冲不在其中）
 } afe_wrapper_config_t;
 
+/**
+ * @brief AFE 负载统计（累计值，始终统计，不依赖延迟追踪）
+ *
+ * 调用方按周期取差值：busy_us 与对应采样数换算出的音频时长之比即处理负载。
+ */
+typedef struct {
+    uint32_t feed_samples;          ///< 已送入 AFE 的采样数（每声道）
+    uint32_t feed_busy_us;          ///< Feed 任务在 AFE feed 中的累计耗时（两次读取回调之间）
+    uint32_t feed_misses;           ///< feed 耗时超过一帧时长的帧数（麦克风 DMA 有溢出风险）
+    uint32_t fetch_samples;         ///< AFE 输出的采样数
+    uint32_t fetch_busy_us;         ///< 结果回调累计耗时（事件、预录、录音回调）
+    uint32_t fetch_misses;          ///< 输出停顿：有积压时两次结果回调间隔超过两帧的次数
+    uint32_t backlog_samples;       ///< 已送入尚未输出的采样数（AFE 内部环形缓冲积压）
+} afe_load_stats_t;
+
 /** AFE 包装器句柄 */
 typedef struct afe_wrapper_s *afe_wrapper_handle_t;
 
@@ -93,17 +153,41 @@ typedef struct afe_wrapper_s *afe_wrapper_handle_t;
  */
 afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config);
 
+/**
+ * @brief 累加创建 AFE 包装器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ * @note 仅包含包装器自身；esp-sr 模型与 AFE Manager 的内部分配由其自行管理
+ */
+void afe_wrapper_get_footprint(const afe_wrapper_config_t *config, audio_arena_footprint_t *fp);
+
 /**
  * @brief 销毁 AFE 包装器
  * @param wrapper AFE 包装器句柄
  */
 void afe_wrapper_destroy(afe_wrapper_handle_t wrapper);
 
+/**
+ * @brief 预加载模型分区（可与其他启动阶段并行，模型在包装器销毁后保留）
+ * @param partition 模型分区名称
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 已加载其他分区；ESP_FAIL 加载失败
+ * @note 不可与 afe_wrapper_create/destroy 并发调用；创建时分区名一致才使用缓存；
+ *       开启 CONFIG_AUDIO_MANAGER_MODEL_MMAP 时模型在创建时按选择映射，此函数直接返回 ESP_OK
+ */
+esp_err_t afe_wrapper_preload_models(const char *partition);
+
+/**
+ * @brief 释放预加载的模型
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 仍有包装器在使用
+ */
+esp_err_t afe_wrapper_release_models(void);
+
 /**
  * @brief 更新唤醒词配置
  * @param wrapper AFE 包装器句柄
  * @param config 新配置
- * @return ESP_OK 成功
+ * @return ESP_OK 成功；重建失败返回对应错误（已恢复原配置）
+ * @note 开关、灵敏度、WakeNet 模型或分区变化时热重建 AFE（映射模式下只重新映射选中的模型）
  */
 esp_err_t afe_wrapper_update_wakeup_config(afe_wrapper_handle_t wrapper, 
                                             const afe_wakeup_config_t *config);
@@ -117,6 +201,69 @@ esp_err_t afe_wrapper_update_wakeup_config(afe_wrapper_handle_t wrapper,
 esp_err_t afe_wrapper_get_wakeup_config(afe_wrapper_handle_t wrapper, 
                                          afe_wakeup_config_t *config);
 
+/**
+ * @brief 更新 AFE 功能与 VAD 配置（运行中热切换，不重新加载模型）
+ * @param wrapper AFE 包装器句柄
+ * @param features 新的功能配置
+ * @param vad_config 新的 VAD 配置
+ * @return ESP_OK 成功
+ * @note 仅开关已初始化的功能时无中断；afe_mode、VAD 参数变化或开启新功能时重建 AFE Manager，
+ *       麦克风数据中断约为 AFE 创建耗时
+ */
+esp_err_t afe_wrapper_update_feature_config(afe_wrapper_handle_t wrapper,
+                                            const afe_feature_config_t *features,
+                                            const afe_vad_config_t *vad_config);
+
+/**
+ * @brief 获取当前 AFE 输出流位置
+ * @param wrapper AFE 包装器句柄
+ * @return 自创建起 AFE 输出的采样点总数
+ * @note 可在 ISR / esp_timer 回调中调用（IRAM，读取在临界区内完成）
+ */
+uint64_t afe_wrapper_get_stream_pos(afe_wrapper_handle_t wrapper);
+
+/**
+ * @brief 获取本段录音第一个采样的流位置
+ * @param wrapper AFE 包装器句柄
+ * @return 流位置（含预录数据），与 afe_event_t.sample_pos 相减即为事件在录音中的偏移
+ */
+uint64_t afe_wrapper_get_record_start_pos(afe_wrapper_handle_t wrapper);
+
+/**
+ * @brief 切换运行档位（无需重建 AFE）
+ * @param wrapper AFE 包装器句柄
+ * @param profile 目标档位
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未启用低功耗监听
+ * @note CPU 降频需应用层通过 esp_pm_configure() 开启动态调频（CONFIG_PM_ENABLE）；
+ *       I2S RX 的 DMA 帧长在 Feed 任务下一次读取前生效
+ */
+esp_err_t afe_wrapper_set_profile(afe_wrapper_handle_t wrapper, afe_profile_t profile);
+
+/**
+ * @brief 获取当前运行档位
+ * @param wrapper AFE 包装器句柄
+ * @return 当前档位，参数无效返回 AFE_PROFILE_FULL
+ */
+afe_profile_t afe_wrapper_get_profile(afe_wrapper_handle_t wrapper);
+
+/**
+ * @brief 获取 AFE Feed/Fetch 任务信息（栈高水位报告用）
+ * @param wrapper AFE 包装器句柄
+ * @param feed 输出 Feed 任务信息，可为 NULL
+ * @param fetch 输出 Fetch 任务信息，可为 NULL
+ * @note 两个任务由 esp_gmf_afe_manager 内部动态创建，句柄在各自首次回调时记录，
+ *       管线启动前或重建后首帧前 handle 为 NULL
+ */
+void afe_wrapper_get_task_info(afe_wrapper_handle_t wrapper,
+                               audio_arena_task_info_t *feed, audio_arena_task_info_t *fetch);
+
+/**
+ * @brief 获取 AFE 负载统计
+ * @param wrapper AFE 包装器句柄
+ * @param stats 输出统计（wrapper 为 NULL 时清零）
+ */
+void afe_wrapper_get_load_stats(afe_wrapper_handle_t wrapper, afe_load_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,176 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-03 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-03 14:05:12
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_arena.h
+ * @Description: 音频管线内存区 - 初始化时一次性预分配，按区域顺序切分
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 切分粒度（字节），兼顾 DMA 与 PSRAM cache line 对齐 */
+#define AUDIO_ARENA_ALIGN       16
+
+/** 按切分粒度向上取整 */
+#define AUDIO_ARENA_ALIGN_UP(n) (((n) + AUDIO_ARENA_ALIGN - 1) & ~((size_t)AUDIO_ARENA_ALIGN - 1))
+
+/** 内存区域 */
+typedef enum {
+    AUDIO_ARENA_INTERNAL = 0,   ///< 内部 RAM（DMA 可用）：上下文、TCB、任务栈、I2S 相关缓冲
+    AUDIO_ARENA_PSRAM,          ///< PSRAM：大容量环形缓冲区
+    AUDIO_ARENA_REGION_MAX,
+} audio_arena_region_t;
+
+/** 各区域字节数（用于预估占用或描述内存区容量） */
+typedef struct {
+    size_t bytes[AUDIO_ARENA_REGION_MAX];   ///< 按 audio_arena_region_t 索引
+} audio_arena_footprint_t;
+
+/** 模块任务描述（用于栈高水位报告） */
+typedef struct {
+    TaskHandle_t handle;        ///< 任务句柄（未创建时为 NULL）
+    size_t stack_bytes;         ///< 任务栈字节数
+    bool stack_psram;           ///< 任务栈位于 PSRAM
+    bool is_static;             ///< TCB 与任务栈为静态分配（不经过 FreeRTOS 堆）
+} audio_arena_task_info_t;
+
+/** 内存区句柄，NULL 表示直接使用堆分配 */
+typedef struct audio_arena_s *audio_arena_handle_t;
+
+/**
+ * @brief 累加一块内存的占用（按切分粒度对齐）
+ * @param fp 占用统计，可为 NULL
+ * @param region 内存区域
+ * @param size 字节数
+ */
+static inline void audio_arena_footprint_add(audio_arena_footprint_t *fp,
+                                             audio_arena_region_t region, size_t size)
+{
+    if (fp && size > 0) {
+        fp->bytes[region] += AUDIO_ARENA_ALIGN_UP(size);
+    }
+}
+
+/**
+ * @brief 累加一个静态任务（TCB + 任务栈）的占用
+ * @param fp 占用统计，可为 NULL
+ * @param stack_region 任务栈所在区域（TCB 固定在内部 RAM）
+ * @param stack_bytes 任务栈字节数
+ */
+void audio_arena_footprint_add_task(audio_arena_footprint_t *fp,
+                                    audio_arena_region_t stack_region, size_t stack_bytes);
+
+/**
+ * @brief 累加一个静态信号量/互斥锁的占用
+ * @param fp 占用统计，可为 NULL
+ */
+void audio_arena_footprint_add_semaphore(audio_arena_footprint_t *fp);
+
+/**
+ * @brief 累加一个静态队列（控制块 + 存储区）的占用
+ * @param fp 占用统计，可为 NULL
+ * @param length 队列长度
+ * @param item_size 元素大小（字节）
+ */
+void audio_arena_footprint_add_queue(audio_arena_footprint_t *fp, size_t length, size_t item_size);
+
+/**
+ * @brief 创建内存区（每个区域一次性分配）
+ * @param size 各区域容量，通常由各模块 *_get_footprint() 累加得到
+ * @return 内存区句柄，失败返回 NULL
+ */
+audio_arena_handle_t audio_arena_create(const audio_arena_footprint_t *size);
+
+/**
+ * @brief 销毁内存区并释放所有区域
+ * @param arena 内存区句柄
+ * @note 调用前必须先销毁所有从该内存区切分资源的对象（任务、队列、信号量）
+ */
+void audio_arena_destroy(audio_arena_handle_t arena);
+
+/**
+ * @brief 分配并清零一块内存
+ * @param arena 内存区句柄，NULL 时使用 heap_caps_calloc() 按区域能力分配
+ * @param region 内存区域
+ * @param size 字节数
+ * @return 内存指针，空间不足返回 NULL
+ * @note 内存区模式下仅在初始化阶段调用，不是线程安全的
+ */
+void *audio_arena_calloc(audio_arena_handle_t arena, audio_arena_region_t region, size_t size);
+
+/**
+ * @brief 释放 audio_arena_calloc() 分配的内存
+ * @param arena 内存区句柄，NULL 时调用 heap_caps_free()；非 NULL 时为空操作
+ * @param ptr 内存指针，允许为 NULL
+ */
+void audio_arena_free(audio_arena_handle_t arena, void *ptr);
+
+/**
+ * @brief 创建固定在指定核心的任务
+ * @param arena 内存区句柄，NULL 时使用 xTaskCreatePinnedToCore() 动态创建
+ * @param task_func 任务函数
+ * @param name 任务名称
+ * @param stack_bytes 任务栈字节数
+ * @param arg 任务参数
+ * @param priority 优先级
+ * @param stack_region 任务栈所在区域（仅内存区模式有效）
+ * @param core 运行核心
+ * @return 任务句柄，失败返回 NULL
+ */
+TaskHandle_t audio_arena_create_task(audio_arena_handle_t arena, TaskFunction_t task_func,
+                                     const char *name, size_t stack_bytes, void *arg,
+                                     UBaseType_t priority, audio_arena_region_t stack_region,
+                                     BaseType_t core);
+
+/**
+ * @brief 创建二值信号量
+ * @param arena 内存区句柄，NULL 时动态创建
+ * @return 信号量句柄，失败返回 NULL
+ */
+SemaphoreHandle_t audio_arena_create_binary(audio_arena_handle_t arena);
+
+/**
+ * @brief 创建互斥锁
+ * @param arena 内存区句柄，NULL 时动态创建
+ * @return 互斥锁句柄，失败返回 NULL
+ */
+SemaphoreHandle_t audio_arena_create_mutex(audio_arena_handle_t arena);
+
+/**
+ * @brief 创建队列
+ * @param arena 内存区句柄，NULL 时动态创建
+ * @param length 队列长度
+ * @param item_size 元素大小（字节）
+ * @return 队列句柄，失败返回 NULL
+ */
+QueueHandle_t audio_arena_create_queue(audio_arena_handle_t arena, size_t length, size_t item_size);
+
+/**
+ * @brief 获取内存区使用情况
+ * @param arena 内存区句柄
+ * @param used 输出已切分字节数（可为 NULL）
+ * @param capacity 输出各区域容量（可为 NULL）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_arena_get_usage(audio_arena_handle_t arena,
+                                audio_arena_footprint_t *used,
+                                audio_arena_footprint_t *capacity);
+
+#ifdef __cplusplus
+}
+#endif
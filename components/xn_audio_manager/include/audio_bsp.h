@@ -10,6 +10,7 @@
 
 #include "esp_err.h"
 #include "driver/i2s_std.h"
+#include "audio_arena.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -18,6 +19,9 @@
 extern "C" {
 #endif
 
+/** 最大麦克风数 */
+#define AUDIO_BSP_MAX_MIC_NUM 2
+
 /**
  * @brief 麦克风硬件配置
  */
@@ -30,6 +34,8 @@ typedef struct {
     int bits;                ///< 位深
     size_t max_frame_samples;///< 最大采样帧数（用于分配临时缓冲）
     uint8_t bit_shift;       ///< 32bit 转 16bit 的右移位数
+    uint8_t mic_num;         ///< 麦克风数（1 单麦克风，2 双麦克风阵列：左声道为 0 号）
+    float gain[AUDIO_BSP_MAX_MIC_NUM]; ///< 每路麦克风校准增益（线性倍数，最大 2.0，0 表示 1.0）
 } audio_bsp_mic_config_t;
 
 /**
@@ -51,14 +57,24 @@ typedef struct {
 typedef struct {
     audio_bsp_mic_config_t mic;
     audio_bsp_speaker_config_t speaker;
+    bool full_duplex;                ///< 全双工：扬声器与麦克风共用麦克风端口与 BCLK/LRCK（采样率须一致）
+    audio_arena_handle_t arena;      ///< 内存区（可选，NULL 使用堆分配）
 } audio_bsp_hw_config_t;
 
 typedef struct audio_bsp_s *audio_bsp_handle_t;
 
 audio_bsp_handle_t audio_bsp_create(const audio_bsp_hw_config_t *config);
 
+/**
+ * @brief 累加创建 BSP 所需的内存占用（内存区模式）
+ */
+void audio_bsp_get_footprint(const audio_bsp_hw_config_t *config, audio_arena_footprint_t *fp);
+
 void audio_bsp_destroy(audio_bsp_handle_t handle);
 
+/**
+ * @brief 读取麦克风数据（多麦克风时第 c 路位于 out_samples + c * sample_count）
+ */
 esp_err_t audio_bsp_read_mic(audio_bsp_handle_t handle,
                              int16_t *out_samples,
                              size_t sample_count,
@@ -73,6 +89,20 @@ i2s_chan_handle_t audio_bsp_get_rx(audio_bsp_handle_t handle);
 
 i2s_chan_handle_t audio_bsp_get_tx(audio_bsp_handle_t handle);
 
+size_t audio_bsp_get_tx_queue_samples(audio_bsp_handle_t handle);
+
+uint8_t audio_bsp_get_mic_num(audio_bsp_handle_t handle);
+
+/**
+ * @brief 是否为全双工（麦克风与扬声器同一时钟，须由同一任务锁步读写）
+ */
+bool audio_bsp_is_full_duplex(audio_bsp_handle_t handle);
+
+/**
+ * @brief 设置麦克风 DMA 帧长（0 恢复默认），须在读取麦克风的任务中调用
+ */
+esp_err_t audio_bsp_set_mic_dma_frame(audio_bsp_handle_t handle, uint32_t frame_num);
+
 #ifdef __cplusplus
 }
 #endif
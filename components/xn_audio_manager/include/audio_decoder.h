@@ -0,0 +1,97 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 09:40:18
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 09:40:18
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_decoder.h
+ * @Description: 压缩音频解码级 - 按帧增量解码 Opus/MP3/ADPCM 为 16bit 单声道 PCM
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "audio_arena.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 支持的压缩格式 */
+typedef enum {
+    AUDIO_DECODER_CODEC_OPUS = 0,   ///< 裸 Opus 包（每次输入一个完整包）
+    AUDIO_DECODER_CODEC_MP3,        ///< MP3 码流（可任意切分）
+    AUDIO_DECODER_CODEC_ADPCM,      ///< IMA-ADPCM 4bit（每次输入完整块）
+    AUDIO_DECODER_CODEC_MAX,
+} audio_decoder_codec_t;
+
+/** 解码器句柄 */
+typedef struct audio_decoder_s *audio_decoder_handle_t;
+
+/** 解码器配置 */
+typedef struct {
+    uint32_t sample_rate;           ///< 输出采样率（Opus/ADPCM 按此解码，其他采样率的码流重采样到此）
+    size_t max_frame_samples;       ///< 单帧最大采样点数（按解码器原始声道数计）
+    size_t max_input_bytes;         ///< 跨输入拼接的最大字节数（码流格式）
+    bool resample;                  ///< 码流采样率与输出不一致时重采样（重采样器约 7KB，关闭时此类码流不支持）
+    audio_arena_handle_t arena;     ///< 内存区（可选，NULL 使用堆分配）
+} audio_decoder_config_t;
+
+#define AUDIO_DECODER_DEFAULT_CONFIG()                               \
+    (audio_decoder_config_t){                                        \
+        .sample_rate = 16000,                                        \
+        .max_frame_samples = 2304,                                   \
+        .max_input_bytes = 2048,                                     \
+        .resample = true,                                            \
+        .arena = NULL,                                               \
+    }
+
+/**
+ * @brief 创建解码器（分配工作缓冲区，具体编解码器在首次解码时打开）
+ * @param config 配置参数
+ * @return 解码器句柄，失败返回 NULL
+ */
+audio_decoder_handle_t audio_decoder_create(const audio_decoder_config_t *config);
+
+/**
+ * @brief 累加创建解码器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ * @note 不含编解码库内部状态（由 esp_audio_codec 从堆分配）
+ */
+void audio_decoder_get_footprint(const audio_decoder_config_t *config, audio_arena_footprint_t *fp);
+
+/**
+ * @brief 销毁解码器
+ * @param decoder 解码器句柄
+ */
+void audio_decoder_destroy(audio_decoder_handle_t decoder);
+
+/**
+ * @brief 解码一帧
+ * @param decoder 解码器句柄
+ * @param codec 输入格式（与上一次不同时自动重新打开编解码器）
+ * @param data 输入数据
+ * @param len 输入字节数
+ * @param consumed 输出本次消耗的输入字节数，调用方下次从 data + consumed 继续
+ * @param pcm 输出 PCM 指针（16bit 单声道，指向解码器内部缓冲，下次调用前有效）
+ * @param samples 输出采样点数，0 表示需要更多输入
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 格式或采样率不支持（超出重采样范围或未启用 resample）；
+ *         ESP_FAIL 数据损坏
+ */
+esp_err_t audio_decoder_decode(audio_decoder_handle_t decoder, audio_decoder_codec_t codec,
+                               const uint8_t *data, size_t len, size_t *consumed,
+                               const int16_t **pcm, size_t *samples);
+
+/**
+ * @brief 丢弃拼接中的残留数据并关闭编解码器（切换音频流时调用）
+ * @param decoder 解码器句柄
+ */
+void audio_decoder_reset(audio_decoder_handle_t decoder);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,123 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 10:12:40
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_dsp.h
+ * @Description: 音频定点运算内核 - 麦克风位宽转换、音量缩放、声道扩展/交织
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Q15 单位增益（1.0） */
+#define AUDIO_DSP_Q15_UNITY     32768
+
+/**
+ * @brief 将 0-100 音量映射为 Q15 增益
+ * @param volume 音量（0-100，超出按 100 处理）
+ * @return Q15 增益（0 ~ AUDIO_DSP_Q15_UNITY）
+ */
+int32_t audio_dsp_volume_to_q15(uint8_t volume);
+
+/**
+ * @brief 32 位采样右移后饱和转换为 16 位
+ * @param in 输入数据（32 位）
+ * @param out 输出数据（16 位），可与 in 指向同一块内存
+ * @param count 采样点数
+ * @param shift 右移位数
+ * @note 超出 int16 范围的值被钳位到 INT16_MIN/INT16_MAX，而不是截断回绕
+ */
+void audio_dsp_s32_to_s16_sat(const int32_t *in, int16_t *out, size_t count, uint8_t shift);
+
+/**
+ * @brief 多声道 32 位交织采样解交织为 16 位平面，同时右移、按声道增益缩放并饱和
+ * @param in 输入数据（32 位交织，长度 frames * channels）
+ * @param out 输出数据（16 位，第 c 声道位于 out + c * out_stride）
+ * @param frames 每声道采样点数
+ * @param channels 声道数
+ * @param out_stride 输出声道平面间隔（采样点数，不小于 frames）
+ * @param shift 右移位数
+ * @param gain_q15 每声道 Q15 增益（0 ~ 2 * AUDIO_DSP_Q15_UNITY，NULL 表示单位增益）
+ */
+void audio_dsp_s32_deinterleave_s16(const int32_t *in, int16_t *out, size_t frames, size_t channels,
+                                    size_t out_stride, uint8_t shift, const int32_t *gain_q15);
+
+/**
+ * @brief 单声道按 Q15 增益缩放并复制到左右声道
+ * @param in 输入数据（16 位单声道）
+ * @param out 输出数据（16 位立体声 LRLR...，长度 count * 2）
+ * @param count 输入采样点数
+ * @param gain_q15 Q15 增益（0 ~ AUDIO_DSP_Q15_UNITY）
+ */
+void audio_dsp_mono_to_stereo_q15(const int16_t *in, int16_t *out, size_t count, int32_t gain_q15);
+
+/**
+ * @brief 单声道线性增益渐变（淡入/淡出）
+ * @param in 输入数据（16 位单声道）
+ * @param out 输出数据，可与 in 指向同一块内存
+ * @param count 采样点数
+ * @param gain_from 首个采样的 Q15 增益
+ * @param gain_to 末尾（不含）的 Q15 增益，第 count 个采样将达到该值
+ */
+void audio_dsp_ramp_q15(const int16_t *in, int16_t *out, size_t count,
+                        int32_t gain_from, int32_t gain_to);
+
+/**
+ * @brief 单声道按线性渐变的 Q15 增益缩放后累加到 32 位混音缓冲
+ * @param in 输入数据（16 位单声道）
+ * @param acc 混音累加缓冲（32 位，长度 count）
+ * @param count 采样点数
+ * @param gain_from 首个采样的 Q15 增益
+ * @param gain_to 末尾（不含）的 Q15 增益，两者相等时为固定增益（均不超过 AUDIO_DSP_Q15_UNITY）
+ * @note 累加结果用 audio_dsp_s32_to_s16_sat(acc, out, n, 0) 饱和输出
+ */
+void audio_dsp_mix_ramp_q15(const int16_t *in, int32_t *acc, size_t count,
+                            int32_t gain_from, int32_t gain_to);
+
+/**
+ * @brief 两路单声道交织为双声道
+ * @param ch0 第 0 声道数据
+ * @param ch1 第 1 声道数据（NULL 表示静音）
+ * @param out 输出数据（长度 count * 2）
+ * @param count 每声道采样点数
+ */
+void audio_dsp_interleave2_s16(const int16_t *ch0, const int16_t *ch1, int16_t *out, size_t count);
+
+/**
+ * @brief 多路单声道交织
+ * @param chans 各声道数据指针（NULL 表示该声道静音）
+ * @param channels 声道数
+ * @param out 输出数据（长度 count * channels）
+ * @param count 每声道采样点数
+ */
+void audio_dsp_interleave_s16(const int16_t *const *chans, size_t channels, int16_t *out, size_t count);
+
+/**
+ * @brief 多声道交织采样下混为单声道（各声道取平均）
+ * @param in 输入数据（长度 frames * channels）
+ * @param out 输出数据（长度 frames），可与 in 指向同一块内存（原地下混）
+ * @param frames 帧数
+ * @param channels 声道数
+ */
+void audio_dsp_downmix_s16(const int16_t *in, int16_t *out, size_t frames, size_t channels);
+
+/**
+ * @brief Q15 系数 FIR 点积，结果舍入右移 15 位并饱和
+ * @param x 输入采样（n 个连续采样）
+ * @param coef Q15 系数（系数绝对值之和须小于 2.0，保证累加不溢出 int32）
+ * @param n 抽头数
+ * @return 输出采样
+ */
+int16_t audio_dsp_fir_q15(const int16_t *x, const int16_t *coef, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 16:22:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 16:22:05
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_encoder.h
+ * @Description: 录音编码级 - 在独立任务中把 16bit 单声道 PCM 按帧编码为 Opus/ADPCM 包
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "audio_arena.h"
+#include "ring_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 支持的编码格式 */
+typedef enum {
+    AUDIO_ENCODER_CODEC_OPUS = 0,   ///< Opus（VOIP 模式），帧长 10/20/40/60 ms
+    AUDIO_ENCODER_CODEC_ADPCM,      ///< IMA-ADPCM 4bit，帧长由编码块决定
+    AUDIO_ENCODER_CODEC_MAX,
+} audio_encoder_codec_t;
+
+/** 编码包回调（在编码任务中调用） */
+typedef void (*audio_encoder_packet_cb_t)(const uint8_t *data, size_t len, void *user_ctx);
+
+/** 编码器句柄 */
+typedef struct audio_encoder_s *audio_encoder_handle_t;
+
+/** 编码器配置 */
+typedef struct {
+    audio_encoder_codec_t codec;        ///< 编码格式
+    uint32_t sample_rate;               ///< 输入采样率
+    uint16_t frame_ms;                  ///< 帧长（毫秒，Opus 有效）
+    uint32_t bitrate;                   ///< 码率（bps，Opus 有效）
+    uint16_t buffer_ms;                 ///< 输入缓冲深度（毫秒），编码跟不上时丢弃新数据
+    size_t task_stack_size;             ///< 编码任务栈大小（字节）
+    UBaseType_t task_priority;          ///< 编码任务优先级
+    BaseType_t task_core;               ///< 编码任务运行核心
+    audio_arena_region_t stack_region;  ///< 编码任务栈所在区域（仅内存区模式有效）
+    audio_encoder_packet_cb_t packet_callback; ///< 编码包回调
+    void *packet_ctx;                   ///< 回调上下文
+    audio_arena_handle_t arena;         ///< 内存区（可选，NULL 使用堆分配）
+} audio_encoder_config_t;
+
+#define AUDIO_ENCODER_DEFAULT_CONFIG()                               \
+    (audio_encoder_config_t){                                        \
+        .codec = AUDIO_ENCODER_CODEC_OPUS,                           \
+        .sample_rate = 16000,                                        \
+        .frame_ms = 20,                                              \
+        .bitrate = 24000,                                            \
+        .buffer_ms = 200,                                            \
+        .task_stack_size = 24 * 1024,                                \
+        .task_priority = 6,                                          \
+        .task_core = 0,                                              \
+        .stack_region = AUDIO_ARENA_INTERNAL,                        \
+        .packet_callback = NULL,                                     \
+        .packet_ctx = NULL,                                          \
+        .arena = NULL,                                               \
+    }
+
+/**
+ * @brief 创建编码器并启动编码任务
+ * @param config 配置参数
+ * @return 编码器句柄，失败返回 NULL
+ */
+audio_encoder_handle_t audio_encoder_create(const audio_encoder_config_t *config);
+
+/**
+ * @brief 累加创建编码器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ * @note 不含编解码库内部状态（由 esp_audio_codec 从堆分配）
+ */
+void audio_encoder_get_footprint(const audio_encoder_config_t *config, audio_arena_footprint_t *fp);
+
+/**
+ * @brief 停止编码任务并销毁编码器
+ * @param encoder 编码器句柄
+ */
+void audio_encoder_destroy(audio_encoder_handle_t encoder);
+
+/**
+ * @brief 送入 PCM 数据（不阻塞，只做一次拷贝）
+ * @param encoder 编码器句柄
+ * @param pcm 16bit 单声道 PCM
+ * @param samples 采样点数
+ * @return ESP_OK 成功；ESP_ERR_NO_MEM 输入缓冲已满，数据被丢弃
+ * @note 单生产者：只能在同一个任务中调用
+ */
+esp_err_t audio_encoder_feed(audio_encoder_handle_t encoder, const int16_t *pcm, size_t samples);
+
+/**
+ * @brief 结束当前语音段：编码剩余数据，不足一帧补静音后输出
+ * @param encoder 编码器句柄
+ * @return ESP_OK 成功（异步执行，不等待）
+ */
+esp_err_t audio_encoder_flush(audio_encoder_handle_t encoder);
+
+/**
+ * @brief 获取输入缓冲统计（丢弃量等）
+ * @param encoder 编码器句柄
+ * @param stats 输出统计
+ * @return ESP_OK 成功
+ */
+esp_err_t audio_encoder_get_stats(audio_encoder_handle_t encoder, ring_buffer_stats_t *stats);
+
+/**
+ * @brief 获取编码任务信息（栈高水位报告用）
+ * @param encoder 编码器句柄
+ * @param info 输出任务信息
+ */
+void audio_encoder_get_task_info(audio_encoder_handle_t encoder, audio_arena_task_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
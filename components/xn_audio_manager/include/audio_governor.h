@@ -0,0 +1,156 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-12 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-12 10:00:00
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_governor.h
+ * @Description: 负载调节器 - 按 AFE 帧截止、积压与空闲内存决定管线降级档位
+ *
+ * 只做决策，不直接操作管线：调用方周期性传入累计计数，按返回的档位调整 AFE 功能。
+ * 档位逐级调整：连续 degrade_windows 个周期过载降一级，连续 recover_windows 个周期空闲升一级。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "audio_arena.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 降级档位（逐级累加） */
+typedef enum {
+    AUDIO_GOVERNOR_LEVEL_NORMAL = 0,    ///< 按配置运行
+    AUDIO_GOVERNOR_LEVEL_REDUCED,       ///< 关闭 NS/AGC（运行时开关，无中断）
+    AUDIO_GOVERNOR_LEVEL_LOW_COST,      ///< 再切到 LOW_COST afe_mode（需热重建 AFE）
+} audio_governor_level_t;
+
+/** 决策原因 */
+typedef enum {
+    AUDIO_GOVERNOR_REASON_PLACEMENT = 0, ///< 启动时确定任务放置（由调用方报告）
+    AUDIO_GOVERNOR_REASON_FEED_DEADLINE, ///< Feed 帧处理超过帧时长
+    AUDIO_GOVERNOR_REASON_FETCH_DEADLINE, ///< Fetch 输出停顿
+    AUDIO_GOVERNOR_REASON_BACKLOG,      ///< AFE 积压过多或回采缓冲区溢出
+    AUDIO_GOVERNOR_REASON_CPU_LOAD,     ///< Feed/Fetch 负载超过 overload_pct
+    AUDIO_GOVERNOR_REASON_LOW_MEMORY,   ///< 内部 RAM 不足：暂缓需要重建 AFE 的档位调整
+    AUDIO_GOVERNOR_REASON_RECOVERED,    ///< 负载恢复，升一级
+} audio_governor_reason_t;
+
+/** 负载调节器句柄 */
+typedef struct audio_governor_s *audio_governor_handle_t;
+
+/** 负载调节器配置 */
+typedef struct {
+    uint32_t sample_rate;               ///< 采样率（采样数换算为音频时长）
+    uint8_t overload_pct;               ///< 负载（处理耗时占音频时长）达到该比例视为过载
+    uint8_t recover_pct;                ///< 负载低于该比例视为空闲（须小于 overload_pct，形成回差）
+    uint16_t backlog_ms;                ///< AFE 积压超过该时长视为过载
+    uint8_t degrade_windows;            ///< 连续过载多少个周期降一级
+    uint8_t recover_windows;            ///< 连续空闲多少个周期升一级
+    size_t min_free_internal;           ///< 内部 RAM 空闲低于该值时不做需要重建的调整（0 不检查）
+    audio_governor_level_t max_level;   ///< 最多降到的档位
+    audio_arena_handle_t arena;         ///< 内存区（可选，NULL 使用堆分配）
+} audio_governor_config_t;
+
+#define AUDIO_GOVERNOR_DEFAULT_CONFIG()                              \
+    (audio_governor_config_t){                                       \
+        .sample_rate = 16000,                                        \
+        .overload_pct = 85,                                          \
+        .recover_pct = 50,                                           \
+        .backlog_ms = 200,                                           \
+        .degrade_windows = 2,                                        \
+        .recover_windows = 10,                                       \
+        .min_free_internal = 24 * 1024,                              \
+        .max_level = AUDIO_GOVERNOR_LEVEL_LOW_COST,                  \
+        .arena = NULL,                                               \
+    }
+
+/** 一次采样（均为累计值，调节器内部取差值） */
+typedef struct {
+    uint32_t feed_samples;              ///< 已送入 AFE 的采样数
+    uint32_t feed_busy_us;              ///< 累计 feed 耗时
+    uint32_t feed_misses;               ///< 累计 feed 超时帧数
+    uint32_t fetch_samples;             ///< AFE 已输出的采样数
+    uint32_t fetch_busy_us;             ///< 累计结果回调耗时
+    uint32_t fetch_misses;              ///< 累计输出停顿次数
+    uint32_t backlog_samples;           ///< 当前 AFE 积压（采样数）
+    uint32_t ref_overrun_samples;       ///< 回采缓冲区累计溢出采样数
+    size_t free_internal;               ///< 当前内部 RAM 空闲字节
+} audio_governor_sample_t;
+
+/** 决策结果 */
+typedef struct {
+    audio_governor_level_t level;       ///< 调整后的档位
+    audio_governor_level_t prev_level;  ///< 调整前的档位
+    audio_governor_reason_t reason;     ///< 原因
+    uint8_t feed_load_pct;              ///< 本周期 Feed 负载
+    uint8_t fetch_load_pct;             ///< 本周期 Fetch 回调负载
+    uint16_t backlog_ms;                ///< 当前 AFE 积压
+    size_t free_internal;               ///< 当前内部 RAM 空闲字节
+} audio_governor_decision_t;
+
+/** 运行统计 */
+typedef struct {
+    audio_governor_level_t level;       ///< 当前档位
+    uint8_t feed_load_pct;              ///< 最近一个周期的 Feed 负载
+    uint8_t fetch_load_pct;             ///< 最近一个周期的 Fetch 回调负载
+    uint16_t backlog_ms;                ///< 最近一次采样的 AFE 积压
+    uint32_t degrades;                  ///< 累计降级次数
+    uint32_t recoveries;                ///< 累计恢复次数
+    uint32_t memory_holds;              ///< 因内存不足暂缓调整的次数
+} audio_governor_stats_t;
+
+/**
+ * @brief 创建负载调节器
+ * @param config 配置参数
+ * @return 句柄，失败返回 NULL
+ */
+audio_governor_handle_t audio_governor_create(const audio_governor_config_t *config);
+
+/**
+ * @brief 累加创建负载调节器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void audio_governor_get_footprint(const audio_governor_config_t *config, audio_arena_footprint_t *fp);
+
+/**
+ * @brief 销毁负载调节器
+ * @param governor 句柄
+ */
+void audio_governor_destroy(audio_governor_handle_t governor);
+
+/**
+ * @brief 输入一次采样并做出决策
+ * @param governor 句柄
+ * @param sample 本次采样
+ * @param decision 输出决策（返回 true 时有效）
+ * @return true 需要报告：档位变化，或因内存不足首次暂缓调整
+ * @note 周期内没有送入数据（未监听）时只更新基准，不计入过载/空闲
+ */
+bool audio_governor_update(audio_governor_handle_t governor, const audio_governor_sample_t *sample,
+                           audio_governor_decision_t *decision);
+
+/**
+ * @brief 获取当前档位
+ * @param governor 句柄
+ * @return 当前档位，句柄无效返回 AUDIO_GOVERNOR_LEVEL_NORMAL
+ */
+audio_governor_level_t audio_governor_get_level(audio_governor_handle_t governor);
+
+/**
+ * @brief 获取运行统计
+ * @param governor 句柄
+ * @param stats 输出统计
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_governor_get_stats(audio_governor_handle_t governor, audio_governor_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
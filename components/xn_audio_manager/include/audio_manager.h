@@ -25,7 +25,6 @@ extern "C" {
 #define AUDIO_MANAGER_TASK_STACK_SIZE        (6 * 1024)
 #define AUDIO_MANAGER_TASK_PRIORITY          7
 #define AUDIO_MANAGER_EVENT_QUEUE_LENGTH     16
-#define AUDIO_MANAGER_STEP_INTERVAL_MS       100
 #define AUDIO_MANAGER_DEFAULT_VOLUME         80
 
 #define AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES 1024
@@ -54,16 +53,49 @@ typedef enum {
     AUDIO_MGR_EVENT_WAKEUP_TIMEOUT,     ///< 唤醒超时（无人说话）
     AUDIO_MGR_EVENT_BUTTON_TRIGGER,     ///< 按键手动触发（按下）
     AUDIO_MGR_EVENT_BUTTON_RELEASE,     ///< 按键松开（新增）
+    AUDIO_MGR_EVENT_PLAYBACK_INTERRUPTED, ///< 播放被打断（唤醒词/人声触发 barge-in 停止播放）
+    AUDIO_MGR_EVENT_GOVERNOR,           ///< 负载调节器决策（任务放置、降级、恢复、因内存不足暂缓）
 } audio_mgr_event_type_t;
 
+/** 负载调节档位（逐级累加） */
+typedef enum {
+    AUDIO_MGR_GOV_LEVEL_NORMAL = 0,     ///< 按配置运行
+    AUDIO_MGR_GOV_LEVEL_REDUCED,        ///< 关闭 NS/AGC
+    AUDIO_MGR_GOV_LEVEL_LOW_COST,       ///< 再切到 LOW_COST afe_mode（热重建 AFE）
+} audio_mgr_gov_level_t;
+
+/** 负载调节决策原因 */
+typedef enum {
+    AUDIO_MGR_GOV_REASON_PLACEMENT = 0, ///< 启动时确定的任务放置
+    AUDIO_MGR_GOV_REASON_FEED_DEADLINE, ///< Feed 帧处理超过帧时长
+    AUDIO_MGR_GOV_REASON_FETCH_DEADLINE, ///< Fetch 输出停顿
+    AUDIO_MGR_GOV_REASON_BACKLOG,       ///< AFE 积压过多或回采缓冲区溢出
+    AUDIO_MGR_GOV_REASON_CPU_LOAD,      ///< Feed/Fetch 负载过高
+    AUDIO_MGR_GOV_REASON_LOW_MEMORY,    ///< 内部 RAM 不足，暂缓需要重建 AFE 的调整
+    AUDIO_MGR_GOV_REASON_RECOVERED,     ///< 负载恢复，升一级
+} audio_mgr_gov_reason_t;
+
 /** 音频管理器事件数据 */
 typedef struct {
     audio_mgr_event_type_t type;        ///< 事件类型
+    int64_t timestamp_us;               ///< 事件发生时间（esp_timer_get_time）
+    uint64_t sample_pos;                ///< 事件发生时的录音流位置（采样点数），用于与录音数据对齐
     union {
         struct {
             int wake_word_index;        ///< 唤醒词索引
             float volume_db;            ///< 音量(dB)
         } wakeup;
+        struct {
+            audio_mgr_gov_level_t level;      ///< 当前档位
+            audio_mgr_gov_level_t prev_level; ///< 调整前的档位
+            audio_mgr_gov_reason_t reason;    ///< 原因
+            uint8_t feed_load_pct;            ///< 最近周期 Feed 负载（处理耗时占音频时长）
+            uint8_t fetch_load_pct;           ///< 最近周期 Fetch 回调负载
+            int8_t feed_core;                 ///< AFE feed 任务所在核
+            int8_t fetch_core;                ///< AFE fetch 任务所在核
+            uint16_t backlog_ms;              ///< AFE 积压
+            uint32_t free_internal;           ///< 内部 RAM 空闲字节
+        } governor;                           ///< AUDIO_MGR_EVENT_GOVERNOR
     } data;
 } audio_mgr_event_t;
 
@@ -76,6 +108,7 @@ typedef void (*audio_mgr_event_cb_t)(const audio_mgr_event_t *event, void *user_
 typedef struct {
     audio_bsp_mic_config_t     mic;     ///< 麦克风 I2S 配置
     audio_bsp_speaker_config_t speaker; ///< 扬声器 I2S 配置
+    bool full_duplex;                   ///< 全双工：扬声器共用麦克风端口与时钟，由 AFE Feed 任务锁步读写
     struct {
         int  gpio;                      ///< 按键 GPIO
         bool active_low;                ///< 低电平有效
@@ -86,6 +119,7 @@ typedef struct {
 typedef struct {
     bool enabled;                   ///< 是否启用唤醒词检测
     const char *wake_word_name;     ///< 唤醒词名称（如"小鸭小鸭"）
+    const char *wake_model_name;    ///< WakeNet 模型名（如"wn9_xiaoyaxiaoya_tts2"，NULL 为分区中第一个 WakeNet）
     const char *model_partition;    ///< 模型分区名称（默认"model"）
     int sensitivity;                ///< 灵敏度 (0-3: 低/中/高/最高，对应DET_MODE_xxx)
     int wakeup_timeout_ms;          ///< 唤醒超时（无人说话自动结束）
@@ -106,14 +140,230 @@ typedef struct {
     bool ns_enabled;                ///< 降噪
     bool agc_enabled;               ///< 自动增益
     int afe_mode;                   ///< AFE模式（0=LOW_COST, 1=HIGH_QUALITY）
+    const char *input_format;       ///< AFE 输入声道排列（如 "MR"、"MMR"、"MMNR"；NULL 按麦克风数自动生成）
+    bool aec_playback_only;         ///< 仅在播放时运行 AEC（未播放时无回声，关闭可节省 Core 1 算力）
+    int aec_ref_lead_ms;            ///< 回采相对回声的提前量（毫秒）
+    bool aec_auto_delay;            ///< 自动估计并修正回采残余延迟
+    uint16_t preroll_ms;            ///< 预录时长（毫秒，录音开始时先输出之前的音频，0 关闭）
 } audio_mgr_afe_config_t;
 
+/** 播放缓冲区满时的处理策略 */
+typedef enum {
+    AUDIO_MGR_OVERRUN_OVERWRITE = 0,    ///< 覆盖最旧数据（默认）
+    AUDIO_MGR_OVERRUN_REJECT,           ///< 拒绝写入，play_audio 返回 ESP_ERR_NO_MEM
+    AUDIO_MGR_OVERRUN_BLOCK,            ///< 等待空间，超时后 play_audio 返回 ESP_ERR_TIMEOUT
+} audio_mgr_overrun_policy_t;
+
+/** 压缩播放格式（audio_manager_play_encoded） */
+typedef enum {
+    AUDIO_MGR_CODEC_OPUS = 0,           ///< 裸 Opus 包（16kHz 单声道解码）
+    AUDIO_MGR_CODEC_MP3,                ///< MP3 码流（其他采样率自动重采样，如 44.1/48/24 kHz；立体声自动下混）
+    AUDIO_MGR_CODEC_ADPCM,              ///< IMA-ADPCM 4bit 单声道
+} audio_mgr_codec_t;
+
+/** PCM 播放格式（audio_manager_play_audio_format） */
+typedef struct {
+    uint32_t sample_rate;               ///< 采样率（8000-48000，如 44100/48000 的音乐、8000 的电话语音）
+    uint8_t channels;                   ///< 声道数（1 或 2，立体声交织，自动下混）
+} audio_mgr_pcm_format_t;
+
+/** 播放流数量上限（含主流 0） */
+#define AUDIO_MANAGER_MAX_STREAMS       4
+
+/** 播放流配置（流 0 为主流：play_audio/play_encoded 的目标） */
+typedef struct {
+    size_t buffer_bytes;                ///< 流缓冲区大小（字节，0 表示不启用；主流使用 pcm_buffer_bytes）
+    uint8_t priority;                   ///< 优先级（越大越高），有更高优先级流在播放时本流被闪避
+    uint8_t gain;                       ///< 流增益（0-100）
+} audio_mgr_stream_config_t;
+
+/** 打断（barge-in）策略：播放中检测到唤醒词/人声时的处理 */
+typedef enum {
+    AUDIO_MGR_BARGE_IN_OFF = 0,         ///< 不处理，播放继续（由应用自行停止，默认）
+    AUDIO_MGR_BARGE_IN_DUCK,            ///< 闪避：播放继续但降到 duck_gain，录音结束后恢复
+    AUDIO_MGR_BARGE_IN_STOP,            ///< 停止：fade_ms 内淡出并丢弃待播放数据，录音结束后自动恢复播放（之后写入的数据照常播放）
+} audio_mgr_barge_in_mode_t;
+
+/** 打断配置 */
+typedef struct {
+    audio_mgr_barge_in_mode_t mode;     ///< 打断策略
+    bool on_wake_word;                  ///< 唤醒词触发打断
+    bool on_vad_start;                  ///< 人声开始触发打断（AEC 残余回声可能误触发，默认关闭）
+    uint16_t fade_ms;                   ///< STOP 策略的淡出时长（毫秒，0 表示一帧）
+} audio_mgr_barge_in_config_t;
+
+/** 播放配置（应用层提供） */
+typedef struct {
+    audio_mgr_overrun_policy_t overrun_policy;  ///< 播放缓冲区满时的处理策略
+    uint32_t write_timeout_ms;                  ///< BLOCK 策略下的最长等待时间
+    size_t pcm_buffer_bytes;                    ///< PCM 播放缓冲区大小（字节，0 使用默认值）
+    size_t encoded_buffer_bytes;                ///< 压缩数据缓冲区大小（字节，0 表示不启用压缩播放）
+    bool format_convert;                        ///< 是否启用 audio_manager_play_audio_format()（重采样器约 7KB）
+    audio_mgr_stream_config_t streams[AUDIO_MANAGER_MAX_STREAMS]; ///< 播放流（启用流 1 及以后即在播放任务中混音）
+    uint8_t duck_gain;                          ///< 闪避增益（0-100），低优先级流被闪避时乘以该增益
+    audio_mgr_barge_in_config_t barge_in;       ///< 打断配置
+} audio_mgr_playback_config_t;
+
+/** 录音编码配置（应用层提供，编码包通过 audio_manager_set_encoded_record_callback 回调） */
+typedef struct {
+    bool enabled;                   ///< 是否启用录音编码
+    audio_mgr_codec_t codec;        ///< 编码格式（支持 OPUS、ADPCM）
+    uint16_t frame_ms;              ///< 每包帧长（毫秒，Opus 支持 10/20/40/60）
+    uint32_t bitrate;               ///< 码率（bps，Opus 有效）
+} audio_mgr_record_encode_config_t;
+
+/** 内存配置（应用层提供） */
+typedef struct {
+    bool use_arena;                 ///< 内存区模式：初始化时按配置一次性预分配全部管线内存
+                                    ///< （CONFIG_AUDIO_MANAGER_STATIC_ALLOC 开启时强制为 true）
+} audio_mgr_memory_config_t;
+
+/** 功耗配置（应用层提供） */
+typedef struct {
+    bool low_power_listen;          ///< 空闲监听（无唤醒、无录音、无播放）时切换到低功耗档位
+    uint32_t listen_dma_frame_num;  ///< 低功耗档位下 I2S RX DMA 帧长（采样数，0 保持默认）
+} audio_mgr_power_config_t;
+
+/** 任务放置：AUDIO_MANAGER_CORE_AUTO 表示按 WiFi 所在核自动选择 */
+#define AUDIO_MANAGER_CORE_AUTO     (-1)
+
+/**
+ * 管线任务绑核（创建任务时确定，运行中不迁移）
+ *
+ * 自动放置：实时路径（AFE feed、播放）放在 WiFi 协议栈之外的核，
+ * 非实时路径（AFE fetch、状态机、录音编码）与 WiFi 共核；单核配置全部在核 0。
+ */
+typedef struct {
+    int8_t afe_feed_core;           ///< AFE feed 任务
+    int8_t afe_fetch_core;          ///< AFE fetch 任务
+    int8_t playback_core;           ///< 播放任务
+    int8_t manager_core;            ///< 状态机任务
+    int8_t encoder_core;            ///< 录音编码任务
+} audio_mgr_task_placement_t;
+
+/**
+ * 负载调节器配置（应用层提供）
+ *
+ * 默认关闭，行为与未引入调节器时一致。需要时由应用层显式开启：
+ * @code
+ * cfg.governor_config.enabled = true;          // 过载时关闭 NS/AGC
+ * cfg.governor_config.allow_low_cost = true;   // 允许再切到 LOW_COST（热重建 AFE，期间丢弃麦克风数据）
+ * @endcode
+ */
+typedef struct {
+    bool enabled;                   ///< 是否启用负载调节（默认 false）
+    uint32_t interval_ms;           ///< 采样周期（毫秒）
+    uint8_t overload_pct;           ///< 负载达到该比例视为过载
+    uint8_t recover_pct;            ///< 负载低于该比例视为空闲（须小于 overload_pct）
+    uint16_t backlog_ms;            ///< AFE 积压超过该时长视为过载
+    uint8_t degrade_windows;        ///< 连续过载多少个周期降一级
+    uint8_t recover_windows;        ///< 连续空闲多少个周期升一级
+    uint32_t min_free_internal;     ///< 内部 RAM 空闲低于该值时暂缓需要重建 AFE 的调整（0 不检查）
+    bool allow_low_cost;            ///< 允许降到 LOW_COST afe_mode（默认 false，否则最多关闭 NS/AGC）
+} audio_mgr_governor_config_t;
+
+/** 管线内存占用（内存区模式） */
+typedef struct {
+    size_t internal_bytes;          ///< 内部 RAM（DMA 可用）：上下文、任务栈/TCB、队列、I2S 缓冲
+    size_t psram_bytes;             ///< PSRAM：播放/回采环形缓冲区
+} audio_mgr_footprint_t;
+
+/** 单个缓冲区的运行统计 */
+typedef struct {
+    uint32_t overrun_samples;       ///< 被覆盖丢弃的采样点数
+    uint32_t rejected_samples;      ///< 被拒绝写入的采样点数
+    uint32_t underrun_reads;        ///< 数据不足的读取次数
+    uint32_t lock_timeouts;         ///< 获取互斥锁超时次数
+    size_t high_water;              ///< 历史最高占用量（采样点数）
+    size_t level;                   ///< 当前占用量（采样点数）
+    size_t capacity;                ///< 缓冲区容量（采样点数）
+} audio_mgr_buffer_stats_t;
+
+/** 回采对齐统计 */
+typedef struct {
+    int32_t ref_offset_us;          ///< 当前补偿量：回采播出时刻相对麦克风采集时刻的偏移
+    uint32_t padded_samples;        ///< 回采不完整的帧中补静音的采样点数
+    uint32_t dropped_samples;       ///< 已过期丢弃的回采采样点数
+    uint32_t delay_updates;         ///< 自动延迟修正次数
+} audio_mgr_aec_stats_t;
+
+/** 内部事件环统计 */
+typedef struct {
+    uint32_t posted;                ///< 已投递事件数（即下一个事件的序号）
+    uint32_t dropped;               ///< 环满丢弃的事件数
+    uint32_t high_water;            ///< 历史最高积压事件数
+    uint32_t capacity;              ///< 事件环容量
+} audio_mgr_event_stats_t;
+
+/** 负载调节器统计 */
+typedef struct {
+    audio_mgr_gov_level_t level;    ///< 当前档位
+    uint8_t feed_load_pct;          ///< 最近周期 Feed 负载
+    uint8_t fetch_load_pct;         ///< 最近周期 Fetch 回调负载
+    uint16_t backlog_ms;            ///< 最近一次采样的 AFE 积压
+    uint32_t feed_misses;           ///< 累计 Feed 超时帧数
+    uint32_t fetch_misses;          ///< 累计 Fetch 停顿次数
+    uint32_t degrades;              ///< 累计降级次数
+    uint32_t recoveries;            ///< 累计恢复次数
+    uint32_t memory_holds;          ///< 因内存不足暂缓调整的次数
+} audio_mgr_governor_stats_t;
+
+/** 音频管理器运行统计 */
+typedef struct {
+    audio_mgr_buffer_stats_t playback;  ///< 播放缓冲区
+    audio_mgr_buffer_stats_t reference; ///< 回采缓冲区（AEC 参考信号）
+    audio_mgr_aec_stats_t aec;          ///< 回采对齐
+    audio_mgr_event_stats_t events;     ///< 内部事件环
+    audio_mgr_governor_stats_t governor; ///< 负载调节器（未启用时全为 0）
+} audio_mgr_stats_t;
+
+/** 单项延迟统计（微秒，滚动窗口约最近 1000 个样本） */
+typedef struct {
+    uint32_t count;                 ///< 窗口内样本数
+    uint32_t p50_us;                ///< 中位数
+    uint32_t p99_us;                ///< 99 分位
+    uint32_t max_us;                ///< 最大值（自上次重置）
+} audio_mgr_latency_t;
+
+/** 管线延迟统计（需先 audio_manager_set_trace_enabled(true)） */
+typedef struct {
+    audio_mgr_latency_t mic_to_callback;    ///< 麦克风采样读出 -> AFE 输出回调
+    audio_mgr_latency_t play_to_speaker;    ///< play_audio 写入 -> I2S TX 写入完成（仅 PCM 播放）
+    audio_mgr_latency_t event_dispatch;     ///< 唤醒/VAD/按键事件发生 -> 状态机处理
+    audio_mgr_latency_t feed_cpu;           ///< 每帧 AFE feed 耗时
+    audio_mgr_latency_t fetch_cpu;          ///< 每帧 AFE 结果回调耗时（含录音回调）
+} audio_mgr_latency_stats_t;
+
+/** 任务栈报告最多包含的任务数 */
+#define AUDIO_MANAGER_MAX_TASKS 5
+
+/** 单个任务的栈使用情况 */
+typedef struct {
+    const char *name;               ///< 任务名
+    uint32_t stack_bytes;           ///< 栈大小（字节）
+    uint32_t stack_free_min;        ///< 运行以来最小剩余栈（字节，高水位）
+    bool stack_in_psram;            ///< 栈位于 PSRAM
+    bool is_static;                 ///< 栈与 TCB 静态分配（来自内存区）
+} audio_mgr_task_stats_t;
+
+/** 全部管线任务的栈报告 */
+typedef struct {
+    uint8_t count;                  ///< 有效任务数
+    audio_mgr_task_stats_t tasks[AUDIO_MANAGER_MAX_TASKS];
+} audio_mgr_task_report_t;
+
 /** 音频管理器配置（应用层组装） */
 typedef struct {
     audio_mgr_hw_config_t      hw_config;       ///< 硬件配置
     audio_mgr_wakeup_config_t  wakeup_config;   ///< 唤醒词配置
     audio_mgr_vad_config_t     vad_config;      ///< VAD配置
     audio_mgr_afe_config_t     afe_config;      ///< AFE配置
+    audio_mgr_playback_config_t playback_config; ///< 播放配置
+    audio_mgr_record_encode_config_t record_encode_config; ///< 录音编码配置
+    audio_mgr_memory_config_t  memory_config;   ///< 内存配置
+    audio_mgr_power_config_t   power_config;    ///< 功耗配置
+    audio_mgr_task_placement_t task_placement;  ///< 任务绑核
+    audio_mgr_governor_config_t governor_config; ///< 负载调节器配置
     audio_mgr_event_cb_t       event_callback;  ///< 事件回调
     audio_mgr_state_cb_t       state_callback;  ///< 状态机回调
     void                      *user_ctx;        ///< 用户上下文
@@ -125,12 +375,14 @@ typedef struct {
             .port = 0, .bclk_gpio = -1, .lrck_gpio = -1, .din_gpio = -1, \
             .sample_rate = 16000, .bits = 32,                        \
             .max_frame_samples = 512, .bit_shift = 14,               \
+            .mic_num = 1, .gain = { 1.0f, 1.0f },                    \
         },                                                           \
         .speaker = {                                                 \
             .port = 0, .bclk_gpio = -1, .lrck_gpio = -1, .dout_gpio = -1, \
             .sample_rate = 16000, .bits = 16,                        \
             .max_frame_samples = AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES,\
         },                                                           \
+        .full_duplex = false,                                        \
         .button = { .gpio = -1, .active_low = true },                \
     }
 
@@ -138,6 +390,7 @@ typedef struct {
     (audio_mgr_wakeup_config_t){                                     \
         .enabled = true,                                             \
         .wake_word_name = "小鸭小鸭",                                \
+        .wake_model_name = NULL,                                     \
         .model_partition = "model",                                  \
         .sensitivity = 2,                                            \
         .wakeup_timeout_ms = 8000,                                   \
@@ -158,6 +411,71 @@ typedef struct {
         .ns_enabled = true,                                          \
         .agc_enabled = true,                                         \
         .afe_mode = 1,                                               \
+        .input_format = NULL,                                        \
+        .aec_playback_only = false,                                  \
+        .aec_ref_lead_ms = 2,                                        \
+        .aec_auto_delay = true,                                      \
+        .preroll_ms = 500,                                           \
+    }
+
+#define AUDIO_MANAGER_DEFAULT_PLAYBACK_CONFIG()                      \
+    (audio_mgr_playback_config_t){                                   \
+        .overrun_policy = AUDIO_MGR_OVERRUN_OVERWRITE,               \
+        .write_timeout_ms = 100,                                     \
+        .pcm_buffer_bytes = AUDIO_MANAGER_PLAYBACK_BUFFER_BYTES,     \
+        .encoded_buffer_bytes = 0,                                   \
+        .format_convert = true,                                      \
+        .streams = {                                                 \
+            [0] = { .buffer_bytes = 0, .priority = 0, .gain = 100 }, \
+        },                                                           \
+        .duck_gain = 30,                                             \
+        .barge_in = {                                                \
+            .mode = AUDIO_MGR_BARGE_IN_OFF,                          \
+            .on_wake_word = true,                                    \
+            .on_vad_start = false,                                   \
+            .fade_ms = 20,                                           \
+        },                                                           \
+    }
+
+#define AUDIO_MANAGER_DEFAULT_RECORD_ENCODE_CONFIG()                 \
+    (audio_mgr_record_encode_config_t){                              \
+        .enabled = false,                                            \
+        .codec = AUDIO_MGR_CODEC_OPUS,                               \
+        .frame_ms = 20,                                              \
+        .bitrate = 24000,                                            \
+    }
+
+#define AUDIO_MANAGER_DEFAULT_MEMORY_CONFIG()                        \
+    (audio_mgr_memory_config_t){                                     \
+        .use_arena = false,                                          \
+    }
+
+#define AUDIO_MANAGER_DEFAULT_POWER_CONFIG()                         \
+    (audio_mgr_power_config_t){                                      \
+        .low_power_listen = false,                                   \
+        .listen_dma_frame_num = 512,                                 \
+    }
+
+#define AUDIO_MANAGER_DEFAULT_TASK_PLACEMENT()                       \
+    (audio_mgr_task_placement_t){                                    \
+        .afe_feed_core = AUDIO_MANAGER_CORE_AUTO,                    \
+        .afe_fetch_core = AUDIO_MANAGER_CORE_AUTO,                   \
+        .playback_core = AUDIO_MANAGER_CORE_AUTO,                    \
+        .manager_core = AUDIO_MANAGER_CORE_AUTO,                     \
+        .encoder_core = AUDIO_MANAGER_CORE_AUTO,                     \
+    }
+
+#define AUDIO_MANAGER_DEFAULT_GOVERNOR_CONFIG()                      \
+    (audio_mgr_governor_config_t){                                   \
+        .enabled = false,                                            \
+        .interval_ms = 500,                                          \
+        .overload_pct = 85,                                          \
+        .recover_pct = 50,                                           \
+        .backlog_ms = 200,                                           \
+        .degrade_windows = 2,                                        \
+        .recover_windows = 10,                                       \
+        .min_free_internal = 24 * 1024,                              \
+        .allow_low_cost = false,                                     \
     }
 
 #define AUDIO_MANAGER_DEFAULT_CONFIG()                               \
@@ -166,6 +484,12 @@ typedef struct {
         .wakeup_config = AUDIO_MANAGER_DEFAULT_WAKEUP_CONFIG(),      \
         .vad_config = AUDIO_MANAGER_DEFAULT_VAD_CONFIG(),            \
         .afe_config = AUDIO_MANAGER_DEFAULT_AFE_CONFIG(),            \
+        .playback_config = AUDIO_MANAGER_DEFAULT_PLAYBACK_CONFIG(),  \
+        .record_encode_config = AUDIO_MANAGER_DEFAULT_RECORD_ENCODE_CONFIG(), \
+        .memory_config = AUDIO_MANAGER_DEFAULT_MEMORY_CONFIG(),      \
+        .power_config = AUDIO_MANAGER_DEFAULT_POWER_CONFIG(),        \
+        .task_placement = AUDIO_MANAGER_DEFAULT_TASK_PLACEMENT(),    \
+        .governor_config = AUDIO_MANAGER_DEFAULT_GOVERNOR_CONFIG(),  \
         .event_callback = NULL,                                      \
         .state_callback = NULL,                                      \
         .user_ctx = NULL,                                            \
@@ -180,11 +504,44 @@ typedef struct {
  */
 esp_err_t audio_manager_init(const audio_mgr_config_t *config);
 
+/**
+ * @brief 计算内存区模式下的管线内存占用（无需初始化）
+ * @param config 配置参数
+ * @param footprint 输出占用
+ * @return ESP_OK 成功
+ * @note 不含 esp-sr 模型与 AFE Manager 内部分配，以及 I2S 驱动的 DMA 描述符
+ */
+esp_err_t audio_manager_get_footprint(const audio_mgr_config_t *config, audio_mgr_footprint_t *footprint);
+
+/**
+ * @brief 预加载唤醒词模型（无需初始化，可与 WiFi 等启动阶段并行）
+ *
+ * 加载的模型在 audio_manager_deinit() 后保留，重新初始化时直接复用。
+ *
+ * @param config 配置参数（未启用唤醒词时直接返回 ESP_OK）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 已加载其他分区；ESP_FAIL 加载失败
+ * @note 不可与 audio_manager_init()/audio_manager_deinit() 并发调用
+ */
+esp_err_t audio_manager_preload_models(const audio_mgr_config_t *config);
+
+/**
+ * @brief 释放预加载的唤醒词模型（需先 audio_manager_deinit()）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 仍在使用
+ */
+esp_err_t audio_manager_release_models(void);
+
 /**
  * @brief 反初始化音频管理器
  */
 void audio_manager_deinit(void);
 
+/**
+ * @brief 获取 WiFi 协议栈所在核（自动放置时非实时任务与其共核）
+ * @return 核编号（单核配置为 0）
+ * @note 应用层可将 WiFi 管理、HTTP 服务等网络任务绑到该核，使另一核专供实时音频
+ */
+int audio_manager_get_network_core(void);
+
 /**
  * @brief 启动音频管理器（开始监听唤醒词）
  * @return ESP_OK 成功
@@ -206,14 +563,15 @@ esp_err_t audio_manager_trigger_conversation(void);
 
 /**
  * @brief 开始录音（用于对话）
- * @note 录音数据会通过audio_record_callback回调返回
- * @return ESP_OK 成功
+ * @note 录音数据会通过audio_record_callback回调返回；异步执行，由状态机任务修改状态
+ * @return ESP_OK 已投递，ESP_FAIL 事件环已满
  */
 esp_err_t audio_manager_start_recording(void);
 
 /**
  * @brief 停止录音
- * @return ESP_OK 成功
+ * @note 异步执行，由状态机任务修改状态
+ * @return ESP_OK 已投递，ESP_FAIL 事件环已满
  */
 esp_err_t audio_manager_stop_recording(void);
 
@@ -221,10 +579,68 @@ esp_err_t audio_manager_stop_recording(void);
  * @brief 播放音频数据（播放器接口）
  * @param pcm_data PCM数据（16bit, 16kHz, 单声道）
  * @param sample_count 采样点数
- * @return ESP_OK 成功
+ * @return ESP_OK 成功；ESP_ERR_NO_MEM 缓冲区已满（REJECT 策略）；
+ *         ESP_ERR_TIMEOUT 等待空间超时（BLOCK 策略）。出错时数据未写入，可稍后重试
+ * @note 播放缓冲区为无锁单生产者模式，请在同一个任务中调用
  */
 esp_err_t audio_manager_play_audio(const int16_t *pcm_data, size_t sample_count);
 
+/**
+ * @brief 按指定格式播放 PCM（重采样到扬声器采样率并下混为单声道后写入播放缓冲区）
+ * @param pcm_data PCM 数据（16bit，多声道交织）
+ * @param frames 帧数（每帧 channels 个采样）
+ * @param format 输入格式，与扬声器格式一致时等同 audio_manager_play_audio()
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未启用 format_convert 或格式不支持；
+ *         ESP_ERR_NO_MEM/ESP_ERR_TIMEOUT 缓冲区已满，数据未写入，可稍后重试
+ * @note 与 audio_manager_play_audio() 共用单生产者播放缓冲区，请在同一个任务中调用
+ */
+esp_err_t audio_manager_play_audio_format(const int16_t *pcm_data, size_t frames,
+                                          const audio_mgr_pcm_format_t *format);
+
+/**
+ * @brief 播放音频数据到指定播放流（与其他流在播放任务中混音）
+ * @param stream 流编号（0 等同 audio_manager_play_audio()）
+ * @param pcm_data PCM数据（16bit, 16kHz, 单声道）
+ * @param sample_count 采样点数
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 流未启用；
+ *         ESP_ERR_NO_MEM/ESP_ERR_TIMEOUT 缓冲区已满，数据未写入，可稍后重试
+ * @note 每个流各自为单生产者，不同流可在不同任务中写入（如提示音与 TTS）
+ */
+esp_err_t audio_manager_play_stream(uint8_t stream, const int16_t *pcm_data, size_t sample_count);
+
+/**
+ * @brief 设置播放流增益
+ * @param stream 流编号
+ * @param gain 增益（0-100）
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 流未启用
+ */
+esp_err_t audio_manager_set_stream_gain(uint8_t stream, uint8_t gain);
+
+/**
+ * @brief 清空指定播放流（其余流继续播放）
+ * @param stream 流编号
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 流未启用
+ */
+esp_err_t audio_manager_clear_stream(uint8_t stream);
+
+/**
+ * @brief 获取指定播放流可用空间（样本数）
+ * @param stream 流编号
+ * @return 可用空间（样本数），流未启用返回 0
+ */
+size_t audio_manager_get_stream_free_space(uint8_t stream);
+
+/**
+ * @brief 播放压缩音频数据（在播放任务中按帧增量解码）
+ * @param codec 压缩格式
+ * @param data 压缩数据（Opus 每次一个完整包，ADPCM 每次完整块，MP3 可任意切分）
+ * @param len 字节数
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未配置 encoded_buffer_bytes；
+ *         ESP_ERR_NO_MEM/ESP_ERR_TIMEOUT 缓冲区已满，数据未写入，可稍后重试
+ * @note 启用压缩播放后可把 pcm_buffer_bytes 调小（如 32KB），播放内存约为原来的 1/10
+ */
+esp_err_t audio_manager_play_encoded(audio_mgr_codec_t codec, const uint8_t *data, size_t len);
+
 /**
  * @brief 获取播放缓冲区可用空间（样本数）
  * 
@@ -236,19 +652,22 @@ size_t audio_manager_get_playback_free_space(void);
 
 /**
  * @brief 开始播放（启动播放任务）
- * @return ESP_OK 成功
+ * @note 由状态机任务启动播放控制器并等待结果；返回 ESP_OK 后 audio_manager_is_playing() 为 true，
+ *       之前写入的数据不受影响
+ * @return ESP_OK 成功，ESP_FAIL 事件环已满，ESP_ERR_TIMEOUT 等待超时，其他为播放控制器的错误码
  */
 esp_err_t audio_manager_start_playback(void);
 
 /**
  * @brief 停止播放
- * @return ESP_OK 成功
+ * @note 由状态机任务停止播放控制器并等待结果
+ * @return ESP_OK 成功，ESP_FAIL 事件环已满，ESP_ERR_TIMEOUT 等待超时，其他为播放控制器的错误码
  */
 esp_err_t audio_manager_stop_playback(void);
 
 /**
  * @brief 清空播放缓冲区（用于打断场景）
- * @note 立即清空所有待播放的音频数据
+ * @note 立即清空所有播放流中待播放的音频数据
  * @return ESP_OK 成功
  */
 esp_err_t audio_manager_clear_playback_buffer(void);
@@ -268,7 +687,10 @@ uint8_t audio_manager_get_volume(void);
 /**
  * @brief 动态更新唤醒词配置（后期网页配置用）
  * @param config 新的唤醒词配置
- * @return ESP_OK 成功
+ * @return ESP_OK 成功；AFE 重建失败返回对应错误（保持原唤醒词）；
+ *         ESP_ERR_TIMEOUT 等待状态机任务超时（配置仍会在之后生效）
+ * @note 更换 wake_model_name 会热重建 AFE，映射模式下只映射新选择的模型
+ * @note 由状态机任务执行，调用方阻塞等待结果；字符串字段须在调用后保持有效
  */
 esp_err_t audio_manager_update_wakeup_config(const audio_mgr_wakeup_config_t *config);
 
@@ -279,6 +701,32 @@ esp_err_t audio_manager_update_wakeup_config(const audio_mgr_wakeup_config_t *co
  */
 esp_err_t audio_manager_get_wakeup_config(audio_mgr_wakeup_config_t *config);
 
+/**
+ * @brief 运行时更新 AFE 功能配置（不重新加载模型）
+ * @param config 新的 AFE 配置
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 等待状态机任务超时；其他为 AFE 热重建失败
+ * @note 由状态机任务执行，调用方阻塞等待结果
+ * @note AEC/NS/AGC 开关即时生效无中断；afe_mode 变化或开启初始化时未启用的功能会热重建 AFE，
+ *       麦克风数据短暂中断。aec_ref_lead_ms/aec_auto_delay/preroll_ms 仅在初始化时生效
+ */
+esp_err_t audio_manager_update_afe_config(const audio_mgr_afe_config_t *config);
+
+/**
+ * @brief 获取当前 AFE 功能配置
+ * @param config 输出配置
+ * @return ESP_OK 成功
+ */
+esp_err_t audio_manager_get_afe_config(audio_mgr_afe_config_t *config);
+
+/**
+ * @brief 运行时更新 VAD 配置
+ * @param config 新的 VAD 配置
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 等待状态机任务超时；其他为 AFE 热重建失败
+ * @note 由状态机任务执行，调用方阻塞等待结果
+ * @note 仅开关 VAD 时无中断；vad_mode 或时长参数变化会热重建 AFE
+ */
+esp_err_t audio_manager_update_vad_config(const audio_mgr_vad_config_t *config);
+
 /**
  * @brief 检查音频管理器是否正在运行
  * @return true 运行中
@@ -303,6 +751,67 @@ bool audio_manager_is_playing(void);
  */
 audio_mgr_state_t audio_manager_get_state(void);
 
+/**
+ * @brief 是否处于低功耗监听档位
+ * @return true 仅运行唤醒词检测（AEC/NS/AGC/VAD 已关闭，CPU 可降频）
+ * @note 需在 power_config 中启用 low_power_listen；唤醒、录音或播放时自动切回完整管线，
+ *       低功耗档位下 VAD 关闭，只能通过唤醒词或按键开始录音
+ */
+bool audio_manager_is_low_power(void);
+
+/**
+ * @brief 获取播放/回采缓冲区运行统计
+ * @param stats 输出统计数据
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t audio_manager_get_stats(audio_mgr_stats_t *stats);
+
+/**
+ * @brief 获取当前录音段第一个采样的流位置
+ * @return 流位置（采样点数，含预录数据），未初始化返回 0
+ * @note event->sample_pos 减去该值即为事件在本段录音中的采样偏移
+ */
+uint64_t audio_manager_get_record_start_pos(void);
+
+/**
+ * @brief 开启/关闭管线延迟跟踪（默认关闭）
+ * @param enabled true 开启
+ */
+void audio_manager_set_trace_enabled(bool enabled);
+
+/**
+ * @brief 获取管线延迟统计（p50/p99）
+ * @param stats 输出统计
+ * @return ESP_OK 成功
+ */
+esp_err_t audio_manager_get_latency_stats(audio_mgr_latency_stats_t *stats);
+
+/**
+ * @brief 清空延迟统计
+ */
+void audio_manager_reset_latency_stats(void);
+
+/**
+ * @brief 打印延迟统计与最近的跟踪点到日志
+ */
+void audio_manager_dump_trace(void);
+
+/**
+ * @brief 获取各管线任务的栈大小与高水位
+ *
+ * 包含状态机、播放、录音编码（启用时）与 AFE Feed/Fetch 任务；
+ * AFE 任务在管线首帧前尚未记录句柄，此时不计入报告。
+ *
+ * @param report 输出报告
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t audio_manager_get_task_report(audio_mgr_task_report_t *report);
+
+/**
+ * @brief 打印任务栈报告到日志（用于确定栈大小余量）
+ */
+void audio_manager_dump_task_report(void);
+
 // ============ 录音数据回调（应用层实现） ============
 
 /**
@@ -321,6 +830,23 @@ typedef void (*audio_record_callback_t)(const int16_t *pcm_data, size_t sample_c
  */
 void audio_manager_set_record_callback(audio_record_callback_t callback, void *user_ctx);
 
+/**
+ * @brief 编码录音数据回调函数类型
+ * @param data 编码包（Opus 每次一个完整包）
+ * @param len 字节数
+ * @param user_ctx 用户上下文
+ * @note 在编码任务中调用（与 AFE Fetch 同核），不占用 PCM 录音回调路径
+ */
+typedef void (*audio_encoded_record_callback_t)(const uint8_t *data, size_t len, void *user_ctx);
+
+/**
+ * @brief 注册编码录音数据回调（需在配置中启用 record_encode_config）
+ * @param callback 回调函数，NULL 表示停止输出编码包
+ * @param user_ctx 用户上下文
+ * @note 每段录音结束时剩余数据补静音编成最后一包
+ */
+void audio_manager_set_encoded_record_callback(audio_encoded_record_callback_t callback, void *user_ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,103 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 10:20:15
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 10:20:15
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_resampler.h
+ * @Description: 采样率转换 - 多相 FIR 重采样与声道下混（16bit PCM -> 单声道输出采样率）
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "audio_arena.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最大输入声道数 */
+#define AUDIO_RESAMPLER_MAX_CHANNELS    2
+/** 最大降采样倍数（输入采样率 / 输出采样率，如 48kHz -> 16kHz 为 3） */
+#define AUDIO_RESAMPLER_MAX_DECIMATION  3
+
+/** 重采样器句柄 */
+typedef struct audio_resampler_s *audio_resampler_handle_t;
+
+/** 重采样器配置 */
+typedef struct {
+    uint32_t out_rate;              ///< 输出采样率（单声道）
+    audio_arena_handle_t arena;     ///< 内存区（可选，NULL 使用堆分配）
+} audio_resampler_config_t;
+
+#define AUDIO_RESAMPLER_DEFAULT_CONFIG(rate)                        \
+    (audio_resampler_config_t){                                      \
+        .out_rate = (rate),                                          \
+        .arena = NULL,                                               \
+    }
+
+/**
+ * @brief 创建重采样器（系数表与工作缓冲按最大规格一次分配，切换输入格式不再分配内存）
+ * @param config 配置参数
+ * @return 句柄，失败返回 NULL
+ */
+audio_resampler_handle_t audio_resampler_create(const audio_resampler_config_t *config);
+
+/**
+ * @brief 累加创建重采样器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void audio_resampler_get_footprint(const audio_resampler_config_t *config, audio_arena_footprint_t *fp);
+
+/**
+ * @brief 销毁重采样器
+ * @param rs 句柄
+ */
+void audio_resampler_destroy(audio_resampler_handle_t rs);
+
+/**
+ * @brief 设置输入格式（格式变化时重新生成系数并清空历史）
+ * @param rs 句柄
+ * @param in_rate 输入采样率
+ * @param channels 输入声道数（交织，下混为单声道）
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 声道数或降采样倍数超出范围
+ * @note 格式未变化时直接返回，保持流连续
+ */
+esp_err_t audio_resampler_set_input(audio_resampler_handle_t rs, uint32_t in_rate, uint8_t channels);
+
+/**
+ * @brief 清空历史数据（新的音频流开始时调用）
+ * @param rs 句柄
+ */
+void audio_resampler_reset(audio_resampler_handle_t rs);
+
+/**
+ * @brief 计算再输入 frames 帧后可输出的采样点数
+ * @param rs 句柄
+ * @param frames 输入帧数
+ * @return 输出采样点数（与随后 audio_resampler_process() 输出的总数一致）
+ */
+size_t audio_resampler_get_output_size(audio_resampler_handle_t rs, size_t frames);
+
+/**
+ * @brief 转换一段输入
+ * @param rs 句柄
+ * @param in 输入（16bit 交织 PCM）
+ * @param frames 输入帧数
+ * @param consumed 输出已消耗的输入帧数（输出空间用完时可能小于 frames）
+ * @param out 输出（16bit 单声道）
+ * @param out_cap 输出空间（采样点数）
+ * @return 实际输出的采样点数
+ * @note 单生产者使用，不可并发调用
+ */
+size_t audio_resampler_process(audio_resampler_handle_t rs, const int16_t *in, size_t frames,
+                               size_t *consumed, int16_t *out, size_t out_cap);
+
+#ifdef __cplusplus
+}
+#endif
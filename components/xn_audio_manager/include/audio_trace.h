@@ -0,0 +1,115 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-05 10:12:47
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-05 10:12:47
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\audio_trace.h
+ * @Description: 音频管线跟踪 - 关键节点打点、按采样位置计算延迟、滚动直方图统计 p50/p99
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 跟踪点 */
+typedef enum {
+    AUDIO_TRACE_MIC_READ = 0,       ///< I2S RX 读取完成（pos = 送入 AFE 的累计采样数）
+    AUDIO_TRACE_AFE_FEED,           ///< 数据交给 AFE feed（pos 同上）
+    AUDIO_TRACE_AFE_FETCH,          ///< AFE 输出到达 afe_result_callback（pos = AFE 输出累计采样数）
+    AUDIO_TRACE_RECORD_CB,          ///< 录音回调返回（pos 同上）
+    AUDIO_TRACE_EVENT_POST,         ///< 事件投递到状态机队列（pos = 内部事件类型）
+    AUDIO_TRACE_EVENT_RECV,         ///< 状态机任务取出事件（pos = 内部事件类型）
+    AUDIO_TRACE_PLAY_WRITE,         ///< play_audio 写入播放缓冲区（pos = 累计写入采样数）
+    AUDIO_TRACE_PLAY_READ,          ///< 播放任务取出一帧（pos = 累计读取采样数）
+    AUDIO_TRACE_SPK_WRITE,          ///< I2S TX 写入完成（pos 同上）
+    AUDIO_TRACE_POINT_MAX,
+} audio_trace_point_t;
+
+/** 统计指标 */
+typedef enum {
+    AUDIO_TRACE_LAT_MIC_TO_CALLBACK = 0,    ///< 麦克风采样读出 -> AFE 输出回调
+    AUDIO_TRACE_LAT_PLAY_TO_SPEAKER,        ///< play_audio 写入 -> I2S TX 写入完成
+    AUDIO_TRACE_LAT_EVENT_DISPATCH,         ///< 事件发生 -> 状态机任务处理
+    AUDIO_TRACE_CPU_FEED,                   ///< 每帧 AFE feed 耗时（两次读取回调之间）
+    AUDIO_TRACE_CPU_FETCH,                  ///< 每帧结果回调耗时（事件、预录、录音回调）
+    AUDIO_TRACE_METRIC_MAX,
+} audio_trace_metric_t;
+
+/** 指标摘要（单位微秒，分位值为直方图桶中值，精度约 ±6%） */
+typedef struct {
+    uint32_t count;     ///< 窗口内样本数（超过窗口后旧样本按半衰减）
+    uint32_t p50_us;    ///< 中位数
+    uint32_t p99_us;    ///< 99 分位
+    uint32_t max_us;    ///< 自上次重置以来的最大值
+    uint32_t last_us;   ///< 最近一次的值
+} audio_trace_summary_t;
+
+/**
+ * @brief 开启/关闭跟踪（默认关闭，关闭时各打点只做一次判断）
+ * @param enabled true 开启
+ */
+void audio_trace_set_enabled(bool enabled);
+
+/**
+ * @brief 是否已开启跟踪
+ * @return true 已开启
+ */
+bool audio_trace_is_enabled(void);
+
+/**
+ * @brief 获取当前时间戳（微秒，开启跟踪时有效，否则返回 0 以省去取时）
+ * @return esp_timer 时间的低 32 位
+ */
+uint32_t audio_trace_now(void);
+
+/**
+ * @brief 打点：写入跟踪日志；MIC_READ/PLAY_WRITE 同时记录"采样位置 pos 在此刻可用"
+ * @param point 跟踪点
+ * @param pos 采样位置或附加值（见 audio_trace_point_t）
+ */
+void audio_trace_mark(audio_trace_point_t point, uint32_t pos);
+
+/**
+ * @brief 按采样位置计算延迟：当前时刻减去 from 点上 pos 位置采样可用的时刻
+ * @param metric 统计指标
+ * @param from 起点（仅 MIC_READ/PLAY_WRITE 有位置记录）
+ * @param pos 采样位置（累计计数，从 1 开始即第 pos 个采样）
+ * @note 位置记录已被覆盖（过旧）时忽略本次
+ */
+void audio_trace_latency(audio_trace_metric_t metric, audio_trace_point_t from, uint32_t pos);
+
+/**
+ * @brief 记录一个耗时/延迟样本
+ * @param metric 统计指标
+ * @param us 微秒
+ */
+void audio_trace_record(audio_trace_metric_t metric, uint32_t us);
+
+/**
+ * @brief 获取指标摘要
+ * @param metric 统计指标
+ * @param summary 输出摘要
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_trace_get_summary(audio_trace_metric_t metric, audio_trace_summary_t *summary);
+
+/**
+ * @brief 清空全部统计与跟踪日志
+ */
+void audio_trace_reset(void);
+
+/**
+ * @brief 打印各指标摘要与最近的跟踪日志
+ */
+void audio_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
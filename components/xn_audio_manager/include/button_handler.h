@@ -12,6 +12,7 @@
 
 #include "esp_err.h"
 #include "driver/gpio.h"
+#include "audio_arena.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -25,7 +26,11 @@ typedef enum {
     BUTTON_EVENT_RELEASE,   ///< 按键松开
 } button_event_type_t;
 
-/** 按键事件回调函数类型 */
+/**
+ * @brief 按键事件回调函数类型
+ * @note 在防抖定时器回调中调用：开启 CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD 与
+ *       CONFIG_GPIO_CTRL_FUNC_IN_IRAM 时为中断上下文，须放在 IRAM 且不得阻塞或打印日志
+ */
 typedef void (*button_event_callback_t)(button_event_type_t event, void *user_ctx);
 
 /** 按键处理器句柄 */
@@ -35,9 +40,10 @@ typedef struct button_handler_s *button_handler_handle_t;
 typedef struct {
     int gpio;                           ///< 按键 GPIO
     bool active_low;                    ///< 低电平有效
-    uint32_t debounce_ms;               ///< 防抖时间（毫秒）
+    uint32_t debounce_ms;               ///< 防抖时间（毫秒，电平稳定这么久后判定）
     button_event_callback_t callback;   ///< 事件回调
     void *user_ctx;                     ///< 用户上下文
+    audio_arena_handle_t arena;         ///< 内存区（可选，NULL 使用堆分配）
 } button_handler_config_t;
 
 /**
@@ -47,6 +53,13 @@ typedef struct {
  */
 button_handler_handle_t button_handler_create(const button_handler_config_t *config);
 
+/**
+ * @brief 累加创建按键处理器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void button_handler_get_footprint(const button_handler_config_t *config, audio_arena_footprint_t *fp);
+
 /**
  * @brief 销毁按键处理器
  * @param handler 按键处理器句柄
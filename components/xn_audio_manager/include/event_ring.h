@@ -0,0 +1,115 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 10:00:00
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\event_ring.h
+ * @Description: 事件环 - 无锁多生产者/单消费者定长事件队列（可在 ISR 中投递）
+ * 
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "audio_arena.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 事件环句柄 */
+typedef struct event_ring_s *event_ring_handle_t;
+
+/** 事件环配置 */
+typedef struct {
+    size_t length;                  ///< 槽位数，向上取整为 2 的幂
+    size_t item_size;               ///< 单个事件大小（字节）
+    audio_arena_handle_t arena;     ///< 内存区（可选，NULL 使用堆分配）
+} event_ring_config_t;
+
+#define EVENT_RING_DEFAULT_CONFIG(len, size)                         \
+    (event_ring_config_t){                                           \
+        .length = (len),                                             \
+        .item_size = (size),                                         \
+        .arena = NULL,                                               \
+    }
+
+/** 事件环运行统计 */
+typedef struct {
+    uint32_t posted;                ///< 成功投递的事件数（即下一个事件的序号）
+    uint32_t dropped;               ///< 环满被丢弃的事件数
+    uint32_t high_water;            ///< 历史最高积压事件数
+    uint32_t capacity;              ///< 槽位数
+} event_ring_stats_t;
+
+/**
+ * @brief 创建事件环
+ * @param config 配置参数
+ * @return 事件环句柄，失败返回 NULL
+ */
+event_ring_handle_t event_ring_create(const event_ring_config_t *config);
+
+/**
+ * @brief 累加创建事件环所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void event_ring_get_footprint(const event_ring_config_t *config, audio_arena_footprint_t *fp);
+
+/**
+ * @brief 销毁事件环
+ * @param ring 事件环句柄
+ */
+void event_ring_destroy(event_ring_handle_t ring);
+
+/**
+ * @brief 设置消费者任务，投递成功后以任务通知唤醒
+ * @param ring 事件环句柄
+ * @param task 消费者任务（NULL 表示不通知）
+ * @note 占用消费者任务的默认通知槽（计数方式），该任务不能再用任务通知做其他用途
+ */
+void event_ring_set_consumer(event_ring_handle_t ring, TaskHandle_t task);
+
+/**
+ * @brief 投递一个事件（任意任务或 ISR 中调用，不阻塞）
+ * @param ring 事件环句柄
+ * @param item 事件数据（item_size 字节）
+ * @return true 成功；false 环已满（计入 dropped）
+ */
+bool event_ring_push(event_ring_handle_t ring, const void *item);
+
+/**
+ * @brief 取出最早的事件（仅消费者任务调用）
+ * @param ring 事件环句柄
+ * @param item 输出事件数据
+ * @param seq 输出事件序号（按投递顺序递增，可为 NULL）
+ * @return true 取到事件；false 环为空
+ */
+bool event_ring_pop(event_ring_handle_t ring, void *item, uint32_t *seq);
+
+/**
+ * @brief 等待新事件通知（仅消费者任务调用）
+ *
+ * 典型用法：循环 pop 直到为空，再调用 wait；期间投递的事件会留下通知，不会丢失唤醒。
+ *
+ * @param ring 事件环句柄
+ * @param ticks 最长等待时间
+ * @return true 收到通知；false 超时
+ */
+bool event_ring_wait(event_ring_handle_t ring, TickType_t ticks);
+
+/**
+ * @brief 获取运行统计
+ * @param ring 事件环句柄
+ * @param stats 输出统计
+ */
+void event_ring_get_stats(event_ring_handle_t ring, event_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
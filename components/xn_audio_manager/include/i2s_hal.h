@@ -12,6 +12,7 @@
 
 #include "esp_err.h"
 #include "driver/i2s_std.h"
+#include "audio_arena.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -19,6 +20,9 @@
 extern "C" {
 #endif
 
+/** 最大麦克风数（标准模式立体声，左声道为 0 号麦克风） */
+#define I2S_HAL_MAX_MIC_NUM 2
+
 /** I2S 麦克风配置 */
 typedef struct {
     int port;           ///< I2S 端口号
@@ -29,6 +33,8 @@ typedef struct {
     int bits;           ///< 位深度（硬件采集 32bit，由数据手册要求）
     size_t max_frame_samples;  ///< 最大帧采样数（用于预分配临时缓冲区，默认 512）
     uint8_t bit_shift;  ///< 32位转16位的右移位数（默认 14，可调 12-16）
+    uint8_t mic_num;    ///< 麦克风数（1 单声道右声道，2 立体声阵列；0 按 1 处理）
+    int32_t gain_q15[I2S_HAL_MAX_MIC_NUM];  ///< 每路麦克风校准增益（Q15，最大 2.0，0 表示单位增益）
 } i2s_mic_config_t;
 
 /** I2S 扬声器配置 */
@@ -40,6 +46,7 @@ typedef struct {
     int sample_rate;    ///< 采样率（通常 16000）
     int bits;           ///< 位深度（16bit）
     size_t max_frame_samples;  ///< 最大帧采样数（用于分配立体声缓冲区）
+    bool full_duplex;   ///< 全双工：与麦克风共用端口和 BCLK/LRCK（忽略 port/bclk/lrck，采样率须与麦克风一致）
 } i2s_speaker_config_t;
 
 /** I2S HAL 句柄 */
@@ -49,10 +56,22 @@ typedef struct i2s_hal_s *i2s_hal_handle_t;
  * @brief 创建 I2S HAL 实例
  * @param mic_config 麦克风配置
  * @param speaker_config 扬声器配置
+ * @param arena 内存区（可选，NULL 使用堆分配）
  * @return I2S HAL 句柄，失败返回 NULL
  */
 i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config, 
-                                 const i2s_speaker_config_t *speaker_config);
+                                 const i2s_speaker_config_t *speaker_config,
+                                 audio_arena_handle_t arena);
+
+/**
+ * @brief 累加创建 I2S HAL 实例所需的内存占用（内存区模式）
+ * @param mic_config 麦克风配置
+ * @param speaker_config 扬声器配置
+ * @param fp 占用统计（累加）
+ */
+void i2s_hal_get_footprint(const i2s_mic_config_t *mic_config,
+                           const i2s_speaker_config_t *speaker_config,
+                           audio_arena_footprint_t *fp);
 
 /**
  * @brief 销毁 I2S HAL 实例
@@ -63,11 +82,11 @@ void i2s_hal_destroy(i2s_hal_handle_t hal);
 /**
  * @brief 从麦克风读取音频数据
  * @param hal I2S HAL 句柄
- * @param out_samples 输出缓冲区（16bit PCM）
- * @param sample_count 期望读取的采样点数
- * @param out_got 实际读取的采样点数（可选）
+ * @param out_samples 输出缓冲区（16bit PCM，多麦克风时按声道平面存放，长度 sample_count * mic_num）
+ * @param sample_count 期望读取的每声道采样点数（也是声道平面间隔）
+ * @param out_got 实际读取的每声道采样点数（可选）
  * @return ESP_OK 成功
- * @note 自动将 32bit 硬件数据转换为 16bit
+ * @note 自动将 32bit 硬件数据转换为 16bit 并应用校准增益；第 c 路麦克风位于 out_samples + c * sample_count
  */
 esp_err_t i2s_hal_read_mic(i2s_hal_handle_t hal, int16_t *out_samples, 
                            size_t sample_count, size_t *out_got);
@@ -84,6 +103,20 @@ esp_err_t i2s_hal_read_mic(i2s_hal_handle_t hal, int16_t *out_samples,
 esp_err_t i2s_hal_write_speaker(i2s_hal_handle_t hal, const int16_t *samples, 
                                  size_t sample_count, uint8_t volume);
 
+/**
+ * @brief 获取麦克风数
+ * @param hal I2S HAL 句柄
+ * @return 麦克风数，失败返回 0
+ */
+uint8_t i2s_hal_get_mic_num(i2s_hal_handle_t hal);
+
+/**
+ * @brief 是否为全双工模式（麦克风与扬声器同一端口、同一时钟）
+ * @param hal I2S HAL 句柄
+ * @return true 全双工
+ */
+bool i2s_hal_is_full_duplex(i2s_hal_handle_t hal);
+
 /**
  * @brief 获取 RX 句柄（用于 AFE 回调）
  * @param hal I2S HAL 句柄
@@ -98,6 +131,22 @@ i2s_chan_handle_t i2s_hal_get_rx_handle(i2s_hal_handle_t hal);
  */
 i2s_chan_handle_t i2s_hal_get_tx_handle(i2s_hal_handle_t hal);
 
+/**
+ * @brief 设置 RX DMA 帧长（重建 RX 通道）
+ * @param hal I2S HAL 句柄
+ * @param frame_num 每个 DMA 帧的采样数（0 恢复默认）
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 全双工模式（TX/RX 共用 DMA 配置）
+ * @note 必须在读取麦克风的任务中调用
+ */
+esp_err_t i2s_hal_set_rx_dma_frame(i2s_hal_handle_t hal, uint32_t frame_num);
+
+/**
+ * @brief 获取 TX DMA 队列深度（写入返回到实际播出的延迟）
+ * @param hal I2S HAL 句柄
+ * @return 队列深度（每声道采样点数）
+ */
+size_t i2s_hal_get_tx_queue_samples(i2s_hal_handle_t hal);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,9 @@
 #include "esp_err.h"
 #include "ring_buffer.h"
 #include "audio_bsp.h"
+#include "audio_decoder.h"
+#include "aec_reference.h"
+#include "audio_resampler.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -26,15 +29,43 @@ typedef struct playback_controller_s *playback_controller_handle_t;
 /** 回采数据回调函数类型 */
 typedef void (*playback_reference_callback_t)(const int16_t *samples, size_t count, void *user_ctx);
 
+/** PCM 输入格式（16bit 交织） */
+typedef struct {
+    uint32_t sample_rate;                            ///< 采样率（8000-48000）
+    uint8_t channels;                                ///< 声道数（1 或 2，立体声下混为单声道）
+} playback_pcm_format_t;
+
+/** 混音流数量上限（含主流 0） */
+#define PLAYBACK_MAX_STREAMS    4
+
+/** 混音流配置 */
+typedef struct {
+    size_t buffer_samples;                           ///< 流缓冲区大小（采样点数，0 表示不启用；主流使用 playback_buffer_samples）
+    uint8_t priority;                                ///< 优先级（越大越高），有更高优先级流在播放时本流被闪避
+    uint8_t gain;                                    ///< 流增益（0-100）
+} playback_stream_config_t;
+
 /** 播放控制器配置 */
 typedef struct {
     audio_bsp_handle_t bsp_handle;                  ///< 音频 BSP 句柄（抽象硬件）
     size_t playback_buffer_samples;                  ///< 播放缓冲区大小（采样点数）
     size_t reference_buffer_samples;                 ///< 回采缓冲区大小（采样点数）
+    int reference_lead_ms;                           ///< 回采相对回声的提前量（毫秒）
+    bool reference_auto_delay;                       ///< 是否自动估计回采残余延迟
     size_t frame_samples;                            ///< 每帧采样点数
     playback_reference_callback_t reference_callback; ///< 回采数据回调（可选，用于AFE）
     void *reference_ctx;                             ///< 回采回调上下文
     uint8_t *volume_ptr;                             ///< 音量指针（外部管理）
+    ring_buffer_overrun_policy_t overrun_policy;     ///< 播放缓冲区满时的写入策略
+    uint32_t write_timeout_ms;                       ///< BLOCK 策略下写入的最长等待时间（毫秒）
+    size_t encoded_buffer_bytes;                     ///< 压缩数据缓冲区大小（字节，0 表示不启用压缩播放）
+    uint32_t sample_rate;                            ///< 输出采样率（压缩数据的解码目标）
+    bool full_duplex;                                ///< 全双工：不直接写 I2S，由麦克风读取任务调用 playback_controller_pull() 锁步输出
+    bool format_convert;                             ///< 是否启用 playback_controller_write_format()（创建重采样器）
+    playback_stream_config_t streams[PLAYBACK_MAX_STREAMS]; ///< 混音流（流 0 为主流，承载 PCM 与压缩播放；其余流任一启用即进入混音模式）
+    uint8_t duck_gain;                               ///< 闪避增益（0-100），低优先级流被闪避时乘以该增益
+    BaseType_t task_core;                            ///< 播放任务运行核心
+    audio_arena_handle_t arena;                      ///< 内存区（可选，NULL 使用堆分配）
 } playback_controller_config_t;
 
 /**
@@ -44,6 +75,14 @@ typedef struct {
  */
 playback_controller_handle_t playback_controller_create(const playback_controller_config_t *config);
 
+/**
+ * @brief 累加创建播放控制器所需的内存占用（内存区模式）
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void playback_controller_get_footprint(const playback_controller_config_t *config,
+                                       audio_arena_footprint_t *fp);
+
 /**
  * @brief 销毁播放控制器
  * @param controller 播放控制器句柄
@@ -51,33 +90,121 @@ playback_controller_handle_t playback_controller_create(const playback_controlle
 void playback_controller_destroy(playback_controller_handle_t controller);
 
 /**
- * @brief 启动播放任务
+ * @brief 开始播放（通知常驻播放任务，不等待）
  * @param controller 播放控制器句柄
  * @return ESP_OK 成功
  */
 esp_err_t playback_controller_start(playback_controller_handle_t controller);
 
 /**
- * @brief 停止播放任务
+ * @brief 停止播放（淡出当前帧，最多延迟一帧）
  * @param controller 播放控制器句柄
- * @return ESP_OK 成功
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 播放任务应答超时
+ * @note 缓冲区中剩余数据保留，不能在回采回调（播放任务上下文）中调用
  */
 esp_err_t playback_controller_stop(playback_controller_handle_t controller);
 
+/**
+ * @brief 打断播放：淡出后停止并丢弃全部待播放数据，回采照常排空
+ * @param controller 播放控制器句柄
+ * @param fade_ms 淡出时长（毫秒，0 表示一帧）
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 播放任务应答超时
+ * @note 不能在回采回调（播放任务上下文）中调用
+ */
+esp_err_t playback_controller_interrupt(playback_controller_handle_t controller, uint32_t fade_ms);
+
+/**
+ * @brief 设置外部闪避（所有流按 duck_gain 输出，用于打断时不停止播放）
+ * @param controller 播放控制器句柄
+ * @param ducked true 闪避，false 恢复
+ * @return ESP_OK 成功
+ */
+esp_err_t playback_controller_set_ducked(playback_controller_handle_t controller, bool ducked);
+
 /**
  * @brief 写入音频数据到播放缓冲区
  * @param controller 播放控制器句柄
  * @param pcm_data PCM 数据（16bit, 单声道）
  * @param sample_count 采样点数
- * @return ESP_OK 成功
+ * @return ESP_OK 成功；ESP_ERR_NO_MEM 缓冲区已满（REJECT 策略）；
+ *         ESP_ERR_TIMEOUT 等待空间超时（BLOCK 策略），本次数据未写入
+ * @note 播放缓冲区为单生产者模式，请勿在多个任务中并发写入
  */
 esp_err_t playback_controller_write(playback_controller_handle_t controller, 
                                      const int16_t *pcm_data, size_t sample_count);
 
 /**
- * @brief 清空播放缓冲区
+ * @brief 按指定格式写入 PCM，转换为输出格式（单声道、输出采样率）后直接写入播放缓冲区
  * @param controller 播放控制器句柄
- * @return ESP_OK 成功
+ * @param pcm_data PCM 数据（16bit，多声道交织）
+ * @param frames 帧数（每帧 channels 个采样）
+ * @param format 输入格式，与输出格式一致时等同 playback_controller_write()
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未启用格式转换或格式不支持；
+ *         ESP_ERR_NO_MEM 缓冲区已满（REJECT 策略）；ESP_ERR_TIMEOUT 等待空间超时（BLOCK 策略），本次数据未写入；
+ *         ESP_ERR_INVALID_SIZE 转换后超出播放缓冲区容量
+ * @note 与 playback_controller_write() 同属单生产者；格式变化时重采样历史清零
+ */
+esp_err_t playback_controller_write_format(playback_controller_handle_t controller,
+                                           const int16_t *pcm_data, size_t frames,
+                                           const playback_pcm_format_t *format);
+
+/**
+ * @brief 写入音频数据到指定混音流
+ * @param controller 播放控制器句柄
+ * @param stream 流编号（0 等同 playback_controller_write()）
+ * @param pcm_data PCM 数据（16bit, 单声道）
+ * @param sample_count 采样点数
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 流未启用；ESP_ERR_NO_MEM/ESP_ERR_TIMEOUT 缓冲区已满，本次数据未写入
+ * @note 每个流各自为单生产者，不同流可由不同任务写入
+ */
+esp_err_t playback_controller_write_stream(playback_controller_handle_t controller, uint8_t stream,
+                                           const int16_t *pcm_data, size_t sample_count);
+
+/**
+ * @brief 设置混音流增益（下一帧生效，带渐变）
+ * @param controller 播放控制器句柄
+ * @param stream 流编号
+ * @param gain 增益（0-100）
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 流未启用
+ */
+esp_err_t playback_controller_set_stream_gain(playback_controller_handle_t controller, uint8_t stream,
+                                              uint8_t gain);
+
+/**
+ * @brief 清空指定混音流（由播放任务执行，返回时已生效，其余流不受影响）
+ * @param controller 播放控制器句柄
+ * @param stream 流编号（0 同时丢弃压缩数据）
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 流未启用；ESP_ERR_TIMEOUT 播放任务应答超时
+ */
+esp_err_t playback_controller_clear_stream(playback_controller_handle_t controller, uint8_t stream);
+
+/**
+ * @brief 获取指定混音流缓冲区可用空间（样本数）
+ * @param controller 播放控制器句柄
+ * @param stream 流编号
+ * @return 可用空间（样本数），流未启用返回 0
+ */
+size_t playback_controller_get_stream_free_space(playback_controller_handle_t controller, uint8_t stream);
+
+/**
+ * @brief 写入压缩音频数据，由播放任务按帧增量解码播放
+ * @param controller 播放控制器句柄
+ * @param codec 压缩格式
+ * @param data 压缩数据（Opus 为一个完整包，ADPCM 为完整块，MP3 可任意切分）
+ * @param len 字节数
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未启用压缩播放；ESP_ERR_NO_MEM 缓冲区已满；
+ *         ESP_ERR_TIMEOUT 等待空间超时（BLOCK 策略），本次数据未写入
+ * @note 压缩缓冲区不支持覆盖，OVERWRITE 策略按 REJECT 处理
+ */
+esp_err_t playback_controller_write_encoded(playback_controller_handle_t controller,
+                                            audio_decoder_codec_t codec,
+                                            const uint8_t *data, size_t len);
+
+/**
+ * @brief 清空播放缓冲区（全部混音流，由播放任务执行，返回时已生效）
+ * @param controller 播放控制器句柄
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 播放任务应答超时
+ * @note 全双工模式下已交给锁步任务的输出（至多两帧）在其下一帧清空
  */
 esp_err_t playback_controller_clear(playback_controller_handle_t controller);
 
@@ -96,11 +223,42 @@ bool playback_controller_is_running(playback_controller_handle_t controller);
 size_t playback_controller_get_free_space(playback_controller_handle_t controller);
 
 /**
- * @brief 获取回采缓冲区（用于 AFE 读取）
+ * @brief 取出一帧待输出的音频（全双工，锁步任务调用）
+ * @param controller 播放控制器句柄
+ * @param out 输出缓冲区（16bit 单声道，未应用音量）
+ * @param count 期望采样点数
+ * @param volume 输出当前生效音量（0-100，单流时已并入主流增益与闪避）
+ * @return 实际取出的采样点数（不足部分由调用方补静音）；非全双工模式返回 0
+ * @note 调用方写入 I2S TX 后须立即把这段数据写入回采对齐（此时回采生产者为锁步任务）
+ */
+size_t playback_controller_pull(playback_controller_handle_t controller, int16_t *out, size_t count,
+                                uint8_t *volume);
+
+/**
+ * @brief 获取回采对齐（用于 AFE 读取）
+ * @param controller 播放控制器句柄
+ * @return 回采对齐句柄
+ */
+aec_reference_handle_t playback_controller_get_reference(playback_controller_handle_t controller);
+
+/**
+ * @brief 获取播放/回采缓冲区运行统计
+ * @param controller 播放控制器句柄
+ * @param playback 输出播放缓冲区统计（可为 NULL）
+ * @param reference 输出回采缓冲区统计（可为 NULL）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t playback_controller_get_stats(playback_controller_handle_t controller,
+                                        ring_buffer_stats_t *playback,
+                                        ring_buffer_stats_t *reference);
+
+/**
+ * @brief 获取常驻播放任务信息（栈高水位报告用）
  * @param controller 播放控制器句柄
- * @return 回采缓冲区句柄
+ * @param info 输出任务信息
  */
-ring_buffer_handle_t playback_controller_get_reference_buffer(playback_controller_handle_t controller);
+void playback_controller_get_task_info(playback_controller_handle_t controller,
+                                       audio_arena_task_info_t *info);
 
 #ifdef __cplusplus
 }
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "audio_arena.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include <stdint.h>
@@ -23,14 +24,86 @@ extern "C" {
 /** 环形缓冲区句柄 */
 typedef struct ring_buffer_s *ring_buffer_handle_t;
 
+/** 缓冲区满时的写入策略 */
+typedef enum {
+    RING_BUFFER_OVERRUN_OVERWRITE = 0,  ///< 覆盖最旧数据（默认，适合实时回采等只关心最新数据的场景）
+    RING_BUFFER_OVERRUN_REJECT,         ///< 拒绝本次写入（空间不足时整块丢弃新数据）
+    RING_BUFFER_OVERRUN_BLOCK,          ///< 阻塞等待空间，超时后按 REJECT 处理
+} ring_buffer_overrun_policy_t;
+
+/** 环形缓冲区配置 */
+typedef struct {
+    size_t samples;     ///< 缓冲区容量（采样点数），无锁模式下向上取整为 2 的幂
+    bool with_sem;      ///< 是否使用信号量（用于阻塞读取）
+    bool lock_free;     ///< 无锁 SPSC 模式（单生产者 + 单消费者，不使用互斥锁）
+    ring_buffer_overrun_policy_t overrun_policy;  ///< 缓冲区满时的写入策略
+    uint32_t write_timeout_ms;                    ///< BLOCK 策略下的最长等待时间（毫秒）
+    audio_arena_handle_t arena;                   ///< 内存区（可选，NULL 使用堆分配）
+} ring_buffer_config_t;
+
+/**
+ * @brief 环形缓冲区运行统计
+ *
+ * 计数器在读写路径上以原子操作累加，不加锁、不打印日志；
+ * 由上层按需拉取，用于定位丢帧/欠载问题。
+ */
+typedef struct {
+    uint32_t overrun_samples;   ///< 因覆盖策略被丢弃的最旧采样点数
+    uint32_t rejected_samples;  ///< 因 REJECT/BLOCK 策略被拒绝写入的采样点数
+    uint32_t underrun_reads;    ///< 返回数据少于请求量的读取次数
+    uint32_t lock_timeouts;     ///< 获取互斥锁超时次数（仅互斥锁模式）
+    size_t high_water;          ///< 历史最高占用量（采样点数）
+    size_t level;               ///< 当前占用量（采样点数）
+    size_t capacity;            ///< 缓冲区容量（采样点数）
+} ring_buffer_stats_t;
+
+/**
+ * @brief 环形缓冲区内的连续区间（回绕时最多两段）
+ *
+ * 由 ring_buffer_acquire_write()/ring_buffer_peek_read() 填充，
+ * 调用方直接在缓冲区内存上读写，避免额外拷贝。
+ */
+typedef struct {
+    int16_t *data[2];   ///< 区间起始地址，第二段为空时 data[1] == NULL
+    size_t len[2];      ///< 各段采样点数
+    size_t total;       ///< 总采样点数（len[0] + len[1]）
+} ring_buffer_span_t;
+
+#define RING_BUFFER_DEFAULT_CONFIG(n)                                \
+    (ring_buffer_config_t){                                          \
+        .samples = (n),                                              \
+        .with_sem = false,                                           \
+        .lock_free = false,                                          \
+        .overrun_policy = RING_BUFFER_OVERRUN_OVERWRITE,             \
+        .write_timeout_ms = 0,                                       \
+        .arena = NULL,                                               \
+    }
+
 /**
  * @brief 创建环形缓冲区
  * @param samples 缓冲区容量（采样点数）
  * @param with_sem 是否使用信号量（用于阻塞读取）
  * @return 环形缓冲区句柄，失败返回NULL
+ * @note 等价于 lock_free = false 的 ring_buffer_create_with_config()
  */
 ring_buffer_handle_t ring_buffer_create(size_t samples, bool with_sem);
 
+/**
+ * @brief 按配置创建环形缓冲区
+ * @param config 配置参数
+ * @return 环形缓冲区句柄，失败返回NULL
+ * @note 无锁模式要求同一时刻只有一个写入者和一个读取者；
+ *       ring_buffer_clear()/ring_buffer_available() 可在任意任务调用
+ */
+ring_buffer_handle_t ring_buffer_create_with_config(const ring_buffer_config_t *config);
+
+/**
+ * @brief 累加按配置创建环形缓冲区所需的内存占用
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void ring_buffer_get_footprint(const ring_buffer_config_t *config, audio_arena_footprint_t *fp);
+
 /**
  * @brief 销毁环形缓冲区
  * @param rb 环形缓冲区句柄
@@ -43,7 +116,9 @@ void ring_buffer_destroy(ring_buffer_handle_t rb);
  * @param data 数据指针
  * @param samples 采样点数
  * @return 实际写入的采样点数
- * @note 如果缓冲区满，会覆盖旧数据
+ * @note 缓冲区满时按 overrun_policy 处理：OVERWRITE 覆盖旧数据；
+ *       REJECT/BLOCK 空间不足（或等待超时）时整块拒绝并返回 0；
+ *       互斥锁模式下获取锁超时返回 0
  */
 size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t samples);
 
@@ -57,6 +132,45 @@ size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t sa
  */
 size_t ring_buffer_read(ring_buffer_handle_t rb, int16_t *out, size_t samples, uint32_t timeout_ms);
 
+/**
+ * @brief 预留写入空间（零拷贝写入）
+ * @param rb 环形缓冲区句柄（必须为无锁模式）
+ * @param samples 预留的采样点数（不超过容量），空间不足时按 overrun_policy 处理
+ * @param span 输出可直接写入的区间
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 非无锁模式；ESP_ERR_INVALID_SIZE 超出容量；
+ *         ESP_ERR_NO_MEM REJECT 策略空间不足；ESP_ERR_TIMEOUT BLOCK 策略等待超时
+ * @note 写入完成后调用 ring_buffer_commit_write() 发布数据
+ */
+esp_err_t ring_buffer_acquire_write(ring_buffer_handle_t rb, size_t samples, ring_buffer_span_t *span);
+
+/**
+ * @brief 提交已预留区间中实际写入的数据
+ * @param rb 环形缓冲区句柄
+ * @param samples 实际写入的采样点数（不超过预留量）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_SIZE 超过预留量
+ */
+esp_err_t ring_buffer_commit_write(ring_buffer_handle_t rb, size_t samples);
+
+/**
+ * @brief 查看可读数据区间（零拷贝读取，不移动读指针）
+ * @param rb 环形缓冲区句柄（必须为无锁模式）
+ * @param samples 期望的最大采样点数
+ * @param span 输出可直接读取的区间（total 可能小于 samples，为 0 表示无数据）
+ * @param timeout_ms 超时时间（毫秒），0表示不阻塞
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 非无锁模式
+ * @note 读取完成后调用 ring_buffer_release_read() 释放空间
+ */
+esp_err_t ring_buffer_peek_read(ring_buffer_handle_t rb, size_t samples,
+                                ring_buffer_span_t *span, uint32_t timeout_ms);
+
+/**
+ * @brief 释放已查看区间中实际消费的数据
+ * @param rb 环形缓冲区句柄
+ * @param samples 实际消费的采样点数（不超过查看量）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 查看期间数据已被生产者覆盖
+ */
+esp_err_t ring_buffer_release_read(ring_buffer_handle_t rb, size_t samples);
+
 /**
  * @brief 获取环形缓冲区中可用的数据量
  * @param rb 环形缓冲区句柄
@@ -68,9 +182,28 @@ size_t ring_buffer_available(ring_buffer_handle_t rb);
  * @brief 清空环形缓冲区
  * @param rb 环形缓冲区句柄
  * @return ESP_OK 成功
+ * @note 会唤醒 BLOCK 策略下等待空间的生产者
  */
 esp_err_t ring_buffer_clear(ring_buffer_handle_t rb);
 
+/**
+ * @brief 唤醒阻塞在 ring_buffer_read()/ring_buffer_peek_read() 上的消费者
+ * @param rb 环形缓冲区句柄
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未启用 data_sem
+ * @note 消费者被唤醒后可能读到 0 个采样，用于让其及时处理控制命令
+ */
+esp_err_t ring_buffer_wake_reader(ring_buffer_handle_t rb);
+
+/**
+ * @brief 获取累计写入/读取位置（无锁模式）
+ * @param rb 环形缓冲区句柄（必须为无锁模式）
+ * @param written 输出累计写入采样点数（可为 NULL）
+ * @param read 输出累计读取采样点数，含被覆盖/清空跳过的部分（可为 NULL）
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 非无锁模式
+ * @note 两个位置均单调递增并按 size_t 回绕，用于把采样与其写入时刻对应起来
+ */
+esp_err_t ring_buffer_get_positions(ring_buffer_handle_t rb, size_t *written, size_t *read);
+
 /**
  * @brief 获取环形缓冲区的容量
  * @param rb 环形缓冲区句柄
@@ -78,6 +211,22 @@ esp_err_t ring_buffer_clear(ring_buffer_handle_t rb);
  */
 size_t ring_buffer_get_size(ring_buffer_handle_t rb);
 
+/**
+ * @brief 获取运行统计快照
+ * @param rb 环形缓冲区句柄
+ * @param stats 输出统计数据
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ * @note 不加锁，可在任意任务调用；各字段独立读取，彼此之间不保证严格一致
+ */
+esp_err_t ring_buffer_get_stats(ring_buffer_handle_t rb, ring_buffer_stats_t *stats);
+
+/**
+ * @brief 清零运行统计（高水位重置为当前占用量）
+ * @param rb 环形缓冲区句柄
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t ring_buffer_reset_stats(ring_buffer_handle_t rb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,451 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-05 15:40:26
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-05 15:40:26
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\aec_reference.c
+ * @Description: AEC 回采对齐实现
+ *
+ * 生产者（播放任务）在 I2S TX 写入返回后写入回采，并按 DMA 队列深度推算每段数据的播出时刻；
+ * 连续播放只在第一帧记录一个标注，中断后重新标注。
+ * 消费者（AFE Feed）按麦克风帧的采集时刻找到同一时刻播出的回采：尚未播出的部分补静音，
+ * 已经过期的部分丢弃。残余延迟（声学路径、RX DMA 等）由麦克风/回采包络互相关估计并逐步修正。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "aec_reference.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+static const char *TAG = "AEC_REF";
+
+#define AEC_REF_TAGS                16          ///< 播出时间标注队列长度（每次播放中断产生一个）
+#define AEC_REF_CONTINUITY_US       2000        ///< 与上一段的播出时刻相差不超过该值视为连续
+#define AEC_REF_FETCH_STEPS         4           ///< 单帧对齐最多处理的标注段数
+#define AEC_REF_BLOCK               32          ///< 包络块大小（16kHz 下 2ms）
+#define AEC_REF_ENV_BLOCKS          512         ///< 每次估计的包络窗口（16kHz 下约 1 秒）
+#define AEC_REF_LAG_MIN             (-16)       ///< 搜索的最小滞后（块）
+#define AEC_REF_LAG_MAX             48          ///< 搜索的最大滞后（块）
+#define AEC_REF_CORR_MIN            0.5f        ///< 互相关峰值低于该值时不采信
+#define AEC_REF_MIN_LEVEL           100         ///< 回采平均幅度低于该值（约 -50 dBFS）时不估计
+#define AEC_REF_MAX_OFFSET_US       100000      ///< 自动修正的最大范围
+
+/** 播出时间标注：累计位置 pos 的采样在 t0_us 播出，其后连续 */
+typedef struct {
+    size_t pos;
+    int64_t t0_us;
+} aec_ref_tag_t;
+
+/**
+ * @brief 回采对齐结构体
+ */
+typedef struct aec_reference_s {
+    audio_arena_handle_t arena;             ///< 所属内存区（NULL 表示堆分配）
+    ring_buffer_handle_t rb;                ///< 回采缓冲区（无锁 SPSC：播放任务写入 -> AFE Feed 读取）
+    uint32_t sample_rate;                   ///< 采样率
+    int64_t tx_queue_us;                    ///< TX DMA 队列时长
+
+    /* 播出时间标注（SPSC：生产者写入 tags[head] 后推进 head，消费者推进 tail） */
+    aec_ref_tag_t tags[AEC_REF_TAGS];
+    atomic_uint tag_head;
+    atomic_uint tag_tail;
+    int64_t seg_end_us;                     ///< 上次写入末尾的播出时刻（仅生产者）
+    bool tag_pending;                       ///< 上次标注因队列满未写入，下次必须重新标注（仅生产者）
+
+    /* 对齐与延迟估计（仅消费者） */
+    volatile int32_t offset_us;             ///< 回采播出时刻相对麦克风采集时刻的偏移
+    int32_t lead_us;                        ///< 配置的提前量
+    bool auto_delay;                        ///< 是否自动修正
+    int last_lag;                           ///< 上一窗口的估计滞后（连续两次一致才修正）
+    uint16_t env_mic[AEC_REF_ENV_BLOCKS];   ///< 麦克风包络（每块平均幅度）
+    uint16_t env_ref[AEC_REF_ENV_BLOCKS];   ///< 对齐后回采包络
+    size_t env_fill;                        ///< 包络窗口已填充块数
+    uint32_t acc_mic;                       ///< 当前块幅度累加
+    uint32_t acc_ref;
+    size_t acc_n;                           ///< 当前块已累加采样数
+
+    /* 统计 */
+    atomic_uint padded_samples;
+    atomic_uint dropped_samples;
+    atomic_uint delay_updates;
+} aec_reference_t;
+
+static inline int64_t aec_ref_samples_to_us(const aec_reference_t *ref, int64_t samples)
+{
+    return samples * 1000000 / ref->sample_rate;
+}
+
+static inline int64_t aec_ref_us_to_samples(const aec_reference_t *ref, int64_t us)
+{
+    return us * ref->sample_rate / 1000000;
+}
+
+/**
+ * @brief 回采缓冲区配置（创建与占用预估共用）
+ */
+static ring_buffer_config_t aec_ref_ring_config(const aec_reference_config_t *config)
+{
+    ring_buffer_config_t rb_cfg = RING_BUFFER_DEFAULT_CONFIG(config->buffer_samples);
+    rb_cfg.lock_free = true;
+    rb_cfg.arena = config->arena;
+    return rb_cfg;
+}
+
+/**
+ * @brief 写入播出时间标注（生产者）
+ * @return false 队列已满
+ */
+static bool aec_ref_push_tag(aec_reference_t *ref, size_t pos, int64_t t0_us)
+{
+    unsigned head = atomic_load_explicit(&ref->tag_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ref->tag_tail, memory_order_acquire);
+    if (head - tail >= AEC_REF_TAGS) {
+        return false;
+    }
+
+    ref->tags[head % AEC_REF_TAGS] = (aec_ref_tag_t){ .pos = pos, .t0_us = t0_us };
+    atomic_store_explicit(&ref->tag_head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief 查找覆盖 pos 的播出时间标注（消费者，顺带丢弃已读完的标注）
+ *
+ * @param ref 句柄
+ * @param pos 读位置
+ * @param seg_end 输出本段结束位置（下一个标注位置，无则不修改）
+ * @return 标注，pos 之前没有标注时返回 NULL
+ */
+static const aec_ref_tag_t *aec_ref_find_tag(aec_reference_t *ref, size_t pos, size_t *seg_end)
+{
+    unsigned tail = atomic_load_explicit(&ref->tag_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ref->tag_head, memory_order_acquire);
+
+    while (head - tail >= 2 && (ptrdiff_t)(ref->tags[(tail + 1) % AEC_REF_TAGS].pos - pos) <= 0) {
+        tail++;
+    }
+    atomic_store_explicit(&ref->tag_tail, tail, memory_order_release);
+
+    if (head == tail) {
+        return NULL;
+    }
+    const aec_ref_tag_t *tag = &ref->tags[tail % AEC_REF_TAGS];
+    if ((ptrdiff_t)(tag->pos - pos) > 0) {
+        *seg_end = tag->pos;
+        return NULL;
+    }
+    if (head - tail >= 2) {
+        *seg_end = ref->tags[(tail + 1) % AEC_REF_TAGS].pos;
+    }
+    return tag;
+}
+
+/**
+ * @brief 用一个包络窗口估计残余延迟，连续两次结果一致时修正偏移
+ *
+ * 在 [LAG_MIN, LAG_MAX] 块范围内计算去均值包络的归一化互相关，
+ * 峰值滞后 L 表示回声比回采晚 L 块出现；目标是晚 lead 对应的块数。
+ */
+static void aec_ref_estimate(aec_reference_t *ref)
+{
+    float mic_mean = 0.0f;
+    float ref_mean = 0.0f;
+    for (size_t i = 0; i < AEC_REF_ENV_BLOCKS; i++) {
+        mic_mean += ref->env_mic[i];
+        ref_mean += ref->env_ref[i];
+    }
+    mic_mean /= AEC_REF_ENV_BLOCKS;
+    ref_mean /= AEC_REF_ENV_BLOCKS;
+    if (ref_mean < AEC_REF_MIN_LEVEL) {
+        ref->last_lag = INT_MIN;
+        return;
+    }
+
+    int best_lag = 0;
+    float best_corr = -1.0f;
+    for (int lag = AEC_REF_LAG_MIN; lag <= AEC_REF_LAG_MAX; lag++) {
+        int begin = lag > 0 ? lag : 0;
+        int end = AEC_REF_ENV_BLOCKS + (lag < 0 ? lag : 0);
+        float sxy = 0.0f, sxx = 0.0f, syy = 0.0f;
+        for (int k = begin; k < end; k++) {
+            float x = ref->env_mic[k] - mic_mean;
+            float y = ref->env_ref[k - lag] - ref_mean;
+            sxy += x * y;
+            sxx += x * x;
+            syy += y * y;
+        }
+        if (sxx <= 0.0f || syy <= 0.0f) {
+            continue;
+        }
+        float corr = sxy / sqrtf(sxx * syy);
+        if (corr > best_corr) {
+            best_corr = corr;
+            best_lag = lag;
+        }
+    }
+
+    if (best_corr < AEC_REF_CORR_MIN) {
+        ref->last_lag = INT_MIN;
+        return;
+    }
+
+    const int32_t block_us = (int32_t)aec_ref_samples_to_us(ref, AEC_REF_BLOCK);
+    const int target = (ref->lead_us + block_us / 2) / block_us;
+    if (best_lag != ref->last_lag || best_lag == target) {
+        ref->last_lag = best_lag;
+        return;
+    }
+
+    // 回声晚于目标：回采给早了，改为配对更早播出的回采
+    int32_t offset = ref->offset_us - (best_lag - target) * block_us;
+    if (offset > AEC_REF_MAX_OFFSET_US) {
+        offset = AEC_REF_MAX_OFFSET_US;
+    } else if (offset < -AEC_REF_MAX_OFFSET_US) {
+        offset = -AEC_REF_MAX_OFFSET_US;
+    }
+    ref->offset_us = offset;
+    ref->last_lag = INT_MIN;
+    atomic_fetch_add_explicit(&ref->delay_updates, 1, memory_order_relaxed);
+    ESP_LOGI(TAG, "🎯 回采延迟修正: 滞后 %d 块 (相关 %.2f), 偏移 -> %d us",
+             best_lag, best_corr, (int)offset);
+}
+
+/**
+ * @brief 累加一段麦克风/回采幅度到包络（ref_data 为 NULL 表示静音回采）
+ */
+static void aec_ref_accumulate(aec_reference_t *ref, const int16_t *mic, const int16_t *ref_data, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        ref->acc_mic += (uint32_t)abs(mic[i]);
+        if (ref_data) {
+            ref->acc_ref += (uint32_t)abs(ref_data[i]);
+        }
+        if (++ref->acc_n < AEC_REF_BLOCK) {
+            continue;
+        }
+
+        ref->env_mic[ref->env_fill] = (uint16_t)(ref->acc_mic / AEC_REF_BLOCK);
+        ref->env_ref[ref->env_fill] = (uint16_t)(ref->acc_ref / AEC_REF_BLOCK);
+        ref->acc_mic = 0;
+        ref->acc_ref = 0;
+        ref->acc_n = 0;
+        if (++ref->env_fill == AEC_REF_ENV_BLOCKS) {
+            aec_ref_estimate(ref);
+            ref->env_fill = 0;
+        }
+    }
+}
+
+aec_reference_handle_t aec_reference_create(const aec_reference_config_t *config)
+{
+    if (!config || config->buffer_samples == 0 || config->sample_rate == 0) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    aec_reference_t *ref = (aec_reference_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                 sizeof(aec_reference_t));
+    if (!ref) {
+        ESP_LOGE(TAG, "回采对齐分配失败");
+        return NULL;
+    }
+    ref->arena = config->arena;
+    ref->sample_rate = config->sample_rate;
+    ref->tx_queue_us = aec_ref_samples_to_us(ref, (int64_t)config->tx_queue_samples);
+    ref->lead_us = config->lead_ms * 1000;
+    ref->offset_us = ref->lead_us;
+    ref->auto_delay = config->auto_delay;
+    ref->last_lag = INT_MIN;
+    atomic_init(&ref->tag_head, 0);
+    atomic_init(&ref->tag_tail, 0);
+    atomic_init(&ref->padded_samples, 0);
+    atomic_init(&ref->dropped_samples, 0);
+    atomic_init(&ref->delay_updates, 0);
+
+    ring_buffer_config_t rb_cfg = aec_ref_ring_config(config);
+    ref->rb = ring_buffer_create_with_config(&rb_cfg);
+    if (!ref->rb) {
+        ESP_LOGE(TAG, "回采缓冲区创建失败");
+        audio_arena_free(ref->arena, ref);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "回采对齐: TX 队列 %u 采样, 提前 %d ms, 自动延迟%s",
+             (unsigned)config->tx_queue_samples, config->lead_ms, config->auto_delay ? "开启" : "关闭");
+    return ref;
+}
+
+void aec_reference_get_footprint(const aec_reference_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+
+    ring_buffer_config_t rb_cfg = aec_ref_ring_config(config);
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(aec_reference_t));
+    ring_buffer_get_footprint(&rb_cfg, fp);
+}
+
+void aec_reference_destroy(aec_reference_handle_t ref)
+{
+    if (!ref) {
+        return;
+    }
+    ring_buffer_destroy(ref->rb);
+    audio_arena_free(ref->arena, ref);
+}
+
+/**
+ * @brief 写入刚送入 I2S TX 的音频
+ *
+ * 写入返回时这段数据位于 DMA 队列末尾，最后一个采样约在 tx_queue_us 后播出。
+ * 与上一段首尾相接时沿用上一段的时间轴，避免任务调度抖动引入标注误差。
+ */
+esp_err_t aec_reference_write(aec_reference_handle_t ref, const int16_t *samples, size_t count)
+{
+    if (!ref || !samples || count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t duration = aec_ref_samples_to_us(ref, (int64_t)count);
+    int64_t start = esp_timer_get_time() + ref->tx_queue_us - duration;
+
+    if (ref->tag_pending || llabs(start - ref->seg_end_us) > AEC_REF_CONTINUITY_US) {
+        size_t head = 0;
+        ring_buffer_get_positions(ref->rb, &head, NULL);
+        ref->tag_pending = !aec_ref_push_tag(ref, head, start);
+    } else {
+        start = ref->seg_end_us;
+    }
+    ref->seg_end_us = start + duration;
+
+    ring_buffer_write(ref->rb, samples, count);
+    return ESP_OK;
+}
+
+esp_err_t aec_reference_clear(aec_reference_handle_t ref)
+{
+    if (!ref) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 标注随读位置自然过期；清零时间轴使下一段重新标注
+    ref->seg_end_us = 0;
+    return ring_buffer_clear(ref->rb);
+}
+
+/**
+ * @brief 取出与一帧麦克风数据对齐的回采
+ *
+ * 目标是帧首采样采集时刻（加偏移）播出的回采：读位置的播出时刻晚于目标时帧首补静音，
+ * 早于目标时丢弃过期部分；一次最多取到本段结束，跨段的部分留给下一帧。
+ */
+esp_err_t aec_reference_fetch(aec_reference_handle_t ref, size_t samples, int64_t capture_end_us,
+                              aec_reference_frame_t *frame)
+{
+    if (!ref || !frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(frame, 0, sizeof(*frame));
+
+    const int64_t target_us = capture_end_us - aec_ref_samples_to_us(ref, (int64_t)samples) + ref->offset_us;
+
+    for (int step = 0; step < AEC_REF_FETCH_STEPS; step++) {
+        size_t head = 0, tail = 0;
+        ring_buffer_get_positions(ref->rb, &head, &tail);
+        if (head == tail) {
+            break;
+        }
+
+        size_t seg_end = head;
+        const aec_ref_tag_t *tag = aec_ref_find_tag(ref, tail, &seg_end);
+        size_t seg = seg_end - tail;
+        if (seg > head - tail) {
+            seg = head - tail;
+        }
+
+        int64_t diff = 0;
+        if (tag) {
+            int64_t play_us = tag->t0_us + aec_ref_samples_to_us(ref, (int64_t)(tail - tag->pos));
+            diff = aec_ref_us_to_samples(ref, play_us - target_us);
+        }
+
+        if (diff < 0) {
+            // 已播出且早于本帧：丢弃过期部分
+            ring_buffer_span_t skip = {0};
+            size_t drop = (size_t)-diff < seg ? (size_t)-diff : seg;
+            ring_buffer_peek_read(ref->rb, drop, &skip, 0);
+            ring_buffer_release_read(ref->rb, skip.total);
+            atomic_fetch_add_explicit(&ref->dropped_samples, (unsigned)skip.total, memory_order_relaxed);
+            continue;
+        }
+
+        frame->lead = (size_t)diff < samples ? (size_t)diff : samples;
+        size_t take = samples - frame->lead;
+        if (take > seg) {
+            take = seg;
+        }
+        if (take > 0) {
+            ring_buffer_peek_read(ref->rb, take, &frame->span, 0);
+        }
+        break;
+    }
+
+    if (frame->span.total > 0 && frame->span.total < samples) {
+        atomic_fetch_add_explicit(&ref->padded_samples, (unsigned)(samples - frame->span.total),
+                                  memory_order_relaxed);
+    }
+    return ESP_OK;
+}
+
+void aec_reference_release(aec_reference_handle_t ref, const int16_t *mic, size_t samples,
+                           const aec_reference_frame_t *frame)
+{
+    if (!ref || !frame) {
+        return;
+    }
+
+    if (frame->span.total > 0) {
+        ring_buffer_release_read(ref->rb, frame->span.total);
+    }
+    if (!ref->auto_delay || !mic) {
+        return;
+    }
+
+    // 按帧内顺序累加：帧首静音、回采区间、帧尾静音
+    size_t i = frame->lead < samples ? frame->lead : samples;
+    aec_ref_accumulate(ref, mic, NULL, i);
+    for (int seg = 0; seg < 2 && frame->span.len[seg] > 0 && i < samples; seg++) {
+        size_t n = frame->span.len[seg];
+        if (n > samples - i) {
+            n = samples - i;
+        }
+        aec_ref_accumulate(ref, mic + i, frame->span.data[seg], n);
+        i += n;
+    }
+    aec_ref_accumulate(ref, mic + i, NULL, samples - i);
+}
+
+esp_err_t aec_reference_get_stats(aec_reference_handle_t ref, ring_buffer_stats_t *ring,
+                                  aec_reference_stats_t *stats)
+{
+    if (!ref) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (ring) {
+        ring_buffer_get_stats(ref->rb, ring);
+    }
+    if (stats) {
+        stats->offset_us = ref->offset_us;
+        stats->padded_samples = atomic_load_explicit(&ref->padded_samples, memory_order_relaxed);
+        stats->dropped_samples = atomic_load_explicit(&ref->dropped_samples, memory_order_relaxed);
+        stats->delay_updates = atomic_load_explicit(&ref->delay_updates, memory_order_relaxed);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,301 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:00:00
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\afe_models.c
+ * @Description: 模型映射实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "afe_models.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "AFE_MODELS";
+
+#define AFE_MODELS_MAX_SLOTS        3       ///< 最多映射的模型数（WakeNet + VADNet + NSNet）
+#define AFE_MODELS_MAX_FILES        8       ///< 单个模型最多文件数
+#define AFE_MODELS_MAX_ENTRIES      256     ///< 分区头中模型数的合理上限（超出视为分区内容无效）
+#define AFE_MODELS_MAX_ENTRY_FILES  64      ///< 分区头中单个模型文件数的合理上限
+#define AFE_MODELS_ENTRY_BYTES      (AFE_MODELS_NAME_LEN + 4)       ///< 模型头：名称 + 文件数
+#define AFE_MODELS_FILE_BYTES       (AFE_MODELS_NAME_LEN + 8)       ///< 文件头：名称 + 偏移 + 长度
+
+/** 单个已映射模型 */
+typedef struct {
+    char name[AFE_MODELS_NAME_LEN + 1];                             ///< 模型名
+    char file_names[AFE_MODELS_MAX_FILES][AFE_MODELS_NAME_LEN + 1]; ///< 文件名
+    char *files[AFE_MODELS_MAX_FILES];                              ///< 文件名指针（srmodel_data_t.files）
+    char *file_data[AFE_MODELS_MAX_FILES];                          ///< 文件数据（指向映射区）
+    int sizes[AFE_MODELS_MAX_FILES];                                ///< 文件长度
+    srmodel_data_t data;                                            ///< esp-sr 模型数据描述
+    esp_partition_mmap_handle_t mmap;                               ///< 映射句柄
+    size_t mapped_bytes;                                            ///< 映射区间长度
+} afe_model_slot_t;
+
+/**
+ * @brief 模型映射结构体
+ *
+ * 一次分配，内含 esp-sr 模型列表所需的全部数组；列表不经过 esp_srmodel_init，
+ * 因此不能用 esp_srmodel_deinit 释放，须调用 afe_models_unmap。
+ */
+typedef struct afe_models_s {
+    srmodel_list_t list;                                ///< 返回给 AFE 的模型列表
+    char *names[AFE_MODELS_MAX_SLOTS];                  ///< 模型名指针（srmodel_list_t.model_name）
+    srmodel_data_t *data[AFE_MODELS_MAX_SLOTS];         ///< 模型数据指针（srmodel_list_t.model_data）
+    afe_model_slot_t slots[AFE_MODELS_MAX_SLOTS];       ///< 已映射模型
+    uint8_t slot_num;                                   ///< 已映射模型数
+
+    // 映射时的选择（用于判断是否需要重新映射）
+    char partition[17];                                 ///< 模型分区名称
+    char wake_model[AFE_MODELS_NAME_LEN + 1];           ///< 指定的 WakeNet 模型名（空为第一个）
+    bool wakenet;
+    bool vadnet;
+    bool nsnet;
+    bool has_wakenet;                                   ///< 已映射 WakeNet
+    bool has_vadnet;                                    ///< 已映射 VADNet
+    bool has_nsnet;                                     ///< 已映射 NSNet
+} afe_models_t;
+
+/**
+ * @brief 判断分区中的模型是否需要映射（每类只映射第一个匹配项），并标记已选中
+ */
+static bool afe_models_take(afe_models_t *models, const char *name)
+{
+    if (models->wakenet && !models->has_wakenet &&
+        strncmp(name, ESP_WN_PREFIX, strlen(ESP_WN_PREFIX)) == 0 &&
+        (models->wake_model[0] == '\0' || strcmp(name, models->wake_model) == 0)) {
+        models->has_wakenet = true;
+        return true;
+    }
+    if (models->vadnet && !models->has_vadnet &&
+        strncmp(name, ESP_VADN_PREFIX, strlen(ESP_VADN_PREFIX)) == 0) {
+        models->has_vadnet = true;
+        return true;
+    }
+    if (models->nsnet && !models->has_nsnet &&
+        strncmp(name, ESP_NSNET_PREFIX, strlen(ESP_NSNET_PREFIX)) == 0) {
+        models->has_nsnet = true;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 读取一个模型的文件表并映射其所在的连续区间
+ *
+ * @param models 模型映射
+ * @param part 模型分区
+ * @param offset 文件表在分区中的偏移
+ * @param name 模型名
+ * @param file_num 文件数
+ * @return esp_err_t ESP_OK 成功
+ */
+static esp_err_t afe_models_map_one(afe_models_t *models, const esp_partition_t *part,
+                                    size_t offset, const char *name, int32_t file_num)
+{
+    if (file_num <= 0 || file_num > AFE_MODELS_MAX_FILES) {
+        ESP_LOGE(TAG, "模型 %s 文件数无效: %d", name, (int)file_num);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    afe_model_slot_t *slot = &models->slots[models->slot_num];
+    int32_t starts[AFE_MODELS_MAX_FILES];
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+
+    for (int32_t i = 0; i < file_num; i++) {
+        uint8_t entry[AFE_MODELS_FILE_BYTES];
+        esp_err_t ret = esp_partition_read(part, offset + (size_t)i * AFE_MODELS_FILE_BYTES,
+                                           entry, sizeof(entry));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        int32_t start, len;
+        memcpy(slot->file_names[i], entry, AFE_MODELS_NAME_LEN);
+        memcpy(&start, entry + AFE_MODELS_NAME_LEN, sizeof(start));
+        memcpy(&len, entry + AFE_MODELS_NAME_LEN + 4, sizeof(len));
+        if (start < 0 || len < 0 || (uint64_t)start + (uint64_t)len > part->size) {
+            ESP_LOGE(TAG, "模型 %s 文件 %s 越界: 偏移 %d 长度 %d", name, slot->file_names[i],
+                     (int)start, (int)len);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        starts[i] = start;
+        slot->sizes[i] = len;
+        lo = (uint32_t)start < lo ? (uint32_t)start : lo;
+        hi = (uint32_t)(start + len) > hi ? (uint32_t)(start + len) : hi;
+    }
+
+    // 只映射本模型的区间（起始地址的页对齐由 esp_partition_mmap 处理）
+    const void *base = NULL;
+    esp_err_t ret = esp_partition_mmap(part, lo, hi - lo, ESP_PARTITION_MMAP_DATA, &base, &slot->mmap);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "模型 %s 映射失败: %s", name, esp_err_to_name(ret));
+        return ret;
+    }
+    slot->mapped_bytes = hi - lo;
+
+    for (int32_t i = 0; i < file_num; i++) {
+        slot->files[i] = slot->file_names[i];
+        slot->file_data[i] = (char *)base + (starts[i] - (int32_t)lo);
+    }
+    strcpy(slot->name, name);
+    slot->data = (srmodel_data_t){
+        .num = file_num,
+        .files = slot->files,
+        .data = slot->file_data,
+        .sizes = slot->sizes,
+    };
+    models->names[models->slot_num] = slot->name;
+    models->data[models->slot_num] = &slot->data;
+    models->slot_num++;
+
+    ESP_LOGI(TAG, "📦 映射模型 %s: %d 个文件，%u KB", name, (int)file_num,
+             (unsigned)(slot->mapped_bytes / 1024));
+    return ESP_OK;
+}
+
+/**
+ * @brief 映射选中的模型
+ *
+ * 逐条读取分区头，只为选中的模型读取文件表并映射；未选中的模型不产生任何映射。
+ *
+ * @param select 模型选择
+ * @param out 输出映射句柄
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t afe_models_map(const afe_models_select_t *select, afe_models_handle_t *out)
+{
+    if (!select || !out || !select->partition) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(select->partition) >= sizeof(((afe_models_t *)0)->partition) ||
+        (select->wake_model && strlen(select->wake_model) > AFE_MODELS_NAME_LEN)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, select->partition);
+    if (!part) {
+        ESP_LOGE(TAG, "未找到模型分区: %s", select->partition);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    afe_models_t *models = (afe_models_t *)calloc(1, sizeof(afe_models_t));
+    if (!models) {
+        return ESP_ERR_NO_MEM;
+    }
+    strcpy(models->partition, select->partition);
+    if (select->wake_model) {
+        strcpy(models->wake_model, select->wake_model);
+    }
+    models->wakenet = select->wakenet;
+    models->vadnet = select->vadnet;
+    models->nsnet = select->nsnet;
+
+    int32_t model_num = 0;
+    esp_err_t ret = esp_partition_read(part, 0, &model_num, sizeof(model_num));
+    if (ret == ESP_OK && (model_num <= 0 || model_num > AFE_MODELS_MAX_ENTRIES)) {
+        ESP_LOGE(TAG, "分区 %s 不是有效的模型镜像（模型数 %d）", select->partition, (int)model_num);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t offset = sizeof(model_num);
+    for (int32_t i = 0; ret == ESP_OK && i < model_num; i++) {
+        uint8_t entry[AFE_MODELS_ENTRY_BYTES];
+        ret = esp_partition_read(part, offset, entry, sizeof(entry));
+        if (ret != ESP_OK) {
+            break;
+        }
+        char name[AFE_MODELS_NAME_LEN + 1] = {0};
+        int32_t file_num;
+        memcpy(name, entry, AFE_MODELS_NAME_LEN);
+        memcpy(&file_num, entry + AFE_MODELS_NAME_LEN, sizeof(file_num));
+        offset += AFE_MODELS_ENTRY_BYTES;
+        if (file_num < 0 || file_num > AFE_MODELS_MAX_ENTRY_FILES) {
+            ESP_LOGE(TAG, "模型 %s 文件数无效: %d", name, (int)file_num);
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+
+        if (afe_models_take(models, name)) {
+            ret = afe_models_map_one(models, part, offset, name, file_num);
+        }
+        offset += (size_t)file_num * AFE_MODELS_FILE_BYTES;
+    }
+
+    if (ret == ESP_OK && models->wakenet && !models->has_wakenet) {
+        ESP_LOGE(TAG, "分区 %s 中没有 WakeNet 模型 %s", select->partition,
+                 models->wake_model[0] ? models->wake_model : "");
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    if (ret != ESP_OK) {
+        afe_models_unmap(models);
+        return ret;
+    }
+
+    models->list = (srmodel_list_t){
+        .model_name = models->names,
+        .partition_label = models->partition,
+        .model_data = models->data,
+        .num = models->slot_num,
+    };
+    ESP_LOGI(TAG, "✅ 从 %s 映射了 %d 个模型，共 %u KB", select->partition, models->slot_num,
+             (unsigned)(afe_models_get_mapped_bytes(models) / 1024));
+    *out = models;
+    return ESP_OK;
+}
+
+/**
+ * @brief 解除映射并释放句柄
+ */
+void afe_models_unmap(afe_models_handle_t models)
+{
+    if (!models) return;
+
+    for (uint8_t i = 0; i < models->slot_num; i++) {
+        esp_partition_munmap(models->slots[i].mmap);
+    }
+    free(models);
+}
+
+/**
+ * @brief 获取 esp-sr 模型列表
+ */
+srmodel_list_t *afe_models_get_list(afe_models_handle_t models)
+{
+    return models ? &models->list : NULL;
+}
+
+/**
+ * @brief 判断已映射的模型是否满足选择
+ */
+bool afe_models_matches(afe_models_handle_t models, const afe_models_select_t *select)
+{
+    if (!models || !select || !select->partition) {
+        return false;
+    }
+    const char *wake_model = select->wake_model ? select->wake_model : "";
+    return strcmp(models->partition, select->partition) == 0 &&
+           strcmp(models->wake_model, wake_model) == 0 &&
+           models->wakenet == select->wakenet &&
+           models->vadnet == select->vadnet &&
+           models->nsnet == select->nsnet;
+}
+
+/**
+ * @brief 获取映射的 Flash 总字节数
+ */
+size_t afe_models_get_mapped_bytes(afe_models_handle_t models)
+{
+    if (!models) return 0;
+
+    size_t bytes = 0;
+    for (uint8_t i = 0; i < models->slot_num; i++) {
+        bytes += models->slots[i].mapped_bytes;
+    }
+    return bytes;
+}
@@ -9,49 +9,240 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "afe_wrapper.h"
+#include "afe_models.h"
+#include "audio_dsp.h"
+#include "audio_trace.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_gmf_afe_manager.h"
 #include "esp_afe_sr_models.h"
 #include "esp_afe_sr_iface.h"
 #include "esp_afe_config.h"
 #include "model_path.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 #include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "AFE_WRAPPER";
 
+/**
+ * @brief 预加载的模型缓存
+ *
+ * 启动时可与其他初始化并行加载，并在管线销毁/重建后保留，直到显式释放。
+ * 预加载、释放与 afe_wrapper_create/destroy 需由调用方保证不并发。
+ */
+static struct {
+    char partition[17];                         ///< 模型分区名称（分区标签最长 16 字符）
+    srmodel_list_t *models;                     ///< 已加载的模型列表
+    uint8_t users;                              ///< 正在使用缓存的包装器数量
+} s_model_cache;
+
 /**
  * @brief AFE 包装器上下文结构体
  * 
  * 封装了 AFE Manager 和语音识别相关的所有状态和资源
  */
 typedef struct afe_wrapper_s {
+    audio_arena_handle_t arena;                 ///< 所属内存区（NULL 表示堆分配）
     esp_gmf_afe_manager_handle_t afe_manager;  ///< AFE Manager 句柄
     esp_afe_sr_iface_t *afe_handle;            ///< AFE 接口句柄
     srmodel_list_t *models;                     ///< 语音识别模型列表
+    bool models_cached;                         ///< 模型来自预加载缓存（销毁时不释放）
+#if CONFIG_AUDIO_MANAGER_MODEL_MMAP
+    afe_models_handle_t mapped;                 ///< 已映射的模型（models 指向其列表）
+#endif
     
     audio_bsp_handle_t bsp_handle;              ///< BSP 句柄，用于读取麦克风数据
-    ring_buffer_handle_t reference_rb;         ///< 回采数据环形缓冲区
+    aec_reference_handle_t reference;          ///< 回采对齐
     
     afe_wakeup_config_t wakeup_config;         ///< 唤醒词配置
+    afe_feature_config_t feature_config;       ///< 当前期望的功能配置（完整档位下启用的处理）
+    afe_vad_config_t vad_config;               ///< 当前期望的 VAD 配置
+    afe_feature_config_t built_features;       ///< AFE Manager 创建时初始化的功能（仅这些可运行时开关）
+    afe_vad_config_t built_vad;                ///< AFE Manager 创建时的 VAD 配置
+    SemaphoreHandle_t lock;                    ///< 档位切换、功能更新与重建互斥
     afe_event_callback_t event_callback;       ///< 事件回调函数
     void *event_ctx;                            ///< 事件回调上下文
     afe_record_callback_t record_callback;      ///< 录音数据回调函数
     void *record_ctx;                           ///< 录音回调上下文
+    afe_speaker_pull_t speaker_pull;            ///< 全双工扬声器数据源（NULL 表示扬声器由播放任务独立写入）
+    void *speaker_ctx;                          ///< 扬声器数据源上下文
     
     bool *running_ptr;                          ///< 指向运行状态标志的指针
     bool *recording_ptr;                        ///< 指向录音状态标志的指针
+    bool was_recording;                         ///< 上一帧的录音状态（检测录音开始）
+    bool vad_active;                            ///< 是否处于人声段（Fetch 任务读写，重建时复位）
+    
+    // 预录（仅 Fetch 任务读写）
+    ring_buffer_handle_t preroll_rb;            ///< 预录缓冲区：未录音时保存最近的 AFE 输出
+    volatile uint64_t stream_pos;               ///< AFE 输出流位置（采样点数）
+    volatile uint64_t record_start_pos;         ///< 本段录音第一个采样的流位置
+    portMUX_TYPE pos_lock;                      ///< 保护上面两个 64 位位置（32 位 CPU 上读写非原子，读者可能在定时器/ISR 中）
+    
+    // 运行档位
+    afe_low_power_config_t low_power_config;    ///< 低功耗监听配置
+    afe_profile_t profile;                      ///< 当前档位
+    volatile uint32_t rx_dma_frame_req;         ///< 期望的 RX DMA 帧长（0 为默认，Feed 任务中生效）
+    uint32_t rx_dma_frame_cur;                  ///< 已生效的 RX DMA 帧长（仅 Feed 任务读写）
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock;               ///< 完整档位持有的 CPU 最高频率锁
+#endif
+
+    // 任务句柄（esp_gmf_afe_manager 内部创建，首次回调时记录，重建时清空）
+    volatile TaskHandle_t feed_task;            ///< Feed 任务
+    volatile TaskHandle_t fetch_task;           ///< Fetch 任务
+
+    // 跟踪（仅 Feed 任务读写）
+    uint32_t feed_pos;                          ///< 已送入 AFE 的累计采样数（与 stream_pos 一一对应）
+    uint32_t feed_exit_us;                      ///< 上次读取回调返回的时刻（0 表示未在送入）
+
+    // 负载统计（始终开启；feed_* 仅 Feed 任务写，fetch_* 仅 Fetch 任务写）
+    uint32_t load_feed_exit_us;                 ///< 上次读取回调返回的时刻（0 表示未在送入）
+    uint32_t load_feed_frame_us;                ///< 上一帧的音频时长
+    volatile uint32_t load_feed_busy_us;        ///< 累计 feed 耗时
+    volatile uint32_t load_feed_misses;         ///< feed 超时帧数
+    uint32_t load_fetch_last_us;                ///< 上次结果回调进入的时刻
+    volatile uint32_t load_fetch_busy_us;       ///< 累计结果回调耗时
+    volatile uint32_t load_fetch_misses;        ///< 输出停顿次数
+    int8_t feed_core;                           ///< Feed 任务核心
+    int8_t fetch_core;                          ///< Fetch 任务核心
     
-    // 静态缓冲区（避免频繁 malloc）
-    int16_t mic_buffer[512];                    ///< 麦克风数据缓冲区
-    int16_t ref_buffer[512];                    ///< 回采数据缓冲区
+    // 输入声道排列
+    char input_format[AFE_WRAPPER_MAX_CHANNELS + 1];   ///< AFE 输入格式（如 "MR"、"MMR"）
+    int8_t channel_map[AFE_WRAPPER_MAX_CHANNELS];      ///< 每个输入声道的来源：>=0 麦克风序号，AFE_CH_REF/AFE_CH_NONE
+    uint8_t channels;                           ///< AFE 输入声道数
+    uint8_t mic_num;                            ///< 麦克风数
+
+    // 预分配缓冲区（避免频繁 malloc）
+    int16_t *mic_buffer;                        ///< 麦克风数据（按声道平面，mic_num * AFE_WRAPPER_MAX_FRAME_SAMPLES）
+    int16_t *spk_buffer;                        ///< 全双工扬声器帧（AFE_WRAPPER_MAX_FRAME_SAMPLES，仅全双工分配）
 } afe_wrapper_t;
 
+/** 输入声道来源：回采 / 空声道 */
+#define AFE_CH_REF      (-1)
+#define AFE_CH_NONE     (-2)
+
+/**
+ * @brief 解析 AFE 输入格式并生成声道来源表（创建与占用预估共用）
+ * 
+ * 格式由 M（麦克风，按出现顺序对应 0、1... 号）、R（回采，最多一个）、N（空声道）组成，
+ * M 的个数须与麦克风数一致。未指定时使用 mic_num 个 M 加一个 R。
+ * 
+ * @param config 配置参数
+ * @param format 输出格式字符串（AFE_WRAPPER_MAX_CHANNELS + 1 字节）
+ * @param map 输出声道来源表（可为 NULL）
+ * @return 声道数，格式无效返回 0
+ */
+static uint8_t afe_parse_input_format(const afe_wrapper_config_t *config, char *format, int8_t *map)
+{
+    uint8_t mic_num = config->mic_num ? config->mic_num : 1;
+    if (config->input_format) {
+        if (strlen(config->input_format) > AFE_WRAPPER_MAX_CHANNELS) {
+            return 0;
+        }
+        strcpy(format, config->input_format);
+    } else {
+        if (mic_num + 1 > AFE_WRAPPER_MAX_CHANNELS) {
+            return 0;
+        }
+        memset(format, 'M', mic_num);
+        format[mic_num] = 'R';
+        format[mic_num + 1] = '\0';
+    }
+
+    int8_t mic = 0;
+    int refs = 0;
+    uint8_t channels = 0;
+    for (; format[channels] != '\0'; channels++) {
+        int8_t src;
+        switch (format[channels]) {
+        case 'M': src = mic++;       break;
+        case 'R': src = AFE_CH_REF;  refs++; break;
+        case 'N': src = AFE_CH_NONE; break;
+        default:  return 0;
+        }
+        if (map) {
+            map[channels] = src;
+        }
+    }
+
+    if (mic != mic_num || refs > 1) {
+        return 0;
+    }
+    return channels;
+}
+
+/**
+ * @brief 读取回调返回前记录送入位置（跟踪用）
+ * 
+ * @param wrapper AFE 包装器
+ * @param samples 本次送入 AFE 的每通道采样数
+ */
+static inline void afe_trace_feed(afe_wrapper_t *wrapper, size_t samples)
+{
+    wrapper->feed_pos += samples;
+    audio_trace_mark(AUDIO_TRACE_AFE_FEED, wrapper->feed_pos);
+    wrapper->feed_exit_us = audio_trace_now();
+    wrapper->load_feed_frame_us = (uint32_t)(samples * 1000000ULL / AFE_WRAPPER_SAMPLE_RATE);
+    wrapper->load_feed_exit_us = (uint32_t)esp_timer_get_time();
+}
+
+/**
+ * @brief 按输入格式把麦克风平面与一段回采交织进 AFE 输入缓冲
+ * 
+ * @param wrapper AFE 包装器
+ * @param out AFE 输入缓冲（帧首）
+ * @param stride 麦克风声道平面间隔（本帧每声道采样数）
+ * @param offset 本段在帧内的起始采样
+ * @param ref 本段回采（NULL 表示静音）
+ * @param count 本段采样数
+ */
+static void afe_fill_input(afe_wrapper_t *wrapper, int16_t *out, size_t stride, size_t offset,
+                           const int16_t *ref, size_t count)
+{
+    const int16_t *src[AFE_WRAPPER_MAX_CHANNELS];
+    for (int c = 0; c < wrapper->channels; c++) {
+        int8_t m = wrapper->channel_map[c];
+        src[c] = (m >= 0) ? wrapper->mic_buffer + m * stride + offset : (m == AFE_CH_REF ? ref : NULL);
+    }
+    audio_dsp_interleave_s16(src, wrapper->channels, out + offset * wrapper->channels, count);
+}
+
+/**
+ * @brief 全双工：写入一帧扬声器数据并记录回采
+ * 
+ * 与随后的麦克风读取在同一任务、同一 I2S 时钟下锁步进行：TX 写入阻塞到一个 DMA 帧播完，
+ * 此时 RX 恰好采满一帧，因此 TX 队列深度恒定，回采与回声的相对位置逐帧不变。
+ * 无播放数据时同样写入静音，保持锁步；回采只记录含播放数据的帧。
+ * 
+ * @param wrapper AFE 包装器
+ * @param frame_samples 本帧采样数
+ */
+static void afe_duplex_output(afe_wrapper_t *wrapper, size_t frame_samples)
+{
+    uint8_t volume = 0;
+    size_t n = wrapper->speaker_pull(wrapper->spk_buffer, frame_samples, &volume, wrapper->speaker_ctx);
+    if (n < frame_samples) {
+        memset(wrapper->spk_buffer + n, 0, (frame_samples - n) * sizeof(int16_t));
+    }
+
+    audio_bsp_write_speaker(wrapper->bsp_handle, wrapper->spk_buffer, frame_samples, volume);
+    if (n > 0) {
+        aec_reference_write(wrapper->reference, wrapper->spk_buffer, frame_samples);
+    }
+}
+
 /**
  * @brief AFE 读取回调函数
  * 
- * 从 I2S HAL 读取麦克风数据，从环形缓冲区读取回采数据，
- * 并将两者交织成 MR（麦克风+回采）格式供 AFE 处理
+ * 从 I2S HAL 读取麦克风数据，直接在回采环形缓冲区内查看回采数据（零拷贝），
+ * 并按输入格式（如 MR、MMR）交织供 AFE 处理；全双工时读取前先写一帧扬声器数据
  * 
  * @param buffer 输出缓冲区，用于存放交织后的音频数据
  * @param buf_sz 缓冲区大小（字节）
@@ -63,16 +254,32 @@ static int32_t afe_read_callback(void *buffer, int buf_sz, void *user_ctx, TickT
 {
     afe_wrapper_t *wrapper = (afe_wrapper_t *)user_ctx;
     if (!buffer || buf_sz == 0 || !wrapper) return 0;
+    if (!wrapper->feed_task) {
+        wrapper->feed_task = xTaskGetCurrentTaskHandle();
+    }
 
     int16_t *out_buf = (int16_t *)buffer;
     const size_t total_samples = buf_sz / sizeof(int16_t);
-    const size_t channels = 2;  // MR: 麦克风+回采
+    const size_t channels = wrapper->channels;
     const size_t frame_samples = total_samples / channels;
 
+    // 两次读取之间即 AFE feed 的处理耗时；超过一帧时长说明下一帧的麦克风数据已在 DMA 中等待
+    if (wrapper->feed_exit_us) {
+        audio_trace_record(AUDIO_TRACE_CPU_FEED, audio_trace_now() - wrapper->feed_exit_us);
+    }
+    if (wrapper->load_feed_exit_us) {
+        uint32_t busy_us = (uint32_t)esp_timer_get_time() - wrapper->load_feed_exit_us;
+        wrapper->load_feed_busy_us += busy_us;
+        if (busy_us > wrapper->load_feed_frame_us) {
+            wrapper->load_feed_misses++;
+        }
+    }
+
     // 检查帧大小是否超出缓冲区限制
-    if (frame_samples > 512) {
+    if (frame_samples > AFE_WRAPPER_MAX_FRAME_SAMPLES) {
         ESP_LOGE(TAG, "AFE 读取帧过大: %d", (int)frame_samples);
         memset(out_buf, 0, buf_sz);
+        afe_trace_feed(wrapper, frame_samples);
         return buf_sz;
     }
 
@@ -80,37 +287,111 @@ static int32_t afe_read_callback(void *buffer, int buf_sz, void *user_ctx, TickT
 
     // 仅在运行状态下读取数据
     if (wrapper->running_ptr && *wrapper->running_ptr) {
+        // 档位切换后的 RX DMA 帧长在读取麦克风的任务中生效，避免与读取并发重建通道
+        uint32_t dma_frame = wrapper->rx_dma_frame_req;
+        if (dma_frame != wrapper->rx_dma_frame_cur) {
+            audio_bsp_set_mic_dma_frame(wrapper->bsp_handle, dma_frame);
+            wrapper->rx_dma_frame_cur = dma_frame;
+        }
+
+        if (wrapper->speaker_pull) {
+            afe_duplex_output(wrapper, frame_samples);
+        }
+
         // 读取麦克风数据
         esp_err_t ret = audio_bsp_read_mic(wrapper->bsp_handle, wrapper->mic_buffer, 
                                          frame_samples, &mic_got);
 
         if (ret != ESP_OK || mic_got == 0) {
             memset(out_buf, 0, buf_sz);
+            afe_trace_feed(wrapper, frame_samples);
             return buf_sz;
         }
+        int64_t capture_end_us = esp_timer_get_time();
+        audio_trace_mark(AUDIO_TRACE_MIC_READ, wrapper->feed_pos + (uint32_t)mic_got);
 
-        // 读取回采数据（用于回声消除）
-        size_t ref_got = ring_buffer_read(wrapper->reference_rb, wrapper->ref_buffer, mic_got, 0);
+        // 取出与本帧同一时刻播出的回采（用于回声消除），直接从回采缓冲区内存交织
+        aec_reference_frame_t ref_frame = {0};
+        aec_reference_fetch(wrapper->reference, mic_got, capture_end_us, &ref_frame);
 
-        // 如果回采数据不足，用静音填充
-        if (ref_got < mic_got) {
-            memset(wrapper->ref_buffer + ref_got, 0, (mic_got - ref_got) * sizeof(int16_t));
+        // 交织数据（M=麦克风，R=回采，N=空）；回采尚未播出的帧首部分用静音
+        size_t i = ref_frame.lead;
+        afe_fill_input(wrapper, out_buf, frame_samples, 0, NULL, i);
+        for (int seg = 0; seg < 2 && ref_frame.span.len[seg] > 0; seg++) {
+            afe_fill_input(wrapper, out_buf, frame_samples, i, ref_frame.span.data[seg],
+                           ref_frame.span.len[seg]);
+            i += ref_frame.span.len[seg];
         }
 
-        // 交织数据: MR 格式（M=麦克风，R=回采）
-        for (size_t i = 0; i < mic_got; i++) {
-            out_buf[i * 2 + 0] = wrapper->mic_buffer[i];  // M: 麦克风
-            out_buf[i * 2 + 1] = wrapper->ref_buffer[i];  // R: 回采
+        // 如果回采数据不足，用静音填充
+        if (i < mic_got) {
+            afe_fill_input(wrapper, out_buf, frame_samples, i, NULL, mic_got - i);
         }
+
+        // 延迟估计使用 0 号麦克风（第一个声道平面）
+        aec_reference_release(wrapper->reference, wrapper->mic_buffer, mic_got, &ref_frame);
     } else {
+        // 全双工：未监听时仍锁步输出扬声器，麦克风数据丢弃
+        if (wrapper->speaker_pull) {
+            afe_duplex_output(wrapper, frame_samples);
+            audio_bsp_read_mic(wrapper->bsp_handle, wrapper->mic_buffer, frame_samples, NULL);
+        }
+
         // 未运行时填充静音，并临时不向 AFE 提供有效数据，避免在系统尚未开始监听时填满内部 ringbuffer
         memset(out_buf, 0, buf_sz);
+        wrapper->feed_exit_us = 0;
+        wrapper->load_feed_exit_us = 0;
         return 0;
     }
 
+    afe_trace_feed(wrapper, mic_got);
     return mic_got * channels * sizeof(int16_t);
 }
 
+/**
+ * @brief 预录缓冲区配置（创建与占用预估共用）
+ */
+static ring_buffer_config_t afe_preroll_config(const afe_wrapper_config_t *config)
+{
+    // 写入与读取都在 Fetch 任务中，无锁模式即可
+    ring_buffer_config_t rb_cfg = RING_BUFFER_DEFAULT_CONFIG(config->preroll_samples);
+    rb_cfg.lock_free = true;
+    rb_cfg.arena = config->arena;
+    return rb_cfg;
+}
+
+/**
+ * @brief 录音开始时输出预录数据
+ * 
+ * 直接在预录缓冲区内查看（零拷贝）并回调，最多两段连续区间；
+ * 同时记录本段录音起点的流位置，供事件对齐。
+ * 
+ * @param wrapper AFE 包装器
+ * @param current 当前帧采样点数（已计入 stream_pos，尚未输出）
+ */
+static void afe_flush_preroll(afe_wrapper_t *wrapper, size_t current)
+{
+    ring_buffer_span_t span = {0};
+    size_t avail = wrapper->preroll_rb ? ring_buffer_available(wrapper->preroll_rb) : 0;
+
+    portENTER_CRITICAL(&wrapper->pos_lock);
+    wrapper->record_start_pos = wrapper->stream_pos - current - avail;
+    portEXIT_CRITICAL(&wrapper->pos_lock);
+    if (avail == 0) {
+        return;
+    }
+
+    if (ring_buffer_peek_read(wrapper->preroll_rb, avail, &span, 0) == ESP_OK) {
+        for (int i = 0; i < 2 && span.len[i] > 0; i++) {
+            if (wrapper->record_callback) {
+                wrapper->record_callback(span.data[i], span.len[i], wrapper->record_ctx);
+            }
+        }
+        ring_buffer_release_read(wrapper->preroll_rb, span.total);
+    }
+    ESP_LOGD(TAG, "预录数据输出: %u 采样", (unsigned)span.total);
+}
+
 /**
  * @brief AFE 结果回调函数
  * 
@@ -123,8 +404,32 @@ static void afe_result_callback(afe_fetch_result_t *result, void *user_ctx)
 {
     afe_wrapper_t *wrapper = (afe_wrapper_t *)user_ctx;
     if (!result || !wrapper || !wrapper->event_callback) return;
+    if (!wrapper->fetch_task) {
+        wrapper->fetch_task = xTaskGetCurrentTaskHandle();
+    }
+
+    uint32_t enter_us = audio_trace_now();
+    uint32_t load_enter_us = (uint32_t)esp_timer_get_time();
+    size_t samples = (result->data && result->data_size > 0) ? result->data_size / sizeof(int16_t) : 0;
+
+    // 输出停顿：数据已在 AFE 内积压，两次输出间隔仍超过两帧（Fetch 任务被抢占或处理过慢）
+    uint32_t frame_us = (uint32_t)(samples * 1000000ULL / AFE_WRAPPER_SAMPLE_RATE);
+    if (wrapper->load_fetch_last_us && samples > 0 &&
+        load_enter_us - wrapper->load_fetch_last_us > 2 * frame_us &&
+        (int32_t)(wrapper->feed_pos - (uint32_t)wrapper->stream_pos) >= (int32_t)(2 * samples)) {
+        wrapper->load_fetch_misses++;
+    }
+    wrapper->load_fetch_last_us = load_enter_us;
+
+    portENTER_CRITICAL(&wrapper->pos_lock);
+    wrapper->stream_pos += samples;
+    portEXIT_CRITICAL(&wrapper->pos_lock);
+    audio_trace_mark(AUDIO_TRACE_AFE_FETCH, (uint32_t)wrapper->stream_pos);
 
-    afe_event_t event = {0};
+    afe_event_t event = {
+        .timestamp_us = esp_timer_get_time(),
+        .sample_pos = wrapper->stream_pos,
+    };
 
     // 处理唤醒词检测事件
     if (result->wakeup_state == WAKENET_DETECTED) {
@@ -139,98 +444,164 @@ static void afe_result_callback(afe_fetch_result_t *result, void *user_ctx)
     }
 
     // 处理 VAD（语音活动检测）状态变化
-    static bool vad_active = false;
-
-    if (result->vad_state == VAD_SPEECH && !vad_active) {
+    if (result->vad_state == VAD_SPEECH && !wrapper->vad_active) {
         // 检测到语音开始
-        vad_active = true;
+        wrapper->vad_active = true;
         event.type = AFE_EVENT_VAD_START;
         wrapper->event_callback(&event, wrapper->event_ctx);
-    } else if (result->vad_state == VAD_SILENCE && vad_active) {
+    } else if (result->vad_state == VAD_SILENCE && wrapper->vad_active) {
         // 检测到语音结束
-        vad_active = false;
+        wrapper->vad_active = false;
         event.type = AFE_EVENT_VAD_END;
         wrapper->event_callback(&event, wrapper->event_ctx);
     }
 
     // 处理录音数据回调
-    if (wrapper->recording_ptr && *wrapper->recording_ptr && 
-        result->data && result->data_size > 0 && wrapper->record_callback) {
-        size_t samples = result->data_size / sizeof(int16_t);
-        wrapper->record_callback((const int16_t *)result->data, samples, wrapper->record_ctx);
+    bool recording = wrapper->recording_ptr && *wrapper->recording_ptr;
+    if (recording && !wrapper->was_recording) {
+        // 录音开始：先把预录数据作为一段突发回调，再接续当前帧
+        afe_flush_preroll(wrapper, samples);
+    }
+    wrapper->was_recording = recording;
+
+    if (samples == 0) {
+        wrapper->load_fetch_busy_us += (uint32_t)esp_timer_get_time() - load_enter_us;
+        return;
+    }
+    if (recording) {
+        if (wrapper->record_callback) {
+            wrapper->record_callback((const int16_t *)result->data, samples, wrapper->record_ctx);
+        }
+        audio_trace_mark(AUDIO_TRACE_RECORD_CB, (uint32_t)wrapper->stream_pos);
+    } else if (wrapper->preroll_rb) {
+        // 未录音：写入预录缓冲区，满时覆盖最旧数据
+        ring_buffer_write(wrapper->preroll_rb, (const int16_t *)result->data, samples);
     }
+
+    // 本帧第一个采样从 I2S 读出到此刻的延迟，以及本回调的处理耗时
+    audio_trace_latency(AUDIO_TRACE_LAT_MIC_TO_CALLBACK, AUDIO_TRACE_MIC_READ,
+                        (uint32_t)(wrapper->stream_pos - samples + 1));
+    audio_trace_record(AUDIO_TRACE_CPU_FETCH, audio_trace_now() - enter_us);
+    wrapper->load_fetch_busy_us += (uint32_t)esp_timer_get_time() - load_enter_us;
 }
 
 /**
- * @brief 创建 AFE 包装器
+ * @brief 按当前唤醒词配置准备模型列表（调用方保证 AFE Manager 未运行）
  * 
- * 初始化 AFE Manager，加载唤醒词模型，配置各种音频处理功能
+ * 映射模式下只映射 WakeNet 与 built_vad/built_features 需要的 VADNet/NSNet，
+ * 选择变化（换唤醒词、首次开启 VAD/NS）时先解除旧映射再重新映射；
+ * 关闭唤醒词时解除全部映射。esp-sr 模式下首次使用时加载整个分区（或取预加载缓存），之后不再重新加载。
  * 
- * @param config AFE 包装器配置
- * @return afe_wrapper_handle_t AFE 包装器句柄，失败返回 NULL
+ * @param wrapper AFE 包装器
+ * @return esp_err_t ESP_OK 成功
  */
-afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
+static esp_err_t afe_wrapper_load_models(afe_wrapper_t *wrapper)
 {
-    if (!config || !config->bsp_handle || !config->reference_rb || !config->event_callback) {
-        ESP_LOGE(TAG, "无效的配置参数");
-        return NULL;
-    }
+    const afe_wakeup_config_t *wakeup = &wrapper->wakeup_config;
 
-    // 分配包装器上下文内存
-    afe_wrapper_t *wrapper = (afe_wrapper_t *)calloc(1, sizeof(afe_wrapper_t));
-    if (!wrapper) {
-        ESP_LOGE(TAG, "AFE 包装器分配失败");
-        return NULL;
+#if CONFIG_AUDIO_MANAGER_MODEL_MMAP
+    afe_models_select_t select = {
+        .partition = wakeup->model_partition,
+        .wake_model = wakeup->wake_model_name,
+        .wakenet = true,
+        .vadnet = wrapper->built_vad.enabled,
+        .nsnet = wrapper->built_features.ns_enabled,
+    };
+    if (wakeup->enabled && afe_models_matches(wrapper->mapped, &select)) {
+        return ESP_OK;
+    }
+    afe_models_unmap(wrapper->mapped);
+    wrapper->mapped = NULL;
+    wrapper->models = NULL;
+    if (!wakeup->enabled) {
+        return ESP_OK;
     }
 
-    // 保存配置参数
-    wrapper->bsp_handle = config->bsp_handle;
-    wrapper->reference_rb = config->reference_rb;
-    wrapper->wakeup_config = config->wakeup_config;
-    wrapper->event_callback = config->event_callback;
-    wrapper->event_ctx = config->event_ctx;
-    wrapper->record_callback = config->record_callback;
-    wrapper->record_ctx = config->record_ctx;
-    wrapper->running_ptr = config->running_ptr;
-    wrapper->recording_ptr = config->recording_ptr;
+    ESP_LOGI(TAG, "映射唤醒词模型: %s（%s）", wakeup->wake_word_name,
+             wakeup->wake_model_name ? wakeup->wake_model_name : "默认 WakeNet");
+    esp_err_t ret = afe_models_map(&select, &wrapper->mapped);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "模型映射失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    wrapper->models = afe_models_get_list(wrapper->mapped);
+    return ESP_OK;
+#else
+    if (!wakeup->enabled || wrapper->models) {
+        return ESP_OK;
+    }
 
-    // 加载唤醒词模型
-    if (config->wakeup_config.enabled) {
-        ESP_LOGI(TAG, "加载唤醒词模型: %s", config->wakeup_config.wake_word_name);
-        wrapper->models = esp_srmodel_init(config->wakeup_config.model_partition);
+    ESP_LOGI(TAG, "加载唤醒词模型: %s", wakeup->wake_word_name);
+    if (s_model_cache.models && wakeup->model_partition &&
+        strcmp(s_model_cache.partition, wakeup->model_partition) == 0) {
+        wrapper->models = s_model_cache.models;
+        wrapper->models_cached = true;
+        s_model_cache.users++;
+        ESP_LOGI(TAG, "✅ 使用预加载的 %d 个模型", wrapper->models->num);
+    } else {
+        wrapper->models = esp_srmodel_init(wakeup->model_partition);
         if (!wrapper->models) {
             ESP_LOGE(TAG, "模型加载失败");
-            free(wrapper);
-            return NULL;
+            return ESP_FAIL;
         }
         ESP_LOGI(TAG, "✅ 加载了 %d 个模型", wrapper->models->num);
     }
+    return ESP_OK;
+#endif
+}
+
+/**
+ * @brief 按 built_features/built_vad 创建 AFE Manager 并设置结果回调
+ * 
+ * 创建与热重建共用；模型由 afe_wrapper_load_models 准备，选择未变化时不会重新读取模型分区。
+ * 
+ * @param wrapper AFE 包装器
+ * @return esp_err_t ESP_OK 成功
+ */
+static esp_err_t afe_wrapper_start_manager(afe_wrapper_t *wrapper)
+{
+    const afe_feature_config_t *features = &wrapper->built_features;
+    const afe_vad_config_t *vad = &wrapper->built_vad;
+
+    esp_err_t ret = afe_wrapper_load_models(wrapper);
+    if (ret != ESP_OK) {
+        return ret;
+    }
 
     // 配置 AFE
     ESP_LOGI(TAG, "配置 AFE Manager...");
-    afe_config_t *afe_config = afe_config_init("MR", wrapper->models, AFE_TYPE_SR, 
-                                                config->feature_config.afe_mode);
+    afe_config_t *afe_config = afe_config_init(wrapper->input_format, wrapper->models, AFE_TYPE_SR, 
+                                                features->afe_mode);
     if (!afe_config) {
         ESP_LOGE(TAG, "AFE 配置失败");
-        if (wrapper->models) esp_srmodel_deinit(wrapper->models);
-        free(wrapper);
-        return NULL;
+        return ESP_FAIL;
+    }
+
+    // 指定 WakeNet 模型（未指定时 afe_config_init 取列表中第一个）
+    if (wrapper->models && wrapper->wakeup_config.wake_model_name) {
+        char *wake_model = esp_srmodel_filter(wrapper->models, ESP_WN_PREFIX,
+                                              wrapper->wakeup_config.wake_model_name);
+        if (wake_model) {
+            afe_config->wakenet_model_name = wake_model;
+        } else {
+            ESP_LOGW(TAG, "⚠️ 未找到 WakeNet 模型 %s，使用默认模型", wrapper->wakeup_config.wake_model_name);
+        }
     }
 
     // 配置音频处理功能
-    afe_config->aec_init = config->feature_config.aec_enabled;      // 回声消除
+    afe_config->aec_init = features->aec_enabled;                   // 回声消除
     afe_config->se_init = false;                                    // 语音增强（未启用）
-    afe_config->vad_init = config->vad_config.enabled;              // 语音活动检测
-    afe_config->vad_mode = config->vad_config.vad_mode;             // VAD 模式
-    afe_config->vad_min_speech_ms = config->vad_config.min_speech_ms;   // 最小语音时长
-    afe_config->vad_min_noise_ms = config->vad_config.min_silence_ms;   // 最小静音时长
-    afe_config->wakenet_init = config->wakeup_config.enabled;      // 唤醒词检测
-    afe_config->wakenet_mode = config->wakeup_config.sensitivity;   // 唤醒词灵敏度
-    afe_config->afe_perferred_core = 0;                             // 优先运行在核心 0
+    afe_config->vad_init = vad->enabled;                            // 语音活动检测
+    afe_config->vad_mode = vad->vad_mode;                           // VAD 模式
+    afe_config->vad_min_speech_ms = vad->min_speech_ms;             // 最小语音时长
+    afe_config->vad_min_noise_ms = vad->min_silence_ms;             // 最小静音时长
+    afe_config->wakenet_init = wrapper->wakeup_config.enabled;      // 唤醒词检测
+    afe_config->wakenet_mode = wrapper->wakeup_config.sensitivity;  // 唤醒词灵敏度
+    afe_config->afe_perferred_core = wrapper->fetch_core;           // AFE 内部任务与 Fetch 同核
     afe_config->afe_perferred_priority = 8;                         // 任务优先级
     afe_config->memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM;    // 优先使用 PSRAM
-    afe_config->agc_init = config->feature_config.agc_enabled;     // 自动增益控制
-    afe_config->ns_init = config->feature_config.ns_enabled;       // 噪声抑制
+    afe_config->agc_init = features->agc_enabled;                   // 自动增益控制
+    afe_config->ns_init = features->ns_enabled;                     // 噪声抑制
     afe_config->afe_ringbuf_size = 120;                             // 环形缓冲区大小（加大以提供更多缓冲空间）
 
     // 验证配置并创建 AFE 句柄
@@ -243,32 +614,146 @@ afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
         .read_cb = afe_read_callback,              // 数据读取回调
         .read_ctx = wrapper,                       // 读取回调上下文
         .feed_task_setting = {
-            .stack_size = 10 * 1024,               // Feed 任务栈大小（缩减以降低内部RAM占用）
+            .stack_size = AFE_WRAPPER_FEED_STACK_SIZE,  // Feed 任务栈大小（缩减以降低内部RAM占用）
             .prio = 8,                             // Feed 任务优先级
-            .core = 1,                             // Feed 任务运行核心（保持在 CPU1）
+            .core = wrapper->feed_core,            // Feed 任务运行核心（默认避开 WiFi 所在核心）
         },
         .fetch_task_setting = {
-            .stack_size = 10 * 1024,                // Fetch 任务栈大小（缩减占用）
+            .stack_size = AFE_WRAPPER_FETCH_STACK_SIZE, // Fetch 任务栈大小（缩减占用）
             .prio = 8,                             // Fetch 任务优先级（与Feed相同，时间片轮转）
-            .core = 0,                             // Fetch 任务运行在 CPU0，与 Feed 分核
+            .core = wrapper->fetch_core,           // Fetch 任务运行核心（前有 AFE 环形缓冲，可容忍抢占）
         },
     };
 
-    esp_err_t ret = esp_gmf_afe_manager_create(&mgr_cfg, &wrapper->afe_manager);
+    ret = esp_gmf_afe_manager_create(&mgr_cfg, &wrapper->afe_manager);
     afe_config_free(afe_config);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "AFE Manager 创建失败");
-        if (wrapper->models) esp_srmodel_deinit(wrapper->models);
-        free(wrapper);
-        return NULL;
+        wrapper->afe_manager = NULL;
+        return ret;
     }
 
     // 设置结果回调
     esp_gmf_afe_manager_set_result_cb(wrapper->afe_manager, afe_result_callback, wrapper);
+    return ESP_OK;
+}
+
+/**
+ * @brief 创建 AFE 包装器
+ * 
+ * 初始化 AFE Manager，加载唤醒词模型，配置各种音频处理功能
+ * 
+ * @param config AFE 包装器配置
+ * @return afe_wrapper_handle_t AFE 包装器句柄，失败返回 NULL
+ */
+afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
+{
+    if (!config || !config->bsp_handle || !config->reference || !config->event_callback) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    // 分配包装器上下文内存
+    afe_wrapper_t *wrapper = (afe_wrapper_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                 sizeof(afe_wrapper_t));
+    if (!wrapper) {
+        ESP_LOGE(TAG, "AFE 包装器分配失败");
+        return NULL;
+    }
+    portMUX_INITIALIZE(&wrapper->pos_lock);
+
+    // 保存配置参数
+    wrapper->arena = config->arena;
+    wrapper->bsp_handle = config->bsp_handle;
+    wrapper->reference = config->reference;
+    wrapper->wakeup_config = config->wakeup_config;
+    wrapper->feature_config = config->feature_config;
+    wrapper->vad_config = config->vad_config;
+    wrapper->built_features = config->feature_config;
+    wrapper->built_vad = config->vad_config;
+    wrapper->low_power_config = config->low_power_config;
+    wrapper->profile = AFE_PROFILE_FULL;
+    wrapper->event_callback = config->event_callback;
+    wrapper->event_ctx = config->event_ctx;
+    wrapper->record_callback = config->record_callback;
+    wrapper->record_ctx = config->record_ctx;
+    wrapper->speaker_pull = config->speaker_pull;
+    wrapper->speaker_ctx = config->speaker_ctx;
+    wrapper->running_ptr = config->running_ptr;
+    wrapper->recording_ptr = config->recording_ptr;
+    wrapper->mic_num = config->mic_num ? config->mic_num : 1;
+    wrapper->feed_core = config->feed_core;
+    wrapper->fetch_core = config->fetch_core;
+
+    // 输入声道排列
+    wrapper->channels = afe_parse_input_format(config, wrapper->input_format, wrapper->channel_map);
+    if (wrapper->channels == 0) {
+        ESP_LOGE(TAG, "AFE 输入格式无效: %s（麦克风 %d 路）",
+                 config->input_format ? config->input_format : "(默认)", wrapper->mic_num);
+        goto fail;
+    }
+
+    wrapper->mic_buffer = (int16_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                        (size_t)wrapper->mic_num * AFE_WRAPPER_MAX_FRAME_SAMPLES *
+                                                        sizeof(int16_t));
+    if (!wrapper->mic_buffer) {
+        ESP_LOGE(TAG, "麦克风缓冲区分配失败");
+        goto fail;
+    }
+    if (wrapper->speaker_pull) {
+        if (!audio_bsp_is_full_duplex(wrapper->bsp_handle)) {
+            ESP_LOGE(TAG, "锁步输出要求 BSP 工作在全双工模式");
+            goto fail;
+        }
+        wrapper->spk_buffer = (int16_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                            AFE_WRAPPER_MAX_FRAME_SAMPLES * sizeof(int16_t));
+        if (!wrapper->spk_buffer) {
+            ESP_LOGE(TAG, "扬声器缓冲区分配失败");
+            goto fail;
+        }
+    }
+    ESP_LOGI(TAG, "AFE 输入格式: %s（%d 声道）%s", wrapper->input_format, wrapper->channels,
+             wrapper->speaker_pull ? "，扬声器/麦克风锁步" : "");
+
+    wrapper->lock = audio_arena_create_mutex(config->arena);
+    if (!wrapper->lock) {
+        ESP_LOGE(TAG, "互斥锁创建失败");
+        goto fail;
+    }
+
+    // 创建预录缓冲区（在设置结果回调之前，Fetch 任务中无需判空竞争）
+    if (config->preroll_samples > 0) {
+        ring_buffer_config_t preroll_cfg = afe_preroll_config(config);
+        wrapper->preroll_rb = ring_buffer_create_with_config(&preroll_cfg);
+        if (!wrapper->preroll_rb) {
+            ESP_LOGE(TAG, "预录缓冲区创建失败");
+            goto fail;
+        }
+    }
+
+#if CONFIG_PM_ENABLE
+    // 完整档位锁定 CPU 最高频率，切到低功耗档位时释放，由动态调频降到最低频率
+    if (config->low_power_config.enabled) {
+        esp_err_t pm_ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "afe_full", &wrapper->pm_lock);
+        if (pm_ret != ESP_OK) {
+            ESP_LOGE(TAG, "电源锁创建失败: %s", esp_err_to_name(pm_ret));
+            goto fail;
+        }
+        esp_pm_lock_acquire(wrapper->pm_lock);
+    }
+#endif
+
+    if (afe_wrapper_start_manager(wrapper) != ESP_OK) {
+        goto fail;
+    }
 
     ESP_LOGI(TAG, "✅ AFE 包装器创建成功");
     return wrapper;
+
+fail:
+    afe_wrapper_destroy(wrapper);
+    return NULL;
 }
 
 /**
@@ -287,22 +772,283 @@ void afe_wrapper_destroy(afe_wrapper_handle_t wrapper)
         esp_gmf_afe_manager_destroy(wrapper->afe_manager);
     }
 
-    // 释放模型资源
-    if (wrapper->models) {
+#if CONFIG_PM_ENABLE
+    if (wrapper->pm_lock) {
+        if (wrapper->profile == AFE_PROFILE_FULL) {
+            esp_pm_lock_release(wrapper->pm_lock);
+        }
+        esp_pm_lock_delete(wrapper->pm_lock);
+    }
+#endif
+
+    // 释放模型资源（预加载缓存中的模型保留到 afe_wrapper_release_models）
+#if CONFIG_AUDIO_MANAGER_MODEL_MMAP
+    afe_models_unmap(wrapper->mapped);
+#else
+    if (wrapper->models_cached) {
+        s_model_cache.users--;
+    } else if (wrapper->models) {
         esp_srmodel_deinit(wrapper->models);
     }
+#endif
+
+    // 销毁预录缓冲区（AFE Manager 已停止，Fetch 任务不再访问）
+    if (wrapper->preroll_rb) {
+        ring_buffer_destroy(wrapper->preroll_rb);
+    }
+
+    if (wrapper->lock) {
+        vSemaphoreDelete(wrapper->lock);
+    }
+
+    audio_arena_free(wrapper->arena, wrapper->mic_buffer);
+    audio_arena_free(wrapper->arena, wrapper->spk_buffer);
 
     // 释放包装器内存
-    free(wrapper);
+    audio_arena_free(wrapper->arena, wrapper);
     ESP_LOGI(TAG, "AFE 包装器已销毁");
 }
 
+/**
+ * @brief 累加创建 AFE 包装器所需的内存占用
+ * 
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void afe_wrapper_get_footprint(const afe_wrapper_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+    size_t mic_num = config->mic_num ? config->mic_num : 1;
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(afe_wrapper_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, mic_num * AFE_WRAPPER_MAX_FRAME_SAMPLES * sizeof(int16_t));
+    if (config->speaker_pull) {
+        audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, AFE_WRAPPER_MAX_FRAME_SAMPLES * sizeof(int16_t));
+    }
+    audio_arena_footprint_add_semaphore(fp);
+    if (config->preroll_samples > 0) {
+        ring_buffer_config_t preroll_cfg = afe_preroll_config(config);
+        ring_buffer_get_footprint(&preroll_cfg, fp);
+    }
+}
+
+/**
+ * @brief 获取唤醒词配置
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @param config 用于返回配置的缓冲区
+ * @return esp_err_t ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t afe_wrapper_get_wakeup_config(afe_wrapper_handle_t wrapper, 
+                                         afe_wakeup_config_t *config)
+{
+    if (!wrapper || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(config, &wrapper->wakeup_config, sizeof(afe_wakeup_config_t));
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取当前 AFE 输出流位置
+ * 
+ * 可在任意任务、esp_timer 回调或 ISR 中调用；64 位读取在临界区内完成，不会读到半更新的值。
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @return 采样点总数，参数无效返回 0
+ */
+uint64_t IRAM_ATTR afe_wrapper_get_stream_pos(afe_wrapper_handle_t wrapper)
+{
+    if (!wrapper) {
+        return 0;
+    }
+    portENTER_CRITICAL_SAFE(&wrapper->pos_lock);
+    uint64_t pos = wrapper->stream_pos;
+    portEXIT_CRITICAL_SAFE(&wrapper->pos_lock);
+    return pos;
+}
+
+/**
+ * @brief 获取本段录音第一个采样的流位置
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @return 流位置，参数无效返回 0
+ */
+uint64_t afe_wrapper_get_record_start_pos(afe_wrapper_handle_t wrapper)
+{
+    if (!wrapper) {
+        return 0;
+    }
+    portENTER_CRITICAL_SAFE(&wrapper->pos_lock);
+    uint64_t pos = wrapper->record_start_pos;
+    portEXIT_CRITICAL_SAFE(&wrapper->pos_lock);
+    return pos;
+}
+
+/**
+ * @brief 启用/关闭一项 AFE 处理（仅对创建时已初始化的功能有效）
+ */
+static void afe_wrapper_enable_feature(afe_wrapper_t *wrapper, esp_gmf_afe_feature_t feature,
+                                       bool initialized, bool enable)
+{
+    if (!initialized) {
+        return;
+    }
+    esp_err_t ret = esp_gmf_afe_manager_enable_features(wrapper->afe_manager, feature, enable);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "AFE 功能 %d 切换失败: %s", (int)feature, esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 按期望配置与当前档位开关各项处理（调用方持有 lock）
+ * 
+ * 低功耗档位只保留 WakeNet，其余处理一律关闭。
+ */
+static void afe_wrapper_apply_features(afe_wrapper_t *wrapper)
+{
+    const bool full = (wrapper->profile == AFE_PROFILE_FULL);
+    const afe_feature_config_t *want = &wrapper->feature_config;
+    const afe_feature_config_t *built = &wrapper->built_features;
+
+    afe_wrapper_enable_feature(wrapper, ESP_AFE_FEATURE_AEC, built->aec_enabled, full && want->aec_enabled);
+    afe_wrapper_enable_feature(wrapper, ESP_AFE_FEATURE_NS, built->ns_enabled, full && want->ns_enabled);
+    afe_wrapper_enable_feature(wrapper, ESP_AFE_FEATURE_AGC, built->agc_enabled, full && want->agc_enabled);
+    afe_wrapper_enable_feature(wrapper, ESP_AFE_FEATURE_VAD, wrapper->built_vad.enabled,
+                               full && wrapper->vad_config.enabled);
+}
+
+/**
+ * @brief 热重建 AFE Manager（调用方持有 lock）
+ * 
+ * 只销毁并重建 AFE Manager 与其 Feed/Fetch 任务：模型列表、预录缓冲区、
+ * 回采对齐与流位置全部保留，期间丢失的麦克风数据约为 AFE 创建耗时。
+ */
+static esp_err_t afe_wrapper_rebuild(afe_wrapper_t *wrapper)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    if (wrapper->afe_manager) {
+        esp_gmf_afe_manager_destroy(wrapper->afe_manager);
+        wrapper->afe_manager = NULL;
+    }
+    wrapper->feed_exit_us = 0;
+    wrapper->feed_task = NULL;
+    wrapper->fetch_task = NULL;
+
+    // 旧管线内未输出的数据已丢弃：送入位置与输出位置重新对齐，负载统计不计入重建间隔
+    wrapper->feed_pos = (uint32_t)wrapper->stream_pos;
+    wrapper->load_feed_exit_us = 0;
+    wrapper->load_fetch_last_us = 0;
+
+    // 旧管线中未结束的人声段补发结束事件，状态机不会停在人声段内
+    if (wrapper->vad_active) {
+        wrapper->vad_active = false;
+        afe_event_t event = {
+            .type = AFE_EVENT_VAD_END,
+            .timestamp_us = esp_timer_get_time(),
+            .sample_pos = wrapper->stream_pos,
+        };
+        wrapper->event_callback(&event, wrapper->event_ctx);
+    }
+
+    esp_err_t ret = afe_wrapper_start_manager(wrapper);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "❌ AFE 管线重建失败");
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "✅ AFE 管线热重建完成: 模式=%d, VAD 模式=%d, 耗时 %d ms",
+             wrapper->built_features.afe_mode, wrapper->built_vad.vad_mode,
+             (int)((esp_timer_get_time() - start_us) / 1000));
+    return ESP_OK;
+}
+
+/**
+ * @brief 更新 AFE 功能与 VAD 配置
+ * 
+ * AEC/NS/AGC/VAD 的开关直接在运行中的 AFE 上切换，无中断；
+ * afe_mode、VAD 参数变化或开启创建时未初始化的功能需要热重建 AFE Manager，
+ * 重建时已初始化的功能保留（此后可继续无中断开关）。
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @param features 新的功能配置
+ * @param vad_config 新的 VAD 配置
+ * @return esp_err_t ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；重建失败返回对应错误
+ */
+esp_err_t afe_wrapper_update_feature_config(afe_wrapper_handle_t wrapper,
+                                            const afe_feature_config_t *features,
+                                            const afe_vad_config_t *vad_config)
+{
+    if (!wrapper || !features || !vad_config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(wrapper->lock, portMAX_DELAY);
+
+    afe_feature_config_t *built = &wrapper->built_features;
+    afe_vad_config_t *built_vad = &wrapper->built_vad;
+
+    bool vad_params_changed = vad_config->vad_mode != built_vad->vad_mode ||
+                              vad_config->min_speech_ms != built_vad->min_speech_ms ||
+                              vad_config->min_silence_ms != built_vad->min_silence_ms;
+    bool rebuild = !wrapper->afe_manager ||
+                   features->afe_mode != built->afe_mode ||
+                   (features->aec_enabled && !built->aec_enabled) ||
+                   (features->ns_enabled && !built->ns_enabled) ||
+                   (features->agc_enabled && !built->agc_enabled) ||
+                   (vad_config->enabled && (!built_vad->enabled || vad_params_changed));
+
+    bool unchanged = !rebuild &&
+                     features->aec_enabled == wrapper->feature_config.aec_enabled &&
+                     features->ns_enabled == wrapper->feature_config.ns_enabled &&
+                     features->agc_enabled == wrapper->feature_config.agc_enabled &&
+                     vad_config->enabled == wrapper->vad_config.enabled;
+
+    wrapper->feature_config = *features;
+    wrapper->vad_config = *vad_config;
+
+    esp_err_t ret = ESP_OK;
+    if (unchanged) {
+        xSemaphoreGive(wrapper->lock);
+        return ESP_OK;
+    }
+    if (rebuild) {
+        built->aec_enabled |= features->aec_enabled;
+        built->ns_enabled |= features->ns_enabled;
+        built->agc_enabled |= features->agc_enabled;
+        built->afe_mode = features->afe_mode;
+        bool vad_built = built_vad->enabled || vad_config->enabled;
+        *built_vad = *vad_config;
+        built_vad->enabled = vad_built;
+        ret = afe_wrapper_rebuild(wrapper);
+    }
+    if (ret == ESP_OK) {
+        afe_wrapper_apply_features(wrapper);
+    }
+
+    xSemaphoreGive(wrapper->lock);
+    return ret;
+}
+
+/** 比较可为 NULL 的字符串 */
+static bool afe_str_equal(const char *a, const char *b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
 /**
  * @brief 更新唤醒词配置
  * 
+ * 开关、灵敏度、WakeNet 模型或模型分区变化时热重建 AFE Manager：映射模式下按新选择重新映射，
+ * esp-sr 模式下在已加载的模型列表中重新选择 WakeNet（分区变化需重新创建包装器）。
+ * 仅唤醒词显示名称变化时不重建。重建失败时恢复原配置并按原配置再重建一次。
+ * 
  * @param wrapper AFE 包装器句柄
  * @param config 新的唤醒词配置
- * @return esp_err_t ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ * @return esp_err_t ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效，重建失败返回对应错误
  */
 esp_err_t afe_wrapper_update_wakeup_config(afe_wrapper_handle_t wrapper, 
                                             const afe_wakeup_config_t *config)
@@ -311,27 +1057,208 @@ esp_err_t afe_wrapper_update_wakeup_config(afe_wrapper_handle_t wrapper,
         return ESP_ERR_INVALID_ARG;
     }
 
-    memcpy(&wrapper->wakeup_config, config, sizeof(afe_wakeup_config_t));
-    ESP_LOGI(TAG, "唤醒词配置已更新: %s", config->wake_word_name);
+    xSemaphoreTake(wrapper->lock, portMAX_DELAY);
+
+    afe_wakeup_config_t old = wrapper->wakeup_config;
+    bool rebuild = config->enabled != old.enabled ||
+                   config->sensitivity != old.sensitivity ||
+                   !afe_str_equal(config->wake_model_name, old.wake_model_name) ||
+                   !afe_str_equal(config->model_partition, old.model_partition);
+
+    wrapper->wakeup_config = *config;
+    esp_err_t ret = ESP_OK;
+    if (rebuild) {
+        ret = afe_wrapper_rebuild(wrapper);
+        if (ret != ESP_OK) {
+            wrapper->wakeup_config = old;
+            if (afe_wrapper_rebuild(wrapper) == ESP_OK) {
+                afe_wrapper_apply_features(wrapper);
+            }
+        } else {
+            afe_wrapper_apply_features(wrapper);
+        }
+    }
+
+    xSemaphoreGive(wrapper->lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "唤醒词配置已更新: %s%s", config->wake_word_name, rebuild ? "（已重建）" : "");
+    }
+    return ret;
+}
+
+/**
+ * @brief 切换运行档位
+ * 
+ * 低功耗档位只保留 WakeNet：关闭 AEC（此时无播放，回采为静音）、NS、AGC 与 VAD，
+ * 释放 CPU 频率锁，并让 Feed 任务改用较大的 I2S RX DMA 帧以减少中断。
+ * 切回完整档位时按当前功能配置恢复处理。
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @param profile 目标档位
+ * @return esp_err_t ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_NOT_SUPPORTED 未启用低功耗监听
+ */
+esp_err_t afe_wrapper_set_profile(afe_wrapper_handle_t wrapper, afe_profile_t profile)
+{
+    if (!wrapper) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (profile == AFE_PROFILE_LOW_POWER && !wrapper->low_power_config.enabled) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    xSemaphoreTake(wrapper->lock, portMAX_DELAY);
+    if (!wrapper->afe_manager) {
+        // 上次重建失败，等待下一次功能更新重建
+        xSemaphoreGive(wrapper->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (profile == wrapper->profile) {
+        xSemaphoreGive(wrapper->lock);
+        return ESP_OK;
+    }
+
+    const bool full = (profile == AFE_PROFILE_FULL);
 
+#if CONFIG_PM_ENABLE
+    // 先升频再恢复处理，降频前先关闭处理
+    if (full && wrapper->pm_lock) {
+        esp_pm_lock_acquire(wrapper->pm_lock);
+    }
+#endif
+
+    wrapper->profile = profile;
+    afe_wrapper_apply_features(wrapper);
+
+#if CONFIG_PM_ENABLE
+    if (!full && wrapper->pm_lock) {
+        esp_pm_lock_release(wrapper->pm_lock);
+    }
+#endif
+
+    wrapper->rx_dma_frame_req = full ? 0 : wrapper->low_power_config.rx_dma_frame_num;
+    xSemaphoreGive(wrapper->lock);
+
+    ESP_LOGI(TAG, "%s", full ? "⚡ 切换到完整管线" : "🔋 切换到低功耗监听（仅唤醒词）");
     return ESP_OK;
 }
 
 /**
- * @brief 获取唤醒词配置
+ * @brief 获取当前运行档位
  * 
  * @param wrapper AFE 包装器句柄
- * @param config 用于返回配置的缓冲区
- * @return esp_err_t ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ * @return afe_profile_t 当前档位
  */
-esp_err_t afe_wrapper_get_wakeup_config(afe_wrapper_handle_t wrapper, 
-                                         afe_wakeup_config_t *config)
+afe_profile_t afe_wrapper_get_profile(afe_wrapper_handle_t wrapper)
 {
-    if (!wrapper || !config) {
+    return wrapper ? wrapper->profile : AFE_PROFILE_FULL;
+}
+
+/**
+ * @brief 获取 AFE Feed/Fetch 任务信息
+ *
+ * 任务栈由 esp_gmf_afe_manager 从堆分配，始终报告为动态分配、内部 RAM。
+ *
+ * @param wrapper AFE 包装器句柄
+ * @param feed 输出 Feed 任务信息，可为 NULL
+ * @param fetch 输出 Fetch 任务信息，可为 NULL
+ */
+void afe_wrapper_get_task_info(afe_wrapper_handle_t wrapper,
+                               audio_arena_task_info_t *feed, audio_arena_task_info_t *fetch)
+{
+    if (feed) {
+        *feed = (audio_arena_task_info_t){
+            .handle = wrapper ? wrapper->feed_task : NULL,
+            .stack_bytes = AFE_WRAPPER_FEED_STACK_SIZE,
+        };
+    }
+    if (fetch) {
+        *fetch = (audio_arena_task_info_t){
+            .handle = wrapper ? wrapper->fetch_task : NULL,
+            .stack_bytes = AFE_WRAPPER_FETCH_STACK_SIZE,
+        };
+    }
+}
+
+/**
+ * @brief 预加载模型分区
+ *
+ * 可在 afe_wrapper_create 之前与其他初始化并行调用，加载的模型在包装器销毁后保留。
+ *
+ * @param partition 模型分区名称
+ * @return ESP_OK 成功（已加载同一分区时直接返回）；ESP_ERR_INVALID_ARG 参数无效；
+ *         ESP_ERR_INVALID_STATE 已加载其他分区；ESP_FAIL 模型加载失败
+ */
+esp_err_t afe_wrapper_preload_models(const char *partition)
+{
+    if (!partition || strlen(partition) >= sizeof(s_model_cache.partition)) {
         return ESP_ERR_INVALID_ARG;
     }
+#if CONFIG_AUDIO_MANAGER_MODEL_MMAP
+    // 映射模式下模型在创建/重建时按选择直接映射，只读分区头，无需预加载
+    return ESP_OK;
+#else
+    if (s_model_cache.models) {
+        return strcmp(s_model_cache.partition, partition) == 0 ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
 
-    memcpy(config, &wrapper->wakeup_config, sizeof(afe_wakeup_config_t));
+    int64_t start_us = esp_timer_get_time();
+    srmodel_list_t *models = esp_srmodel_init(partition);
+    if (!models) {
+        ESP_LOGE(TAG, "模型预加载失败: %s", partition);
+        return ESP_FAIL;
+    }
+    strcpy(s_model_cache.partition, partition);
+    s_model_cache.models = models;
+    ESP_LOGI(TAG, "✅ 预加载了 %d 个模型（%s，%lld ms）", models->num, partition,
+             (long long)((esp_timer_get_time() - start_us) / 1000));
     return ESP_OK;
+#endif
 }
 
+/**
+ * @brief 释放预加载的模型
+ *
+ * @return ESP_OK 成功（未预加载时也返回 ESP_OK）；ESP_ERR_INVALID_STATE 仍有包装器在使用
+ */
+esp_err_t afe_wrapper_release_models(void)
+{
+    if (!s_model_cache.models) {
+        return ESP_OK;
+    }
+    if (s_model_cache.users > 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_srmodel_deinit(s_model_cache.models);
+    memset(&s_model_cache, 0, sizeof(s_model_cache));
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取 AFE 负载统计
+ *
+ * 各计数由 Feed/Fetch 任务单写，32 位读取无撕裂，无需加锁。
+ *
+ * @param wrapper AFE 包装器句柄
+ * @param stats 输出统计
+ */
+void afe_wrapper_get_load_stats(afe_wrapper_handle_t wrapper, afe_load_stats_t *stats)
+{
+    if (!stats) return;
+    if (!wrapper) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    uint32_t stream_pos = (uint32_t)wrapper->stream_pos;
+    uint32_t feed_pos = wrapper->feed_pos;
+    *stats = (afe_load_stats_t){
+        .feed_samples = feed_pos,
+        .feed_busy_us = wrapper->load_feed_busy_us,
+        .feed_misses = wrapper->load_feed_misses,
+        .fetch_samples = stream_pos,
+        .fetch_busy_us = wrapper->load_fetch_busy_us,
+        .fetch_misses = wrapper->load_fetch_misses,
+        .backlog_samples = (int32_t)(feed_pos - stream_pos) > 0 ? feed_pos - stream_pos : 0,
+    };
+}
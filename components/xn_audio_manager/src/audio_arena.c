@@ -0,0 +1,252 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-03 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-03 14:05:12
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_arena.c
+ * @Description: 音频管线内存区实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_arena.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+static const char *TAG = "AUDIO_ARENA";
+
+/** 各区域对应的堆能力 */
+static const uint32_t s_region_caps[AUDIO_ARENA_REGION_MAX] = {
+    [AUDIO_ARENA_INTERNAL] = MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT,
+    [AUDIO_ARENA_PSRAM]    = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+};
+
+/** 堆模式（未使用内存区）下的分配能力，内部 RAM 不强制 DMA */
+static const uint32_t s_heap_caps[AUDIO_ARENA_REGION_MAX] = {
+    [AUDIO_ARENA_INTERNAL] = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    [AUDIO_ARENA_PSRAM]    = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+};
+
+/**
+ * @brief 内存区结构体
+ *
+ * 每个区域是一整块预分配内存，按 AUDIO_ARENA_ALIGN 顺序切分（bump 分配），
+ * 不支持单独释放，随 audio_arena_destroy() 一并归还，从根本上避免碎片。
+ */
+typedef struct audio_arena_s {
+    uint8_t *base[AUDIO_ARENA_REGION_MAX];  ///< 各区域起始地址
+    size_t size[AUDIO_ARENA_REGION_MAX];    ///< 各区域容量（字节）
+    size_t used[AUDIO_ARENA_REGION_MAX];    ///< 各区域已切分字节数
+} audio_arena_t;
+
+void audio_arena_footprint_add_task(audio_arena_footprint_t *fp,
+                                    audio_arena_region_t stack_region, size_t stack_bytes)
+{
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(StaticTask_t));
+    audio_arena_footprint_add(fp, stack_region, stack_bytes);
+}
+
+void audio_arena_footprint_add_semaphore(audio_arena_footprint_t *fp)
+{
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(StaticSemaphore_t));
+}
+
+void audio_arena_footprint_add_queue(audio_arena_footprint_t *fp, size_t length, size_t item_size)
+{
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(StaticQueue_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, length * item_size);
+}
+
+/**
+ * @brief 创建内存区
+ *
+ * 按 size 为每个非空区域分配一整块内存（内部 RAM 要求 DMA 能力）。
+ *
+ * @param size 各区域容量
+ * @return 内存区句柄，失败返回 NULL
+ */
+audio_arena_handle_t audio_arena_create(const audio_arena_footprint_t *size)
+{
+    if (!size) {
+        return NULL;
+    }
+
+    audio_arena_t *arena = (audio_arena_t *)heap_caps_calloc(1, sizeof(audio_arena_t),
+                                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!arena) {
+        ESP_LOGE(TAG, "内存区句柄分配失败");
+        return NULL;
+    }
+
+    for (int r = 0; r < AUDIO_ARENA_REGION_MAX; r++) {
+        size_t bytes = AUDIO_ARENA_ALIGN_UP(size->bytes[r]);
+        if (bytes == 0) {
+            continue;
+        }
+        arena->base[r] = (uint8_t *)heap_caps_aligned_alloc(AUDIO_ARENA_ALIGN, bytes, s_region_caps[r]);
+        if (!arena->base[r]) {
+            ESP_LOGE(TAG, "内存区分配失败: 区域 %d, %u 字节", r, (unsigned)bytes);
+            audio_arena_destroy(arena);
+            return NULL;
+        }
+        arena->size[r] = bytes;
+    }
+
+    ESP_LOGI(TAG, "📦 内存区创建成功: 内部 %.1f KB, PSRAM %.1f KB",
+             arena->size[AUDIO_ARENA_INTERNAL] / 1024.0f,
+             arena->size[AUDIO_ARENA_PSRAM] / 1024.0f);
+    return arena;
+}
+
+/**
+ * @brief 销毁内存区
+ *
+ * @param arena 内存区句柄，允许为 NULL
+ */
+void audio_arena_destroy(audio_arena_handle_t arena)
+{
+    if (!arena) return;
+
+    for (int r = 0; r < AUDIO_ARENA_REGION_MAX; r++) {
+        if (arena->base[r]) {
+            heap_caps_free(arena->base[r]);
+        }
+    }
+    heap_caps_free(arena);
+}
+
+/**
+ * @brief 分配并清零一块内存
+ *
+ * 内存区模式下从对应区域顺序切分；区域耗尽说明占用预估与实际创建不一致，打印错误。
+ *
+ * @param arena 内存区句柄，NULL 使用堆
+ * @param region 内存区域
+ * @param size 字节数
+ * @return 内存指针，失败返回 NULL
+ */
+void *audio_arena_calloc(audio_arena_handle_t arena, audio_arena_region_t region, size_t size)
+{
+    if (region >= AUDIO_ARENA_REGION_MAX || size == 0) {
+        return NULL;
+    }
+
+    if (!arena) {
+        return heap_caps_calloc(1, size, s_heap_caps[region]);
+    }
+
+    size_t bytes = AUDIO_ARENA_ALIGN_UP(size);
+    if (arena->size[region] - arena->used[region] < bytes) {
+        ESP_LOGE(TAG, "内存区空间不足: 区域 %d, 需要 %u, 剩余 %u", (int)region,
+                 (unsigned)bytes, (unsigned)(arena->size[region] - arena->used[region]));
+        return NULL;
+    }
+
+    void *ptr = arena->base[region] + arena->used[region];
+    arena->used[region] += bytes;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+/**
+ * @brief 释放内存（内存区模式下为空操作）
+ *
+ * @param arena 内存区句柄
+ * @param ptr 内存指针
+ */
+void audio_arena_free(audio_arena_handle_t arena, void *ptr)
+{
+    if (!arena && ptr) {
+        heap_caps_free(ptr);
+    }
+}
+
+/**
+ * @brief 创建任务
+ *
+ * 内存区模式下 TCB 与任务栈均来自内存区，使用静态任务创建；
+ * 删除任务不会释放内存，随内存区一并归还。
+ */
+TaskHandle_t audio_arena_create_task(audio_arena_handle_t arena, TaskFunction_t task_func,
+                                     const char *name, size_t stack_bytes, void *arg,
+                                     UBaseType_t priority, audio_arena_region_t stack_region,
+                                     BaseType_t core)
+{
+    TaskHandle_t handle = NULL;
+
+    if (!arena) {
+        if (xTaskCreatePinnedToCore(task_func, name, stack_bytes, arg, priority, &handle, core) != pdPASS) {
+            return NULL;
+        }
+        return handle;
+    }
+
+    StaticTask_t *tcb = (StaticTask_t *)audio_arena_calloc(arena, AUDIO_ARENA_INTERNAL, sizeof(StaticTask_t));
+    StackType_t *stack = (StackType_t *)audio_arena_calloc(arena, stack_region, stack_bytes);
+    if (!tcb || !stack) {
+        return NULL;
+    }
+
+    return xTaskCreateStaticPinnedToCore(task_func, name, stack_bytes / sizeof(StackType_t),
+                                         arg, priority, stack, tcb, core);
+}
+
+SemaphoreHandle_t audio_arena_create_binary(audio_arena_handle_t arena)
+{
+    if (!arena) {
+        return xSemaphoreCreateBinary();
+    }
+
+    StaticSemaphore_t *buf = (StaticSemaphore_t *)audio_arena_calloc(arena, AUDIO_ARENA_INTERNAL,
+                                                                     sizeof(StaticSemaphore_t));
+    return buf ? xSemaphoreCreateBinaryStatic(buf) : NULL;
+}
+
+SemaphoreHandle_t audio_arena_create_mutex(audio_arena_handle_t arena)
+{
+    if (!arena) {
+        return xSemaphoreCreateMutex();
+    }
+
+    StaticSemaphore_t *buf = (StaticSemaphore_t *)audio_arena_calloc(arena, AUDIO_ARENA_INTERNAL,
+                                                                     sizeof(StaticSemaphore_t));
+    return buf ? xSemaphoreCreateMutexStatic(buf) : NULL;
+}
+
+QueueHandle_t audio_arena_create_queue(audio_arena_handle_t arena, size_t length, size_t item_size)
+{
+    if (!arena) {
+        return xQueueCreate(length, item_size);
+    }
+
+    StaticQueue_t *queue = (StaticQueue_t *)audio_arena_calloc(arena, AUDIO_ARENA_INTERNAL, sizeof(StaticQueue_t));
+    uint8_t *storage = (uint8_t *)audio_arena_calloc(arena, AUDIO_ARENA_INTERNAL, length * item_size);
+    if (!queue || !storage) {
+        return NULL;
+    }
+
+    return xQueueCreateStatic(length, item_size, storage, queue);
+}
+
+/**
+ * @brief 获取内存区使用情况
+ *
+ * @param arena 内存区句柄
+ * @param used 输出已切分字节数
+ * @param capacity 输出各区域容量
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_arena_get_usage(audio_arena_handle_t arena,
+                                audio_arena_footprint_t *used,
+                                audio_arena_footprint_t *capacity)
+{
+    if (!arena) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int r = 0; r < AUDIO_ARENA_REGION_MAX; r++) {
+        if (used) used->bytes[r] = arena->used[r];
+        if (capacity) capacity->bytes[r] = arena->size[r];
+    }
+    return ESP_OK;
+}
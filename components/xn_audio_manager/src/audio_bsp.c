@@ -9,6 +9,7 @@
 
 #include "audio_bsp.h"
 #include "i2s_hal.h"
+#include "audio_dsp.h"
 #include "esp_log.h"
 #include <stdlib.h>
 
@@ -16,15 +17,15 @@ static const char *TAG = "audio_bsp";
 
 struct audio_bsp_s {
     i2s_hal_handle_t i2s;
+    audio_arena_handle_t arena;
 };
 
-audio_bsp_handle_t audio_bsp_create(const audio_bsp_hw_config_t *config)
+/* 将 BSP 配置转换为 I2S HAL 配置（补齐默认值） */
+static void audio_bsp_to_i2s_config(const audio_bsp_hw_config_t *config,
+                                    i2s_mic_config_t *mic,
+                                    i2s_speaker_config_t *speaker)
 {
-    if (!config) {
-        return NULL;
-    }
-
-    i2s_mic_config_t mic_cfg = {
+    *mic = (i2s_mic_config_t){
         .port = config->mic.port,
         .bclk_gpio = config->mic.bclk_gpio,
         .lrck_gpio = config->mic.lrck_gpio,
@@ -33,9 +34,14 @@ audio_bsp_handle_t audio_bsp_create(const audio_bsp_hw_config_t *config)
         .bits = config->mic.bits,
         .max_frame_samples = config->mic.max_frame_samples ? config->mic.max_frame_samples : 512,
         .bit_shift = config->mic.bit_shift ? config->mic.bit_shift : 14,
+        .mic_num = config->mic.mic_num ? config->mic.mic_num : 1,
     };
+    for (int i = 0; i < AUDIO_BSP_MAX_MIC_NUM && i < I2S_HAL_MAX_MIC_NUM; i++) {
+        float gain = config->mic.gain[i] > 0.0f ? config->mic.gain[i] : 1.0f;
+        mic->gain_q15[i] = (int32_t)(gain * AUDIO_DSP_Q15_UNITY + 0.5f);
+    }
 
-    i2s_speaker_config_t speaker_cfg = {
+    *speaker = (i2s_speaker_config_t){
         .port = config->speaker.port,
         .bclk_gpio = config->speaker.bclk_gpio,
         .lrck_gpio = config->speaker.lrck_gpio,
@@ -43,15 +49,28 @@ audio_bsp_handle_t audio_bsp_create(const audio_bsp_hw_config_t *config)
         .sample_rate = config->speaker.sample_rate,
         .bits = config->speaker.bits,
         .max_frame_samples = config->speaker.max_frame_samples ? config->speaker.max_frame_samples : 1024,
+        .full_duplex = config->full_duplex,
     };
+}
 
-    i2s_hal_handle_t hal = i2s_hal_create(&mic_cfg, &speaker_cfg);
+audio_bsp_handle_t audio_bsp_create(const audio_bsp_hw_config_t *config)
+{
+    if (!config) {
+        return NULL;
+    }
+
+    i2s_mic_config_t mic_cfg;
+    i2s_speaker_config_t speaker_cfg;
+    audio_bsp_to_i2s_config(config, &mic_cfg, &speaker_cfg);
+
+    i2s_hal_handle_t hal = i2s_hal_create(&mic_cfg, &speaker_cfg, config->arena);
     if (!hal) {
         ESP_LOGE(TAG, "create I2S HAL failed");
         return NULL;
     }
 
-    audio_bsp_handle_t handle = (audio_bsp_handle_t)calloc(1, sizeof(struct audio_bsp_s));
+    audio_bsp_handle_t handle = (audio_bsp_handle_t)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                       sizeof(struct audio_bsp_s));
     if (!handle) {
         ESP_LOGE(TAG, "alloc audio_bsp failed");
         i2s_hal_destroy(hal);
@@ -59,6 +78,7 @@ audio_bsp_handle_t audio_bsp_create(const audio_bsp_hw_config_t *config)
     }
 
     handle->i2s = hal;
+    handle->arena = config->arena;
     ESP_LOGI(TAG, "audio BSP (I2S) ready");
     return handle;
 }
@@ -74,7 +94,21 @@ void audio_bsp_destroy(audio_bsp_handle_t handle)
         handle->i2s = NULL;
     }
 
-    free(handle);
+    audio_arena_free(handle->arena, handle);
+}
+
+void audio_bsp_get_footprint(const audio_bsp_hw_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+
+    i2s_mic_config_t mic_cfg;
+    i2s_speaker_config_t speaker_cfg;
+    audio_bsp_to_i2s_config(config, &mic_cfg, &speaker_cfg);
+
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(struct audio_bsp_s));
+    i2s_hal_get_footprint(&mic_cfg, &speaker_cfg, fp);
 }
 
 esp_err_t audio_bsp_read_mic(audio_bsp_handle_t handle,
@@ -115,4 +149,34 @@ i2s_chan_handle_t audio_bsp_get_tx(audio_bsp_handle_t handle)
     return i2s_hal_get_tx_handle(handle->i2s);
 }
 
+size_t audio_bsp_get_tx_queue_samples(audio_bsp_handle_t handle)
+{
+    if (!handle || !handle->i2s) {
+        return 0;
+    }
+    return i2s_hal_get_tx_queue_samples(handle->i2s);
+}
+
+uint8_t audio_bsp_get_mic_num(audio_bsp_handle_t handle)
+{
+    if (!handle || !handle->i2s) {
+        return 0;
+    }
+    return i2s_hal_get_mic_num(handle->i2s);
+}
+
+bool audio_bsp_is_full_duplex(audio_bsp_handle_t handle)
+{
+    if (!handle || !handle->i2s) {
+        return false;
+    }
+    return i2s_hal_is_full_duplex(handle->i2s);
+}
 
+esp_err_t audio_bsp_set_mic_dma_frame(audio_bsp_handle_t handle, uint32_t frame_num)
+{
+    if (!handle || !handle->i2s) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return i2s_hal_set_rx_dma_frame(handle->i2s, frame_num);
+}
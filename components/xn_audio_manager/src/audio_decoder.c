@@ -0,0 +1,434 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 09:40:18
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 09:40:18
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_decoder.c
+ * @Description: 压缩音频解码级实现（基于 esp_audio_codec）
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_decoder.h"
+#include "audio_dsp.h"
+#include "audio_resampler.h"
+#include "esp_log.h"
+#include "esp_audio_dec.h"
+#include "esp_audio_dec_default.h"
+#include "esp_opus_dec.h"
+#include "esp_adpcm_dec.h"
+#include <string.h>
+
+static const char *TAG = "AUDIO_DEC";
+
+/**
+ * @brief 格式描述
+ *
+ * framed 为 true 的格式（Opus 包、ADPCM 块）每次输入即一个完整帧，
+ * 不做跨输入拼接；否则为码流格式，不足一帧的尾部数据暂存到拼接缓冲区。
+ */
+typedef struct {
+    esp_audio_type_t type;          ///< esp_audio_codec 格式
+    bool framed;                    ///< 输入是否按帧对齐
+    const char *name;               ///< 日志名称
+} audio_decoder_codec_desc_t;
+
+static const audio_decoder_codec_desc_t s_codecs[AUDIO_DECODER_CODEC_MAX] = {
+    [AUDIO_DECODER_CODEC_OPUS]  = { ESP_AUDIO_TYPE_OPUS,  true,  "Opus"  },
+    [AUDIO_DECODER_CODEC_MP3]   = { ESP_AUDIO_TYPE_MP3,   false, "MP3"   },
+    [AUDIO_DECODER_CODEC_ADPCM] = { ESP_AUDIO_TYPE_ADPCM, true,  "ADPCM" },
+};
+
+/**
+ * @brief 解码器结构体
+ */
+typedef struct audio_decoder_s {
+    audio_arena_handle_t arena;     ///< 所属内存区（NULL 表示堆分配）
+    uint32_t sample_rate;           ///< 输出采样率
+    esp_audio_dec_handle_t handle;  ///< 当前打开的编解码器，NULL 表示未打开
+    audio_decoder_codec_t codec;    ///< 当前格式
+    int16_t *out_buf;               ///< 解码输出缓冲区
+    size_t out_samples;             ///< 输出缓冲区容量（采样点数）
+    uint8_t *carry_buf;             ///< 码流拼接缓冲区
+    size_t carry_size;              ///< 拼接缓冲区容量
+    size_t carry_len;               ///< 拼接缓冲区中的字节数
+    audio_resampler_handle_t resampler; ///< 码流采样率与输出不一致时使用，NULL 表示未启用
+    int16_t *rs_buf;                ///< 重采样输出缓冲区
+    size_t rs_samples;              ///< 重采样输出缓冲区容量（采样点数）
+    uint32_t in_rate;               ///< 当前码流采样率（用于检测变化并打印日志）
+} audio_decoder_t;
+
+/**
+ * @brief 注册默认编解码器（全局只需一次）
+ */
+static void audio_decoder_register_once(void)
+{
+    static bool s_registered = false;
+    if (!s_registered) {
+        esp_audio_dec_register_default();
+        s_registered = true;
+    }
+}
+
+/**
+ * @brief 按格式打开编解码器
+ */
+static esp_err_t audio_decoder_open(audio_decoder_t *dec, audio_decoder_codec_t codec)
+{
+    esp_opus_dec_cfg_t opus_cfg = ESP_OPUS_DEC_CONFIG_DEFAULT();
+    esp_adpcm_dec_cfg_t adpcm_cfg = {
+        .sample_rate = dec->sample_rate,
+        .channel = 1,
+        .bits_per_sample = 4,
+    };
+    esp_audio_dec_cfg_t cfg = {
+        .type = s_codecs[codec].type,
+    };
+
+    switch (codec) {
+    case AUDIO_DECODER_CODEC_OPUS:
+        opus_cfg.sample_rate = dec->sample_rate;
+        opus_cfg.channel = 1;
+        cfg.cfg = &opus_cfg;
+        cfg.cfg_sz = sizeof(opus_cfg);
+        break;
+    case AUDIO_DECODER_CODEC_ADPCM:
+        cfg.cfg = &adpcm_cfg;
+        cfg.cfg_sz = sizeof(adpcm_cfg);
+        break;
+    default:
+        break;
+    }
+
+    audio_decoder_register_once();
+    if (esp_audio_dec_open(&cfg, &dec->handle) != ESP_AUDIO_ERR_OK) {
+        ESP_LOGE(TAG, "%s 解码器打开失败", s_codecs[codec].name);
+        dec->handle = NULL;
+        return ESP_FAIL;
+    }
+
+    dec->codec = codec;
+    ESP_LOGI(TAG, "🎼 %s 解码器已打开", s_codecs[codec].name);
+    return ESP_OK;
+}
+
+/**
+ * @brief 调用编解码器解码
+ *
+ * @param used 输出消耗字节数
+ * @param samples 输出采样点数（按解码器原始声道数）
+ * @return ESP_OK 解码出一帧；ESP_ERR_NOT_FINISHED 需要更多数据；其它为错误
+ */
+static esp_err_t audio_decoder_process(audio_decoder_t *dec, const uint8_t *data, size_t len,
+                                       size_t *used, size_t *samples)
+{
+    esp_audio_dec_in_raw_t raw = {
+        .buffer = (uint8_t *)data,
+        .len = len,
+    };
+    esp_audio_dec_out_frame_t frame = {
+        .buffer = (uint8_t *)dec->out_buf,
+        .len = dec->out_samples * sizeof(int16_t),
+    };
+
+    esp_audio_err_t ret = esp_audio_dec_process(dec->handle, &raw, &frame);
+    *used = raw.consumed;
+    *samples = frame.decoded_size / sizeof(int16_t);
+
+    if (ret == ESP_AUDIO_ERR_OK) {
+        return ESP_OK;
+    }
+    if (ret == ESP_AUDIO_ERR_DATA_LACK) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    if (ret == ESP_AUDIO_ERR_BUFF_NOT_ENOUGH) {
+        ESP_LOGE(TAG, "输出缓冲区不足: 需要 %u 字节", (unsigned)frame.needed_size);
+    }
+    return ESP_FAIL;
+}
+
+/**
+ * @brief 转换为输出格式：同采样率时原地下混为单声道，否则重采样（同时下混）
+ *
+ * 采样率取自解码器报告的码流信息（如 44.1/48/24 kHz 的 MP3），
+ * 重采样器在格式不变时保持历史，跨帧连续。
+ *
+ * @param pcm 输出 PCM 指针（out_buf 或 rs_buf）
+ * @param samples 输入为解码采样点数（按原始声道数），输出为单声道采样点数
+ */
+static esp_err_t audio_decoder_convert(audio_decoder_t *dec, const int16_t **pcm, size_t *samples)
+{
+    esp_audio_dec_info_t info = {0};
+    if (esp_audio_dec_get_info(dec->handle, &info) != ESP_AUDIO_ERR_OK) {
+        return ESP_FAIL;
+    }
+
+    if (info.bits_per_sample != 16 || info.channel == 0 || info.channel > AUDIO_RESAMPLER_MAX_CHANNELS ||
+        (info.sample_rate != dec->sample_rate && !dec->resampler)) {
+        ESP_LOGE(TAG, "不支持的输出格式: %u Hz / %u ch / %u bit（需要 %u Hz / 16 bit）",
+                 (unsigned)info.sample_rate, info.channel, info.bits_per_sample, (unsigned)dec->sample_rate);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    size_t frames = *samples / info.channel;
+    if (info.sample_rate == dec->sample_rate) {
+        if (info.channel == 2) {
+            audio_dsp_downmix_s16(dec->out_buf, dec->out_buf, frames, 2);
+        }
+        *pcm = dec->out_buf;
+        *samples = frames;
+        return ESP_OK;
+    }
+
+    esp_err_t ret = audio_resampler_set_input(dec->resampler, info.sample_rate, info.channel);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "不支持的采样率转换: %u Hz -> %u Hz", (unsigned)info.sample_rate, (unsigned)dec->sample_rate);
+        return ret;
+    }
+    if (info.sample_rate != dec->in_rate) {
+        ESP_LOGI(TAG, "🔁 码流 %u Hz / %u ch，重采样到 %u Hz",
+                 (unsigned)info.sample_rate, info.channel, (unsigned)dec->sample_rate);
+        dec->in_rate = info.sample_rate;
+    }
+
+    size_t need = audio_resampler_get_output_size(dec->resampler, frames);
+    if (need > dec->rs_samples) {
+        ESP_LOGE(TAG, "重采样输出超出缓冲区: %u > %u", (unsigned)need, (unsigned)dec->rs_samples);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    *samples = audio_resampler_process(dec->resampler, dec->out_buf, frames, NULL, dec->rs_buf, dec->rs_samples);
+    *pcm = dec->rs_buf;
+    return ESP_OK;
+}
+
+/**
+ * @brief 码流格式解码（含跨输入拼接）
+ *
+ * 拼接缓冲区为空时直接在输入上解码（零拷贝）；剩余不足一帧时把尾部拷入拼接缓冲区，
+ * 下次调用先补齐拼接缓冲区再解码。
+ */
+static esp_err_t audio_decoder_stream(audio_decoder_t *dec, const uint8_t *data, size_t len,
+                                      size_t *consumed, size_t *samples)
+{
+    size_t used = 0;
+    esp_err_t ret;
+
+    if (dec->carry_len == 0) {
+        ret = audio_decoder_process(dec, data, len, &used, samples);
+        if (ret == ESP_ERR_NOT_FINISHED || (ret == ESP_OK && used == 0)) {
+            // 剩余数据不足一帧，暂存等待后续输入；超出拼接缓冲区的部分不计入已消耗，
+            // 由调用方按码流顺序再次送入
+            size_t keep = len < dec->carry_size ? len : dec->carry_size;
+            memcpy(dec->carry_buf, data, keep);
+            dec->carry_len = keep;
+            *consumed = keep;
+            *samples = 0;
+            return ESP_OK;
+        }
+        *consumed = used;
+        return ret;
+    }
+
+    // 先用新数据补齐拼接缓冲区
+    size_t old_len = dec->carry_len;
+    size_t take = dec->carry_size - old_len;
+    if (take > len) {
+        take = len;
+    }
+    memcpy(dec->carry_buf + old_len, data, take);
+    dec->carry_len += take;
+
+    ret = audio_decoder_process(dec, dec->carry_buf, dec->carry_len, &used, samples);
+    if (ret == ESP_ERR_NOT_FINISHED || (ret == ESP_OK && used == 0)) {
+        if (dec->carry_len == dec->carry_size) {
+            ESP_LOGW(TAG, "拼接缓冲区已满仍无法解码，丢弃 %u 字节", (unsigned)dec->carry_len);
+            dec->carry_len = 0;
+        }
+        *consumed = take;
+        *samples = 0;
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        dec->carry_len = 0;
+        *consumed = take;
+        return ret;
+    }
+
+    if (used >= old_len) {
+        // 旧数据已全部消耗，新数据中未用部分留在调用方输入中继续解码
+        *consumed = used - old_len;
+        dec->carry_len = 0;
+    } else {
+        memmove(dec->carry_buf, dec->carry_buf + used, dec->carry_len - used);
+        dec->carry_len -= used;
+        *consumed = take;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 创建解码器
+ *
+ * @param config 配置参数
+ * @return 解码器句柄，失败返回 NULL
+ */
+audio_decoder_handle_t audio_decoder_create(const audio_decoder_config_t *config)
+{
+    if (!config || config->max_frame_samples == 0) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    audio_decoder_t *dec = (audio_decoder_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                 sizeof(audio_decoder_t));
+    if (!dec) {
+        ESP_LOGE(TAG, "解码器分配失败");
+        return NULL;
+    }
+
+    dec->arena = config->arena;
+    dec->sample_rate = config->sample_rate;
+    dec->codec = AUDIO_DECODER_CODEC_MAX;
+    dec->out_samples = config->max_frame_samples;
+    dec->carry_size = config->max_input_bytes;
+
+    dec->out_buf = (int16_t *)audio_arena_calloc(dec->arena, AUDIO_ARENA_INTERNAL,
+                                                 dec->out_samples * sizeof(int16_t));
+    if (!dec->out_buf) {
+        goto fail;
+    }
+    if (dec->carry_size > 0) {
+        dec->carry_buf = (uint8_t *)audio_arena_calloc(dec->arena, AUDIO_ARENA_INTERNAL, dec->carry_size);
+        if (!dec->carry_buf) {
+            goto fail;
+        }
+    }
+    if (config->resample) {
+        audio_resampler_config_t rs_cfg = AUDIO_RESAMPLER_DEFAULT_CONFIG(dec->sample_rate);
+        rs_cfg.arena = dec->arena;
+        dec->resampler = audio_resampler_create(&rs_cfg);
+        dec->rs_samples = dec->out_samples;
+        dec->rs_buf = (int16_t *)audio_arena_calloc(dec->arena, AUDIO_ARENA_INTERNAL,
+                                                    dec->rs_samples * sizeof(int16_t));
+        if (!dec->resampler || !dec->rs_buf) {
+            goto fail;
+        }
+    }
+
+    return dec;
+
+fail:
+    ESP_LOGE(TAG, "解码缓冲区分配失败");
+    audio_decoder_destroy(dec);
+    return NULL;
+}
+
+/**
+ * @brief 累加创建解码器所需的内存占用
+ *
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void audio_decoder_get_footprint(const audio_decoder_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(audio_decoder_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, config->max_frame_samples * sizeof(int16_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, config->max_input_bytes);
+    if (config->resample) {
+        audio_resampler_config_t rs_cfg = AUDIO_RESAMPLER_DEFAULT_CONFIG(config->sample_rate);
+        audio_resampler_get_footprint(&rs_cfg, fp);
+        audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, config->max_frame_samples * sizeof(int16_t));
+    }
+}
+
+/**
+ * @brief 销毁解码器
+ *
+ * @param decoder 解码器句柄
+ */
+void audio_decoder_destroy(audio_decoder_handle_t decoder)
+{
+    if (!decoder) return;
+
+    audio_decoder_reset(decoder);
+    audio_resampler_destroy(decoder->resampler);
+    audio_arena_free(decoder->arena, decoder->rs_buf);
+    audio_arena_free(decoder->arena, decoder->carry_buf);
+    audio_arena_free(decoder->arena, decoder->out_buf);
+    audio_arena_free(decoder->arena, decoder);
+}
+
+/**
+ * @brief 解码一帧
+ *
+ * @return ESP_OK 成功（samples 为 0 表示需要更多输入）；其它为错误，调用方应丢弃本段输入
+ */
+esp_err_t audio_decoder_decode(audio_decoder_handle_t decoder, audio_decoder_codec_t codec,
+                               const uint8_t *data, size_t len, size_t *consumed,
+                               const int16_t **pcm, size_t *samples)
+{
+    if (!decoder || !data || !consumed || !pcm || !samples) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (codec >= AUDIO_DECODER_CODEC_MAX) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    *consumed = 0;
+    *samples = 0;
+    *pcm = decoder->out_buf;
+
+    // 格式切换：丢弃上一个流的残留并重新打开
+    if (decoder->handle && decoder->codec != codec) {
+        audio_decoder_reset(decoder);
+    }
+    if (!decoder->handle) {
+        esp_err_t ret = audio_decoder_open(decoder, codec);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    esp_err_t ret;
+    if (s_codecs[codec].framed) {
+        // 整包解码，包内未消耗部分视为无效数据
+        size_t used = 0;
+        ret = audio_decoder_process(decoder, data, len, &used, samples);
+        *consumed = len;
+        if (ret == ESP_ERR_NOT_FINISHED) {
+            *samples = 0;
+            return ESP_OK;
+        }
+    } else {
+        ret = audio_decoder_stream(decoder, data, len, consumed, samples);
+    }
+
+    if (ret != ESP_OK || *samples == 0) {
+        return ret;
+    }
+    return audio_decoder_convert(decoder, pcm, samples);
+}
+
+/**
+ * @brief 重置解码器
+ *
+ * @param decoder 解码器句柄
+ */
+void audio_decoder_reset(audio_decoder_handle_t decoder)
+{
+    if (!decoder) return;
+
+    if (decoder->handle) {
+        esp_audio_dec_close(decoder->handle);
+        decoder->handle = NULL;
+    }
+    decoder->codec = AUDIO_DECODER_CODEC_MAX;
+    decoder->carry_len = 0;
+    decoder->in_rate = 0;
+    if (decoder->resampler) {
+        audio_resampler_reset(decoder->resampler);
+    }
+}
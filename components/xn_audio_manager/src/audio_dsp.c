@@ -0,0 +1,429 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 10:12:40
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_dsp.c
+ * @Description: 音频定点运算内核实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_dsp.h"
+#include <string.h>
+#include "sdkconfig.h"
+
+#if defined(__XTENSA__)
+#include "xtensa/config/core-isa.h"
+#include "dsps_mulc.h"
+#endif
+
+/* Xtensa（ESP32/ESP32-S3）提供单周期 CLAMPS 饱和指令 */
+#if defined(__XTENSA__) && XCHAL_HAVE_CLAMPS
+#define AUDIO_DSP_HAVE_CLAMPS   1
+#else
+#define AUDIO_DSP_HAVE_CLAMPS   0
+#endif
+
+/* Xtensa 上 Q15 常数乘法交给 ESP-DSP 的汇编内核（dsps_mulc_s16_ae32） */
+#if defined(__XTENSA__)
+#define AUDIO_DSP_HAVE_ESP_DSP  1
+#else
+#define AUDIO_DSP_HAVE_ESP_DSP  0
+#endif
+
+/* ESP32-S3 的 PIE 128 位向量扩展：一次处理 8 个 32 位采样的移位/饱和/收窄 */
+#if defined(__XTENSA__) && CONFIG_IDF_TARGET_ESP32S3
+#define AUDIO_DSP_HAVE_PIE      1
+#else
+#define AUDIO_DSP_HAVE_PIE      0
+#endif
+
+/** PIE 内核的对齐要求（EE.VLD/VST.128 忽略地址低 4 位） */
+#define AUDIO_DSP_PIE_ALIGN     16
+
+/* 以 32 位一次写入两个 16 位采样，声明 may_alias 以免违反严格别名规则 */
+typedef uint32_t __attribute__((__may_alias__)) audio_dsp_u32_t;
+
+/**
+ * @brief 饱和到 int16 范围
+ */
+static inline int16_t audio_dsp_sat16(int32_t x)
+{
+#if AUDIO_DSP_HAVE_CLAMPS
+    int32_t r;
+    __asm__ ("clamps %0, %1, 15" : "=a"(r) : "a"(x));
+    return (int16_t)r;
+#else
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return (int16_t)x;
+#endif
+}
+
+/**
+ * @brief 将两个 16 位采样打包为一个 32 位字（小端：lo 在前）
+ */
+static inline uint32_t audio_dsp_pack2(int16_t lo, int16_t hi)
+{
+    return (uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+/**
+ * @brief 检查指针是否 4 字节对齐（可使用 32 位写入）
+ */
+static inline int audio_dsp_aligned4(const void *p)
+{
+    return ((uintptr_t)p & 3u) == 0;
+}
+
+/**
+ * @brief 检查指针是否满足 PIE 128 位访存对齐
+ */
+static inline int audio_dsp_aligned16(const void *p)
+{
+    return ((uintptr_t)p & (AUDIO_DSP_PIE_ALIGN - 1)) == 0;
+}
+
+/**
+ * @brief Q15 乘法（四舍五入），增益不超过 1.0 时结果不会溢出
+ */
+static inline int16_t audio_dsp_mul_q15(int16_t v, int32_t gain_q15)
+{
+    return (int16_t)(((int32_t)v * gain_q15 + (1 << 14)) >> 15);
+}
+
+/**
+ * @brief 音量（0-100）映射为 Q15 增益
+ */
+int32_t audio_dsp_volume_to_q15(uint8_t volume)
+{
+    if (volume >= 100) {
+        return AUDIO_DSP_Q15_UNITY;
+    }
+    return ((int32_t)volume * AUDIO_DSP_Q15_UNITY + 50) / 100;
+}
+
+#if AUDIO_DSP_HAVE_PIE
+/**
+ * @brief PIE 向量内核：每块 8 个采样，EE.VSR.32 算术右移，VMIN/VMAX 钳位到 int16，
+ *        EE.VUNZIP.16 取各 32 位通道的低半字收窄后一次写出 16 字节
+ *
+ * in/out 须 16 字节对齐；每块先读完 32 字节再写 16 字节，支持原地转换。
+ */
+static void audio_dsp_s32_to_s16_sat_pie(const int32_t *in, int16_t *out, size_t blocks, uint8_t shift)
+{
+    static const int32_t limits[2] = { INT16_MAX, INT16_MIN };
+    const int32_t *hi = &limits[0];
+    const int32_t *lo = &limits[1];
+
+    __asm__ volatile (
+        "wsr.sar        %[shift]\n"
+        "ee.vldbc.32    q6, %[hi]\n"
+        "ee.vldbc.32    q7, %[lo]\n"
+        "1:\n"
+        "ee.vld.128.ip  q0, %[in], 16\n"
+        "ee.vld.128.ip  q1, %[in], 16\n"
+        "ee.vsr.32      q0, q0\n"
+        "ee.vsr.32      q1, q1\n"
+        "ee.vmin.s32    q0, q0, q6\n"
+        "ee.vmin.s32    q1, q1, q6\n"
+        "ee.vmax.s32    q0, q0, q7\n"
+        "ee.vmax.s32    q1, q1, q7\n"
+        "ee.vunzip.16   q0, q1\n"
+        "ee.vst.128.ip  q0, %[out], 16\n"
+        "addi           %[n], %[n], -1\n"
+        "bnez           %[n], 1b\n"
+        : [in] "+r"(in), [out] "+r"(out), [n] "+r"(blocks)
+        : [shift] "r"((uint32_t)shift), [hi] "r"(hi), [lo] "r"(lo)
+        : "sar", "memory");
+}
+#endif
+
+/**
+ * @brief 32 位转 16 位（右移 + 饱和）
+ *
+ * 每轮先读入 4 个 32 位采样再写出，因此 out 与 in 指向同一块内存时
+ * （原地转换）也不会覆盖尚未读取的数据。ESP32-S3 上对齐的缓冲区先走 PIE 向量内核，
+ * 不足 8 个的尾部再按标量处理。
+ */
+void audio_dsp_s32_to_s16_sat(const int32_t *in, int16_t *out, size_t count, uint8_t shift)
+{
+    size_t i = 0;
+
+#if AUDIO_DSP_HAVE_PIE
+    if (count >= 8 && audio_dsp_aligned16(in) && audio_dsp_aligned16(out)) {
+        audio_dsp_s32_to_s16_sat_pie(in, out, count / 8, shift);
+        i = count & ~(size_t)7;
+    }
+#endif
+
+    for (; i + 4 <= count; i += 4) {
+        int32_t a = in[i + 0] >> shift;
+        int32_t b = in[i + 1] >> shift;
+        int32_t c = in[i + 2] >> shift;
+        int32_t d = in[i + 3] >> shift;
+        out[i + 0] = audio_dsp_sat16(a);
+        out[i + 1] = audio_dsp_sat16(b);
+        out[i + 2] = audio_dsp_sat16(c);
+        out[i + 3] = audio_dsp_sat16(d);
+    }
+    for (; i < count; i++) {
+        out[i] = audio_dsp_sat16(in[i] >> shift);
+    }
+}
+
+/**
+ * @brief 多声道 32 位解交织为 16 位平面（右移 + 声道增益 + 饱和）
+ *
+ * 双声道（双麦克风）按帧展开处理；增益最大 2.0 时 16 位采样与 Q15 增益之积不超过 int32。
+ */
+void audio_dsp_s32_deinterleave_s16(const int32_t *in, int16_t *out, size_t frames, size_t channels,
+                                    size_t out_stride, uint8_t shift, const int32_t *gain_q15)
+{
+    if (channels == 1 && !gain_q15) {
+        audio_dsp_s32_to_s16_sat(in, out, frames, shift);
+        return;
+    }
+
+    if (channels == 2) {
+        int16_t *out0 = out;
+        int16_t *out1 = out + out_stride;
+        if (!gain_q15) {
+            for (size_t i = 0; i < frames; i++) {
+                out0[i] = audio_dsp_sat16(in[i * 2 + 0] >> shift);
+                out1[i] = audio_dsp_sat16(in[i * 2 + 1] >> shift);
+            }
+        } else {
+            const int32_t g0 = gain_q15[0];
+            const int32_t g1 = gain_q15[1];
+            for (size_t i = 0; i < frames; i++) {
+                int32_t a = audio_dsp_sat16(in[i * 2 + 0] >> shift);
+                int32_t b = audio_dsp_sat16(in[i * 2 + 1] >> shift);
+                out0[i] = audio_dsp_sat16((a * g0 + (1 << 14)) >> 15);
+                out1[i] = audio_dsp_sat16((b * g1 + (1 << 14)) >> 15);
+            }
+        }
+        return;
+    }
+
+    for (size_t c = 0; c < channels; c++) {
+        int16_t *dst = out + c * out_stride;
+        const int32_t g = gain_q15 ? gain_q15[c] : AUDIO_DSP_Q15_UNITY;
+        for (size_t i = 0; i < frames; i++) {
+            int32_t v = audio_dsp_sat16(in[i * channels + c] >> shift);
+            dst[i] = (g == AUDIO_DSP_Q15_UNITY) ? (int16_t)v : audio_dsp_sat16((v * g + (1 << 14)) >> 15);
+        }
+    }
+}
+
+/**
+ * @brief 单声道缩放 + 扩展为立体声
+ *
+ * 单位增益时跳过乘法，静音时直接清零；对齐时每个 LR 对用一次 32 位写入。
+ * Xtensa 上非单位增益由 dsps_mulc_s16 以输出步长 2 分别写左右声道（截断而非四舍五入，差 1 LSB）。
+ */
+void audio_dsp_mono_to_stereo_q15(const int16_t *in, int16_t *out, size_t count, int32_t gain_q15)
+{
+    if (gain_q15 <= 0) {
+        memset(out, 0, count * 2 * sizeof(int16_t));
+        return;
+    }
+
+    const int unity = (gain_q15 >= AUDIO_DSP_Q15_UNITY);
+    size_t i = 0;
+
+#if AUDIO_DSP_HAVE_ESP_DSP
+    if (!unity && count > 0) {
+        dsps_mulc_s16(in, out, (int)count, (int16_t)gain_q15, 1, 2);
+        dsps_mulc_s16(in, out + 1, (int)count, (int16_t)gain_q15, 1, 2);
+        return;
+    }
+#endif
+
+    if (audio_dsp_aligned4(out)) {
+        audio_dsp_u32_t *out32 = (audio_dsp_u32_t *)out;
+        if (unity) {
+            for (; i + 2 <= count; i += 2) {
+                out32[i + 0] = audio_dsp_pack2(in[i + 0], in[i + 0]);
+                out32[i + 1] = audio_dsp_pack2(in[i + 1], in[i + 1]);
+            }
+        } else {
+            for (; i + 2 <= count; i += 2) {
+                int16_t a = audio_dsp_mul_q15(in[i + 0], gain_q15);
+                int16_t b = audio_dsp_mul_q15(in[i + 1], gain_q15);
+                out32[i + 0] = audio_dsp_pack2(a, a);
+                out32[i + 1] = audio_dsp_pack2(b, b);
+            }
+        }
+    }
+
+    // 剩余采样（或输出未对齐）逐点处理
+    for (; i < count; i++) {
+        int16_t v = unity ? in[i] : audio_dsp_mul_q15(in[i], gain_q15);
+        out[i * 2 + 0] = v;
+        out[i * 2 + 1] = v;
+    }
+}
+
+/**
+ * @brief 单声道线性增益渐变
+ *
+ * 增益以 Q15 << 8 的精度逐点累加，避免长渐变时步进被截断为 0。
+ */
+void audio_dsp_ramp_q15(const int16_t *in, int16_t *out, size_t count,
+                        int32_t gain_from, int32_t gain_to)
+{
+    if (count == 0) {
+        return;
+    }
+
+    int32_t gain = gain_from * 256;
+    int32_t step = (gain_to - gain_from) * 256 / (int32_t)count;
+
+    for (size_t i = 0; i < count; i++) {
+        out[i] = audio_dsp_mul_q15(in[i], gain >> 8);
+        gain += step;
+    }
+}
+
+/**
+ * @brief 带增益渐变的混音累加
+ *
+ * 固定增益（最常见：无闪避变化）时走 4 路展开的快速路径。
+ */
+void audio_dsp_mix_ramp_q15(const int16_t *in, int32_t *acc, size_t count,
+                            int32_t gain_from, int32_t gain_to)
+{
+    if (count == 0) {
+        return;
+    }
+
+    if (gain_from == gain_to) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            acc[i + 0] += audio_dsp_mul_q15(in[i + 0], gain_from);
+            acc[i + 1] += audio_dsp_mul_q15(in[i + 1], gain_from);
+            acc[i + 2] += audio_dsp_mul_q15(in[i + 2], gain_from);
+            acc[i + 3] += audio_dsp_mul_q15(in[i + 3], gain_from);
+        }
+        for (; i < count; i++) {
+            acc[i] += audio_dsp_mul_q15(in[i], gain_from);
+        }
+        return;
+    }
+
+    int32_t gain = gain_from * 256;
+    int32_t step = (gain_to - gain_from) * 256 / (int32_t)count;
+
+    for (size_t i = 0; i < count; i++) {
+        acc[i] += audio_dsp_mul_q15(in[i], gain >> 8);
+        gain += step;
+    }
+}
+
+/**
+ * @brief 两路单声道交织（ch1 为 NULL 时补静音）
+ */
+void audio_dsp_interleave2_s16(const int16_t *ch0, const int16_t *ch1, int16_t *out, size_t count)
+{
+    size_t i = 0;
+
+    if (audio_dsp_aligned4(out)) {
+        audio_dsp_u32_t *out32 = (audio_dsp_u32_t *)out;
+        if (ch1) {
+            for (; i + 2 <= count; i += 2) {
+                out32[i + 0] = audio_dsp_pack2(ch0[i + 0], ch1[i + 0]);
+                out32[i + 1] = audio_dsp_pack2(ch0[i + 1], ch1[i + 1]);
+            }
+        } else {
+            for (; i + 2 <= count; i += 2) {
+                out32[i + 0] = (uint16_t)ch0[i + 0];
+                out32[i + 1] = (uint16_t)ch0[i + 1];
+            }
+        }
+    }
+
+    for (; i < count; i++) {
+        out[i * 2 + 0] = ch0[i];
+        out[i * 2 + 1] = ch1 ? ch1[i] : 0;
+    }
+}
+
+/**
+ * @brief 多路单声道交织（NULL 声道补静音）
+ *
+ * 双声道转用 audio_dsp_interleave2_s16() 的 32 位写入路径。
+ */
+void audio_dsp_interleave_s16(const int16_t *const *chans, size_t channels, int16_t *out, size_t count)
+{
+    if (channels == 2 && chans[0]) {
+        audio_dsp_interleave2_s16(chans[0], chans[1], out, count);
+        return;
+    }
+
+    for (size_t c = 0; c < channels; c++) {
+        const int16_t *src = chans[c];
+        int16_t *dst = out + c;
+        if (src) {
+            for (size_t i = 0; i < count; i++) {
+                dst[i * channels] = src[i];
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                dst[i * channels] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 多声道下混为单声道
+ *
+ * 按顺序逐帧写出，out 不超过 in 的读位置，因此支持原地下混。
+ * 双声道使用移位代替除法。
+ */
+void audio_dsp_downmix_s16(const int16_t *in, int16_t *out, size_t frames, size_t channels)
+{
+    if (channels <= 1) {
+        if (out != in) {
+            memmove(out, in, frames * sizeof(int16_t));
+        }
+        return;
+    }
+
+    if (channels == 2) {
+        for (size_t i = 0; i < frames; i++) {
+            out[i] = (int16_t)(((int32_t)in[2 * i] + in[2 * i + 1]) >> 1);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        int32_t sum = 0;
+        for (size_t c = 0; c < channels; c++) {
+            sum += in[i * channels + c];
+        }
+        out[i] = (int16_t)(sum / (int32_t)channels);
+    }
+}
+
+/**
+ * @brief Q15 FIR 点积
+ *
+ * 4 路展开，编译器在 ESP32-S3 上可生成 MULA 累加指令。
+ */
+int16_t audio_dsp_fir_q15(const int16_t *x, const int16_t *coef, size_t n)
+{
+    int32_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 += (int32_t)x[i] * coef[i];
+        acc1 += (int32_t)x[i + 1] * coef[i + 1];
+        acc2 += (int32_t)x[i + 2] * coef[i + 2];
+        acc3 += (int32_t)x[i + 3] * coef[i + 3];
+    }
+    for (; i < n; i++) {
+        acc0 += (int32_t)x[i] * coef[i];
+    }
+    return audio_dsp_sat16((acc0 + acc1 + acc2 + acc3 + (1 << 14)) >> 15);
+}
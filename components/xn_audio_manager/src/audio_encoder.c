@@ -0,0 +1,443 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 16:22:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 16:22:05
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_encoder.c
+ * @Description: 录音编码级实现（基于 esp_audio_codec）
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_encoder.h"
+#include "esp_log.h"
+#include "esp_audio_enc.h"
+#include "esp_audio_enc_default.h"
+#include "esp_opus_enc.h"
+#include "esp_adpcm_enc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "AUDIO_ENC";
+
+#define AUDIO_ENCODER_WAIT_MS          100      ///< 输入为空时的等待时间（命令会提前唤醒）
+#define AUDIO_ENCODER_EXIT_TIMEOUT_MS  500      ///< 销毁时等待编码任务退出的最长时间
+#define AUDIO_ENCODER_OPUS_MAX_PACKET  1276     ///< 单个 Opus 包（20ms）最大字节数
+#define AUDIO_ENCODER_ADPCM_MAX_BLOCK  1024     ///< ADPCM 编码块最大采样点数（占用预估用）
+
+/** 编码任务命令（任务通知位） */
+#define AUDIO_ENCODER_CMD_FLUSH        (1u << 0)   ///< 编码剩余数据并补齐最后一帧
+#define AUDIO_ENCODER_CMD_EXIT         (1u << 1)   ///< 退出编码任务
+
+/**
+ * @brief 编码器结构体
+ */
+typedef struct audio_encoder_s {
+    audio_arena_handle_t arena;         ///< 所属内存区（NULL 表示堆分配）
+    esp_audio_enc_handle_t handle;      ///< 编解码库句柄
+    ring_buffer_handle_t pcm_rb;        ///< 输入缓冲（无锁 SPSC：录音回调写入 -> 编码任务读取）
+    TaskHandle_t task;                  ///< 编码任务句柄
+    audio_arena_task_info_t task_info;  ///< 编码任务栈信息（高水位报告用）
+    SemaphoreHandle_t exit_done;        ///< 编码任务退出应答
+    int16_t *frame_buf;                 ///< 帧缓冲（仅编码任务访问）
+    size_t frame_samples;               ///< 每帧采样点数
+    size_t frame_fill;                  ///< 帧缓冲中已有的采样点数
+    uint8_t *out_buf;                   ///< 编码输出缓冲
+    size_t out_size;                    ///< 编码输出缓冲大小
+    audio_encoder_packet_cb_t packet_callback; ///< 编码包回调
+    void *packet_ctx;                   ///< 回调上下文
+} audio_encoder_t;
+
+/**
+ * @brief 注册默认编码器（全局只需一次）
+ */
+static void audio_encoder_register_once(void)
+{
+    static bool s_registered = false;
+    if (!s_registered) {
+        esp_audio_enc_register_default();
+        s_registered = true;
+    }
+}
+
+/**
+ * @brief 帧长（毫秒）映射为 Opus 帧长枚举
+ */
+static bool audio_encoder_opus_duration(uint16_t frame_ms, esp_opus_enc_frame_duration_t *duration)
+{
+    switch (frame_ms) {
+    case 10: *duration = ESP_OPUS_ENC_FRAME_DURATION_10_MS; return true;
+    case 20: *duration = ESP_OPUS_ENC_FRAME_DURATION_20_MS; return true;
+    case 40: *duration = ESP_OPUS_ENC_FRAME_DURATION_40_MS; return true;
+    case 60: *duration = ESP_OPUS_ENC_FRAME_DURATION_60_MS; return true;
+    default: return false;
+    }
+}
+
+/**
+ * @brief 预估帧缓冲与输出缓冲大小（创建与占用预估共用）
+ *
+ * Opus 帧长由配置决定；ADPCM 帧长由编码块决定，按上限预估。
+ * 实际大小以编解码库返回值为准，内存区模式下超出预估会创建失败。
+ */
+static void audio_encoder_frame_estimate(const audio_encoder_config_t *config,
+                                         size_t *frame_samples, size_t *out_size)
+{
+    if (config->codec == AUDIO_ENCODER_CODEC_OPUS) {
+        *frame_samples = (size_t)config->sample_rate * config->frame_ms / 1000;
+        *out_size = AUDIO_ENCODER_OPUS_MAX_PACKET * ((config->frame_ms + 19) / 20);
+    } else {
+        *frame_samples = AUDIO_ENCODER_ADPCM_MAX_BLOCK;
+        *out_size = AUDIO_ENCODER_ADPCM_MAX_BLOCK / 2 + 16;
+    }
+}
+
+/**
+ * @brief 输入缓冲配置（创建与占用预估共用）
+ */
+static ring_buffer_config_t audio_encoder_ring_config(const audio_encoder_config_t *config)
+{
+    ring_buffer_config_t rb_cfg = RING_BUFFER_DEFAULT_CONFIG((size_t)config->sample_rate * config->buffer_ms / 1000);
+    rb_cfg.with_sem = true;
+    rb_cfg.lock_free = true;
+    rb_cfg.overrun_policy = RING_BUFFER_OVERRUN_REJECT;   // 不阻塞 AFE Fetch 任务
+    rb_cfg.arena = config->arena;
+    return rb_cfg;
+}
+
+/**
+ * @brief 打开编解码器并获取帧大小
+ */
+static esp_err_t audio_encoder_open(audio_encoder_t *enc, const audio_encoder_config_t *config,
+                                    size_t *frame_samples, size_t *out_size)
+{
+    esp_opus_enc_config_t opus_cfg = ESP_OPUS_ENC_CONFIG_DEFAULT();
+    esp_adpcm_enc_config_t adpcm_cfg = ESP_ADPCM_ENC_CONFIG_DEFAULT();
+    esp_audio_enc_config_t cfg = {0};
+
+    if (config->codec == AUDIO_ENCODER_CODEC_OPUS) {
+        if (!audio_encoder_opus_duration(config->frame_ms, &opus_cfg.frame_duration)) {
+            ESP_LOGE(TAG, "不支持的 Opus 帧长: %u ms", config->frame_ms);
+            return ESP_ERR_INVALID_ARG;
+        }
+        opus_cfg.sample_rate = config->sample_rate;
+        opus_cfg.channel = 1;
+        opus_cfg.bits_per_sample = 16;
+        opus_cfg.bitrate = config->bitrate;
+        opus_cfg.application_mode = ESP_OPUS_ENC_APPLICATION_VOIP;
+        cfg.type = ESP_AUDIO_TYPE_OPUS;
+        cfg.cfg = &opus_cfg;
+        cfg.cfg_sz = sizeof(opus_cfg);
+    } else {
+        adpcm_cfg.sample_rate = config->sample_rate;
+        adpcm_cfg.channel = 1;
+        adpcm_cfg.bits_per_sample = 16;
+        cfg.type = ESP_AUDIO_TYPE_ADPCM;
+        cfg.cfg = &adpcm_cfg;
+        cfg.cfg_sz = sizeof(adpcm_cfg);
+    }
+
+    audio_encoder_register_once();
+    if (esp_audio_enc_open(&cfg, &enc->handle) != ESP_AUDIO_ERR_OK) {
+        enc->handle = NULL;
+        ESP_LOGE(TAG, "编码器打开失败");
+        return ESP_FAIL;
+    }
+
+    int in_bytes = 0;
+    int out_bytes = 0;
+    if (esp_audio_enc_get_frame_size(enc->handle, &in_bytes, &out_bytes) != ESP_AUDIO_ERR_OK ||
+        in_bytes <= 0 || out_bytes <= 0) {
+        ESP_LOGE(TAG, "获取编码帧大小失败");
+        return ESP_FAIL;
+    }
+
+    *frame_samples = (size_t)in_bytes / sizeof(int16_t);
+    *out_size = (size_t)out_bytes;
+    return ESP_OK;
+}
+
+/**
+ * @brief 编码一帧并回调输出
+ */
+static void audio_encoder_emit(audio_encoder_t *enc)
+{
+    esp_audio_enc_in_frame_t in = {
+        .buffer = (uint8_t *)enc->frame_buf,
+        .len = enc->frame_samples * sizeof(int16_t),
+    };
+    esp_audio_enc_out_frame_t out = {
+        .buffer = enc->out_buf,
+        .len = enc->out_size,
+    };
+
+    enc->frame_fill = 0;
+    if (esp_audio_enc_process(enc->handle, &in, &out) != ESP_AUDIO_ERR_OK) {
+        ESP_LOGW(TAG, "编码失败，丢弃一帧");
+        return;
+    }
+    if (out.encoded_bytes > 0 && enc->packet_callback) {
+        enc->packet_callback(enc->out_buf, out.encoded_bytes, enc->packet_ctx);
+    }
+}
+
+/**
+ * @brief 从输入缓冲填充帧缓冲，满一帧即编码
+ *
+ * @param timeout_ms 输入为空时的等待时间
+ * @return 本次读取的采样点数
+ */
+static size_t audio_encoder_pump(audio_encoder_t *enc, uint32_t timeout_ms)
+{
+    size_t n = ring_buffer_read(enc->pcm_rb, enc->frame_buf + enc->frame_fill,
+                                enc->frame_samples - enc->frame_fill, timeout_ms);
+    enc->frame_fill += n;
+    if (enc->frame_fill == enc->frame_samples) {
+        audio_encoder_emit(enc);
+    }
+    return n;
+}
+
+/**
+ * @brief 编码任务
+ *
+ * 运行在 AFE Fetch 所在核心，录音回调只做一次拷贝，编码不占用回调路径。
+ *
+ * @param arg 编码器上下文
+ */
+static void audio_encoder_task(void *arg)
+{
+    audio_encoder_t *enc = (audio_encoder_t *)arg;
+
+    while (1) {
+        uint32_t cmd = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &cmd, 0);
+
+        if (cmd & AUDIO_ENCODER_CMD_EXIT) {
+            break;
+        }
+
+        if (cmd & AUDIO_ENCODER_CMD_FLUSH) {
+            // 编完缓冲中的全部数据，最后一帧补静音
+            while (audio_encoder_pump(enc, 0) > 0) {
+            }
+            if (enc->frame_fill > 0) {
+                memset(enc->frame_buf + enc->frame_fill, 0,
+                       (enc->frame_samples - enc->frame_fill) * sizeof(int16_t));
+                audio_encoder_emit(enc);
+            }
+            continue;
+        }
+
+        audio_encoder_pump(enc, AUDIO_ENCODER_WAIT_MS);
+    }
+
+    xSemaphoreGive(enc->exit_done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 向编码任务发送命令并唤醒
+ */
+static void audio_encoder_send_cmd(audio_encoder_t *enc, uint32_t cmd)
+{
+    xTaskNotify(enc->task, cmd, eSetBits);
+    ring_buffer_wake_reader(enc->pcm_rb);
+}
+
+/**
+ * @brief 创建编码器
+ *
+ * @param config 配置参数
+ * @return 编码器句柄，失败返回 NULL
+ */
+audio_encoder_handle_t audio_encoder_create(const audio_encoder_config_t *config)
+{
+    if (!config || config->codec >= AUDIO_ENCODER_CODEC_MAX || config->sample_rate == 0 ||
+        config->buffer_ms == 0 || !config->packet_callback) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    audio_encoder_t *enc = (audio_encoder_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                 sizeof(audio_encoder_t));
+    if (!enc) {
+        ESP_LOGE(TAG, "编码器分配失败");
+        return NULL;
+    }
+
+    enc->arena = config->arena;
+    enc->packet_callback = config->packet_callback;
+    enc->packet_ctx = config->packet_ctx;
+
+    // 帧大小以编解码库为准；内存区模式下不得超过占用预估
+    size_t est_samples = 0;
+    size_t est_out = 0;
+    audio_encoder_frame_estimate(config, &est_samples, &est_out);
+    if (audio_encoder_open(enc, config, &enc->frame_samples, &enc->out_size) != ESP_OK) {
+        goto fail;
+    }
+    if (enc->arena && (enc->frame_samples > est_samples || enc->out_size > est_out)) {
+        ESP_LOGE(TAG, "编码帧超出内存区预估: %u 采样 / %u 字节",
+                 (unsigned)enc->frame_samples, (unsigned)enc->out_size);
+        goto fail;
+    }
+
+    ring_buffer_config_t rb_cfg = audio_encoder_ring_config(config);
+    enc->pcm_rb = ring_buffer_create_with_config(&rb_cfg);
+    enc->frame_buf = (int16_t *)audio_arena_calloc(enc->arena, AUDIO_ARENA_INTERNAL,
+                                                   (enc->arena ? est_samples : enc->frame_samples) * sizeof(int16_t));
+    enc->out_buf = (uint8_t *)audio_arena_calloc(enc->arena, AUDIO_ARENA_INTERNAL,
+                                                 enc->arena ? est_out : enc->out_size);
+    enc->exit_done = audio_arena_create_binary(enc->arena);
+    if (!enc->pcm_rb || !enc->frame_buf || !enc->out_buf || !enc->exit_done) {
+        ESP_LOGE(TAG, "编码缓冲区创建失败");
+        goto fail;
+    }
+
+    enc->task = audio_arena_create_task(enc->arena, audio_encoder_task, "audio_enc",
+                                        config->task_stack_size, enc, config->task_priority,
+                                        config->stack_region, config->task_core);
+    if (!enc->task) {
+        ESP_LOGE(TAG, "编码任务创建失败");
+        goto fail;
+    }
+    enc->task_info = (audio_arena_task_info_t){
+        .handle = enc->task,
+        .stack_bytes = config->task_stack_size,
+        .stack_psram = enc->arena && config->stack_region == AUDIO_ARENA_PSRAM,
+        .is_static = enc->arena != NULL,
+    };
+
+    ESP_LOGI(TAG, "✅ 录音编码器创建成功: %s, 每帧 %u 采样",
+             config->codec == AUDIO_ENCODER_CODEC_OPUS ? "Opus" : "ADPCM", (unsigned)enc->frame_samples);
+    return enc;
+
+fail:
+    audio_encoder_destroy(enc);
+    return NULL;
+}
+
+/**
+ * @brief 累加创建编码器所需的内存占用
+ *
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void audio_encoder_get_footprint(const audio_encoder_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+
+    size_t frame_samples = 0;
+    size_t out_size = 0;
+    audio_encoder_frame_estimate(config, &frame_samples, &out_size);
+    ring_buffer_config_t rb_cfg = audio_encoder_ring_config(config);
+
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(audio_encoder_t));
+    ring_buffer_get_footprint(&rb_cfg, fp);
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, frame_samples * sizeof(int16_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, out_size);
+    audio_arena_footprint_add_semaphore(fp);
+    audio_arena_footprint_add_task(fp, config->stack_region, config->task_stack_size);
+}
+
+/**
+ * @brief 销毁编码器
+ *
+ * @param encoder 编码器句柄
+ */
+void audio_encoder_destroy(audio_encoder_handle_t encoder)
+{
+    if (!encoder) return;
+
+    // 通知编码任务退出并等待（任务可能正在编码，不能直接删除）
+    if (encoder->task) {
+        audio_encoder_send_cmd(encoder, AUDIO_ENCODER_CMD_EXIT);
+        if (xSemaphoreTake(encoder->exit_done, pdMS_TO_TICKS(AUDIO_ENCODER_EXIT_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGW(TAG, "编码任务退出超时，强制删除");
+            vTaskDelete(encoder->task);
+        }
+        encoder->task = NULL;
+    }
+
+    if (encoder->handle) {
+        esp_audio_enc_close(encoder->handle);
+    }
+    if (encoder->exit_done) {
+        vSemaphoreDelete(encoder->exit_done);
+    }
+    if (encoder->pcm_rb) {
+        ring_buffer_destroy(encoder->pcm_rb);
+    }
+    audio_arena_free(encoder->arena, encoder->out_buf);
+    audio_arena_free(encoder->arena, encoder->frame_buf);
+    audio_arena_free(encoder->arena, encoder);
+}
+
+/**
+ * @brief 送入 PCM 数据
+ *
+ * @param encoder 编码器句柄
+ * @param pcm PCM 数据
+ * @param samples 采样点数
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效，ESP_ERR_NO_MEM 输入缓冲已满
+ */
+esp_err_t audio_encoder_feed(audio_encoder_handle_t encoder, const int16_t *pcm, size_t samples)
+{
+    if (!encoder || !pcm || samples == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ring_buffer_write(encoder->pcm_rb, pcm, samples) == samples ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief 结束当前语音段
+ *
+ * @param encoder 编码器句柄
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_encoder_flush(audio_encoder_handle_t encoder)
+{
+    if (!encoder || !encoder->task) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_encoder_send_cmd(encoder, AUDIO_ENCODER_CMD_FLUSH);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取输入缓冲统计
+ *
+ * @param encoder 编码器句柄
+ * @param stats 输出统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_encoder_get_stats(audio_encoder_handle_t encoder, ring_buffer_stats_t *stats)
+{
+    if (!encoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ring_buffer_get_stats(encoder->pcm_rb, stats);
+}
+
+/**
+ * @brief 获取编码任务信息
+ *
+ * @param encoder 编码器句柄
+ * @param info 输出任务信息（编码器无效时清零）
+ */
+void audio_encoder_get_task_info(audio_encoder_handle_t encoder, audio_arena_task_info_t *info)
+{
+    if (!info) {
+        return;
+    }
+    if (!encoder) {
+        memset(info, 0, sizeof(*info));
+        return;
+    }
+    *info = encoder->task_info;
+}
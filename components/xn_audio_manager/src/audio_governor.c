@@ -0,0 +1,225 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-12 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-12 10:00:00
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_governor.c
+ * @Description: 负载调节器实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_governor.h"
+
+/**
+ * @brief 负载调节器结构体
+ *
+ * 仅由调用方的单个任务（音频管理器状态机任务）调用 update；统计字段可从其他任务读取。
+ */
+typedef struct audio_governor_s {
+    audio_governor_config_t config;     ///< 配置
+    audio_governor_sample_t prev;       ///< 上一次采样（取差值的基准）
+    bool has_prev;                      ///< 是否已有基准
+    audio_governor_level_t level;       ///< 当前档位
+    uint8_t overload_windows;           ///< 连续过载周期数
+    uint8_t idle_windows;               ///< 连续空闲周期数
+    bool hold_reported;                 ///< 本轮内存不足已报告过暂缓
+    audio_governor_stats_t stats;       ///< 运行统计
+} audio_governor_t;
+
+/** 档位 a 与 b 之间的调整是否需要重建 AFE（跨越 LOW_COST） */
+static bool audio_governor_needs_rebuild(audio_governor_level_t a, audio_governor_level_t b)
+{
+    return (a == AUDIO_GOVERNOR_LEVEL_LOW_COST) != (b == AUDIO_GOVERNOR_LEVEL_LOW_COST);
+}
+
+/** 处理耗时占音频时长的百分比（上限 255） */
+static uint8_t audio_governor_load_pct(uint32_t busy_us, uint32_t samples, uint32_t sample_rate)
+{
+    if (samples == 0) {
+        return 0;
+    }
+    uint64_t audio_us = (uint64_t)samples * 1000000ULL / sample_rate;
+    uint64_t pct = audio_us ? (uint64_t)busy_us * 100 / audio_us : 0;
+    return pct > 255 ? 255 : (uint8_t)pct;
+}
+
+/**
+ * @brief 创建负载调节器
+ *
+ * @param config 配置参数（recover_pct 须小于 overload_pct）
+ * @return audio_governor_handle_t 句柄，失败返回 NULL
+ */
+audio_governor_handle_t audio_governor_create(const audio_governor_config_t *config)
+{
+    if (!config || config->sample_rate == 0 || config->recover_pct >= config->overload_pct) {
+        return NULL;
+    }
+
+    audio_governor_t *gov = (audio_governor_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                   sizeof(audio_governor_t));
+    if (!gov) {
+        return NULL;
+    }
+    gov->config = *config;
+    if (gov->config.degrade_windows == 0) {
+        gov->config.degrade_windows = 1;
+    }
+    if (gov->config.recover_windows == 0) {
+        gov->config.recover_windows = 1;
+    }
+    return gov;
+}
+
+/**
+ * @brief 累加创建负载调节器所需的内存占用（仅上下文，内部 RAM）
+ */
+void audio_governor_get_footprint(const audio_governor_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(audio_governor_t));
+}
+
+/**
+ * @brief 销毁负载调节器
+ */
+void audio_governor_destroy(audio_governor_handle_t governor)
+{
+    if (!governor) return;
+    audio_arena_free(governor->config.arena, governor);
+}
+
+/**
+ * @brief 输入一次采样并做出决策
+ *
+ * 过载判定按严重程度取第一个命中的原因：Feed 超时 > Fetch 停顿 > 积压/回采溢出 > 负载过高。
+ * 空闲要求两项负载都低于 recover_pct 且积压低于阈值的一半；介于两者之间的周期清零两个计数。
+ * 内存不足时，跨越 LOW_COST 的调整（需重建 AFE、重新分配内部缓冲）暂缓，首次暂缓时报告。
+ */
+bool audio_governor_update(audio_governor_handle_t governor, const audio_governor_sample_t *sample,
+                           audio_governor_decision_t *decision)
+{
+    if (!governor || !sample || !decision) {
+        return false;
+    }
+    audio_governor_t *gov = governor;
+    const audio_governor_config_t *cfg = &gov->config;
+
+    audio_governor_sample_t prev = gov->prev;
+    bool has_prev = gov->has_prev;
+    gov->prev = *sample;
+    gov->has_prev = true;
+
+    // AFE 重建后送入位置回退到输出位置，差值可能为负
+    int32_t fed = (int32_t)(sample->feed_samples - prev.feed_samples);
+    if (!has_prev || fed <= 0) {
+        // 未监听（或重建中）：不计入过载/空闲
+        gov->overload_windows = 0;
+        gov->idle_windows = 0;
+        return false;
+    }
+
+    uint8_t feed_pct = audio_governor_load_pct(sample->feed_busy_us - prev.feed_busy_us, (uint32_t)fed,
+                                               cfg->sample_rate);
+    uint8_t fetch_pct = audio_governor_load_pct(sample->fetch_busy_us - prev.fetch_busy_us,
+                                                sample->fetch_samples - prev.fetch_samples,
+                                                cfg->sample_rate);
+    uint32_t backlog_ms = (uint32_t)((uint64_t)sample->backlog_samples * 1000 / cfg->sample_rate);
+    gov->stats.feed_load_pct = feed_pct;
+    gov->stats.fetch_load_pct = fetch_pct;
+    gov->stats.backlog_ms = backlog_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)backlog_ms;
+
+    bool overload = true;
+    audio_governor_reason_t reason;
+    if (sample->feed_misses != prev.feed_misses) {
+        reason = AUDIO_GOVERNOR_REASON_FEED_DEADLINE;
+    } else if (sample->fetch_misses != prev.fetch_misses) {
+        reason = AUDIO_GOVERNOR_REASON_FETCH_DEADLINE;
+    } else if (backlog_ms > cfg->backlog_ms || sample->ref_overrun_samples != prev.ref_overrun_samples) {
+        reason = AUDIO_GOVERNOR_REASON_BACKLOG;
+    } else if (feed_pct >= cfg->overload_pct || fetch_pct >= cfg->overload_pct) {
+        reason = AUDIO_GOVERNOR_REASON_CPU_LOAD;
+    } else {
+        overload = false;
+        reason = AUDIO_GOVERNOR_REASON_RECOVERED;
+    }
+    bool idle = !overload && feed_pct < cfg->recover_pct && fetch_pct < cfg->recover_pct &&
+                backlog_ms < cfg->backlog_ms / 2;
+
+    audio_governor_level_t target = gov->level;
+    if (overload) {
+        gov->idle_windows = 0;
+        if (gov->level < cfg->max_level && ++gov->overload_windows >= cfg->degrade_windows) {
+            target = (audio_governor_level_t)(gov->level + 1);
+        }
+    } else if (idle) {
+        gov->overload_windows = 0;
+        if (gov->level > AUDIO_GOVERNOR_LEVEL_NORMAL && ++gov->idle_windows >= cfg->recover_windows) {
+            target = (audio_governor_level_t)(gov->level - 1);
+        }
+    } else {
+        gov->overload_windows = 0;
+        gov->idle_windows = 0;
+    }
+
+    bool low_memory = cfg->min_free_internal > 0 && sample->free_internal < cfg->min_free_internal;
+    if (!low_memory) {
+        gov->hold_reported = false;
+    }
+
+    *decision = (audio_governor_decision_t){
+        .level = gov->level,
+        .prev_level = gov->level,
+        .reason = reason,
+        .feed_load_pct = feed_pct,
+        .fetch_load_pct = fetch_pct,
+        .backlog_ms = gov->stats.backlog_ms,
+        .free_internal = sample->free_internal,
+    };
+
+    if (target == gov->level) {
+        return false;
+    }
+    if (low_memory && audio_governor_needs_rebuild(gov->level, target)) {
+        gov->stats.memory_holds++;
+        if (gov->hold_reported) {
+            return false;
+        }
+        gov->hold_reported = true;
+        decision->reason = AUDIO_GOVERNOR_REASON_LOW_MEMORY;
+        return true;
+    }
+
+    if (target > gov->level) {
+        gov->stats.degrades++;
+    } else {
+        gov->stats.recoveries++;
+    }
+    gov->level = target;
+    gov->stats.level = target;
+    gov->overload_windows = 0;
+    gov->idle_windows = 0;
+    decision->level = target;
+    return true;
+}
+
+/**
+ * @brief 获取当前档位
+ */
+audio_governor_level_t audio_governor_get_level(audio_governor_handle_t governor)
+{
+    return governor ? governor->level : AUDIO_GOVERNOR_LEVEL_NORMAL;
+}
+
+/**
+ * @brief 获取运行统计
+ */
+esp_err_t audio_governor_get_stats(audio_governor_handle_t governor, audio_governor_stats_t *stats)
+{
+    if (!governor || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = governor->stats;
+    return ESP_OK;
+}
@@ -10,17 +10,28 @@
  */
 #include "audio_manager.h"
 #include "ring_buffer.h"
+#include "event_ring.h"
 #include "playback_controller.h"
 #include "button_handler.h"
 #include "afe_wrapper.h"
+#include "audio_encoder.h"
+#include "audio_arena.h"
+#include "audio_trace.h"
+#include "audio_governor.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include <string.h>
 
 static const char *TAG = "AUDIO_MGR";
 
+#define AUDIO_MANAGER_EXIT_TIMEOUT_MS  500      ///< 反初始化时等待状态机任务退出的最长时间
+#define AUDIO_MANAGER_SYNC_TIMEOUT_MS  3000     ///< 同步接口等待状态机任务执行完成的最长时间（含 AFE 热重建）
+
 typedef enum {
     AUDIO_INT_EVT_START_LISTEN = 0,
     AUDIO_INT_EVT_STOP_LISTEN,
@@ -30,15 +41,31 @@ typedef enum {
     AUDIO_INT_EVT_VAD_START,
     AUDIO_INT_EVT_VAD_END,
     AUDIO_INT_EVT_WAKE_TIMEOUT,
+    AUDIO_INT_EVT_PLACEMENT,
+    AUDIO_INT_EVT_GOVERNOR_TICK,
+    AUDIO_INT_EVT_START_RECORDING,
+    AUDIO_INT_EVT_STOP_RECORDING,
+    AUDIO_INT_EVT_START_PLAYBACK,
+    AUDIO_INT_EVT_STOP_PLAYBACK,
+    AUDIO_INT_EVT_UPDATE_WAKEUP,        ///< 更新唤醒词配置（同步请求）
+    AUDIO_INT_EVT_UPDATE_AFE,           ///< 更新 AFE 功能配置（同步请求）
+    AUDIO_INT_EVT_UPDATE_VAD,           ///< 更新 VAD 配置（同步请求）
+    AUDIO_INT_EVT_QUIT,                 ///< 状态机任务退出（处理完此前的事件后退出）
 } audio_mgr_internal_event_t;
 
 typedef struct {
     audio_mgr_internal_event_t type;
+    int64_t timestamp_us;       ///< 事件发生时间
+    uint64_t sample_pos;        ///< 事件发生时的 AFE 输出流位置
+    uint32_t sync_seq;          ///< 同步请求序号（0 表示异步事件，无需应答）
     union {
         struct {
             int   wake_word_index;
             float volume_db;
         } wakeup;
+        audio_mgr_wakeup_config_t wakeup_config;
+        audio_mgr_afe_config_t afe_config;
+        audio_mgr_vad_config_t vad_config;
     } data;
 } audio_mgr_internal_msg_t;
 
@@ -62,27 +89,49 @@ typedef struct {
     playback_controller_handle_t playback_ctrl;  ///< 播放控制器句柄
     button_handler_handle_t button_handler; ///< 按键处理器句柄
     afe_wrapper_handle_t afe_wrapper;      ///< AFE 包装器句柄
+    audio_encoder_handle_t encoder;        ///< 录音编码器句柄（未启用时为 NULL）
     
     // 共享缓冲区
-    ring_buffer_handle_t reference_rb;     ///< 回采缓冲区句柄（播放控制器和 AFE 共享）
+    aec_reference_handle_t reference;      ///< 回采对齐句柄（播放控制器和 AFE 共享）
+
+    // 内存
+    audio_arena_handle_t arena;            ///< 管线内存区（未启用时为 NULL，各模块使用堆）
     
     // 状态
     bool initialized;                       ///< 是否已初始化
     bool running;                           ///< 是否正在运行（监听音频）
     bool recording;                         ///< 是否正在录音
     bool playing;                           ///< 是否正在播放
+    bool ducked;                            ///< 是否因打断处于闪避（录音结束后恢复）
+    bool resume_playback;                   ///< 播放被打断停止（录音结束后恢复）
     uint8_t volume;                         ///< 音量（0-100）
     audio_mgr_state_t state;                ///< 状态机
     bool wake_active;                       ///< 是否处于唤醒窗口
-    TickType_t wake_deadline_tick;          ///< 唤醒超时tick
+    int64_t wake_deadline_us;               ///< 唤醒超时时刻（esp_timer 时间）
+    esp_timer_handle_t wake_timer;          ///< 唤醒/结束延迟定时器（单次，到期投递 WAKE_TIMEOUT）
+
+    // 负载调节
+    audio_mgr_task_placement_t placement;   ///< 实际任务绑核（已解析 AUTO）
+    audio_governor_handle_t governor;       ///< 负载调节器（未启用时为 NULL）
+    esp_timer_handle_t governor_timer;      ///< 采样定时器（周期，到期投递 GOVERNOR_TICK）
     
     // 回调
     audio_record_callback_t record_callback; ///< 录音数据回调函数
     void *record_ctx;                        ///< 录音回调的用户上下文
+    audio_encoded_record_callback_t encoded_record_callback; ///< 编码录音回调函数
+    void *encoded_record_ctx;                ///< 编码录音回调的用户上下文
+    bool encoder_recording;                  ///< 上次刷新状态时的录音标志（用于检测录音段结束）
 
     // 调度
-    QueueHandle_t event_queue;
+    event_ring_handle_t event_ring;         ///< 内部事件环（按键/AFE/定时器/API 无锁投递）
     TaskHandle_t manager_task;
+    SemaphoreHandle_t manager_exit;         ///< 状态机任务退出应答
+    SemaphoreHandle_t sync_lock;            ///< 同步请求互斥锁（同一时刻只有一个调用方等待应答）
+    SemaphoreHandle_t sync_done;            ///< 同步请求应答信号量
+    uint32_t sync_seq;                      ///< 最近一次同步请求的序号（持有 sync_lock 时递增）
+    volatile uint32_t sync_done_seq;        ///< 最近完成的同步请求序号（状态机任务写入）
+    esp_err_t sync_result;                  ///< 最近完成的同步请求结果（先于 sync_done_seq 写入）
+    uint32_t events_dropped_logged;         ///< 已在日志中报告过的丢弃事件数
 
 } audio_manager_ctx_t;
 
@@ -98,9 +147,23 @@ static void audio_manager_notify_event(const audio_mgr_event_t *event);
 static bool audio_manager_post_event(const audio_mgr_internal_msg_t *msg);
 static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *msg);
 static void audio_manager_task(void *arg);
-static void audio_manager_tick(void);
+
+/** 各子模块的创建配置（初始化与内存占用预估共用，句柄字段在创建时补齐） */
+typedef struct {
+    audio_bsp_hw_config_t bsp;
+    playback_controller_config_t playback;
+    afe_wrapper_config_t afe;
+    button_handler_config_t button;
+    audio_encoder_config_t encoder;
+    bool encoder_enabled;
+    audio_governor_config_t governor;
+    bool governor_enabled;
+    audio_mgr_task_placement_t placement;
+} audio_manager_module_configs_t;
 static void audio_manager_arm_wake_timer(int duration_ms);
 static void audio_manager_clear_wake_timer(void);
+static void audio_manager_update_profile(void);
+static esp_err_t audio_manager_apply_afe_features(void);
 
 static void audio_manager_set_state(audio_mgr_state_t new_state)
 {
@@ -121,6 +184,26 @@ static void audio_manager_refresh_state(void)
         return;
     }
 
+    // 录音段结束：让编码器输出最后一包
+    if (s_ctx.encoder && s_ctx.encoder_recording && !s_ctx.recording) {
+        audio_encoder_flush(s_ctx.encoder);
+    }
+    s_ctx.encoder_recording = s_ctx.recording;
+
+    // 打断闪避：录音结束或播放停止后恢复
+    if (s_ctx.ducked && (!s_ctx.recording || !s_ctx.playing)) {
+        playback_controller_set_ducked(s_ctx.playback_ctrl, false);
+        s_ctx.ducked = false;
+    }
+
+    // 打断停止的播放在本次录音结束后恢复：待播放数据已丢弃，之后写入的回复照常播放
+    if (s_ctx.resume_playback && !s_ctx.recording) {
+        s_ctx.resume_playback = false;
+        if (playback_controller_start(s_ctx.playback_ctrl) == ESP_OK) {
+            s_ctx.playing = true;
+        }
+    }
+
     if (s_ctx.playing) {
         audio_manager_set_state(AUDIO_MGR_STATE_PLAYBACK);
     } else if (s_ctx.recording) {
@@ -130,6 +213,66 @@ static void audio_manager_refresh_state(void)
     } else {
         audio_manager_set_state(AUDIO_MGR_STATE_IDLE);
     }
+
+    if (s_ctx.config.afe_config.aec_playback_only) {
+        audio_manager_apply_afe_features();
+    }
+    audio_manager_update_profile();
+}
+
+/**
+ * @brief 按当前配置与播放状态下发 AFE 功能开关
+ *
+ * aec_playback_only 时仅播放期间运行 AEC；其余功能按配置，再按负载调节档位降级。
+ * 未变化时包装器直接返回。
+ */
+static esp_err_t audio_manager_apply_afe_features(void)
+{
+    if (!s_ctx.afe_wrapper) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const audio_mgr_afe_config_t *afe = &s_ctx.config.afe_config;
+    const audio_mgr_vad_config_t *vad = &s_ctx.config.vad_config;
+    afe_feature_config_t features = {
+        .aec_enabled = afe->aec_enabled && (!afe->aec_playback_only || s_ctx.playing),
+        .ns_enabled = afe->ns_enabled,
+        .agc_enabled = afe->agc_enabled,
+        .afe_mode = afe->afe_mode,
+    };
+    // 负载调节档位在配置之上逐级关闭功能，恢复后回到配置值
+    audio_governor_level_t level = audio_governor_get_level(s_ctx.governor);
+    if (level >= AUDIO_GOVERNOR_LEVEL_REDUCED) {
+        features.ns_enabled = false;
+        features.agc_enabled = false;
+    }
+    if (level >= AUDIO_GOVERNOR_LEVEL_LOW_COST) {
+        features.afe_mode = 0;
+    }
+    afe_vad_config_t vad_cfg = {
+        .enabled = vad->enabled,
+        .vad_mode = vad->vad_mode,
+        .min_speech_ms = vad->min_speech_ms,
+        .min_silence_ms = vad->min_silence_ms,
+    };
+    return afe_wrapper_update_feature_config(s_ctx.afe_wrapper, &features, &vad_cfg);
+}
+
+/**
+ * @brief 按状态选择 AFE 档位
+ *
+ * 没有唤醒窗口、录音和播放时只需检测唤醒词，切到低功耗档位；
+ * 唤醒、按键、开始播放都会先刷新状态，从而立即切回完整管线。
+ */
+static void audio_manager_update_profile(void)
+{
+    if (!s_ctx.afe_wrapper || !s_ctx.config.power_config.low_power_listen) {
+        return;
+    }
+
+    bool idle_listen = (s_ctx.state == AUDIO_MGR_STATE_LISTENING || s_ctx.state == AUDIO_MGR_STATE_IDLE) &&
+                       !s_ctx.wake_active;
+    afe_wrapper_set_profile(s_ctx.afe_wrapper, idle_listen ? AFE_PROFILE_LOW_POWER : AFE_PROFILE_FULL);
 }
 
 static void audio_manager_notify_event(const audio_mgr_event_t *event)
@@ -140,15 +283,20 @@ static void audio_manager_notify_event(const audio_mgr_event_t *event)
     s_ctx.config.event_callback(event, s_ctx.config.user_ctx);
 }
 
-static bool audio_manager_post_event(const audio_mgr_internal_msg_t *msg)
+/**
+ * @brief 投递内部事件（任意任务、esp_timer 回调或 ISR 中调用，不阻塞）
+ *
+ * 环满时只累加丢弃计数，由状态机任务统一打印告警。
+ */
+static bool IRAM_ATTR audio_manager_post_event(const audio_mgr_internal_msg_t *msg)
 {
-    if (!s_ctx.event_queue || !msg) {
+    if (!s_ctx.event_ring || !msg) {
         return false;
     }
-    if (xQueueSend(s_ctx.event_queue, msg, 0) != pdTRUE) {
-        ESP_LOGW(TAG, "event queue full, drop type=%d", msg->type);
+    if (!event_ring_push(s_ctx.event_ring, msg)) {
         return false;
     }
+    audio_trace_mark(AUDIO_TRACE_EVENT_POST, msg->type);
     return true;
 }
 
@@ -158,29 +306,50 @@ static void audio_manager_arm_wake_timer(int duration_ms)
         audio_manager_clear_wake_timer();
         return;
     }
+    uint64_t timeout_us = (uint64_t)duration_ms * 1000;
     s_ctx.wake_active = true;
-    s_ctx.wake_deadline_tick = xTaskGetTickCount() + pdMS_TO_TICKS(duration_ms);
+    s_ctx.wake_deadline_us = esp_timer_get_time() + (int64_t)timeout_us;
+    esp_timer_stop(s_ctx.wake_timer);
+    esp_timer_start_once(s_ctx.wake_timer, timeout_us);
 }
 
 static void audio_manager_clear_wake_timer(void)
 {
     s_ctx.wake_active = false;
-    s_ctx.wake_deadline_tick = 0;
+    s_ctx.wake_deadline_us = 0;
+    if (s_ctx.wake_timer) {
+        esp_timer_stop(s_ctx.wake_timer);
+    }
 }
 
-static void audio_manager_tick(void)
+/**
+ * @brief 唤醒定时器到期回调（esp_timer 任务上下文）
+ *
+ * 只投递事件，由状态机任务统一处理；重新计时前已触发的旧事件在处理时按截止时刻过滤。
+ */
+static void audio_manager_wake_timer_cb(void *arg)
 {
-    if (!s_ctx.wake_active) {
-        return;
-    }
-    TickType_t now = xTaskGetTickCount();
-    if ((int32_t)(now - s_ctx.wake_deadline_tick) >= 0) {
-        s_ctx.wake_active = false;
-        audio_mgr_internal_msg_t msg = {
-            .type = AUDIO_INT_EVT_WAKE_TIMEOUT,
-        };
-        audio_manager_handle_internal_event(&msg);
-    }
+    audio_mgr_internal_msg_t msg = {
+        .type = AUDIO_INT_EVT_WAKE_TIMEOUT,
+        .timestamp_us = esp_timer_get_time(),
+        .sample_pos = afe_wrapper_get_stream_pos(s_ctx.afe_wrapper),
+    };
+    audio_manager_post_event(&msg);
+}
+
+/**
+ * @brief 负载调节采样定时器回调（esp_timer 任务上下文）
+ *
+ * 只投递事件，采样与决策在状态机任务中完成，调整 AFE 功能与其他 API 调用串行。
+ */
+static void audio_manager_governor_timer_cb(void *arg)
+{
+    audio_mgr_internal_msg_t msg = {
+        .type = AUDIO_INT_EVT_GOVERNOR_TICK,
+        .timestamp_us = esp_timer_get_time(),
+        .sample_pos = afe_wrapper_get_stream_pos(s_ctx.afe_wrapper),
+    };
+    audio_manager_post_event(&msg);
 }
 
 // ============ 内部回调函数 ============
@@ -188,17 +357,19 @@ static void audio_manager_tick(void)
 /**
  * @brief 按键事件回调函数
  * 
- * 当按键被按下或松开时，由按键处理器调用此函数。
- * 将按键事件转换为音频管理器事件并通知上层应用。
+ * 当按键被按下或松开时，由按键处理器的防抖定时器回调调用此函数（可能处于中断上下文）。
+ * 直接把事件写入事件环并唤醒状态机任务，不经过中间任务。
  * 
  * @param event 按键事件类型（按下/松开）
  * @param user_ctx 用户上下文（未使用）
  */
-static void button_event_handler(button_event_type_t event, void *user_ctx)
+static void IRAM_ATTR button_event_handler(button_event_type_t event, void *user_ctx)
 {
     audio_mgr_internal_msg_t msg = {
         .type = (event == BUTTON_EVENT_PRESS) ? AUDIO_INT_EVT_BUTTON_PRESS
                                               : AUDIO_INT_EVT_BUTTON_RELEASE,
+        .timestamp_us = esp_timer_get_time(),
+        .sample_pos = afe_wrapper_get_stream_pos(s_ctx.afe_wrapper),
     };
     audio_manager_post_event(&msg);
 }
@@ -218,7 +389,10 @@ static void afe_event_handler(const afe_event_t *event, void *user_ctx)
         return;
     }
 
-    audio_mgr_internal_msg_t msg = {0};
+    audio_mgr_internal_msg_t msg = {
+        .timestamp_us = event->timestamp_us,
+        .sample_pos = event->sample_pos,
+    };
 
     switch (event->type) {
         case AFE_EVENT_WAKEUP_DETECTED:
@@ -256,6 +430,285 @@ static void afe_record_handler(const int16_t *pcm_data, size_t samples, void *us
     if (s_ctx.record_callback) {
         s_ctx.record_callback(pcm_data, samples, s_ctx.record_ctx);
     }
+
+    // 编码录音：只拷贝进编码器输入缓冲，编码在独立任务中完成
+    if (s_ctx.encoder && s_ctx.encoded_record_callback) {
+        audio_encoder_feed(s_ctx.encoder, pcm_data, samples);
+    }
+}
+
+/**
+ * @brief 全双工扬声器数据源（AFE Feed 任务调用）
+ */
+static size_t afe_speaker_pull_handler(int16_t *pcm, size_t samples, uint8_t *volume, void *user_ctx)
+{
+    return playback_controller_pull(s_ctx.playback_ctrl, pcm, samples, volume);
+}
+
+/**
+ * @brief 编码包回调函数（编码任务上下文）
+ */
+static void encoder_packet_handler(const uint8_t *data, size_t len, void *user_ctx)
+{
+    audio_encoded_record_callback_t callback = s_ctx.encoded_record_callback;
+    if (callback) {
+        callback(data, len, s_ctx.encoded_record_ctx);
+    }
+}
+
+/**
+ * @brief 应用层编码格式映射为编码器格式
+ */
+static bool audio_manager_encoder_codec(audio_mgr_codec_t codec, audio_encoder_codec_t *out)
+{
+    switch (codec) {
+    case AUDIO_MGR_CODEC_OPUS:  *out = AUDIO_ENCODER_CODEC_OPUS;  return true;
+    case AUDIO_MGR_CODEC_ADPCM: *out = AUDIO_ENCODER_CODEC_ADPCM; return true;
+    default:                    return false;
+    }
+}
+
+/**
+ * @brief 打断播放（barge-in）
+ * 
+ * 在通知应用之前执行，交互延迟不受应用回调影响。STOP 策略由播放任务在 fade_ms 内淡出，
+ * 丢弃全部待播放数据但保留回采，已写入 I2S 的尾音仍可被 AEC 消除；录音结束后自动恢复播放。
+ * 
+ * @param wake_word true 由唤醒词触发，false 由人声开始触发
+ * @param evt 触发事件（时间戳与录音流位置随打断事件一并上报）
+ */
+static void audio_manager_barge_in(bool wake_word, const audio_mgr_event_t *evt)
+{
+    const audio_mgr_barge_in_config_t *cfg = &s_ctx.config.playback_config.barge_in;
+
+    if (!s_ctx.playing || cfg->mode == AUDIO_MGR_BARGE_IN_OFF) {
+        return;
+    }
+    if (wake_word ? !cfg->on_wake_word : !cfg->on_vad_start) {
+        return;
+    }
+
+    if (cfg->mode == AUDIO_MGR_BARGE_IN_DUCK) {
+        if (!s_ctx.ducked) {
+            ESP_LOGI(TAG, "🔉 打断：闪避播放");
+            playback_controller_set_ducked(s_ctx.playback_ctrl, true);
+            s_ctx.ducked = true;
+        }
+        return;
+    }
+
+    playback_controller_interrupt(s_ctx.playback_ctrl, cfg->fade_ms);
+    s_ctx.playing = false;
+    s_ctx.resume_playback = true;
+
+    audio_mgr_event_t interrupted = *evt;
+    interrupted.type = AUDIO_MGR_EVENT_PLAYBACK_INTERRUPTED;
+    audio_manager_notify_event(&interrupted);
+}
+
+/**
+ * @brief 负载调节：采样、决策并报告（状态机任务上下文）
+ *
+ * 过载时逐级关闭 NS/AGC、切换 LOW_COST afe_mode，空闲后逐级恢复；
+ * 启动时的任务放置与每次档位调整都通过 AUDIO_MGR_EVENT_GOVERNOR 报告。
+ *
+ * @param placement true 仅报告任务放置（初始化完成时投递一次）
+ * @param evt 已填好时间戳与流位置的事件
+ */
+static void audio_manager_governor_tick(bool placement, audio_mgr_event_t *evt)
+{
+    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    evt->type = AUDIO_MGR_EVENT_GOVERNOR;
+    evt->data.governor.feed_core = s_ctx.placement.afe_feed_core;
+    evt->data.governor.fetch_core = s_ctx.placement.afe_fetch_core;
+    evt->data.governor.free_internal = (uint32_t)free_internal;
+
+    if (placement) {
+        audio_mgr_gov_level_t level = (audio_mgr_gov_level_t)audio_governor_get_level(s_ctx.governor);
+        evt->data.governor.level = level;
+        evt->data.governor.prev_level = level;
+        evt->data.governor.reason = AUDIO_MGR_GOV_REASON_PLACEMENT;
+        ESP_LOGI(TAG, "🧭 任务放置: feed=%d fetch=%d playback=%d mgr=%d encoder=%d (WiFi 核 %d)",
+                 s_ctx.placement.afe_feed_core, s_ctx.placement.afe_fetch_core,
+                 s_ctx.placement.playback_core, s_ctx.placement.manager_core,
+                 s_ctx.placement.encoder_core, audio_manager_get_network_core());
+        audio_manager_notify_event(evt);
+        return;
+    }
+    if (!s_ctx.governor) {
+        return;
+    }
+
+    afe_load_stats_t load = {0};
+    afe_wrapper_get_load_stats(s_ctx.afe_wrapper, &load);
+    ring_buffer_stats_t playback = {0};
+    ring_buffer_stats_t reference = {0};
+    playback_controller_get_stats(s_ctx.playback_ctrl, &playback, &reference);
+
+    audio_governor_sample_t sample = {
+        .feed_samples = load.feed_samples,
+        .feed_busy_us = load.feed_busy_us,
+        .feed_misses = load.feed_misses,
+        .fetch_samples = load.fetch_samples,
+        .fetch_busy_us = load.fetch_busy_us,
+        .fetch_misses = load.fetch_misses,
+        .backlog_samples = load.backlog_samples,
+        .ref_overrun_samples = reference.overrun_samples,
+        .free_internal = free_internal,
+    };
+    audio_governor_decision_t decision;
+    if (!audio_governor_update(s_ctx.governor, &sample, &decision)) {
+        return;
+    }
+
+    if (decision.level != decision.prev_level) {
+        esp_err_t ret = audio_manager_apply_afe_features();
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "负载调节下发 AFE 功能失败: %s", esp_err_to_name(ret));
+        }
+    }
+    if (decision.level > decision.prev_level) {
+        ESP_LOGW(TAG, "⚠️ 负载调节降级 %d -> %d (原因 %d, feed %u%%, fetch %u%%, 积压 %u ms)",
+                 decision.prev_level, decision.level, decision.reason,
+                 decision.feed_load_pct, decision.fetch_load_pct, decision.backlog_ms);
+    } else if (decision.level < decision.prev_level) {
+        ESP_LOGI(TAG, "✅ 负载调节恢复 %d -> %d (feed %u%%, fetch %u%%)",
+                 decision.prev_level, decision.level, decision.feed_load_pct, decision.fetch_load_pct);
+    } else {
+        ESP_LOGW(TAG, "⚠️ 内部 RAM 仅剩 %u B，暂缓需要重建 AFE 的调整", (unsigned)decision.free_internal);
+    }
+
+    // audio_mgr_gov_*_t 与 audio_governor_*_t 取值一一对应
+    evt->data.governor.level = (audio_mgr_gov_level_t)decision.level;
+    evt->data.governor.prev_level = (audio_mgr_gov_level_t)decision.prev_level;
+    evt->data.governor.reason = (audio_mgr_gov_reason_t)decision.reason;
+    evt->data.governor.feed_load_pct = decision.feed_load_pct;
+    evt->data.governor.fetch_load_pct = decision.fetch_load_pct;
+    evt->data.governor.backlog_ms = decision.backlog_ms;
+    audio_manager_notify_event(evt);
+}
+
+/**
+ * @brief 执行同步请求（仅在状态机任务中调用）
+ *
+ * @return 请求结果，由 audio_manager_call() 返回给调用方
+ */
+static esp_err_t audio_manager_exec_request(const audio_mgr_internal_msg_t *msg)
+{
+    switch (msg->type) {
+    case AUDIO_INT_EVT_START_PLAYBACK: {
+        esp_err_t ret = playback_controller_start(s_ctx.playback_ctrl);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "❌ 启动播放失败: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        s_ctx.playing = true;
+        audio_manager_refresh_state();
+        return ESP_OK;
+    }
+
+    case AUDIO_INT_EVT_STOP_PLAYBACK: {
+        esp_err_t ret = playback_controller_stop(s_ctx.playback_ctrl);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "❌ 停止播放失败: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        s_ctx.playing = false;
+        s_ctx.resume_playback = false;
+        audio_manager_refresh_state();
+        return ESP_OK;
+    }
+
+    case AUDIO_INT_EVT_UPDATE_WAKEUP: {
+        const audio_mgr_wakeup_config_t *config = &msg->data.wakeup_config;
+        memcpy(&s_ctx.config.wakeup_config, config, sizeof(audio_mgr_wakeup_config_t));
+
+        afe_wakeup_config_t afe_wakeup = {
+            .enabled = config->enabled,
+            .wake_word_name = config->wake_word_name,
+            .wake_model_name = config->wake_model_name,
+            .model_partition = config->model_partition,
+            .sensitivity = config->sensitivity,
+        };
+        return afe_wrapper_update_wakeup_config(s_ctx.afe_wrapper, &afe_wakeup);
+    }
+
+    case AUDIO_INT_EVT_UPDATE_AFE: {
+        const audio_mgr_afe_config_t *config = &msg->data.afe_config;
+        audio_mgr_afe_config_t *afe = &s_ctx.config.afe_config;
+        afe->aec_enabled = config->aec_enabled;
+        afe->ns_enabled = config->ns_enabled;
+        afe->agc_enabled = config->agc_enabled;
+        afe->afe_mode = config->afe_mode;
+        afe->aec_playback_only = config->aec_playback_only;
+
+        ESP_LOGI(TAG, "AFE 配置更新: AEC=%d%s, NS=%d, AGC=%d, 模式=%d",
+                 afe->aec_enabled, afe->aec_playback_only ? "(仅播放)" : "",
+                 afe->ns_enabled, afe->agc_enabled, afe->afe_mode);
+        return audio_manager_apply_afe_features();
+    }
+
+    case AUDIO_INT_EVT_UPDATE_VAD: {
+        const audio_mgr_vad_config_t *config = &msg->data.vad_config;
+        memcpy(&s_ctx.config.vad_config, config, sizeof(audio_mgr_vad_config_t));
+        ESP_LOGI(TAG, "VAD 配置更新: %s, 模式=%d", config->enabled ? "启用" : "关闭", config->vad_mode);
+        return audio_manager_apply_afe_features();
+    }
+
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+/**
+ * @brief 应答同步请求（异步投递的事件 sync_seq 为 0，不应答）
+ */
+static void audio_manager_complete_request(const audio_mgr_internal_msg_t *msg, esp_err_t result)
+{
+    if (msg->sync_seq == 0) {
+        return;
+    }
+    s_ctx.sync_result = result;
+    s_ctx.sync_done_seq = msg->sync_seq;
+    xSemaphoreGive(s_ctx.sync_done);
+}
+
+/**
+ * @brief 同步请求：投递到状态机任务执行并等待结果
+ *
+ * 状态与 AFE 只在状态机任务中修改；在事件回调（状态机任务）中调用时直接执行。
+ * 超时的请求仍会在之后执行，其迟到的应答按序号识别并忽略。
+ *
+ * @return 请求结果；ESP_FAIL 事件环已满；ESP_ERR_TIMEOUT 等待超时
+ */
+static esp_err_t audio_manager_call(audio_mgr_internal_msg_t *msg)
+{
+    if (xTaskGetCurrentTaskHandle() == s_ctx.manager_task) {
+        return audio_manager_exec_request(msg);
+    }
+
+    xSemaphoreTake(s_ctx.sync_lock, portMAX_DELAY);
+    if (++s_ctx.sync_seq == 0) {
+        s_ctx.sync_seq = 1;
+    }
+    msg->sync_seq = s_ctx.sync_seq;
+
+    esp_err_t ret = ESP_FAIL;
+    if (audio_manager_post_event(msg)) {
+        ret = ESP_ERR_TIMEOUT;
+        TickType_t start = xTaskGetTickCount();
+        TickType_t timeout = pdMS_TO_TICKS(AUDIO_MANAGER_SYNC_TIMEOUT_MS);
+        TickType_t elapsed = 0;
+        while (elapsed < timeout && xSemaphoreTake(s_ctx.sync_done, timeout - elapsed) == pdTRUE) {
+            if (s_ctx.sync_done_seq == msg->sync_seq) {
+                ret = s_ctx.sync_result;
+                break;
+            }
+            elapsed = xTaskGetTickCount() - start;
+        }
+    }
+    xSemaphoreGive(s_ctx.sync_lock);
+    return ret;
 }
 
 static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *msg)
@@ -264,7 +717,10 @@ static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *
         return;
     }
 
-    audio_mgr_event_t evt = {0};
+    audio_mgr_event_t evt = {
+        .timestamp_us = msg->timestamp_us,
+        .sample_pos = msg->sample_pos,
+    };
 
     switch (msg->type) {
     case AUDIO_INT_EVT_START_LISTEN:
@@ -301,6 +757,7 @@ static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *
         break;
 
     case AUDIO_INT_EVT_WAKE_WORD:
+        audio_manager_barge_in(true, &evt);
         evt.type = AUDIO_MGR_EVENT_WAKEUP_DETECTED;
         evt.data.wakeup.wake_word_index = msg->data.wakeup.wake_word_index;
         evt.data.wakeup.volume_db = msg->data.wakeup.volume_db;
@@ -311,6 +768,7 @@ static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *
         break;
 
     case AUDIO_INT_EVT_VAD_START:
+        audio_manager_barge_in(false, &evt);
         evt.type = AUDIO_MGR_EVENT_VAD_START;
         audio_manager_notify_event(&evt);
         s_ctx.recording = true;
@@ -326,39 +784,409 @@ static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *
         audio_manager_refresh_state();
         break;
 
+    case AUDIO_INT_EVT_PLACEMENT:
+    case AUDIO_INT_EVT_GOVERNOR_TICK:
+        audio_manager_governor_tick(msg->type == AUDIO_INT_EVT_PLACEMENT, &evt);
+        break;
+
     case AUDIO_INT_EVT_WAKE_TIMEOUT:
+        // 定时器已被清除或重新计时：丢弃过期的到期事件
+        if (!s_ctx.wake_active || msg->timestamp_us < s_ctx.wake_deadline_us) {
+            break;
+        }
         evt.type = AUDIO_MGR_EVENT_WAKEUP_TIMEOUT;
         audio_manager_notify_event(&evt);
         s_ctx.recording = false;
         audio_manager_clear_wake_timer();
         audio_manager_refresh_state();
         break;
+
+    case AUDIO_INT_EVT_START_RECORDING:
+        ESP_LOGI(TAG, "📼 开始录音");
+        s_ctx.recording = true;
+        audio_manager_refresh_state();
+        break;
+
+    case AUDIO_INT_EVT_STOP_RECORDING:
+        if (!s_ctx.recording) {
+            break;
+        }
+        ESP_LOGI(TAG, "⏹️ 停止录音");
+        s_ctx.recording = false;
+        audio_manager_refresh_state();
+        break;
+
+    case AUDIO_INT_EVT_START_PLAYBACK:
+    case AUDIO_INT_EVT_STOP_PLAYBACK:
+    case AUDIO_INT_EVT_UPDATE_WAKEUP:
+    case AUDIO_INT_EVT_UPDATE_AFE:
+    case AUDIO_INT_EVT_UPDATE_VAD:
+        audio_manager_complete_request(msg, audio_manager_exec_request(msg));
+        break;
+
+    case AUDIO_INT_EVT_QUIT:
+        // 由任务循环处理
+        break;
+    }
+}
+
+/**
+ * @brief 报告新增的丢弃事件（投递方可能在 ISR 中，不能直接打印）
+ */
+static void audio_manager_check_dropped_events(void)
+{
+    event_ring_stats_t stats;
+    event_ring_get_stats(s_ctx.event_ring, &stats);
+    if (stats.dropped != s_ctx.events_dropped_logged) {
+        ESP_LOGW(TAG, "⚠️ 事件环已满，丢弃 %u 个事件（累计 %u）",
+                 (unsigned)(stats.dropped - s_ctx.events_dropped_logged), (unsigned)stats.dropped);
+        s_ctx.events_dropped_logged = stats.dropped;
     }
 }
 
 static void audio_manager_task(void *arg)
 {
     audio_mgr_internal_msg_t msg = {0};
-
-    while (true) {
-        if (xQueueReceive(s_ctx.event_queue, &msg, pdMS_TO_TICKS(AUDIO_MANAGER_STEP_INTERVAL_MS)) == pdTRUE) {
+    uint32_t seq = 0;
+
+    bool quit = false;
+
+    // 纯事件驱动：超时由定时器投递，空闲时阻塞在任务通知上
+    while (!quit) {
+        while (event_ring_pop(s_ctx.event_ring, &msg, &seq)) {
+            if (msg.type == AUDIO_INT_EVT_QUIT) {
+                quit = true;
+                break;
+            }
+            audio_trace_mark(AUDIO_TRACE_EVENT_RECV, msg.type);
+            if (msg.timestamp_us > 0 && audio_trace_is_enabled()) {
+                audio_trace_record(AUDIO_TRACE_LAT_EVENT_DISPATCH,
+                                   (uint32_t)(esp_timer_get_time() - msg.timestamp_us));
+            }
+            ESP_LOGD(TAG, "事件 #%u type=%d", (unsigned)seq, msg.type);
             audio_manager_handle_internal_event(&msg);
         }
-        audio_manager_tick();
+        audio_manager_check_dropped_events();
+        if (!quit) {
+            event_ring_wait(s_ctx.event_ring, portMAX_DELAY);
+        }
+    }
+
+    xSemaphoreGive(s_ctx.manager_exit);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 通知状态机任务退出并等待
+ *
+ * 任务可能正持有 AFE 或播放控制器的锁，不能直接删除；退出事件排在已投递的
+ * 停止事件之后，任务处理完后自行退出。事件环满时在超时内重试投递。
+ */
+static void audio_manager_quit_task(void)
+{
+    const audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_QUIT };
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(AUDIO_MANAGER_EXIT_TIMEOUT_MS);
+    bool exited = false;
+
+    while (!audio_manager_post_event(&msg)) {
+        if (xTaskGetTickCount() - start >= timeout) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (elapsed < timeout) {
+        exited = (xSemaphoreTake(s_ctx.manager_exit, timeout - elapsed) == pdTRUE);
+    }
+    if (!exited) {
+        ESP_LOGW(TAG, "状态机任务退出超时，强制删除");
+        vTaskDelete(s_ctx.manager_task);
+    }
+    s_ctx.manager_task = NULL;
+}
+
+// ============ 任务放置 ============
+
+/**
+ * @brief 解析单个任务的绑核
+ *
+ * 双核时实时任务放在 WiFi 协议栈之外的核，非实时任务与 WiFi 共核；
+ * 单核配置或请求的核不存在时按自动处理。
+ *
+ * @param requested 请求的核（AUDIO_MANAGER_CORE_AUTO 为自动）
+ * @param realtime 是否为实时任务（有帧截止要求）
+ */
+static int8_t audio_manager_resolve_core(int8_t requested, bool realtime)
+{
+#if CONFIG_FREERTOS_UNICORE
+    (void)requested;
+    (void)realtime;
+    return 0;
+#else
+    if (requested >= 0 && requested < portNUM_PROCESSORS) {
+        return requested;
+    }
+    int network_core = audio_manager_get_network_core();
+    return (int8_t)(realtime ? 1 - network_core : network_core);
+#endif
+}
+
+/**
+ * @brief 解析全部管线任务的绑核
+ *
+ * 默认配置下与固定布局一致：feed/播放在 Core 1，fetch/状态机/编码与 WiFi 同在 Core 0。
+ */
+static void audio_manager_resolve_placement(const audio_mgr_task_placement_t *req,
+                                            audio_mgr_task_placement_t *out)
+{
+    out->afe_feed_core = audio_manager_resolve_core(req->afe_feed_core, true);
+    out->playback_core = audio_manager_resolve_core(req->playback_core, true);
+    out->afe_fetch_core = audio_manager_resolve_core(req->afe_fetch_core, false);
+    out->manager_core = audio_manager_resolve_core(req->manager_core, false);
+    out->encoder_core = audio_manager_resolve_core(req->encoder_core, false);
+}
+
+// ============ 内存规划 ============
+
+/**
+ * @brief 由应用层配置生成各子模块配置
+ * 
+ * 初始化与占用预估共用同一份转换，保证预估的缓冲区大小与实际创建一致。
+ * bsp_handle/reference 等运行时句柄在创建对应模块后补齐。
+ * 
+ * @param config 应用层配置
+ * @param arena 内存区（NULL 使用堆）
+ * @param out 输出子模块配置
+ */
+static void audio_manager_build_module_configs(const audio_mgr_config_t *config,
+                                               audio_arena_handle_t arena,
+                                               audio_manager_module_configs_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    audio_manager_resolve_placement(&config->task_placement, &out->placement);
+
+    out->bsp = (audio_bsp_hw_config_t){
+        .mic = config->hw_config.mic,
+        .speaker = config->hw_config.speaker,
+        .full_duplex = config->hw_config.full_duplex,
+        .arena = arena,
+    };
+
+    out->playback = (playback_controller_config_t){
+        .bsp_handle = NULL,
+        .playback_buffer_samples = (config->playback_config.pcm_buffer_bytes ?
+                                    config->playback_config.pcm_buffer_bytes :
+                                    AUDIO_MANAGER_PLAYBACK_BUFFER_BYTES) / sizeof(int16_t),
+        .reference_buffer_samples = AUDIO_MANAGER_REFERENCE_BUFFER_BYTES / sizeof(int16_t),
+        .reference_lead_ms = config->afe_config.aec_ref_lead_ms,
+        .reference_auto_delay = config->afe_config.aec_auto_delay,
+        .frame_samples = AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES,
+        .reference_callback = NULL,
+        .reference_ctx = NULL,
+        .volume_ptr = &s_ctx.volume,
+        // audio_mgr_overrun_policy_t 与 ring_buffer_overrun_policy_t 取值一一对应
+        .overrun_policy = (ring_buffer_overrun_policy_t)config->playback_config.overrun_policy,
+        .write_timeout_ms = config->playback_config.write_timeout_ms,
+        .encoded_buffer_bytes = config->playback_config.encoded_buffer_bytes,
+        .sample_rate = config->hw_config.speaker.sample_rate,
+        .full_duplex = config->hw_config.full_duplex,
+        .format_convert = config->playback_config.format_convert,
+        .duck_gain = config->playback_config.duck_gain,
+        .task_core = out->placement.playback_core,
+        .arena = arena,
+    };
+    // 流 0 的缓冲区由 pcm_buffer_bytes 决定
+    _Static_assert(AUDIO_MANAGER_MAX_STREAMS == PLAYBACK_MAX_STREAMS, "播放流数量须一致");
+    for (int i = 0; i < AUDIO_MANAGER_MAX_STREAMS; i++) {
+        const audio_mgr_stream_config_t *stream = &config->playback_config.streams[i];
+        out->playback.streams[i] = (playback_stream_config_t){
+            .buffer_samples = i == 0 ? 0 : stream->buffer_bytes / sizeof(int16_t),
+            .priority = stream->priority,
+            .gain = stream->gain,
+        };
+    }
+
+    out->afe = (afe_wrapper_config_t){
+        .bsp_handle = NULL,
+        .reference = NULL,
+        .mic_num = config->hw_config.mic.mic_num,
+        .input_format = config->afe_config.input_format,
+        .wakeup_config = (afe_wakeup_config_t){
+            .enabled = config->wakeup_config.enabled,
+            .wake_word_name = config->wakeup_config.wake_word_name,
+            .wake_model_name = config->wakeup_config.wake_model_name,
+            .model_partition = config->wakeup_config.model_partition,
+            .sensitivity = config->wakeup_config.sensitivity,
+        },
+        .vad_config = (afe_vad_config_t){
+            .enabled = config->vad_config.enabled,
+            .vad_mode = config->vad_config.vad_mode,
+            .min_speech_ms = config->vad_config.min_speech_ms,
+            .min_silence_ms = config->vad_config.min_silence_ms,
+        },
+        .feature_config = (afe_feature_config_t){
+            .aec_enabled = config->afe_config.aec_enabled,
+            .ns_enabled = config->afe_config.ns_enabled,
+            .agc_enabled = config->afe_config.agc_enabled,
+            .afe_mode = config->afe_config.afe_mode,
+        },
+        .low_power_config = (afe_low_power_config_t){
+            .enabled = config->power_config.low_power_listen,
+            .rx_dma_frame_num = config->power_config.listen_dma_frame_num,
+        },
+        .event_callback = afe_event_handler,
+        .event_ctx = NULL,
+        .record_callback = afe_record_handler,
+        .record_ctx = NULL,
+        .speaker_pull = config->hw_config.full_duplex ? afe_speaker_pull_handler : NULL,
+        .speaker_ctx = NULL,
+        .running_ptr = &s_ctx.running,
+        .recording_ptr = &s_ctx.recording,
+        .preroll_samples = (size_t)config->hw_config.mic.sample_rate * config->afe_config.preroll_ms / 1000,
+        .feed_core = out->placement.afe_feed_core,
+        .fetch_core = out->placement.afe_fetch_core,
+        .arena = arena,
+    };
+
+    out->button = (button_handler_config_t){
+        .gpio = config->hw_config.button.gpio,
+        .active_low = config->hw_config.button.active_low,
+        .debounce_ms = 50,
+        .callback = button_event_handler,
+        .user_ctx = NULL,
+        .arena = arena,
+    };
+
+    // 录音编码：非实时任务，默认与 AFE Fetch 同核
+    out->encoder_enabled = config->record_encode_config.enabled;
+    out->encoder = AUDIO_ENCODER_DEFAULT_CONFIG();
+    audio_manager_encoder_codec(config->record_encode_config.codec, &out->encoder.codec);
+    out->encoder.sample_rate = config->hw_config.mic.sample_rate;
+    out->encoder.frame_ms = config->record_encode_config.frame_ms;
+    out->encoder.bitrate = config->record_encode_config.bitrate;
+    // 录音开始时预录数据会一次性送入，输入缓冲需额外容纳这部分
+    out->encoder.buffer_ms += config->afe_config.preroll_ms;
+    out->encoder.task_core = out->placement.encoder_core;
+    out->encoder.packet_callback = encoder_packet_handler;
+    out->encoder.arena = arena;
+#if CONFIG_AUDIO_MANAGER_ENCODER_STACK_PSRAM
+    // 编码任务不访问 Flash，栈可放 PSRAM 以节省内部 RAM（编码耗时略增）
+    out->encoder.stack_region = AUDIO_ARENA_PSRAM;
+#endif
+
+    // 负载调节：配置已是 LOW_COST 模式或不允许切换时，最多关闭 NS/AGC
+    _Static_assert((int)AUDIO_MGR_GOV_LEVEL_LOW_COST == (int)AUDIO_GOVERNOR_LEVEL_LOW_COST, "档位取值须一致");
+    _Static_assert((int)AUDIO_MGR_GOV_REASON_RECOVERED == (int)AUDIO_GOVERNOR_REASON_RECOVERED, "原因取值须一致");
+    const audio_mgr_governor_config_t *gov = &config->governor_config;
+    out->governor_enabled = gov->enabled;
+    out->governor = AUDIO_GOVERNOR_DEFAULT_CONFIG();
+    out->governor.sample_rate = AFE_WRAPPER_SAMPLE_RATE;
+    out->governor.overload_pct = gov->overload_pct;
+    out->governor.recover_pct = gov->recover_pct;
+    out->governor.backlog_ms = gov->backlog_ms;
+    out->governor.degrade_windows = gov->degrade_windows;
+    out->governor.recover_windows = gov->recover_windows;
+    out->governor.min_free_internal = gov->min_free_internal;
+    out->governor.max_level = (gov->allow_low_cost && config->afe_config.afe_mode != 0) ?
+                              AUDIO_GOVERNOR_LEVEL_LOW_COST : AUDIO_GOVERNOR_LEVEL_REDUCED;
+    out->governor.arena = arena;
+}
+
+/**
+ * @brief 累加全部模块（含状态机任务与事件队列）的内存占用
+ */
+static void audio_manager_calc_footprint(const audio_manager_module_configs_t *cfgs,
+                                         audio_arena_footprint_t *fp)
+{
+    audio_bsp_get_footprint(&cfgs->bsp, fp);
+    playback_controller_get_footprint(&cfgs->playback, fp);
+    afe_wrapper_get_footprint(&cfgs->afe, fp);
+    button_handler_get_footprint(&cfgs->button, fp);
+    if (cfgs->encoder_enabled) {
+        audio_encoder_get_footprint(&cfgs->encoder, fp);
+    }
+    if (cfgs->governor_enabled) {
+        audio_governor_get_footprint(&cfgs->governor, fp);
     }
+    event_ring_config_t ring_cfg = EVENT_RING_DEFAULT_CONFIG(AUDIO_MANAGER_EVENT_QUEUE_LENGTH,
+                                                             sizeof(audio_mgr_internal_msg_t));
+    event_ring_get_footprint(&ring_cfg, fp);
+    audio_arena_footprint_add_semaphore(fp);   // 退出应答
+    audio_arena_footprint_add_semaphore(fp);   // 同步请求互斥锁
+    audio_arena_footprint_add_semaphore(fp);   // 同步请求应答
+    audio_arena_footprint_add_task(fp, AUDIO_ARENA_INTERNAL, AUDIO_MANAGER_TASK_STACK_SIZE);
 }
 
 // ============ 公共 API 实现 ============
 
+/**
+ * @brief 计算内存区模式下的管线内存占用
+ * 
+ * 不需要先初始化，可在编译期/启动前用于确定内存预算。
+ * 
+ * @param config 音频管理器配置参数
+ * @param footprint 输出占用
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t audio_manager_get_footprint(const audio_mgr_config_t *config, audio_mgr_footprint_t *footprint)
+{
+    if (!config || !footprint) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_manager_module_configs_t cfgs;
+    audio_arena_footprint_t fp = {0};
+    audio_manager_build_module_configs(config, NULL, &cfgs);
+    audio_manager_calc_footprint(&cfgs, &fp);
+
+    footprint->internal_bytes = fp.bytes[AUDIO_ARENA_INTERNAL];
+    footprint->psram_bytes = fp.bytes[AUDIO_ARENA_PSRAM];
+    return ESP_OK;
+}
+
+/**
+ * @brief 预加载唤醒词模型
+ * 
+ * 模型加载是初始化中最慢的一步，提前加载可与 WiFi 等其他启动阶段并行。
+ * 
+ * @param config 音频管理器配置参数
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；其他为模型加载错误
+ */
+esp_err_t audio_manager_preload_models(const audio_mgr_config_t *config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!config->wakeup_config.enabled) {
+        return ESP_OK;
+    }
+    return afe_wrapper_preload_models(config->wakeup_config.model_partition);
+}
+
+/**
+ * @brief 释放预加载的唤醒词模型
+ * 
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 管线仍在使用
+ */
+esp_err_t audio_manager_release_models(void)
+{
+    return afe_wrapper_release_models();
+}
+
 /**
  * @brief 初始化音频管理器
  * 
  * 按照以下顺序初始化各个模块：
+ * 0. 启用内存区时，按配置计算全部占用并一次性预分配
  * 1. 创建 I2S HAL（硬件抽象层）
  * 2. 创建回采缓冲区（用于 AEC）
  * 3. 创建播放控制器（管理音频播放）
- * 4. 创建 AFE 包装器（音频前端处理）
- * 5. 创建按键处理器（处理物理按键）
+ * 4. 创建录音编码器（可选）
+ * 5. 创建 AFE 包装器（音频前端处理）
+ * 6. 创建按键处理器（处理物理按键）
  * 
  * @param config 音频管理器配置参数
  * @return 
@@ -379,33 +1207,50 @@ esp_err_t audio_manager_init(const audio_mgr_config_t *config)
         return ESP_ERR_INVALID_ARG;
     }
 
+    audio_encoder_codec_t encoder_codec;
+    if (config->record_encode_config.enabled &&
+        !audio_manager_encoder_codec(config->record_encode_config.codec, &encoder_codec)) {
+        ESP_LOGE(TAG, "录音编码不支持该格式: %d", config->record_encode_config.codec);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
     ESP_LOGI(TAG, "======== 初始化音频管理器（模块化状态机）========");
     memset(&s_ctx, 0, sizeof(s_ctx));
     memcpy(&s_ctx.config, config, sizeof(audio_mgr_config_t));
     s_ctx.volume = AUDIO_MANAGER_DEFAULT_VOLUME;
     s_ctx.state = AUDIO_MGR_STATE_DISABLED;
+#if CONFIG_AUDIO_MANAGER_STATIC_ALLOC
+    // 静态分配模式：全部任务栈/TCB 与队列来自启动时一次性分配的内存区
+    s_ctx.config.memory_config.use_arena = true;
+#endif
+
+    // 内存区模式：先按全部模块配置计算占用，一次性预分配
+    if (s_ctx.config.memory_config.use_arena) {
+        audio_manager_module_configs_t plan;
+        audio_arena_footprint_t fp = {0};
+        audio_manager_build_module_configs(&s_ctx.config, NULL, &plan);
+        audio_manager_calc_footprint(&plan, &fp);
+
+        s_ctx.arena = audio_arena_create(&fp);
+        if (!s_ctx.arena) {
+            ESP_LOGE(TAG, "内存区创建失败");
+            ret = ESP_ERR_NO_MEM;
+            goto fail;
+        }
+    }
 
-    audio_bsp_hw_config_t bsp_cfg = {
-        .mic = s_ctx.config.hw_config.mic,
-        .speaker = s_ctx.config.hw_config.speaker,
-    };
+    audio_manager_module_configs_t cfgs;
+    audio_manager_build_module_configs(&s_ctx.config, s_ctx.arena, &cfgs);
 
-    s_ctx.bsp = audio_bsp_create(&bsp_cfg);
+    s_ctx.bsp = audio_bsp_create(&cfgs.bsp);
     if (!s_ctx.bsp) {
         ESP_LOGE(TAG, "BSP 创建失败");
         ret = ESP_ERR_NO_MEM;
         goto fail;
     }
 
-    playback_controller_config_t playback_cfg = {
-        .bsp_handle = s_ctx.bsp,
-        .playback_buffer_samples = AUDIO_MANAGER_PLAYBACK_BUFFER_BYTES / sizeof(int16_t),
-        .reference_buffer_samples = AUDIO_MANAGER_REFERENCE_BUFFER_BYTES / sizeof(int16_t),
-        .frame_samples = AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES,
-        .reference_callback = NULL,
-        .reference_ctx = NULL,
-        .volume_ptr = &s_ctx.volume,
-    };
+    playback_controller_config_t playback_cfg = cfgs.playback;
+    playback_cfg.bsp_handle = s_ctx.bsp;
 
     s_ctx.playback_ctrl = playback_controller_create(&playback_cfg);
     if (!s_ctx.playback_ctrl) {
@@ -414,55 +1259,63 @@ esp_err_t audio_manager_init(const audio_mgr_config_t *config)
         goto fail;
     }
 
-    s_ctx.reference_rb = playback_controller_get_reference_buffer(s_ctx.playback_ctrl);
+    s_ctx.reference = playback_controller_get_reference(s_ctx.playback_ctrl);
 
-    s_ctx.event_queue = xQueueCreate(AUDIO_MANAGER_EVENT_QUEUE_LENGTH, sizeof(audio_mgr_internal_msg_t));
-    if (!s_ctx.event_queue) {
-        ESP_LOGE(TAG, "事件队列创建失败");
+    event_ring_config_t ring_cfg = EVENT_RING_DEFAULT_CONFIG(AUDIO_MANAGER_EVENT_QUEUE_LENGTH,
+                                                             sizeof(audio_mgr_internal_msg_t));
+    ring_cfg.arena = s_ctx.arena;
+    s_ctx.event_ring = event_ring_create(&ring_cfg);
+    if (!s_ctx.event_ring) {
+        ESP_LOGE(TAG, "事件环创建失败");
         ret = ESP_ERR_NO_MEM;
         goto fail;
     }
 
-    if (xTaskCreatePinnedToCore(audio_manager_task,
-                                "audio_mgr",
-                                AUDIO_MANAGER_TASK_STACK_SIZE,
-                                NULL,
-                                AUDIO_MANAGER_TASK_PRIORITY,
-                                &s_ctx.manager_task,
-                                0) != pdPASS) {
-        ESP_LOGE(TAG, "状态机任务创建失败");
+    const esp_timer_create_args_t wake_timer_args = {
+        .callback = audio_manager_wake_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "audio_wake",
+    };
+    ret = esp_timer_create(&wake_timer_args, &s_ctx.wake_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "唤醒定时器创建失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    s_ctx.manager_exit = audio_arena_create_binary(s_ctx.arena);
+    s_ctx.sync_lock = audio_arena_create_mutex(s_ctx.arena);
+    s_ctx.sync_done = audio_arena_create_binary(s_ctx.arena);
+    if (!s_ctx.manager_exit || !s_ctx.sync_lock || !s_ctx.sync_done) {
+        ESP_LOGE(TAG, "状态机信号量创建失败");
         ret = ESP_ERR_NO_MEM;
         goto fail;
     }
 
-    afe_wrapper_config_t afe_cfg = {
-        .bsp_handle = s_ctx.bsp,
-        .reference_rb = s_ctx.reference_rb,
-        .wakeup_config = (afe_wakeup_config_t){
-            .enabled = s_ctx.config.wakeup_config.enabled,
-            .wake_word_name = s_ctx.config.wakeup_config.wake_word_name,
-            .model_partition = s_ctx.config.wakeup_config.model_partition,
-            .sensitivity = s_ctx.config.wakeup_config.sensitivity,
-        },
-        .vad_config = (afe_vad_config_t){
-            .enabled = s_ctx.config.vad_config.enabled,
-            .vad_mode = s_ctx.config.vad_config.vad_mode,
-            .min_speech_ms = s_ctx.config.vad_config.min_speech_ms,
-            .min_silence_ms = s_ctx.config.vad_config.min_silence_ms,
-        },
-        .feature_config = (afe_feature_config_t){
-            .aec_enabled = s_ctx.config.afe_config.aec_enabled,
-            .ns_enabled = s_ctx.config.afe_config.ns_enabled,
-            .agc_enabled = s_ctx.config.afe_config.agc_enabled,
-            .afe_mode = s_ctx.config.afe_config.afe_mode,
-        },
-        .event_callback = afe_event_handler,
-        .event_ctx = NULL,
-        .record_callback = afe_record_handler,
-        .record_ctx = NULL,
-        .running_ptr = &s_ctx.running,
-        .recording_ptr = &s_ctx.recording,
-    };
+    s_ctx.manager_task = audio_arena_create_task(s_ctx.arena, audio_manager_task, "audio_mgr",
+                                                 AUDIO_MANAGER_TASK_STACK_SIZE, NULL,
+                                                 AUDIO_MANAGER_TASK_PRIORITY, AUDIO_ARENA_INTERNAL,
+                                                 cfgs.placement.manager_core);
+    if (!s_ctx.manager_task) {
+        ESP_LOGE(TAG, "状态机任务创建失败");
+        ret = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+    // 此前投递的事件在任务首次循环时取出，不依赖通知
+    event_ring_set_consumer(s_ctx.event_ring, s_ctx.manager_task);
+
+    if (cfgs.encoder_enabled) {
+        s_ctx.encoder = audio_encoder_create(&cfgs.encoder);
+        if (!s_ctx.encoder) {
+            ESP_LOGE(TAG, "录音编码器创建失败");
+            ret = ESP_ERR_NO_MEM;
+            goto fail;
+        }
+    }
+
+    afe_wrapper_config_t afe_cfg = cfgs.afe;
+    afe_cfg.bsp_handle = s_ctx.bsp;
+    afe_cfg.reference = s_ctx.reference;
 
     s_ctx.afe_wrapper = afe_wrapper_create(&afe_cfg);
     if (!s_ctx.afe_wrapper) {
@@ -471,24 +1324,56 @@ esp_err_t audio_manager_init(const audio_mgr_config_t *config)
         goto fail;
     }
 
-    button_handler_config_t button_cfg = {
-        .gpio = s_ctx.config.hw_config.button.gpio,
-        .active_low = s_ctx.config.hw_config.button.active_low,
-        .debounce_ms = 50,
-        .callback = button_event_handler,
-        .user_ctx = NULL,
-    };
-
-    s_ctx.button_handler = button_handler_create(&button_cfg);
+    s_ctx.button_handler = button_handler_create(&cfgs.button);
     if (!s_ctx.button_handler) {
         ESP_LOGE(TAG, "按键处理器创建失败");
         ret = ESP_ERR_NO_MEM;
         goto fail;
     }
 
+    s_ctx.placement = cfgs.placement;
+    if (cfgs.governor_enabled) {
+        s_ctx.governor = audio_governor_create(&cfgs.governor);
+        if (!s_ctx.governor) {
+            ESP_LOGE(TAG, "负载调节器创建失败（recover_pct 须小于 overload_pct）");
+            ret = ESP_ERR_INVALID_ARG;
+            goto fail;
+        }
+
+        const esp_timer_create_args_t governor_timer_args = {
+            .callback = audio_manager_governor_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "audio_gov",
+        };
+        ret = esp_timer_create(&governor_timer_args, &s_ctx.governor_timer);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "负载调节定时器创建失败: %s", esp_err_to_name(ret));
+            goto fail;
+        }
+        uint32_t interval_ms = s_ctx.config.governor_config.interval_ms ? s_ctx.config.governor_config.interval_ms : 500;
+        esp_timer_start_periodic(s_ctx.governor_timer, (uint64_t)interval_ms * 1000);
+    }
+
+    if (s_ctx.arena) {
+        audio_arena_footprint_t used = {0};
+        audio_arena_footprint_t capacity = {0};
+        audio_arena_get_usage(s_ctx.arena, &used, &capacity);
+        ESP_LOGI(TAG, "📦 内存区使用: 内部 %u/%u B, PSRAM %u/%u B",
+                 (unsigned)used.bytes[AUDIO_ARENA_INTERNAL], (unsigned)capacity.bytes[AUDIO_ARENA_INTERNAL],
+                 (unsigned)used.bytes[AUDIO_ARENA_PSRAM], (unsigned)capacity.bytes[AUDIO_ARENA_PSRAM]);
+    }
+
     s_ctx.initialized = true;
     s_ctx.state = AUDIO_MGR_STATE_IDLE;
+    audio_manager_apply_afe_features();
     audio_manager_refresh_state();
+
+    audio_mgr_internal_msg_t placement_msg = {
+        .type = AUDIO_INT_EVT_PLACEMENT,
+        .timestamp_us = esp_timer_get_time(),
+    };
+    audio_manager_post_event(&placement_msg);
     ESP_LOGI(TAG, "✅ 音频管理器初始化完成");
     return ESP_OK;
 
@@ -501,12 +1386,12 @@ fail:
  * @brief 反初始化音频管理器
  * 
  * 按照与初始化相反的顺序销毁各个模块，释放资源。
- * 注意：reference_rb 由播放控制器管理，不需要单独销毁。
+ * 注意：回采对齐由播放控制器管理，不需要单独销毁。
  */
 void audio_manager_deinit(void)
 {
     // 检查是否已初始化
-    if (!s_ctx.initialized && !s_ctx.bsp) {
+    if (!s_ctx.initialized && !s_ctx.bsp && !s_ctx.arena) {
         return;
     }
 
@@ -515,13 +1400,42 @@ void audio_manager_deinit(void)
     audio_manager_stop_playback();
 
     if (s_ctx.manager_task) {
-        vTaskDelete(s_ctx.manager_task);
-        s_ctx.manager_task = NULL;
+        audio_manager_quit_task();
+    }
+    if (s_ctx.manager_exit) {
+        vSemaphoreDelete(s_ctx.manager_exit);
+        s_ctx.manager_exit = NULL;
+    }
+    if (s_ctx.sync_lock) {
+        vSemaphoreDelete(s_ctx.sync_lock);
+        s_ctx.sync_lock = NULL;
+    }
+    if (s_ctx.sync_done) {
+        vSemaphoreDelete(s_ctx.sync_done);
+        s_ctx.sync_done = NULL;
+    }
+
+    // 状态机任务已退出，不会再重新计时
+    if (s_ctx.wake_timer) {
+        esp_timer_stop(s_ctx.wake_timer);
+        esp_timer_delete(s_ctx.wake_timer);
+        s_ctx.wake_timer = NULL;
     }
 
-    if (s_ctx.event_queue) {
-        vQueueDelete(s_ctx.event_queue);
-        s_ctx.event_queue = NULL;
+    if (s_ctx.governor_timer) {
+        esp_timer_stop(s_ctx.governor_timer);
+        esp_timer_delete(s_ctx.governor_timer);
+        s_ctx.governor_timer = NULL;
+    }
+
+    if (s_ctx.governor) {
+        audio_governor_destroy(s_ctx.governor);
+        s_ctx.governor = NULL;
+    }
+
+    if (s_ctx.event_ring) {
+        event_ring_destroy(s_ctx.event_ring);
+        s_ctx.event_ring = NULL;
     }
 
     // 销毁按键处理器
@@ -536,6 +1450,12 @@ void audio_manager_deinit(void)
         s_ctx.afe_wrapper = NULL;
     }
 
+    // 销毁录音编码器（AFE 已停止送数据）
+    if (s_ctx.encoder) {
+        audio_encoder_destroy(s_ctx.encoder);
+        s_ctx.encoder = NULL;
+    }
+
     // 销毁播放控制器
     if (s_ctx.playback_ctrl) {
         playback_controller_destroy(s_ctx.playback_ctrl);
@@ -548,13 +1468,39 @@ void audio_manager_deinit(void)
         s_ctx.bsp = NULL;
     }
 
-    // reference_rb 由播放控制器管理，不需要单独销毁
+    // 回采对齐由播放控制器管理，不需要单独销毁
+
+    // 最后归还内存区（所有任务、队列、缓冲区均已销毁）
+    if (s_ctx.arena) {
+        // 让空闲任务先完成已自删除任务（TCB 位于内存区）的清理
+        vTaskDelay(pdMS_TO_TICKS(10));
+        audio_arena_destroy(s_ctx.arena);
+        s_ctx.arena = NULL;
+    }
 
     // 清空上下文
     memset(&s_ctx, 0, sizeof(s_ctx));
     ESP_LOGI(TAG, "音频管理器已销毁");
 }
 
+/**
+ * @brief 获取 WiFi 协议栈所在核
+ *
+ * 与 Kconfig 中 WiFi 任务绑核一致；自动放置时非实时任务与其共核，应用层网络任务也可绑到此核。
+ *
+ * @return 核编号（单核配置为 0）
+ */
+int audio_manager_get_network_core(void)
+{
+#if CONFIG_FREERTOS_UNICORE
+    return 0;
+#elif CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1
+    return 1;
+#else
+    return 0;
+#endif
+}
+
 /**
  * @brief 启动音频监听
  * 
@@ -615,40 +1561,37 @@ esp_err_t audio_manager_trigger_conversation(void)
  * @brief 开始录音
  * 
  * 设置录音标志，AFE 会开始将处理后的音频数据通过回调传递给上层应用。
+ * 状态由状态机任务修改，本接口只投递事件。
  * 
  * @return 
- *     - ESP_OK: 开始成功
+ *     - ESP_OK: 已投递
  *     - ESP_ERR_INVALID_STATE: 未初始化
+ *     - ESP_FAIL: 事件环已满
  */
 esp_err_t audio_manager_start_recording(void)
 {
     // 检查是否已初始化
     if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
 
-    ESP_LOGI(TAG, "📼 开始录音");
-    s_ctx.recording = true;
-    audio_manager_refresh_state();
-
-    return ESP_OK;
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_START_RECORDING };
+    return audio_manager_post_event(&msg) ? ESP_OK : ESP_FAIL;
 }
 
 /**
  * @brief 停止录音
  * 
- * 清除录音标志，AFE 停止传递音频数据。
+ * 清除录音标志，AFE 停止传递音频数据。状态由状态机任务修改，本接口只投递事件。
  * 
- * @return ESP_OK: 停止成功
+ * @return 
+ *     - ESP_OK: 已投递（或未初始化）
+ *     - ESP_FAIL: 事件环已满
  */
 esp_err_t audio_manager_stop_recording(void)
 {
-    // 如果未在录音，直接返回
-    if (!s_ctx.recording) return ESP_OK;
-
-    ESP_LOGI(TAG, "⏹️ 停止录音");
-    s_ctx.recording = false;
-    audio_manager_refresh_state();
+    if (!s_ctx.initialized) return ESP_OK;
 
-    return ESP_OK;
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_STOP_RECORDING };
+    return audio_manager_post_event(&msg) ? ESP_OK : ESP_FAIL;
 }
 
 /**
@@ -662,6 +1605,8 @@ esp_err_t audio_manager_stop_recording(void)
  *     - ESP_OK: 写入成功
  *     - ESP_ERR_INVALID_ARG: 参数无效
  *     - ESP_ERR_INVALID_STATE: 未初始化
+ *     - ESP_ERR_NO_MEM: 缓冲区已满，数据被拒绝（REJECT 策略）
+ *     - ESP_ERR_TIMEOUT: 等待空间超时，数据被拒绝（BLOCK 策略）
  */
 esp_err_t audio_manager_play_audio(const int16_t *pcm_data, size_t sample_count)
 {
@@ -674,6 +1619,105 @@ esp_err_t audio_manager_play_audio(const int16_t *pcm_data, size_t sample_count)
     return playback_controller_write(s_ctx.playback_ctrl, pcm_data, sample_count);
 }
 
+/**
+ * @brief 按指定格式播放 PCM
+ * 
+ * 在调用任务中完成重采样与下混，结果直接写入播放缓冲区，播放任务与 AFE 回采始终为扬声器格式。
+ * 
+ * @param pcm_data PCM 数据（多声道交织）
+ * @param frames 帧数
+ * @param format 输入格式
+ * @return 
+ *     - ESP_OK: 写入成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ *     - ESP_ERR_NOT_SUPPORTED: 未启用格式转换或格式不支持
+ *     - ESP_ERR_NO_MEM: 缓冲区已满，数据被拒绝（REJECT 策略）
+ *     - ESP_ERR_TIMEOUT: 等待空间超时，数据被拒绝（BLOCK 策略）
+ */
+esp_err_t audio_manager_play_audio_format(const int16_t *pcm_data, size_t frames,
+                                          const audio_mgr_pcm_format_t *format)
+{
+    if (!s_ctx.initialized || !pcm_data || frames == 0 || !format) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    playback_pcm_format_t fmt = {
+        .sample_rate = format->sample_rate,
+        .channels = format->channels,
+    };
+    return playback_controller_write_format(s_ctx.playback_ctrl, pcm_data, frames, &fmt);
+}
+
+/**
+ * @brief 播放压缩音频数据
+ * 
+ * 压缩数据写入压缩缓冲区，由播放任务逐帧解码后输出（同时回采给 AFE）。
+ * 
+ * @param codec 压缩格式
+ * @param data 压缩数据
+ * @param len 字节数
+ * @return 
+ *     - ESP_OK: 写入成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ *     - ESP_ERR_NOT_SUPPORTED: 未启用压缩播放
+ *     - ESP_ERR_NO_MEM: 缓冲区已满，数据被拒绝
+ *     - ESP_ERR_TIMEOUT: 等待空间超时，数据被拒绝（BLOCK 策略）
+ */
+esp_err_t audio_manager_play_encoded(audio_mgr_codec_t codec, const uint8_t *data, size_t len)
+{
+    if (!s_ctx.initialized || !data || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // audio_mgr_codec_t 与 audio_decoder_codec_t 取值一一对应
+    return playback_controller_write_encoded(s_ctx.playback_ctrl, (audio_decoder_codec_t)codec, data, len);
+}
+
+/**
+ * @brief 播放音频数据到指定播放流
+ * 
+ * @param stream 流编号
+ * @param pcm_data PCM 音频数据指针
+ * @param sample_count 采样点数
+ * @return 
+ *     - ESP_OK: 写入成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ *     - ESP_ERR_NOT_FOUND: 流未启用
+ *     - ESP_ERR_NO_MEM: 缓冲区已满，数据被拒绝（REJECT 策略）
+ *     - ESP_ERR_TIMEOUT: 等待空间超时，数据被拒绝（BLOCK 策略）
+ */
+esp_err_t audio_manager_play_stream(uint8_t stream, const int16_t *pcm_data, size_t sample_count)
+{
+    if (!s_ctx.initialized || !pcm_data || sample_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return playback_controller_write_stream(s_ctx.playback_ctrl, stream, pcm_data, sample_count);
+}
+
+esp_err_t audio_manager_set_stream_gain(uint8_t stream, uint8_t gain)
+{
+    if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
+
+    return playback_controller_set_stream_gain(s_ctx.playback_ctrl, stream, gain);
+}
+
+esp_err_t audio_manager_clear_stream(uint8_t stream)
+{
+    if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
+
+    return playback_controller_clear_stream(s_ctx.playback_ctrl, stream);
+}
+
+size_t audio_manager_get_stream_free_space(uint8_t stream)
+{
+    if (!s_ctx.initialized || !s_ctx.playback_ctrl) {
+        return 0;
+    }
+
+    return playback_controller_get_stream_free_space(s_ctx.playback_ctrl, stream);
+}
+
 size_t audio_manager_get_playback_free_space(void)
 {
     // 检查是否已初始化
@@ -688,42 +1732,42 @@ size_t audio_manager_get_playback_free_space(void)
  * @brief 启动播放
  * 
  * 启动播放控制器，开始播放缓冲区中的音频数据。
+ * 由状态机任务执行，本接口等待执行结果返回，返回 ESP_OK 后 audio_manager_is_playing() 即为 true。
  * 
  * @return 
  *     - ESP_OK: 启动成功
  *     - ESP_ERR_INVALID_STATE: 未初始化
+ *     - ESP_FAIL: 事件环已满
+ *     - ESP_ERR_TIMEOUT: 等待状态机任务超时
+ *     - 其他: 播放控制器启动失败
  */
 esp_err_t audio_manager_start_playback(void)
 {
     // 检查是否已初始化
     if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
 
-    esp_err_t ret = playback_controller_start(s_ctx.playback_ctrl);
-    if (ret == ESP_OK) {
-        s_ctx.playing = true;
-        audio_manager_refresh_state();
-    }
-    return ret;
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_START_PLAYBACK };
+    return audio_manager_call(&msg);
 }
 
 /**
  * @brief 停止播放
  * 
- * 停止播放控制器，不再播放音频。
+ * 停止播放控制器，不再播放音频。由状态机任务执行，本接口等待执行结果返回。
  * 
- * @return ESP_OK: 停止成功
+ * @return 
+ *     - ESP_OK: 停止成功（或未初始化）
+ *     - ESP_FAIL: 事件环已满
+ *     - ESP_ERR_TIMEOUT: 等待状态机任务超时
+ *     - 其他: 播放控制器停止失败
  */
 esp_err_t audio_manager_stop_playback(void)
 {
     // 检查是否已初始化
     if (!s_ctx.initialized) return ESP_OK;
 
-    esp_err_t ret = playback_controller_stop(s_ctx.playback_ctrl);
-    if (ret == ESP_OK) {
-        s_ctx.playing = false;
-        audio_manager_refresh_state();
-    }
-    return ret;
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_STOP_PLAYBACK };
+    return audio_manager_call(&msg);
 }
 
 /**
@@ -773,32 +1817,24 @@ uint8_t audio_manager_get_volume(void)
 /**
  * @brief 更新唤醒词配置
  * 
- * 动态更新唤醒词检测的配置参数。
+ * 动态更新唤醒词检测的配置参数。由状态机任务执行，本接口等待执行结果。
  * 
  * @param config 唤醒词配置参数
  * @return 
  *     - ESP_OK: 更新成功
- *     - ESP_ERR_INVALID_ARG: 参数无效
- *     - ESP_ERR_INVALID_STATE: 未初始化
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ *     - ESP_ERR_TIMEOUT: 等待状态机任务超时（配置仍会在之后生效）
+ *     - 其他: AFE 重建失败
  */
 esp_err_t audio_manager_update_wakeup_config(const audio_mgr_wakeup_config_t *config)
 {
     // 参数检查
     if (!s_ctx.initialized || !config) return ESP_ERR_INVALID_ARG;
 
-    // 更新配置
-    memcpy(&s_ctx.config.wakeup_config, config, sizeof(audio_mgr_wakeup_config_t));
-    
-    // 构造 AFE 唤醒词配置
-    afe_wakeup_config_t afe_wakeup = {
-        .enabled = config->enabled,
-        .wake_word_name = config->wake_word_name,
-        .model_partition = config->model_partition,
-        .sensitivity = config->sensitivity,
-    };
-    
-    // 更新 AFE 配置
-    return afe_wrapper_update_wakeup_config(s_ctx.afe_wrapper, &afe_wakeup);
+    // 由状态机任务更新配置并重建 AFE
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_UPDATE_WAKEUP };
+    msg.data.wakeup_config = *config;
+    return audio_manager_call(&msg);
 }
 
 /**
@@ -823,6 +1859,66 @@ esp_err_t audio_manager_get_wakeup_config(audio_mgr_wakeup_config_t *config)
     return ESP_OK;
 }
 
+/**
+ * @brief 运行时更新 AFE 功能配置
+ * 
+ * 只更新可运行时切换的字段（AEC/NS/AGC 开关、afe_mode、aec_playback_only），
+ * 回采对齐与预录参数保持初始化时的值。由状态机任务执行，本接口等待执行结果。
+ * 
+ * @param config AFE 配置参数
+ * @return 
+ *     - ESP_OK: 更新成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ *     - ESP_ERR_TIMEOUT: 等待状态机任务超时（配置仍会在之后生效）
+ *     - 其他: AFE 热重建失败
+ */
+esp_err_t audio_manager_update_afe_config(const audio_mgr_afe_config_t *config)
+{
+    if (!s_ctx.initialized || !config) return ESP_ERR_INVALID_ARG;
+
+    // 状态刷新与负载调节也会读取并应用 AFE 配置，统一在状态机任务中修改
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_UPDATE_AFE };
+    msg.data.afe_config = *config;
+    return audio_manager_call(&msg);
+}
+
+/**
+ * @brief 获取当前 AFE 功能配置
+ * 
+ * @param config 输出参数，用于存储配置
+ * @return 
+ *     - ESP_OK: 获取成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ */
+esp_err_t audio_manager_get_afe_config(audio_mgr_afe_config_t *config)
+{
+    if (!s_ctx.initialized || !config) return ESP_ERR_INVALID_ARG;
+
+    memcpy(config, &s_ctx.config.afe_config, sizeof(audio_mgr_afe_config_t));
+    return ESP_OK;
+}
+
+/**
+ * @brief 运行时更新 VAD 配置
+ * 
+ * 由状态机任务执行，本接口等待执行结果。
+ * 
+ * @param config VAD 配置参数
+ * @return 
+ *     - ESP_OK: 更新成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ *     - ESP_ERR_TIMEOUT: 等待状态机任务超时（配置仍会在之后生效）
+ *     - 其他: AFE 热重建失败
+ */
+esp_err_t audio_manager_update_vad_config(const audio_mgr_vad_config_t *config)
+{
+    if (!s_ctx.initialized || !config) return ESP_ERR_INVALID_ARG;
+
+    audio_mgr_internal_msg_t msg = { .type = AUDIO_INT_EVT_UPDATE_VAD };
+    msg.data.vad_config = *config;
+    return audio_manager_call(&msg);
+}
+
 /**
  * @brief 检查是否正在运行
  * 
@@ -864,6 +1960,246 @@ audio_mgr_state_t audio_manager_get_state(void)
     return s_ctx.state;
 }
 
+/**
+ * @brief 是否处于低功耗监听档位
+ * 
+ * @return true: 低功耗档位，false: 完整管线或未初始化
+ */
+bool audio_manager_is_low_power(void)
+{
+    return s_ctx.initialized && afe_wrapper_get_profile(s_ctx.afe_wrapper) == AFE_PROFILE_LOW_POWER;
+}
+
+/**
+ * @brief 将环形缓冲区统计转换为对外结构
+ */
+static void audio_manager_copy_buffer_stats(const ring_buffer_stats_t *src, audio_mgr_buffer_stats_t *dst)
+{
+    dst->overrun_samples = src->overrun_samples;
+    dst->rejected_samples = src->rejected_samples;
+    dst->underrun_reads = src->underrun_reads;
+    dst->lock_timeouts = src->lock_timeouts;
+    dst->high_water = src->high_water;
+    dst->level = src->level;
+    dst->capacity = src->capacity;
+}
+
+/**
+ * @brief 获取运行统计
+ * 
+ * 读取播放/回采缓冲区的溢出、欠载与高水位计数，用于定位卡顿和回声消除异常。
+ * 
+ * @param stats 输出统计数据
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t audio_manager_get_stats(audio_mgr_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ctx.initialized || !s_ctx.playback_ctrl) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ring_buffer_stats_t playback = {0};
+    ring_buffer_stats_t reference = {0};
+    esp_err_t ret = playback_controller_get_stats(s_ctx.playback_ctrl, &playback, &reference);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    audio_manager_copy_buffer_stats(&playback, &stats->playback);
+    audio_manager_copy_buffer_stats(&reference, &stats->reference);
+
+    aec_reference_stats_t aec = {0};
+    aec_reference_get_stats(s_ctx.reference, NULL, &aec);
+    stats->aec.ref_offset_us = aec.offset_us;
+    stats->aec.padded_samples = aec.padded_samples;
+    stats->aec.dropped_samples = aec.dropped_samples;
+    stats->aec.delay_updates = aec.delay_updates;
+
+    event_ring_stats_t events = {0};
+    event_ring_get_stats(s_ctx.event_ring, &events);
+    stats->events.posted = events.posted;
+    stats->events.dropped = events.dropped;
+    stats->events.high_water = events.high_water;
+    stats->events.capacity = events.capacity;
+
+    memset(&stats->governor, 0, sizeof(stats->governor));
+    audio_governor_stats_t gov = {0};
+    if (audio_governor_get_stats(s_ctx.governor, &gov) == ESP_OK) {
+        afe_load_stats_t load = {0};
+        afe_wrapper_get_load_stats(s_ctx.afe_wrapper, &load);
+        stats->governor.level = (audio_mgr_gov_level_t)gov.level;
+        stats->governor.feed_load_pct = gov.feed_load_pct;
+        stats->governor.fetch_load_pct = gov.fetch_load_pct;
+        stats->governor.backlog_ms = gov.backlog_ms;
+        stats->governor.feed_misses = load.feed_misses;
+        stats->governor.fetch_misses = load.fetch_misses;
+        stats->governor.degrades = gov.degrades;
+        stats->governor.recoveries = gov.recoveries;
+        stats->governor.memory_holds = gov.memory_holds;
+    }
+    return ESP_OK;
+}
+
+static void audio_manager_copy_latency(audio_trace_metric_t metric, audio_mgr_latency_t *dst)
+{
+    audio_trace_summary_t sum = {0};
+    audio_trace_get_summary(metric, &sum);
+    dst->count = sum.count;
+    dst->p50_us = sum.p50_us;
+    dst->p99_us = sum.p99_us;
+    dst->max_us = sum.max_us;
+}
+
+/**
+ * @brief 开启/关闭管线延迟跟踪
+ * 
+ * 关闭时各跟踪点只做一次判断；开启后才取时间戳并累计直方图。
+ * 
+ * @param enabled true 开启
+ */
+void audio_manager_set_trace_enabled(bool enabled)
+{
+    audio_trace_set_enabled(enabled);
+}
+
+/**
+ * @brief 获取管线延迟统计
+ * 
+ * @param stats 输出统计
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t audio_manager_get_latency_stats(audio_mgr_latency_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_manager_copy_latency(AUDIO_TRACE_LAT_MIC_TO_CALLBACK, &stats->mic_to_callback);
+    audio_manager_copy_latency(AUDIO_TRACE_LAT_PLAY_TO_SPEAKER, &stats->play_to_speaker);
+    audio_manager_copy_latency(AUDIO_TRACE_LAT_EVENT_DISPATCH, &stats->event_dispatch);
+    audio_manager_copy_latency(AUDIO_TRACE_CPU_FEED, &stats->feed_cpu);
+    audio_manager_copy_latency(AUDIO_TRACE_CPU_FETCH, &stats->fetch_cpu);
+    return ESP_OK;
+}
+
+/**
+ * @brief 清空延迟统计
+ */
+void audio_manager_reset_latency_stats(void)
+{
+    audio_trace_reset();
+}
+
+/**
+ * @brief 打印延迟统计与最近的跟踪点
+ */
+void audio_manager_dump_trace(void)
+{
+    audio_trace_dump();
+}
+
+/**
+ * @brief 追加一个任务到栈报告（句柄为空或报告已满时跳过）
+ */
+static void audio_manager_report_task(audio_mgr_task_report_t *report,
+                                      const audio_arena_task_info_t *info)
+{
+    if (!info->handle || report->count >= AUDIO_MANAGER_MAX_TASKS) {
+        return;
+    }
+    audio_mgr_task_stats_t *task = &report->tasks[report->count++];
+    task->name = pcTaskGetName(info->handle);
+    task->stack_bytes = info->stack_bytes;
+    // ESP-IDF 中高水位以字节为单位
+    task->stack_free_min = uxTaskGetStackHighWaterMark(info->handle);
+    task->stack_in_psram = info->stack_psram;
+    task->is_static = info->is_static;
+}
+
+/**
+ * @brief 获取各管线任务的栈大小与高水位
+ * 
+ * @param report 输出报告
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t audio_manager_get_task_report(audio_mgr_task_report_t *report)
+{
+    if (!report) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ctx.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(report, 0, sizeof(*report));
+    audio_arena_task_info_t info = {
+        .handle = s_ctx.manager_task,
+        .stack_bytes = AUDIO_MANAGER_TASK_STACK_SIZE,
+        .stack_psram = false,
+        .is_static = s_ctx.arena != NULL,
+    };
+    audio_manager_report_task(report, &info);
+
+    playback_controller_get_task_info(s_ctx.playback_ctrl, &info);
+    audio_manager_report_task(report, &info);
+
+    if (s_ctx.encoder) {
+        audio_encoder_get_task_info(s_ctx.encoder, &info);
+        audio_manager_report_task(report, &info);
+    }
+
+    audio_arena_task_info_t fetch = {0};
+    afe_wrapper_get_task_info(s_ctx.afe_wrapper, &info, &fetch);
+    audio_manager_report_task(report, &info);
+    audio_manager_report_task(report, &fetch);
+    return ESP_OK;
+}
+
+/**
+ * @brief 打印任务栈报告
+ */
+void audio_manager_dump_task_report(void)
+{
+    audio_mgr_task_report_t report;
+    if (audio_manager_get_task_report(&report) != ESP_OK) {
+        ESP_LOGW(TAG, "未初始化，无法生成任务栈报告");
+        return;
+    }
+
+    ESP_LOGI(TAG, "📋 任务栈报告（%u 个任务）", report.count);
+    for (uint8_t i = 0; i < report.count; i++) {
+        const audio_mgr_task_stats_t *task = &report.tasks[i];
+        ESP_LOGI(TAG, "  %-12s 栈 %5u B，最小剩余 %5u B（已用 %3u%%）%s%s",
+                 task->name ? task->name : "?",
+                 (unsigned)task->stack_bytes, (unsigned)task->stack_free_min,
+                 task->stack_bytes ? (unsigned)((task->stack_bytes - task->stack_free_min) * 100 / task->stack_bytes) : 0u,
+                 task->stack_in_psram ? " [PSRAM]" : "",
+                 task->is_static ? " [静态]" : "");
+    }
+}
+
+/**
+ * @brief 获取当前录音段第一个采样的流位置
+ *
+ * 录音开始时预录数据先于当前帧输出，该位置即预录数据的第一个采样，
+ * 事件的 sample_pos 减去该值得到事件在录音数据中的偏移。
+ *
+ * @return 流位置（采样点数），未初始化返回 0
+ */
+uint64_t audio_manager_get_record_start_pos(void)
+{
+    if (!s_ctx.initialized) {
+        return 0;
+    }
+    return afe_wrapper_get_record_start_pos(s_ctx.afe_wrapper);
+}
+
 /**
  * @brief 设置录音回调函数
  * 
@@ -872,6 +2208,15 @@ audio_mgr_state_t audio_manager_get_state(void)
  * @param callback 回调函数指针
  * @param user_ctx 用户上下文指针
  */
+void audio_manager_set_encoded_record_callback(audio_encoded_record_callback_t callback, void *user_ctx)
+{
+    if (!s_ctx.encoder && callback) {
+        ESP_LOGW(TAG, "未启用录音编码（record_encode_config.enabled = false）");
+    }
+    s_ctx.encoded_record_ctx = user_ctx;
+    s_ctx.encoded_record_callback = callback;
+}
+
 void audio_manager_set_record_callback(audio_record_callback_t callback, void *user_ctx)
 {
     s_ctx.record_callback = callback;
@@ -0,0 +1,294 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 10:20:15
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 10:20:15
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_resampler.c
+ * @Description: 采样率转换实现
+ *
+ * 输入先下混为单声道写入工作缓冲，再由多相 FIR 输出：采样率比化简为 L/M（输出/输入），
+ * 每个输出采样在输入时间轴上前进 M/L，整数部分移动窗口，余数 acc（0..L-1）选择相位。
+ * L 不超过相位表大小时每个余数对应一组精确系数（48k->16k、24k->16k、8k->16k 等整数/小比例），
+ * 否则（44.1k、22.05k）在相邻两组系数的输出之间线性插值。
+ * 原型为 Blackman 窗 sinc，截止频率取输入/输出较低者 Nyquist 的 90%；采样率相同则只下混。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_resampler.h"
+#include "audio_dsp.h"
+#include "esp_log.h"
+#include <string.h>
+#include <math.h>
+
+static const char *TAG = "RESAMPLER";
+
+#define RESAMPLER_BASE_TAPS     32      ///< 不降采样时的抽头数（降采样时按倍数加长，保持过渡带宽度）
+#define RESAMPLER_MAX_TAPS      (RESAMPLER_BASE_TAPS * AUDIO_RESAMPLER_MAX_DECIMATION)
+#define RESAMPLER_PHASES        32      ///< 相位表大小（插值模式多存一组，对应下一个输入采样）
+#define RESAMPLER_CHUNK         256     ///< 每次下混进工作缓冲的最大帧数
+#define RESAMPLER_WORK_SAMPLES  (RESAMPLER_MAX_TAPS + RESAMPLER_CHUNK)
+#define RESAMPLER_CUTOFF        0.9f    ///< 截止频率（相对较低 Nyquist）
+
+/**
+ * @brief 重采样器结构体
+ */
+typedef struct audio_resampler_s {
+    audio_arena_handle_t arena;     ///< 所属内存区（NULL 表示堆分配）
+    uint32_t out_rate;              ///< 输出采样率
+    uint32_t in_rate;               ///< 当前输入采样率（0 表示未设置）
+    uint8_t channels;               ///< 当前输入声道数
+    bool passthrough;               ///< 采样率相同，仅下混
+
+    uint32_t l;                     ///< 化简后的输出采样率（相位数）
+    uint32_t m;                     ///< 化简后的输入采样率（每个输出前进 m/l 个输入）
+    uint32_t phases;                ///< 相位表组数（精确模式为 l，插值模式为 RESAMPLER_PHASES）
+    bool interpolate;               ///< 相位表插值模式
+    uint16_t taps;                  ///< 每组抽头数
+    int16_t *coefs;                 ///< 相位表（Q15，(RESAMPLER_PHASES + 1) * RESAMPLER_MAX_TAPS）
+
+    int16_t *work;                  ///< 工作缓冲（单声道，RESAMPLER_WORK_SAMPLES）
+    size_t fill;                    ///< 工作缓冲已填充采样数
+    size_t start;                   ///< 下一个输出的窗口起点
+    uint32_t acc;                   ///< 下一个输出的相位余数（0..l-1）
+} audio_resampler_t;
+
+static uint32_t resampler_gcd(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * @brief 生成相位表：第 r 组对应输出位于窗口中心之后 r/phases 个输入采样，每组归一化为单位直流增益
+ */
+static void resampler_design(audio_resampler_t *rs)
+{
+    const float ratio = rs->in_rate > rs->out_rate ? (float)rs->out_rate / rs->in_rate : 1.0f;
+    const float fc = RESAMPLER_CUTOFF * ratio;
+    const float half = rs->taps / 2.0f;
+    const uint32_t rows = rs->interpolate ? rs->phases + 1 : rs->phases;
+    float h[RESAMPLER_MAX_TAPS];
+
+    for (uint32_t r = 0; r < rows; r++) {
+        const float frac = (float)r / rs->phases;
+        float sum = 0.0f;
+        for (int j = 0; j < rs->taps; j++) {
+            float t = (float)j - (half - 1.0f) - frac;
+            float x = (float)M_PI * fc * t;
+            float sinc = fabsf(x) < 1e-6f ? 1.0f : sinf(x) / x;
+            float w = t / half;
+            float win = 0.42f + 0.5f * cosf((float)M_PI * w) + 0.08f * cosf(2.0f * (float)M_PI * w);
+            h[j] = fc * sinc * win;
+            sum += h[j];
+        }
+
+        int16_t *row = rs->coefs + r * rs->taps;
+        for (int j = 0; j < rs->taps; j++) {
+            row[j] = (int16_t)lrintf(h[j] / sum * AUDIO_DSP_Q15_UNITY);
+        }
+    }
+}
+
+audio_resampler_handle_t audio_resampler_create(const audio_resampler_config_t *config)
+{
+    if (!config || config->out_rate == 0) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    audio_resampler_t *rs = (audio_resampler_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                    sizeof(audio_resampler_t));
+    if (!rs) {
+        ESP_LOGE(TAG, "重采样器分配失败");
+        return NULL;
+    }
+    rs->arena = config->arena;
+    rs->out_rate = config->out_rate;
+
+    // 系数与工作缓冲：内存区模式放内部 RAM，堆模式放 PSRAM（共约 7KB，cache 可完整容纳）
+    const audio_arena_region_t buf_region = rs->arena ? AUDIO_ARENA_INTERNAL : AUDIO_ARENA_PSRAM;
+    rs->coefs = (int16_t *)audio_arena_calloc(rs->arena, buf_region,
+                                              (RESAMPLER_PHASES + 1) * RESAMPLER_MAX_TAPS * sizeof(int16_t));
+    rs->work = (int16_t *)audio_arena_calloc(rs->arena, buf_region,
+                                             RESAMPLER_WORK_SAMPLES * sizeof(int16_t));
+    if (!rs->coefs || !rs->work) {
+        ESP_LOGE(TAG, "重采样缓冲区分配失败");
+        audio_resampler_destroy(rs);
+        return NULL;
+    }
+
+    audio_resampler_set_input(rs, rs->out_rate, 1);
+    return rs;
+}
+
+void audio_resampler_get_footprint(const audio_resampler_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(audio_resampler_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL,
+                              (RESAMPLER_PHASES + 1) * RESAMPLER_MAX_TAPS * sizeof(int16_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, RESAMPLER_WORK_SAMPLES * sizeof(int16_t));
+}
+
+void audio_resampler_destroy(audio_resampler_handle_t rs)
+{
+    if (!rs) {
+        return;
+    }
+    audio_arena_free(rs->arena, rs->work);
+    audio_arena_free(rs->arena, rs->coefs);
+    audio_arena_free(rs->arena, rs);
+}
+
+esp_err_t audio_resampler_set_input(audio_resampler_handle_t rs, uint32_t in_rate, uint8_t channels)
+{
+    if (!rs || in_rate == 0 || channels == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (channels > AUDIO_RESAMPLER_MAX_CHANNELS ||
+        in_rate > (uint64_t)rs->out_rate * AUDIO_RESAMPLER_MAX_DECIMATION) {
+        ESP_LOGE(TAG, "不支持的输入格式: %u Hz / %u 声道", (unsigned)in_rate, channels);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (in_rate == rs->in_rate && channels == rs->channels) {
+        return ESP_OK;
+    }
+
+    rs->in_rate = in_rate;
+    rs->channels = channels;
+    rs->passthrough = in_rate == rs->out_rate;
+
+    uint32_t g = resampler_gcd(in_rate, rs->out_rate);
+    rs->l = rs->out_rate / g;
+    rs->m = in_rate / g;
+    rs->interpolate = rs->l > RESAMPLER_PHASES;
+    rs->phases = rs->interpolate ? RESAMPLER_PHASES : rs->l;
+
+    // 降采样时按倍数加长滤波器，取 4 的倍数便于点积展开
+    uint32_t taps = RESAMPLER_BASE_TAPS;
+    if (in_rate > rs->out_rate) {
+        taps = (RESAMPLER_BASE_TAPS * in_rate + rs->out_rate - 1) / rs->out_rate;
+    }
+    taps = (taps + 3) & ~3u;
+    rs->taps = (uint16_t)(taps > RESAMPLER_MAX_TAPS ? RESAMPLER_MAX_TAPS : taps);
+
+    if (!rs->passthrough) {
+        resampler_design(rs);
+    }
+    audio_resampler_reset(rs);
+
+    ESP_LOGI(TAG, "输入格式: %u Hz / %u 声道 -> %u Hz 单声道（%s，%u 抽头）",
+             (unsigned)in_rate, channels, (unsigned)rs->out_rate,
+             rs->passthrough ? "仅下混" : (rs->interpolate ? "相位插值" : "精确相位"), rs->taps);
+    return ESP_OK;
+}
+
+void audio_resampler_reset(audio_resampler_handle_t rs)
+{
+    if (!rs) {
+        return;
+    }
+    // 预置半个窗口的静音，使第一个输出对齐第一个输入采样
+    rs->fill = rs->taps / 2 - 1;
+    memset(rs->work, 0, rs->fill * sizeof(int16_t));
+    rs->start = 0;
+    rs->acc = 0;
+}
+
+size_t audio_resampler_get_output_size(audio_resampler_handle_t rs, size_t frames)
+{
+    if (!rs) {
+        return 0;
+    }
+    if (rs->passthrough) {
+        return frames;
+    }
+
+    // 第 k 个输出的窗口起点为 start + floor((acc + k*m) / l)，须满足起点 + taps <= 输入总量
+    size_t total = rs->fill + frames;
+    if (total < rs->start + rs->taps) {
+        return 0;
+    }
+    uint64_t span = (uint64_t)(total - rs->taps - rs->start) + 1;
+    return (size_t)((span * rs->l - rs->acc + rs->m - 1) / rs->m);
+}
+
+/**
+ * @brief 计算当前窗口的一个输出采样
+ */
+static inline int16_t resampler_output(const audio_resampler_t *rs)
+{
+    const int16_t *x = rs->work + rs->start;
+    if (!rs->interpolate) {
+        return audio_dsp_fir_q15(x, rs->coefs + rs->acc * rs->taps, rs->taps);
+    }
+
+    uint32_t q = rs->acc * RESAMPLER_PHASES;
+    uint32_t row = q / rs->l;
+    int32_t frac = (int32_t)(((uint64_t)(q % rs->l) << 15) / rs->l);
+    int32_t y0 = audio_dsp_fir_q15(x, rs->coefs + row * rs->taps, rs->taps);
+    if (frac == 0) {
+        return (int16_t)y0;
+    }
+    int32_t y1 = audio_dsp_fir_q15(x, rs->coefs + (row + 1) * rs->taps, rs->taps);
+    return (int16_t)(y0 + (((y1 - y0) * frac) >> 15));
+}
+
+size_t audio_resampler_process(audio_resampler_handle_t rs, const int16_t *in, size_t frames,
+                               size_t *consumed, int16_t *out, size_t out_cap)
+{
+    if (!rs || !in || (!out && out_cap > 0)) {
+        if (consumed) *consumed = 0;
+        return 0;
+    }
+
+    // 采样率相同：直接下混到输出
+    if (rs->passthrough) {
+        size_t n = frames < out_cap ? frames : out_cap;
+        audio_dsp_downmix_s16(in, out, n, rs->channels);
+        if (consumed) *consumed = n;
+        return n;
+    }
+
+    // 输入尽量全部收进工作缓冲，只有待输出而输出空间已满时才提前返回
+    size_t produced = 0;
+    size_t used = 0;
+    for (;;) {
+        while (rs->start + rs->taps <= rs->fill) {
+            if (produced == out_cap) {
+                goto done;
+            }
+            out[produced++] = resampler_output(rs);
+            rs->acc += rs->m;
+            rs->start += rs->acc / rs->l;
+            rs->acc %= rs->l;
+        }
+        if (used == frames) {
+            break;
+        }
+
+        // 保留未用完的窗口（每步最多前进 MAX_DECIMATION 个采样，起点不会越过已填充部分）
+        size_t keep = rs->fill - rs->start;
+        memmove(rs->work, rs->work + rs->start, keep * sizeof(int16_t));
+        rs->fill = keep;
+        rs->start = 0;
+
+        size_t n = frames - used;
+        if (n > RESAMPLER_WORK_SAMPLES - rs->fill) {
+            n = RESAMPLER_WORK_SAMPLES - rs->fill;
+        }
+        audio_dsp_downmix_s16(in + used * rs->channels, rs->work + rs->fill, n, rs->channels);
+        rs->fill += n;
+        used += n;
+    }
+
+done:
+    if (consumed) *consumed = used;
+    return produced;
+}
@@ -0,0 +1,307 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-05 10:12:47
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-05 10:12:47
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\audio_trace.c
+ * @Description: 音频管线跟踪实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_trace.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "AUDIO_TRACE";
+
+#define AUDIO_TRACE_LOG_ENTRIES     64      ///< 跟踪日志条数（循环覆盖）
+#define AUDIO_TRACE_ANCHORS         64      ///< 每条流保留的采样位置记录数（约 2 秒音频）
+#define AUDIO_TRACE_WINDOW          1024    ///< 滚动窗口：样本数达到后所有桶减半
+#define AUDIO_TRACE_LINEAR          16      ///< 16us 以下逐微秒分桶
+#define AUDIO_TRACE_SUB_BITS        3       ///< 其余每个倍程 8 个子桶
+#define AUDIO_TRACE_MAX_MSB         23      ///< 上限约 16.7 秒，超出计入最后一桶
+#define AUDIO_TRACE_BUCKETS         (AUDIO_TRACE_LINEAR + \
+                                     (AUDIO_TRACE_MAX_MSB - AUDIO_TRACE_SUB_BITS) * (1 << AUDIO_TRACE_SUB_BITS))
+
+/** 采样位置记录：pos 之前（含）的采样在 ts 时刻已可用 */
+typedef struct {
+    uint32_t ts;
+    uint32_t pos;
+} trace_anchor_t;
+
+/** 跟踪日志条目 */
+typedef struct {
+    uint32_t ts;
+    uint32_t pos;
+    uint8_t point;
+} trace_log_entry_t;
+
+/** 对数直方图 */
+typedef struct {
+    uint16_t buckets[AUDIO_TRACE_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t last_us;
+} trace_hist_t;
+
+/** 有位置记录的流（MIC_READ、PLAY_WRITE） */
+enum {
+    TRACE_STREAM_MIC = 0,
+    TRACE_STREAM_PLAY,
+    TRACE_STREAM_MAX,
+};
+
+static struct {
+    volatile bool enabled;
+    portMUX_TYPE lock;                                  ///< 各核打点共用，临界区只做少量整数运算
+    trace_hist_t hist[AUDIO_TRACE_METRIC_MAX];
+    trace_anchor_t anchors[TRACE_STREAM_MAX][AUDIO_TRACE_ANCHORS];
+    uint32_t anchor_count[TRACE_STREAM_MAX];
+    trace_log_entry_t log[AUDIO_TRACE_LOG_ENTRIES];
+    uint32_t log_count;
+} s_trace = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static const char *const s_point_names[AUDIO_TRACE_POINT_MAX] = {
+    [AUDIO_TRACE_MIC_READ] = "mic_read",
+    [AUDIO_TRACE_AFE_FEED] = "afe_feed",
+    [AUDIO_TRACE_AFE_FETCH] = "afe_fetch",
+    [AUDIO_TRACE_RECORD_CB] = "record_cb",
+    [AUDIO_TRACE_EVENT_POST] = "evt_post",
+    [AUDIO_TRACE_EVENT_RECV] = "evt_recv",
+    [AUDIO_TRACE_PLAY_WRITE] = "play_write",
+    [AUDIO_TRACE_PLAY_READ] = "play_read",
+    [AUDIO_TRACE_SPK_WRITE] = "spk_write",
+};
+
+static const char *const s_metric_names[AUDIO_TRACE_METRIC_MAX] = {
+    [AUDIO_TRACE_LAT_MIC_TO_CALLBACK] = "mic->callback",
+    [AUDIO_TRACE_LAT_PLAY_TO_SPEAKER] = "play->speaker",
+    [AUDIO_TRACE_LAT_EVENT_DISPATCH] = "event dispatch",
+    [AUDIO_TRACE_CPU_FEED] = "feed cpu",
+    [AUDIO_TRACE_CPU_FETCH] = "fetch cpu",
+};
+
+/**
+ * @brief 跟踪点对应的流，无位置记录返回 -1
+ */
+static int IRAM_ATTR trace_stream_of(audio_trace_point_t point)
+{
+    switch (point) {
+    case AUDIO_TRACE_MIC_READ:   return TRACE_STREAM_MIC;
+    case AUDIO_TRACE_PLAY_WRITE: return TRACE_STREAM_PLAY;
+    default:                     return -1;
+    }
+}
+
+/**
+ * @brief 微秒值映射到桶索引（16us 以下线性，其余每倍程 8 个子桶）
+ */
+static size_t trace_bucket(uint32_t us)
+{
+    if (us < AUDIO_TRACE_LINEAR) {
+        return us;
+    }
+    if (us >= (1u << (AUDIO_TRACE_MAX_MSB + 1))) {
+        return AUDIO_TRACE_BUCKETS - 1;
+    }
+    int msb = 31 - __builtin_clz(us);
+    size_t sub = (us >> (msb - AUDIO_TRACE_SUB_BITS)) & ((1u << AUDIO_TRACE_SUB_BITS) - 1);
+    return AUDIO_TRACE_LINEAR + (size_t)(msb - 4) * (1u << AUDIO_TRACE_SUB_BITS) + sub;
+}
+
+/**
+ * @brief 桶索引对应的代表值（桶中值）
+ */
+static uint32_t trace_bucket_value(size_t idx)
+{
+    if (idx < AUDIO_TRACE_LINEAR) {
+        return (uint32_t)idx;
+    }
+    size_t rel = idx - AUDIO_TRACE_LINEAR;
+    int msb = 4 + (int)(rel >> AUDIO_TRACE_SUB_BITS);
+    uint32_t sub = rel & ((1u << AUDIO_TRACE_SUB_BITS) - 1);
+    uint32_t width = 1u << (msb - AUDIO_TRACE_SUB_BITS);
+    return (1u << msb) + sub * width + width / 2;
+}
+
+/**
+ * @brief 按排名取分位值（调用方持锁）
+ */
+static uint32_t trace_percentile(const trace_hist_t *hist, uint32_t percent)
+{
+    uint32_t rank = (hist->count * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint32_t seen = 0;
+    for (size_t i = 0; i < AUDIO_TRACE_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            return trace_bucket_value(i);
+        }
+    }
+    return 0;
+}
+
+void audio_trace_set_enabled(bool enabled)
+{
+    s_trace.enabled = enabled;
+    ESP_LOGI(TAG, "跟踪已%s", enabled ? "开启" : "关闭");
+}
+
+bool audio_trace_is_enabled(void)
+{
+    return s_trace.enabled;
+}
+
+uint32_t audio_trace_now(void)
+{
+    return s_trace.enabled ? (uint32_t)esp_timer_get_time() : 0;
+}
+
+// 可能经事件投递在定时器中断中调用，放在 IRAM
+void IRAM_ATTR audio_trace_mark(audio_trace_point_t point, uint32_t pos)
+{
+    if (!s_trace.enabled || point >= AUDIO_TRACE_POINT_MAX) {
+        return;
+    }
+
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    int stream = trace_stream_of(point);
+
+    portENTER_CRITICAL_SAFE(&s_trace.lock);
+    trace_log_entry_t *entry = &s_trace.log[s_trace.log_count++ % AUDIO_TRACE_LOG_ENTRIES];
+    entry->ts = now;
+    entry->pos = pos;
+    entry->point = (uint8_t)point;
+
+    if (stream >= 0) {
+        uint32_t n = s_trace.anchor_count[stream]++;
+        s_trace.anchors[stream][n % AUDIO_TRACE_ANCHORS] = (trace_anchor_t){ .ts = now, .pos = pos };
+    }
+    portEXIT_CRITICAL_SAFE(&s_trace.lock);
+}
+
+void audio_trace_latency(audio_trace_metric_t metric, audio_trace_point_t from, uint32_t pos)
+{
+    int stream = trace_stream_of(from);
+    if (!s_trace.enabled || metric >= AUDIO_TRACE_METRIC_MAX || stream < 0) {
+        return;
+    }
+
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    bool found = false;
+    uint32_t ts = 0;
+
+    // 从新到旧找第一个覆盖 pos 的记录（位置用差值比较，允许回绕）
+    portENTER_CRITICAL_SAFE(&s_trace.lock);
+    uint32_t count = s_trace.anchor_count[stream];
+    uint32_t n = count < AUDIO_TRACE_ANCHORS ? count : AUDIO_TRACE_ANCHORS;
+    for (uint32_t i = 0; i < n; i++) {
+        const trace_anchor_t *a = &s_trace.anchors[stream][(count - 1 - i) % AUDIO_TRACE_ANCHORS];
+        if ((int32_t)(a->pos - pos) < 0) {
+            break;
+        }
+        ts = a->ts;
+        // 最旧一条仍覆盖 pos 且记录已回绕：真正的写入时刻已被覆盖
+        found = (i + 1 < n) || (count <= AUDIO_TRACE_ANCHORS);
+    }
+    portEXIT_CRITICAL_SAFE(&s_trace.lock);
+
+    if (found) {
+        audio_trace_record(metric, now - ts);
+    }
+}
+
+void audio_trace_record(audio_trace_metric_t metric, uint32_t us)
+{
+    if (!s_trace.enabled || metric >= AUDIO_TRACE_METRIC_MAX) {
+        return;
+    }
+
+    trace_hist_t *hist = &s_trace.hist[metric];
+
+    portENTER_CRITICAL_SAFE(&s_trace.lock);
+    if (hist->count >= AUDIO_TRACE_WINDOW) {
+        // 指数衰减：旧样本权重减半，分位值跟随最近的负载变化
+        uint32_t total = 0;
+        for (size_t i = 0; i < AUDIO_TRACE_BUCKETS; i++) {
+            hist->buckets[i] >>= 1;
+            total += hist->buckets[i];
+        }
+        hist->count = total;
+    }
+    hist->buckets[trace_bucket(us)]++;
+    hist->count++;
+    hist->last_us = us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    portEXIT_CRITICAL_SAFE(&s_trace.lock);
+}
+
+esp_err_t audio_trace_get_summary(audio_trace_metric_t metric, audio_trace_summary_t *summary)
+{
+    if (metric >= AUDIO_TRACE_METRIC_MAX || !summary) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const trace_hist_t *hist = &s_trace.hist[metric];
+    memset(summary, 0, sizeof(*summary));
+
+    portENTER_CRITICAL_SAFE(&s_trace.lock);
+    summary->count = hist->count;
+    summary->max_us = hist->max_us;
+    summary->last_us = hist->last_us;
+    if (hist->count > 0) {
+        summary->p50_us = trace_percentile(hist, 50);
+        summary->p99_us = trace_percentile(hist, 99);
+    }
+    portEXIT_CRITICAL_SAFE(&s_trace.lock);
+    return ESP_OK;
+}
+
+void audio_trace_reset(void)
+{
+    portENTER_CRITICAL_SAFE(&s_trace.lock);
+    memset(s_trace.hist, 0, sizeof(s_trace.hist));
+    memset(s_trace.anchor_count, 0, sizeof(s_trace.anchor_count));
+    s_trace.log_count = 0;
+    portEXIT_CRITICAL_SAFE(&s_trace.lock);
+}
+
+void audio_trace_dump(void)
+{
+    ESP_LOGI(TAG, "📊 延迟统计（us）: %-16s %8s %8s %8s %8s", "metric", "count", "p50", "p99", "max");
+    for (int m = 0; m < AUDIO_TRACE_METRIC_MAX; m++) {
+        audio_trace_summary_t sum;
+        audio_trace_get_summary((audio_trace_metric_t)m, &sum);
+        ESP_LOGI(TAG, "                   %-16s %8u %8u %8u %8u", s_metric_names[m],
+                 (unsigned)sum.count, (unsigned)sum.p50_us, (unsigned)sum.p99_us, (unsigned)sum.max_us);
+    }
+
+    // 拷贝快照后再打印，避免在临界区内输出日志
+    static trace_log_entry_t snapshot[AUDIO_TRACE_LOG_ENTRIES];
+    portENTER_CRITICAL_SAFE(&s_trace.lock);
+    uint32_t count = s_trace.log_count;
+    memcpy(snapshot, s_trace.log, sizeof(snapshot));
+    portEXIT_CRITICAL_SAFE(&s_trace.lock);
+
+    uint32_t n = count < AUDIO_TRACE_LOG_ENTRIES ? count : AUDIO_TRACE_LOG_ENTRIES;
+    if (n == 0) {
+        return;
+    }
+    uint32_t base = snapshot[(count - n) % AUDIO_TRACE_LOG_ENTRIES].ts;
+    ESP_LOGI(TAG, "📜 最近 %u 个跟踪点（相对时间 us）:", (unsigned)n);
+    for (uint32_t i = count - n; i != count; i++) {
+        const trace_log_entry_t *e = &snapshot[i % AUDIO_TRACE_LOG_ENTRIES];
+        ESP_LOGI(TAG, "  +%8u %-10s pos=%u", (unsigned)(e->ts - base),
+                 s_point_names[e->point], (unsigned)e->pos);
+    }
+}
@@ -0,0 +1,284 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 10:00:00
+ * @FilePath: \xn_esp32_audio\components\xn_audio_manager\src\event_ring.c
+ * @Description: 事件环实现
+ * 
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
+ */
+#include "event_ring.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdatomic.h>
+
+static const char *TAG = "EVENT_RING";
+
+/**
+ * @brief 事件槽
+ *
+ * seq 标记槽位状态（有界 MPMC 队列的经典做法）：
+ * - seq == pos：空闲，等待写入第 pos 个事件
+ * - seq == pos + 1：第 pos 个事件已写好，等待读取
+ * 读取后 seq 推进到 pos + 槽位数，留给下一圈的生产者。
+ */
+typedef struct {
+    atomic_uint seq;              ///< 槽位序号
+    uint8_t data[];               ///< 事件数据
+} event_ring_slot_t;
+
+/**
+ * @brief 事件环结构体
+ *
+ * 多生产者通过 CAS 推进 enqueue_pos 抢占槽位，单消费者顺序读取；
+ * 不使用互斥锁与临界区，可在 ISR、esp_timer 回调和普通任务中并发投递。
+ * 槽位与计数必须位于内部 RAM（原子 CAS 不支持 PSRAM 地址）。
+ */
+typedef struct event_ring_s {
+    audio_arena_handle_t arena;   ///< 所属内存区（NULL 表示堆分配）
+    uint8_t *slots;               ///< 槽位数组（内部 RAM）
+    size_t stride;                ///< 单个槽位大小（字节，4 字节对齐）
+    size_t item_size;             ///< 事件大小（字节）
+    uint32_t mask;                ///< 槽位索引掩码（槽位数 - 1）
+    atomic_uint enqueue_pos;      ///< 下一个写入位置（生产者 CAS 推进）
+    atomic_uint dequeue_pos;      ///< 下一个读取位置（仅消费者推进）
+    TaskHandle_t consumer;        ///< 消费者任务（投递后通知）
+    atomic_uint dropped;          ///< 环满丢弃的事件数
+    atomic_uint high_water;       ///< 历史最高积压事件数
+} event_ring_t;
+
+static size_t event_ring_round_pow2(size_t n)
+{
+    size_t v = 1;
+    while (v < n) {
+        v <<= 1;
+    }
+    return v;
+}
+
+static inline size_t event_ring_stride(size_t item_size)
+{
+    return (sizeof(event_ring_slot_t) + item_size + 3) & ~(size_t)3;
+}
+
+static inline event_ring_slot_t *event_ring_slot(event_ring_t *ring, uint32_t pos)
+{
+    return (event_ring_slot_t *)(ring->slots + (size_t)(pos & ring->mask) * ring->stride);
+}
+
+/**
+ * @brief 创建事件环
+ * 
+ * @param config 配置参数
+ * @return 事件环句柄，失败返回 NULL
+ */
+event_ring_handle_t event_ring_create(const event_ring_config_t *config)
+{
+    if (!config || config->length == 0 || config->item_size == 0) {
+        ESP_LOGE(TAG, "无效的事件环配置");
+        return NULL;
+    }
+
+    event_ring_t *ring = (event_ring_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                            sizeof(event_ring_t));
+    if (!ring) {
+        ESP_LOGE(TAG, "事件环句柄分配失败");
+        return NULL;
+    }
+    ring->arena = config->arena;
+
+    size_t length = event_ring_round_pow2(config->length);
+    ring->stride = event_ring_stride(config->item_size);
+    ring->item_size = config->item_size;
+    ring->mask = (uint32_t)(length - 1);
+    ring->slots = (uint8_t *)audio_arena_calloc(ring->arena, AUDIO_ARENA_INTERNAL, length * ring->stride);
+    if (!ring->slots) {
+        ESP_LOGE(TAG, "事件环槽位分配失败: %u 个", (unsigned)length);
+        audio_arena_free(ring->arena, ring);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < length; i++) {
+        atomic_init(&event_ring_slot(ring, i)->seq, i);
+    }
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->dequeue_pos, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->high_water, 0);
+    return ring;
+}
+
+/**
+ * @brief 累加创建事件环所需的内存占用
+ * 
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void event_ring_get_footprint(const event_ring_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config || config->length == 0 || config->item_size == 0) {
+        return;
+    }
+
+    size_t length = event_ring_round_pow2(config->length);
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(event_ring_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, length * event_ring_stride(config->item_size));
+}
+
+/**
+ * @brief 销毁事件环
+ * 
+ * @param ring 事件环句柄
+ */
+void event_ring_destroy(event_ring_handle_t ring)
+{
+    if (!ring) {
+        return;
+    }
+    audio_arena_free(ring->arena, ring->slots);
+    audio_arena_free(ring->arena, ring);
+}
+
+/**
+ * @brief 设置消费者任务
+ * 
+ * @param ring 事件环句柄
+ * @param task 消费者任务
+ */
+void event_ring_set_consumer(event_ring_handle_t ring, TaskHandle_t task)
+{
+    if (ring) {
+        ring->consumer = task;
+    }
+}
+
+/**
+ * @brief 投递一个事件
+ * 
+ * 抢占槽位只需一次 CAS（竞争时重试），写入数据后以 release 发布 seq，
+ * 再给消费者任务发一次计数通知。环满时不等待，只累加丢弃计数（ISR 中不能打印日志）。
+ * 
+ * @param ring 事件环句柄
+ * @param item 事件数据
+ * @return true 成功；false 环已满
+ */
+bool IRAM_ATTR event_ring_push(event_ring_handle_t ring, const void *item)
+{
+    if (!ring || !item) {
+        return false;
+    }
+
+    event_ring_slot_t *slot;
+    uint32_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    while (true) {
+        slot = event_ring_slot(ring, pos);
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 上一圈的事件尚未被读取：环已满
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->data, item, ring->item_size);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    // 消费者可能已越过本事件（读取了后续生产者的事件），此时积压量按 0 计
+    int32_t backlog = (int32_t)(pos + 1 - atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed));
+    uint32_t level = backlog > 0 ? (uint32_t)backlog : 0;
+    uint32_t high = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+    while (level > high &&
+           !atomic_compare_exchange_weak_explicit(&ring->high_water, &high, level,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    TaskHandle_t consumer = ring->consumer;
+    if (consumer) {
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(consumer, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(consumer);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 取出最早的事件
+ * 
+ * 生产者已抢占但尚未写完的槽位视为空，该生产者写完后会再次通知。
+ * 
+ * @param ring 事件环句柄
+ * @param item 输出事件数据
+ * @param seq 输出事件序号
+ * @return true 取到事件；false 环为空
+ */
+bool event_ring_pop(event_ring_handle_t ring, void *item, uint32_t *seq)
+{
+    if (!ring || !item) {
+        return false;
+    }
+
+    uint32_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    event_ring_slot_t *slot = event_ring_slot(ring, pos);
+    uint32_t slot_seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if ((int32_t)(slot_seq - (pos + 1)) < 0) {
+        return false;
+    }
+
+    memcpy(item, slot->data, ring->item_size);
+    if (seq) {
+        *seq = pos;
+    }
+    atomic_store_explicit(&slot->seq, pos + ring->mask + 1, memory_order_release);
+    atomic_store_explicit(&ring->dequeue_pos, pos + 1, memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief 等待新事件通知
+ * 
+ * @param ring 事件环句柄
+ * @param ticks 最长等待时间
+ * @return true 收到通知；false 超时
+ */
+bool event_ring_wait(event_ring_handle_t ring, TickType_t ticks)
+{
+    if (!ring) {
+        return false;
+    }
+    return ulTaskNotifyTake(pdTRUE, ticks) > 0;
+}
+
+/**
+ * @brief 获取运行统计
+ * 
+ * @param ring 事件环句柄
+ * @param stats 输出统计
+ */
+void event_ring_get_stats(event_ring_handle_t ring, event_ring_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!ring) {
+        return;
+    }
+    stats->posted = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+    stats->capacity = ring->mask + 1;
+}
@@ -9,6 +9,7 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "i2s_hal.h"
+#include "audio_dsp.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "driver/gpio.h"
@@ -25,17 +26,158 @@ static const char *TAG = "I2S_HAL";
  * - TX 和 RX 通道句柄
  * - 立体声转换缓冲区（用于单声道到立体声的转换）
  * - 麦克风临时缓冲区（预分配，避免频繁 malloc/free）
+ *
+ * 缓冲区位置：堆模式下在 PSRAM；内存区模式下在 DMA 可用的内部 RAM，
+ * 与 I2S DMA 拷贝路径相邻，避免 PSRAM cache 抖动。
  */
 typedef struct i2s_hal_s {
+    audio_arena_handle_t arena;     ///< 所属内存区（NULL 表示堆分配）
     i2s_chan_handle_t tx_handle;    ///< 扬声器（TX）通道句柄
     i2s_chan_handle_t rx_handle;    ///< 麦克风（RX）通道句柄
     int16_t *stereo_buffer;         ///< 立体声转换缓冲区（PSRAM），用于单声道到立体声转换
     size_t stereo_buffer_size;      ///< 立体声缓冲区大小（采样点数）
     int32_t *mic_temp_buffer;       ///< 麦克风临时缓冲区（PSRAM），用于32位数据读取
-    size_t mic_temp_buffer_size;    ///< 麦克风临时缓冲区大小（采样点数）
+    size_t mic_temp_buffer_size;    ///< 麦克风临时缓冲区大小（每声道采样点数）
     uint8_t mic_bit_shift;          ///< 32位转16位的右移位数（默认14，可调12-16）
+    uint8_t mic_num;                ///< 麦克风数（RX 声道数）
+    int32_t mic_gain_q15[I2S_HAL_MAX_MIC_NUM];  ///< 每路麦克风校准增益（Q15）
+    bool mic_gain_unity;            ///< 所有增益均为 1.0（跳过乘法）
+    size_t tx_queue_samples;        ///< TX DMA 队列深度（每声道采样点数）
+    i2s_chan_config_t rx_chan_cfg;  ///< RX 通道配置（重建通道时使用）
+    i2s_std_config_t rx_std_cfg;    ///< RX 标准模式配置（重建通道时使用）
+    uint32_t rx_dma_frame_default;  ///< RX 默认 DMA 帧长
+    bool full_duplex;               ///< TX/RX 同一端口、同一时钟
 } i2s_hal_t;
 
+/** 单个 DMA 缓冲区的最大字节数（驱动限制） */
+#define I2S_HAL_DMA_BUFFER_MAX_BYTES 4092
+
+/**
+ * @brief 按保存的配置创建、初始化并使能 RX 通道
+ * 
+ * @param hal I2S HAL 实例
+ * @return esp_err_t ESP_OK 成功；失败时 rx_handle 为 NULL
+ */
+static esp_err_t i2s_hal_open_rx(i2s_hal_t *hal)
+{
+    esp_err_t ret = i2s_new_channel(&hal->rx_chan_cfg, NULL, &hal->rx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "创建 RX 通道失败: %s", esp_err_to_name(ret));
+        hal->rx_handle = NULL;
+        return ret;
+    }
+
+    ret = i2s_channel_init_std_mode(hal->rx_handle, &hal->rx_std_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "初始化 RX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    ret = i2s_channel_enable(hal->rx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "使能 RX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+    return ESP_OK;
+
+fail:
+    i2s_del_channel(hal->rx_handle);
+    hal->rx_handle = NULL;
+    return ret;
+}
+
+/**
+ * @brief 创建、初始化并使能 TX 通道（独立端口）
+ * 
+ * @param hal I2S HAL 实例
+ * @param chan_cfg TX 通道配置
+ * @param std_cfg TX 标准模式配置
+ * @return esp_err_t ESP_OK 成功；失败时 tx_handle 为 NULL
+ */
+static esp_err_t i2s_hal_open_tx(i2s_hal_t *hal, const i2s_chan_config_t *chan_cfg,
+                                 const i2s_std_config_t *std_cfg)
+{
+    esp_err_t ret = i2s_new_channel(chan_cfg, &hal->tx_handle, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "创建 TX 通道失败: %s", esp_err_to_name(ret));
+        hal->tx_handle = NULL;
+        return ret;
+    }
+
+    ret = i2s_channel_init_std_mode(hal->tx_handle, std_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "初始化 TX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    ret = i2s_channel_enable(hal->tx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "使能 TX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+    return ESP_OK;
+
+fail:
+    i2s_del_channel(hal->tx_handle);
+    hal->tx_handle = NULL;
+    return ret;
+}
+
+/**
+ * @brief 在同一端口上创建全双工 TX/RX 通道
+ * 
+ * 两个通道由同一次 i2s_new_channel() 分配，共用 BCLK/LRCK，采样时钟完全一致：
+ * 每写入一帧扬声器数据就恰好采集一帧麦克风数据，回采与回声之间没有时钟漂移。
+ * 先使能 TX 再使能 RX，使两者的 DMA 起点相差固定。
+ * 
+ * @param hal I2S HAL 实例（rx_std_cfg 已填好）
+ * @param chan_cfg 共用的通道配置
+ * @param tx_std_cfg TX 标准模式配置
+ * @return esp_err_t ESP_OK 成功；失败时两个句柄均为 NULL
+ */
+static esp_err_t i2s_hal_open_duplex(i2s_hal_t *hal, const i2s_chan_config_t *chan_cfg,
+                                     const i2s_std_config_t *tx_std_cfg)
+{
+    esp_err_t ret = i2s_new_channel(chan_cfg, &hal->tx_handle, &hal->rx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "创建全双工通道失败: %s", esp_err_to_name(ret));
+        hal->tx_handle = NULL;
+        hal->rx_handle = NULL;
+        return ret;
+    }
+
+    ret = i2s_channel_init_std_mode(hal->tx_handle, tx_std_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "初始化 TX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+    ret = i2s_channel_init_std_mode(hal->rx_handle, &hal->rx_std_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "初始化 RX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    ret = i2s_channel_enable(hal->tx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "使能 TX 失败: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+    ret = i2s_channel_enable(hal->rx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "使能 RX 失败: %s", esp_err_to_name(ret));
+        i2s_channel_disable(hal->tx_handle);
+        goto fail;
+    }
+    return ESP_OK;
+
+fail:
+    i2s_del_channel(hal->rx_handle);
+    i2s_del_channel(hal->tx_handle);
+    hal->rx_handle = NULL;
+    hal->tx_handle = NULL;
+    return ret;
+}
+
 /**
  * @brief 创建 I2S HAL 实例
  * 
@@ -43,12 +185,15 @@ typedef struct i2s_hal_s {
  * 
  * @param mic_config 麦克风配置参数（采样率、GPIO 引脚等）
  * @param speaker_config 扬声器配置参数（采样率、GPIO 引脚、最大帧大小等）
+ * @param arena 内存区（可选，NULL 使用堆分配）
  * @return i2s_hal_handle_t 成功返回句柄，失败返回 NULL
  * 
- * @note 初始化顺序：先 TX 后 RX，失败时自动清理已分配的资源
+ * @note 初始化顺序：先 TX 后 RX，失败时自动清理已分配的资源；
+ *       全双工模式下两者在麦克风端口上一并创建
  */
 i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config, 
-                                 const i2s_speaker_config_t *speaker_config)
+                                 const i2s_speaker_config_t *speaker_config,
+                                 audio_arena_handle_t arena)
 {
     // 参数有效性检查
     if (!mic_config || !speaker_config) {
@@ -57,24 +202,63 @@ i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config,
     }
 
     // 分配 HAL 上下文内存
-    i2s_hal_t *hal = (i2s_hal_t *)calloc(1, sizeof(i2s_hal_t));
+    i2s_hal_t *hal = (i2s_hal_t *)audio_arena_calloc(arena, AUDIO_ARENA_INTERNAL, sizeof(i2s_hal_t));
     if (!hal) {
         ESP_LOGE(TAG, "HAL 上下文分配失败");
         return NULL;
     }
+    hal->arena = arena;
+
+    // 临时缓冲区所在区域：内存区模式放内部 RAM，堆模式放 PSRAM
+    const audio_arena_region_t buf_region = arena ? AUDIO_ARENA_INTERNAL : AUDIO_ARENA_PSRAM;
+
+    // ========== 麦克风参数 ==========
+    hal->mic_num = mic_config->mic_num;
+    if (hal->mic_num == 0) {
+        hal->mic_num = 1;
+    } else if (hal->mic_num > I2S_HAL_MAX_MIC_NUM) {
+        ESP_LOGW(TAG, "麦克风数 %d 超出上限，按 %d 处理", mic_config->mic_num, I2S_HAL_MAX_MIC_NUM);
+        hal->mic_num = I2S_HAL_MAX_MIC_NUM;
+    }
+    const bool mic_array = hal->mic_num > 1;
+
+    hal->full_duplex = speaker_config->full_duplex;
+    if (hal->full_duplex && speaker_config->sample_rate != mic_config->sample_rate) {
+        ESP_LOGE(TAG, "全双工要求扬声器与麦克风采样率一致: %d != %d",
+                 speaker_config->sample_rate, mic_config->sample_rate);
+        audio_arena_free(arena, hal);
+        return NULL;
+    }
 
-    // ========== 初始化 TX（扬声器）通道 ==========
+    // 配置 RX 通道参数：使用主模式
+    hal->rx_chan_cfg = (i2s_chan_config_t)I2S_CHANNEL_DEFAULT_CONFIG(mic_config->port, I2S_ROLE_MASTER);
+    hal->rx_dma_frame_default = hal->rx_chan_cfg.dma_frame_num;
+
+    // 配置 RX 标准模式：32位单声道（双麦克风阵列为立体声），Philips 格式
+    hal->rx_std_cfg = (i2s_std_config_t){
+        .clk_cfg  = I2S_STD_CLK_DEFAULT_CONFIG(mic_config->sample_rate),  // 时钟配置
+        .slot_cfg = I2S_STD_PHILIP_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT,
+                                                       mic_array ? I2S_SLOT_MODE_STEREO : I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = GPIO_NUM_NC,  // 主时钟不使用
+            .bclk = mic_config->bclk_gpio,  // 位时钟 GPIO
+            .ws   = mic_config->lrck_gpio,  // 字选择（左右声道）GPIO
+            .dout = GPIO_NUM_NC,  // 数据输出不使用
+            .din  = mic_config->din_gpio,  // 数据输入 GPIO
+            .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },  // 不反转信号
+        },
+    };
+    // 单麦克风接收右声道数据（单声道麦克风通常使用右声道），阵列左右声道都接收
+    hal->rx_std_cfg.slot_cfg.slot_mask = mic_array ? I2S_STD_SLOT_BOTH : I2S_STD_SLOT_RIGHT;
+
+    // ========== 扬声器参数 ==========
     // 配置 TX 通道参数：使用主模式，自动清除 DMA 缓冲区
     i2s_chan_config_t tx_chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(speaker_config->port, I2S_ROLE_MASTER);
-    tx_chan_cfg.auto_clear = true;  // 自动清除 DMA 缓冲区，避免播放残留数据
-
-    // 创建 TX 通道
-    esp_err_t ret = i2s_new_channel(&tx_chan_cfg, &hal->tx_handle, NULL);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "创建 TX 通道失败: %s", esp_err_to_name(ret));
-        free(hal);
-        return NULL;
+    if (hal->full_duplex) {
+        tx_chan_cfg = hal->rx_chan_cfg;     // 全双工：TX/RX 在同一端口，DMA 配置相同
     }
+    tx_chan_cfg.auto_clear = true;  // 自动清除 DMA 缓冲区，避免播放残留数据
+    hal->tx_queue_samples = (size_t)tx_chan_cfg.dma_desc_num * tx_chan_cfg.dma_frame_num;
 
     // 配置 TX 标准模式：16位立体声，Philips 格式
     i2s_std_config_t tx_std_cfg = {
@@ -89,93 +273,69 @@ i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config,
             .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },  // 不反转信号
         },
     };
-
-    // 初始化 TX 通道为标准模式
-    ret = i2s_channel_init_std_mode(hal->tx_handle, &tx_std_cfg);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "初始化 TX 失败: %s", esp_err_to_name(ret));
-        i2s_del_channel(hal->tx_handle);
-        free(hal);
-        return NULL;
+    if (hal->full_duplex) {
+        // 共用麦克风的 BCLK/LRCK：时钟一致，帧内声道宽度统一为 32 位（16 位数据位于高位）
+        tx_std_cfg.clk_cfg = hal->rx_std_cfg.clk_cfg;
+        tx_std_cfg.slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT;
+        tx_std_cfg.gpio_cfg.bclk = mic_config->bclk_gpio;
+        tx_std_cfg.gpio_cfg.ws = mic_config->lrck_gpio;
+        tx_std_cfg.gpio_cfg.din = mic_config->din_gpio;
+        hal->rx_std_cfg.gpio_cfg.dout = speaker_config->dout_gpio;
     }
 
-    // 使能 TX 通道
-    ret = i2s_channel_enable(hal->tx_handle);
+    // ========== 创建通道 ==========
+    esp_err_t ret = hal->full_duplex ? i2s_hal_open_duplex(hal, &tx_chan_cfg, &tx_std_cfg)
+                                     : i2s_hal_open_tx(hal, &tx_chan_cfg, &tx_std_cfg);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "使能 TX 失败: %s", esp_err_to_name(ret));
-        i2s_del_channel(hal->tx_handle);
-        free(hal);
+        audio_arena_free(arena, hal);
         return NULL;
     }
 
-    ESP_LOGI(TAG, "I2S TX 初始化成功: 端口%d, BCLK=%d, LRCK=%d, DOUT=%d",
-             speaker_config->port, speaker_config->bclk_gpio,
-             speaker_config->lrck_gpio, speaker_config->dout_gpio);
-
-    // ========== 初始化 RX（麦克风）通道 ==========
-    // 配置 RX 通道参数：使用主模式
-    i2s_chan_config_t rx_chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(mic_config->port, I2S_ROLE_MASTER);
-
-    // 创建 RX 通道
-    ret = i2s_new_channel(&rx_chan_cfg, NULL, &hal->rx_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "创建 RX 通道失败: %s", esp_err_to_name(ret));
-        // 清理已创建的 TX 通道
-        i2s_channel_disable(hal->tx_handle);
-        i2s_del_channel(hal->tx_handle);
-        free(hal);
-        return NULL;
-    }
-
-    // 配置 RX 标准模式：32位单声道，Philips 格式
-    i2s_std_config_t rx_std_cfg = {
-        .clk_cfg  = I2S_STD_CLK_DEFAULT_CONFIG(mic_config->sample_rate),  // 时钟配置
-        .slot_cfg = I2S_STD_PHILIP_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),  // 32位单声道
-        .gpio_cfg = {
-            .mclk = GPIO_NUM_NC,  // 主时钟不使用
-            .bclk = mic_config->bclk_gpio,  // 位时钟 GPIO
-            .ws   = mic_config->lrck_gpio,  // 字选择（左右声道）GPIO
-            .dout = GPIO_NUM_NC,  // 数据输出不使用
-            .din  = mic_config->din_gpio,  // 数据输入 GPIO
-            .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },  // 不反转信号
-        },
-    };
-    // 设置接收右声道数据（单声道麦克风通常使用右声道）
-    rx_std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_RIGHT;
-
-    // 初始化 RX 通道为标准模式
-    ret = i2s_channel_init_std_mode(hal->rx_handle, &rx_std_cfg);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "初始化 RX 失败: %s", esp_err_to_name(ret));
-        i2s_del_channel(hal->rx_handle);
-        i2s_channel_disable(hal->tx_handle);
-        i2s_del_channel(hal->tx_handle);
-        free(hal);
-        return NULL;
+    if (hal->full_duplex) {
+        ESP_LOGI(TAG, "I2S 全双工初始化成功: 端口%d, BCLK=%d, LRCK=%d, DIN=%d, DOUT=%d, 麦克风 %d 路",
+                 mic_config->port, mic_config->bclk_gpio, mic_config->lrck_gpio,
+                 mic_config->din_gpio, speaker_config->dout_gpio, hal->mic_num);
+    } else {
+        ESP_LOGI(TAG, "I2S TX 初始化成功: 端口%d, BCLK=%d, LRCK=%d, DOUT=%d",
+                 speaker_config->port, speaker_config->bclk_gpio,
+                 speaker_config->lrck_gpio, speaker_config->dout_gpio);
+
+        // 创建、初始化并使能 RX 通道
+        ret = i2s_hal_open_rx(hal);
+        if (ret != ESP_OK) {
+            // 清理已创建的 TX 通道
+            i2s_channel_disable(hal->tx_handle);
+            i2s_del_channel(hal->tx_handle);
+            audio_arena_free(arena, hal);
+            return NULL;
+        }
+
+        ESP_LOGI(TAG, "I2S RX 初始化成功: 端口%d, BCLK=%d, LRCK=%d, DIN=%d, 麦克风 %d 路",
+                 mic_config->port, mic_config->bclk_gpio,
+                 mic_config->lrck_gpio, mic_config->din_gpio, hal->mic_num);
     }
 
-    // 使能 RX 通道
-    ret = i2s_channel_enable(hal->rx_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "使能 RX 失败: %s", esp_err_to_name(ret));
-        i2s_del_channel(hal->rx_handle);
-        i2s_channel_disable(hal->tx_handle);
-        i2s_del_channel(hal->tx_handle);
-        free(hal);
-        return NULL;
+    // 校准增益：0 视为 1.0，最大 2.0（保证 16 位采样乘增益不溢出 int32）
+    hal->mic_gain_unity = true;
+    for (int i = 0; i < hal->mic_num; i++) {
+        int32_t gain = mic_config->gain_q15[i];
+        if (gain <= 0) {
+            gain = AUDIO_DSP_Q15_UNITY;
+        } else if (gain > 2 * AUDIO_DSP_Q15_UNITY) {
+            gain = 2 * AUDIO_DSP_Q15_UNITY;
+        }
+        hal->mic_gain_q15[i] = gain;
+        if (gain != AUDIO_DSP_Q15_UNITY) {
+            hal->mic_gain_unity = false;
+        }
     }
 
-    ESP_LOGI(TAG, "I2S RX 初始化成功: 端口%d, BCLK=%d, LRCK=%d, DIN=%d",
-             mic_config->port, mic_config->bclk_gpio,
-             mic_config->lrck_gpio, mic_config->din_gpio);
-
-    // ========== 分配麦克风临时缓冲区（PSRAM）==========
-    // 用于存储 32-bit 原始数据，避免频繁 malloc/free
+    // ========== 分配麦克风临时缓冲区 ==========
+    // 用于存储 32-bit 原始数据（多麦克风时为交织数据），避免频繁 malloc/free
     hal->mic_temp_buffer_size = mic_config->max_frame_samples > 0 ? 
                                  mic_config->max_frame_samples : 512;  // 默认 512
-    hal->mic_temp_buffer = (int32_t *)heap_caps_malloc(
-        hal->mic_temp_buffer_size * sizeof(int32_t),
-        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);  // 使用 PSRAM
+    hal->mic_temp_buffer = (int32_t *)audio_arena_calloc(
+        arena, buf_region, hal->mic_temp_buffer_size * hal->mic_num * sizeof(int32_t));
     
     if (!hal->mic_temp_buffer) {
         ESP_LOGE(TAG, "麦克风临时缓冲区分配失败");
@@ -184,7 +344,7 @@ i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config,
         i2s_del_channel(hal->rx_handle);
         i2s_channel_disable(hal->tx_handle);
         i2s_del_channel(hal->tx_handle);
-        free(hal);
+        audio_arena_free(arena, hal);
         return NULL;
     }
 
@@ -192,37 +352,65 @@ i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config,
     hal->mic_bit_shift = (mic_config->bit_shift >= 12 && mic_config->bit_shift <= 16) ? 
                           mic_config->bit_shift : 14;  // 默认 14
 
-    ESP_LOGI(TAG, "✅ 麦克风临时缓冲区初始化: %d samples (%.1f KB) at PSRAM, 右移 %d 位",
-             hal->mic_temp_buffer_size,
-             (hal->mic_temp_buffer_size * sizeof(int32_t)) / 1024.0f,
+    ESP_LOGI(TAG, "✅ 麦克风临时缓冲区初始化: %d samples (%.1f KB) at %s, 右移 %d 位",
+             hal->mic_temp_buffer_size * hal->mic_num,
+             (hal->mic_temp_buffer_size * hal->mic_num * sizeof(int32_t)) / 1024.0f,
+             arena ? "内存区(内部RAM)" : "PSRAM",
              hal->mic_bit_shift);
 
-    // ========== 分配立体声转换缓冲区（PSRAM）==========
+    // ========== 分配立体声转换缓冲区 ==========
     // 缓冲区大小：最大帧采样数 × 2（左右声道）× sizeof(int16_t)
     hal->stereo_buffer_size = speaker_config->max_frame_samples;
-    hal->stereo_buffer = (int16_t *)heap_caps_malloc(
-        hal->stereo_buffer_size * 2 * sizeof(int16_t), 
-        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);  // 使用 PSRAM 分配，节省内部 RAM
+    hal->stereo_buffer = (int16_t *)audio_arena_calloc(
+        arena, buf_region, hal->stereo_buffer_size * 2 * sizeof(int16_t));
     
     if (!hal->stereo_buffer) {
         ESP_LOGE(TAG, "立体声缓冲区分配失败");
         // 清理已创建的资源
-        if (hal->mic_temp_buffer) heap_caps_free(hal->mic_temp_buffer);
+        audio_arena_free(arena, hal->mic_temp_buffer);
         i2s_channel_disable(hal->rx_handle);
         i2s_del_channel(hal->rx_handle);
         i2s_channel_disable(hal->tx_handle);
         i2s_del_channel(hal->tx_handle);
-        free(hal);
+        audio_arena_free(arena, hal);
         return NULL;
     }
 
-    ESP_LOGI(TAG, "✅ 立体声缓冲区初始化: %d samples (%.1f KB) at PSRAM",
+    ESP_LOGI(TAG, "✅ 立体声缓冲区初始化: %d samples (%.1f KB) at %s",
              hal->stereo_buffer_size * 2, 
-             (hal->stereo_buffer_size * 2 * sizeof(int16_t)) / 1024.0f);
+             (hal->stereo_buffer_size * 2 * sizeof(int16_t)) / 1024.0f,
+             arena ? "内存区(内部RAM)" : "PSRAM");
 
     return hal;
 }
 
+/**
+ * @brief 累加创建 I2S HAL 实例所需的内存占用
+ * 
+ * 与 i2s_hal_create() 在内存区模式下的分配一一对应（缓冲区均在内部 RAM）。
+ * I2S 驱动自身的 DMA 描述符由驱动分配，不计入。
+ * 
+ * @param mic_config 麦克风配置
+ * @param speaker_config 扬声器配置
+ * @param fp 占用统计（累加）
+ */
+void i2s_hal_get_footprint(const i2s_mic_config_t *mic_config,
+                           const i2s_speaker_config_t *speaker_config,
+                           audio_arena_footprint_t *fp)
+{
+    if (!mic_config || !speaker_config) {
+        return;
+    }
+
+    size_t mic_samples = mic_config->max_frame_samples > 0 ? mic_config->max_frame_samples : 512;
+    size_t mic_num = mic_config->mic_num == 0 ? 1 :
+                     (mic_config->mic_num > I2S_HAL_MAX_MIC_NUM ? I2S_HAL_MAX_MIC_NUM : mic_config->mic_num);
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(i2s_hal_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, mic_samples * mic_num * sizeof(int32_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL,
+                              speaker_config->max_frame_samples * 2 * sizeof(int16_t));
+}
+
 /**
  * @brief 销毁 I2S HAL 实例
  * 
@@ -249,18 +437,14 @@ void i2s_hal_destroy(i2s_hal_handle_t hal)
         i2s_del_channel(hal->tx_handle);
     }
 
-    // 释放麦克风临时缓冲区（PSRAM）
-    if (hal->mic_temp_buffer) {
-        heap_caps_free(hal->mic_temp_buffer);
-    }
+    // 释放麦克风临时缓冲区
+    audio_arena_free(hal->arena, hal->mic_temp_buffer);
 
-    // 释放立体声转换缓冲区（PSRAM）
-    if (hal->stereo_buffer) {
-        heap_caps_free(hal->stereo_buffer);
-    }
+    // 释放立体声转换缓冲区
+    audio_arena_free(hal->arena, hal->stereo_buffer);
 
     // 释放 HAL 上下文内存
-    free(hal);
+    audio_arena_free(hal->arena, hal);
     ESP_LOGI(TAG, "I2S HAL 已销毁");
 }
 
@@ -269,14 +453,15 @@ void i2s_hal_destroy(i2s_hal_handle_t hal)
  * 
  * 从 I2S RX 通道读取 32 位音频数据，并转换为 16 位输出。
  * 使用预分配的缓冲区，避免频繁 malloc/free。
+ * 多麦克风时在同一遍循环内完成解交织、位宽转换与校准增益，输出按声道平面存放。
  * 
  * @param hal I2S HAL 句柄
- * @param out_samples 输出缓冲区（16位）
- * @param sample_count 期望读取的采样点数
- * @param out_got 实际读取的采样点数（可选）
+ * @param out_samples 输出缓冲区（16位，第 c 路位于 out_samples + c * sample_count）
+ * @param sample_count 期望读取的每声道采样点数
+ * @param out_got 实际读取的每声道采样点数（可选）
  * @return esp_err_t ESP_OK 成功，其他值表示错误
  * 
- * @note 数据格式转换：32位右移可配置位数（默认14）得到16位数据
+ * @note 数据格式转换：32位右移可配置位数（默认14）得到16位数据，超出范围时饱和而非截断
  * @note 根据 MSM261S4030H0R 数据手册：24-bit 有效数据在 32-bit 字中
  */
 esp_err_t i2s_hal_read_mic(i2s_hal_handle_t hal, int16_t *out_samples, 
@@ -295,18 +480,17 @@ esp_err_t i2s_hal_read_mic(i2s_hal_handle_t hal, int16_t *out_samples,
     }
 
     // 从 I2S RX 通道读取 32 位数据（使用预分配的缓冲区）
-    size_t bytes32 = sample_count * sizeof(int32_t);
+    size_t frame_bytes = hal->mic_num * sizeof(int32_t);
     size_t bytes_read = 0;
     esp_err_t ret = i2s_channel_read(hal->rx_handle, hal->mic_temp_buffer, 
-                                      bytes32, &bytes_read, 100);
+                                      sample_count * frame_bytes, &bytes_read, 100);
 
     // 将 32 位数据转换为 16 位
     // 根据数据手册：24-bit 有效数据 + 8-bit 低位填充
-    // 右移位数可配置，以适应不同的音量需求
-    size_t got = bytes_read / sizeof(int32_t);
-    for (size_t i = 0; i < got; i++) {
-        out_samples[i] = (int16_t)(hal->mic_temp_buffer[i] >> hal->mic_bit_shift);
-    }
+    // 右移位数可配置，以适应不同的音量需求；右移较少时大信号饱和钳位
+    size_t got = bytes_read / frame_bytes;
+    audio_dsp_s32_deinterleave_s16(hal->mic_temp_buffer, out_samples, got, hal->mic_num, sample_count,
+                                   hal->mic_bit_shift, hal->mic_gain_unity ? NULL : hal->mic_gain_q15);
 
     if (out_got) *out_got = got;
     return ret;
@@ -326,8 +510,8 @@ esp_err_t i2s_hal_read_mic(i2s_hal_handle_t hal, int16_t *out_samples,
  * 
  * @note 转换过程：
  *       1. 检查缓冲区大小
- *       2. 应用音量控制
- *       3. 单声道复制到左右声道
+ *       2. 应用音量控制（Q15 定点增益）
+ *       3. 单声道复制到左右声道（与第 2 步在同一循环内完成）
  *       4. 写入 I2S TX 通道
  */
 esp_err_t i2s_hal_write_speaker(i2s_hal_handle_t hal, const int16_t *samples, 
@@ -345,13 +529,9 @@ esp_err_t i2s_hal_write_speaker(i2s_hal_handle_t hal, const int16_t *samples,
     }
 
     // 单声道 -> 立体声转换，并应用音量控制
-    // 音量因子：将 0-100 映射到 0.0-1.0
-    float factor = (volume > 100 ? 100 : volume) / 100.0f;
-    for (size_t i = 0; i < sample_count; i++) {
-        int16_t v = (int16_t)(samples[i] * factor);  // 应用音量
-        hal->stereo_buffer[i * 2] = v;      // Left 声道
-        hal->stereo_buffer[i * 2 + 1] = v;  // Right 声道
-    }
+    // 音量增益：将 0-100 映射到 Q15 定点 0.0-1.0
+    audio_dsp_mono_to_stereo_q15(samples, hal->stereo_buffer, sample_count,
+                                 audio_dsp_volume_to_q15(volume));
 
     // 写入 I2S TX 通道
     size_t written = 0;
@@ -373,6 +553,28 @@ esp_err_t i2s_hal_write_speaker(i2s_hal_handle_t hal, const int16_t *samples,
     return ESP_OK;
 }
 
+/**
+ * @brief 获取麦克风数
+ * 
+ * @param hal I2S HAL 句柄
+ * @return uint8_t 麦克风数，失败返回 0
+ */
+uint8_t i2s_hal_get_mic_num(i2s_hal_handle_t hal)
+{
+    return hal ? hal->mic_num : 0;
+}
+
+/**
+ * @brief 是否为全双工模式
+ * 
+ * @param hal I2S HAL 句柄
+ * @return true 麦克风与扬声器同一端口、同一时钟
+ */
+bool i2s_hal_is_full_duplex(i2s_hal_handle_t hal)
+{
+    return hal ? hal->full_duplex : false;
+}
+
 /**
  * @brief 获取 RX 通道句柄
  * 
@@ -395,3 +597,70 @@ i2s_chan_handle_t i2s_hal_get_tx_handle(i2s_hal_handle_t hal)
     return hal ? hal->tx_handle : NULL;
 }
 
+/**
+ * @brief 设置 RX DMA 帧长
+ * 
+ * 帧长越大每秒 DMA 中断越少，但单次读取的等待时间变长；低功耗监听时使用。
+ * 驱动不支持运行时修改帧长，这里按保存的配置重建 RX 通道，期间丢失少量采样。
+ * 
+ * @param hal I2S HAL 句柄
+ * @param frame_num 每个 DMA 帧的采样数（0 恢复默认）
+ * @return esp_err_t ESP_OK 成功（帧长超出驱动限制时按上限处理）；ESP_ERR_NOT_SUPPORTED 全双工模式
+ * 
+ * @note 必须在读取麦克风的任务中调用，避免与 i2s_hal_read_mic() 并发
+ */
+esp_err_t i2s_hal_set_rx_dma_frame(i2s_hal_handle_t hal, uint32_t frame_num)
+{
+    if (!hal || !hal->rx_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (hal->full_duplex) {
+        // 单独重建 RX 会破坏与 TX 的锁步关系
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (frame_num == 0) {
+        frame_num = hal->rx_dma_frame_default;
+    }
+    // 每帧包含全部声道，单个 DMA 缓冲区受驱动限制
+    uint32_t max_frame_num = I2S_HAL_DMA_BUFFER_MAX_BYTES / (hal->mic_num * sizeof(int32_t));
+    if (frame_num > max_frame_num) {
+        ESP_LOGW(TAG, "RX DMA 帧长 %u 超出限制，按 %u 处理", (unsigned)frame_num, (unsigned)max_frame_num);
+        frame_num = max_frame_num;
+    }
+    if (frame_num == hal->rx_chan_cfg.dma_frame_num) {
+        return ESP_OK;
+    }
+
+    uint32_t old_frame_num = hal->rx_chan_cfg.dma_frame_num;
+    i2s_channel_disable(hal->rx_handle);
+    i2s_del_channel(hal->rx_handle);
+
+    hal->rx_chan_cfg.dma_frame_num = frame_num;
+    esp_err_t ret = i2s_hal_open_rx(hal);
+    if (ret != ESP_OK) {
+        // 回退到原帧长，保证麦克风可用
+        hal->rx_chan_cfg.dma_frame_num = old_frame_num;
+        if (i2s_hal_open_rx(hal) != ESP_OK) {
+            ESP_LOGE(TAG, "❌ RX 通道恢复失败");
+        }
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "RX DMA 帧长: %u -> %u", (unsigned)old_frame_num, (unsigned)frame_num);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取 TX DMA 队列深度
+ * 
+ * 写入返回时新数据位于 DMA 队列末尾，约经过该深度的时长才从扬声器播出
+ * （欠载时驱动自动清零已播完的描述符并循环发送，队列深度不变）。
+ * 
+ * @param hal I2S HAL 句柄
+ * @return 队列深度（每声道采样点数），失败返回 0
+ */
+size_t i2s_hal_get_tx_queue_samples(i2s_hal_handle_t hal)
+{
+    return hal ? hal->tx_queue_samples : 0;
+}
+
@@ -9,80 +9,754 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "playback_controller.h"
+#include "audio_dsp.h"
+#include "audio_trace.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
 static const char *TAG = "PLAYBACK_CTRL";
 
+/** 混音流运行状态 */
+typedef struct {
+    ring_buffer_handle_t rb;                        ///< 流缓冲区（流 0 指向 playback_rb，NULL 表示未启用）
+    uint8_t priority;                               ///< 优先级
+    volatile uint8_t gain;                          ///< 流增益（0-100，可运行时修改）
+    int32_t cur_gain;                               ///< 当前生效的 Q15 增益（含闪避，仅播放任务访问）
+    uint32_t hold;                                  ///< 闪避保持剩余帧数（流停止送数后继续闪避其他流）
+} playback_stream_t;
+
+/** 多帧淡出进度（仅播放任务访问） */
+typedef struct {
+    size_t done;                                    ///< 已淡出的采样数
+    size_t total;                                   ///< 淡出总长度（采样数）
+} playback_fade_t;
+
 /**
  * @brief 播放控制器上下文结构体
  * 
  * 存储播放控制器的所有状态信息和资源句柄
  */
 typedef struct playback_controller_s {
+    audio_arena_handle_t arena;                     ///< 所属内存区（NULL 表示堆分配）
     audio_bsp_handle_t bsp_handle;                  ///< BSP 句柄，用于音频输出
     ring_buffer_handle_t playback_rb;               ///< 播放缓冲区，存储待播放的音频数据
-    ring_buffer_handle_t reference_rb;              ///< 回采缓冲区，存储回采的音频数据供AFE使用
-    TaskHandle_t playback_task;                     ///< 播放任务句柄，用于管理播放任务
-    bool running;                                   ///< 运行状态标志，true表示正在运行
-    size_t frame_samples;                           ///< 每帧采样点数，用于分配帧缓冲区
+    aec_reference_handle_t reference;               ///< 回采对齐：在 I2S TX 边界采集回采并标注播出时间，供AFE读取
+    TaskHandle_t playback_task;                     ///< 常驻播放任务句柄（创建时启动，空闲时等待任务通知）
+    size_t task_stack_bytes;                        ///< 播放任务栈字节数
+    SemaphoreHandle_t cmd_lock;                     ///< 命令互斥锁，保证同一时刻只有一条命令在等待应答
+    SemaphoreHandle_t cmd_done;                     ///< 命令应答信号量，播放任务处理完命令后释放
+    int16_t *fade_buf;                              ///< 淡出/OVERWRITE 策略下的输出缓冲区（frame_samples 个采样）
+    volatile bool running;                          ///< 运行状态标志，true表示正在运行
+    size_t frame_samples;                           ///< 每帧采样点数，播放任务每次最多处理的采样数
     playback_reference_callback_t reference_callback; ///< 回采回调函数，用于将音频数据传递给AFE
     void *reference_ctx;                            ///< 回采回调上下文，传递给回调函数的用户数据
     uint8_t *volume_ptr;                            ///< 音量指针，指向音量值（0-100）
+    volatile uint8_t out_volume;                    ///< 生效音量（单流时已并入主流增益与闪避，全双工由 pull 返回）
+    ring_buffer_overrun_policy_t overrun_policy;    ///< 播放缓冲区溢出策略，决定写入失败时的错误码
+    uint32_t write_timeout_ms;                      ///< BLOCK 策略下写入的最长等待时间
+    /* 压缩播放（encoded_rb 为 NULL 表示未启用） */
+    RingbufHandle_t encoded_rb;                     ///< 压缩数据缓冲区（不分割模式，每次写入为一个条目）
+    StaticRingbuffer_t *encoded_rb_struct;          ///< 压缩缓冲区控制块
+    uint8_t *encoded_rb_storage;                    ///< 压缩缓冲区存储区（PSRAM）
+    audio_decoder_handle_t decoder;                 ///< 解码器
+    uint8_t *enc_item;                              ///< 正在解码的条目（仅播放任务访问）
+    size_t enc_len;                                 ///< 条目数据长度
+    size_t enc_pos;                                 ///< 条目内已解码位置
+    audio_decoder_codec_t enc_codec;                ///< 条目格式
+    const int16_t *dec_pcm;                         ///< 已解码待播放的 PCM（解码器内部缓冲）
+    size_t dec_left;                                ///< 已解码待播放的采样点数
+    /* 全双工（duplex_rb 为 NULL 表示由播放任务直接写 I2S） */
+    ring_buffer_handle_t duplex_rb;                 ///< 输出缓冲区（无锁 SPSC：播放任务写入 -> 锁步任务读取）
+    atomic_bool duplex_flush;                       ///< 清空请求，由锁步任务执行
+    atomic_size_t duplex_flush_pos;                 ///< 清空截止位置（请求时输出缓冲区的累计写入位置）
+    /* 格式转换（resampler 为 NULL 表示未启用，仅生产者访问） */
+    audio_resampler_handle_t resampler;             ///< 重采样/下混，输出直接写入播放缓冲区
+    uint32_t sample_rate;                           ///< 输出采样率
+    /* 混音（mixing 为 false 时只有主流，直接零拷贝输出） */
+    bool mixing;                                    ///< 是否启用了附加混音流
+    playback_stream_t streams[PLAYBACK_MAX_STREAMS]; ///< 混音流（流 0 为主流）
+    int32_t duck_gain;                              ///< 闪避 Q15 增益
+    uint8_t duck_percent;                           ///< 闪避增益（0-100，非混音模式并入音量）
+    volatile bool ducked;                           ///< 外部闪避（如打断时用户说话），所有流按闪避增益输出
+    size_t interrupt_fade;                          ///< 打断淡出长度（采样数，发送命令时在 cmd_lock 内设置）
+    int32_t *mix_acc;                               ///< 混音累加缓冲（frame_samples 个 32 位采样）
+    int16_t *mix_out;                               ///< 混音输出缓冲（frame_samples 个采样）
 } playback_controller_t;
 
+/** 压缩数据条目头（随数据一起写入压缩缓冲区） */
+typedef struct {
+    uint32_t codec;                                 ///< audio_decoder_codec_t
+} playback_encoded_hdr_t;
+
+#define PLAYBACK_TASK_STACK_SIZE    (5 * 1024)      ///< 播放任务栈大小（字节）
+#define PLAYBACK_DECODE_STACK_SIZE  (16 * 1024)     ///< 启用压缩播放时的播放任务栈大小（Opus 解码较深）
+#define PLAYBACK_IDLE_WAIT_MS       200             ///< 播放中缓冲区为空时的等待时间（命令会提前唤醒）
+#define PLAYBACK_CMD_TIMEOUT_MS     100             ///< 等待播放任务应答命令的最长时间
+#define PLAYBACK_DUPLEX_WAIT_MS     50              ///< 全双工输出缓冲区满时的最长等待（锁步任务停顿时丢帧）
+#define PLAYBACK_DUCK_HOLD_FRAMES   8               ///< 高优先级流停止送数后继续闪避的帧数（跨过 TTS 分段间隙）
+
+/** 播放任务命令（任务通知位） */
+#define PLAYBACK_CMD_START          (1u << 0)       ///< 开始播放
+#define PLAYBACK_CMD_STOP           (1u << 1)       ///< 淡出当前帧后停止
+#define PLAYBACK_CMD_FLUSH          (1u << 2)       ///< 清空播放/回采缓冲区
+#define PLAYBACK_CMD_INTERRUPT      (1u << 3)       ///< 打断：按 interrupt_fade 淡出后停止并丢弃待播放数据（保留回采）
+#define PLAYBACK_CMD_FLUSH_STREAM(i) (1u << (4 + (i))) ///< 只清空第 i 个混音流
+#define PLAYBACK_CMD_FLUSH_STREAMS  (((1u << PLAYBACK_MAX_STREAMS) - 1) << 4) ///< 全部单流清空命令位
+#define PLAYBACK_CMD_NEED_ACK       (PLAYBACK_CMD_STOP | PLAYBACK_CMD_FLUSH | PLAYBACK_CMD_INTERRUPT | \
+                                     PLAYBACK_CMD_FLUSH_STREAMS) ///< 需等待播放任务应答的命令
+
+/**
+ * @brief 按配置生成播放缓冲区与回采对齐配置（创建与占用预估共用）
+ */
+static void playback_controller_ring_configs(const playback_controller_config_t *config,
+                                             ring_buffer_config_t *playback,
+                                             aec_reference_config_t *reference)
+{
+    // 播放缓冲区（阻塞模式，无锁 SPSC：应用写入 -> 播放任务读取）
+    *playback = RING_BUFFER_DEFAULT_CONFIG(config->playback_buffer_samples);
+    playback->with_sem = true;
+    playback->lock_free = true;
+    playback->overrun_policy = config->overrun_policy;
+    playback->write_timeout_ms = config->write_timeout_ms;
+    playback->arena = config->arena;
+
+    // 回采对齐（无锁 SPSC：播放任务写入 -> AFE Feed 读取），TX 队列深度创建时从 BSP 获取
+    *reference = AEC_REFERENCE_DEFAULT_CONFIG(config->reference_buffer_samples);
+    if (config->sample_rate > 0) {
+        reference->sample_rate = config->sample_rate;
+    }
+    reference->tx_queue_samples = audio_bsp_get_tx_queue_samples(config->bsp_handle);
+    reference->lead_ms = config->reference_lead_ms;
+    reference->auto_delay = config->reference_auto_delay;
+    reference->arena = config->arena;
+}
+
+/**
+ * @brief 按配置生成全双工输出缓冲区配置（创建与占用预估共用）
+ *
+ * 容量为两帧：播放任务最多领先锁步任务一帧，写满时阻塞，由 I2S 时钟控制节奏。
+ */
+static void playback_controller_duplex_config(const playback_controller_config_t *config,
+                                              ring_buffer_config_t *duplex)
+{
+    *duplex = RING_BUFFER_DEFAULT_CONFIG(config->frame_samples * 2);
+    duplex->lock_free = true;
+    duplex->overrun_policy = RING_BUFFER_OVERRUN_BLOCK;
+    duplex->write_timeout_ms = PLAYBACK_DUPLEX_WAIT_MS;
+    duplex->arena = config->arena;
+}
+
+/**
+ * @brief 是否启用了附加混音流（流 1 及以后）
+ */
+static bool playback_controller_mixing(const playback_controller_config_t *config)
+{
+    for (int i = 1; i < PLAYBACK_MAX_STREAMS; i++) {
+        if (config->streams[i].buffer_samples > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 按配置生成附加混音流缓冲区配置（创建与占用预估共用）
+ *
+ * 混音时播放任务只在主流上等待数据，附加流写入后唤醒主流读端，因此不需要数据信号量。
+ */
+static void playback_controller_stream_config(const playback_controller_config_t *config, int stream,
+                                              ring_buffer_config_t *rb)
+{
+    *rb = RING_BUFFER_DEFAULT_CONFIG(config->streams[stream].buffer_samples);
+    rb->lock_free = true;
+    rb->overrun_policy = config->overrun_policy;
+    rb->write_timeout_ms = config->write_timeout_ms;
+    rb->arena = config->arena;
+}
+
+/**
+ * @brief 按配置生成解码器配置（创建与占用预估共用）
+ */
+static void playback_controller_decoder_config(const playback_controller_config_t *config,
+                                               audio_decoder_config_t *decoder)
+{
+    *decoder = AUDIO_DECODER_DEFAULT_CONFIG();
+    if (config->sample_rate > 0) {
+        decoder->sample_rate = config->sample_rate;
+    }
+    decoder->arena = config->arena;
+}
+
+/**
+ * @brief 按配置生成重采样器配置（创建与占用预估共用）
+ */
+static void playback_controller_resampler_config(const playback_controller_config_t *config,
+                                                 audio_resampler_config_t *resampler)
+{
+    *resampler = AUDIO_RESAMPLER_DEFAULT_CONFIG(config->sample_rate > 0 ? config->sample_rate : 16000);
+    resampler->arena = config->arena;
+}
+
+/**
+ * @brief 按配置确定播放任务栈大小
+ */
+static size_t playback_controller_stack_size(const playback_controller_config_t *config)
+{
+    return config->encoded_buffer_bytes > 0 ? PLAYBACK_DECODE_STACK_SIZE : PLAYBACK_TASK_STACK_SIZE;
+}
+
+/**
+ * @brief 输出一段音频：先播放到扬声器，写入 DMA 后再回采给 AFE
+ *
+ * 回采放在 I2S TX 写入返回之后，由回采对齐按 DMA 队列深度推算这段数据的实际播出时刻，
+ * 避免回采领先扬声器输出一整帧加 DMA 队列的时长。
+ * 全双工模式下只写入输出缓冲区，I2S 写入与回采由锁步任务完成。
+ */
+static void playback_output(playback_controller_t *ctrl, const int16_t *samples, size_t count, uint8_t volume)
+{
+    if (ctrl->duplex_rb) {
+        // 锁步任务停顿（如 AFE 重建）超过等待时长时丢弃本段，避免阻塞命令处理
+        ring_buffer_write(ctrl->duplex_rb, samples, count);
+        return;
+    }
+
+    audio_bsp_write_speaker(ctrl->bsp_handle, samples, count, volume);
+
+    // 回采的目的是让AFE能够处理播放的音频，用于回声消除等功能
+    if (ctrl->reference_callback) {
+        // 如果设置了回调函数，直接调用回调函数传递音频数据
+        ctrl->reference_callback(samples, count, ctrl->reference_ctx);
+    } else {
+        // 否则写入回采对齐，供AFE按采集时刻读取
+        aec_reference_write(ctrl->reference, samples, count);
+    }
+}
+
+/**
+ * @brief 归还正在解码的压缩条目
+ */
+static void playback_encoded_release(playback_controller_t *ctrl)
+{
+    if (ctrl->enc_item) {
+        vRingbufferReturnItem(ctrl->encoded_rb, ctrl->enc_item);
+        ctrl->enc_item = NULL;
+    }
+}
+
+/**
+ * @brief 丢弃全部压缩数据并重置解码器
+ */
+static void playback_encoded_flush(playback_controller_t *ctrl)
+{
+    if (!ctrl->encoded_rb) {
+        return;
+    }
+
+    playback_encoded_release(ctrl);
+    ctrl->dec_left = 0;
+
+    size_t size;
+    void *item;
+    while ((item = xRingbufferReceive(ctrl->encoded_rb, &size, 0)) != NULL) {
+        vRingbufferReturnItem(ctrl->encoded_rb, item);
+    }
+    audio_decoder_reset(ctrl->decoder);
+}
+
+/**
+ * @brief 准备压缩流的下一段已解码数据
+ * 
+ * 已解码数据未播完时直接返回；否则从当前条目（或新取的条目）解码一帧。
+ * 原始 PCM 优先：没有正在解码的条目且播放缓冲区有数据时不取新条目。
+ * 
+ * @return true 本步处理了压缩数据（dec_left 可能仍为 0，如只解析了码流头）；false 无压缩数据可处理
+ */
+static bool playback_encoded_prepare(playback_controller_t *ctrl)
+{
+    if (!ctrl->encoded_rb) {
+        return false;
+    }
+
+    if (ctrl->dec_left == 0) {
+        if (!ctrl->enc_item) {
+            if (ring_buffer_available(ctrl->playback_rb) > 0) {
+                return false;
+            }
+            size_t size = 0;
+            uint8_t *item = (uint8_t *)xRingbufferReceive(ctrl->encoded_rb, &size, 0);
+            if (!item) {
+                return false;
+            }
+            playback_encoded_hdr_t hdr;
+            memcpy(&hdr, item, sizeof(hdr));
+            ctrl->enc_item = item;
+            ctrl->enc_codec = (audio_decoder_codec_t)hdr.codec;
+            ctrl->enc_pos = sizeof(hdr);
+            ctrl->enc_len = size;
+        }
+
+        size_t consumed = 0;
+        size_t samples = 0;
+        const int16_t *pcm = NULL;
+        esp_err_t ret = audio_decoder_decode(ctrl->decoder, ctrl->enc_codec,
+                                             ctrl->enc_item + ctrl->enc_pos,
+                                             ctrl->enc_len - ctrl->enc_pos,
+                                             &consumed, &pcm, &samples);
+        ctrl->enc_pos += consumed;
+        if (ret != ESP_OK) {
+            // 数据损坏或格式不支持：丢弃当前条目
+            ESP_LOGW(TAG, "压缩数据解码失败，丢弃 %u 字节: %s",
+                     (unsigned)(ctrl->enc_len - sizeof(playback_encoded_hdr_t)), esp_err_to_name(ret));
+            ctrl->enc_pos = ctrl->enc_len;
+            samples = 0;
+        }
+        if (ctrl->enc_pos >= ctrl->enc_len || consumed == 0) {
+            playback_encoded_release(ctrl);
+        }
+
+        ctrl->dec_pcm = pcm;
+        ctrl->dec_left = samples;
+    }
+    return true;
+}
+
+/**
+ * @brief 压缩流播放一步：最多输出一帧
+ * 
+ * @return true 本步处理了压缩数据；false 无压缩数据可处理
+ */
+static bool playback_encoded_step(playback_controller_t *ctrl, uint8_t volume)
+{
+    if (!playback_encoded_prepare(ctrl)) {
+        return false;
+    }
+    if (ctrl->dec_left == 0) {
+        return true;
+    }
+
+    size_t n = ctrl->dec_left < ctrl->frame_samples ? ctrl->dec_left : ctrl->frame_samples;
+    playback_output(ctrl, ctrl->dec_pcm, n, volume);
+    ctrl->dec_pcm += n;
+    ctrl->dec_left -= n;
+    return true;
+}
+
+/**
+ * @brief 清空一个混音流（流 0 同时丢弃压缩数据）
+ */
+static void playback_stream_flush(playback_controller_t *ctrl, int stream)
+{
+    playback_stream_t *st = &ctrl->streams[stream];
+    if (!st->rb) {
+        return;
+    }
+    ring_buffer_clear(st->rb);
+    if (stream == 0) {
+        playback_encoded_flush(ctrl);
+    }
+    st->hold = 0;
+}
+
+/**
+ * @brief 计算淡出进度 pos 处的 Q15 增益
+ */
+static int32_t playback_fade_gain(const playback_fade_t *fade, size_t pos)
+{
+    if (pos >= fade->total) {
+        return 0;
+    }
+    return (int32_t)((uint64_t)AUDIO_DSP_Q15_UNITY * (fade->total - pos) / fade->total);
+}
+
+/**
+ * @brief 对一段输出应用淡出并推进进度
+ * 
+ * 数据不足请求量（缓冲区已播完）时在本段内直接渐变到静音并结束淡出，避免截断爆音。
+ * 
+ * @param fade 淡出进度
+ * @param pcm 待输出数据（原地处理）
+ * @param count 本段采样数
+ * @param want 本段请求的采样数
+ */
+static void playback_fade_apply(playback_fade_t *fade, int16_t *pcm, size_t count, size_t want)
+{
+    bool last = count < want;
+    int32_t from = playback_fade_gain(fade, fade->done);
+    int32_t to = last ? 0 : playback_fade_gain(fade, fade->done + count);
+    audio_dsp_ramp_q15(pcm, pcm, count, from, to);
+    fade->done = last ? fade->total : fade->done + count;
+}
+
+/**
+ * @brief 混音一步：各流取至多一帧，按流增益与闪避累加后输出
+ * 
+ * 正在播放的流中最高优先级决定闪避：优先级更低的流目标增益再乘以 duck_gain。
+ * 增益变化在本帧内线性渐变，流停止送数后保持 PLAYBACK_DUCK_HOLD_FRAMES 帧再恢复，
+ * 避免在 TTS 分段间隙处反复起落。混音结果同时送往扬声器与回采。
+ * 
+ * @param ctrl 播放控制器上下文
+ * @param volume 音量
+ * @param fade 淡出进度（NULL 表示正常播放），本帧取数不超过剩余淡出长度
+ * @return true 本步有数据处理；false 所有流均无数据
+ */
+static bool playback_mix_step(playback_controller_t *ctrl, uint8_t volume, playback_fade_t *fade)
+{
+    ring_buffer_span_t span[PLAYBACK_MAX_STREAMS] = {0};
+    bool decoded = false;
+    size_t want = ctrl->frame_samples;
+    size_t frame = 0;
+
+    if (fade && fade->total - fade->done < want) {
+        want = fade->total - fade->done;
+    }
+
+    // 取各流数据（零拷贝查看），主流优先播放已解码的压缩数据
+    for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+        if (!ctrl->streams[i].rb) {
+            continue;
+        }
+        if (i == 0 && playback_encoded_prepare(ctrl)) {
+            size_t n = ctrl->dec_left < want ? ctrl->dec_left : want;
+            span[0].data[0] = (int16_t *)ctrl->dec_pcm;
+            span[0].len[0] = n;
+            span[0].total = n;
+            decoded = true;
+        } else {
+            ring_buffer_peek_read(ctrl->streams[i].rb, want, &span[i], 0);
+        }
+        if (span[i].total > frame) {
+            frame = span[i].total;
+        }
+    }
+
+    if (frame == 0) {
+        // 全部静默：不再闪避
+        for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+            ctrl->streams[i].hold = 0;
+        }
+        if (fade) {
+            fade->done = fade->total;
+        }
+        return decoded;
+    }
+
+    // 确定当前最高优先级
+    bool ducking = false;
+    uint8_t top = 0;
+    for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+        playback_stream_t *st = &ctrl->streams[i];
+        if (!st->rb) {
+            continue;
+        }
+        if (span[i].total > 0) {
+            st->hold = PLAYBACK_DUCK_HOLD_FRAMES;
+        } else if (st->hold > 0) {
+            st->hold--;
+        }
+        if (st->hold > 0 && (!ducking || st->priority > top)) {
+            top = st->priority;
+            ducking = true;
+        }
+    }
+
+    size_t read_pos = 0;
+    if (!decoded && span[0].total > 0) {
+        ring_buffer_get_positions(ctrl->playback_rb, NULL, &read_pos);
+        audio_trace_mark(AUDIO_TRACE_PLAY_READ, (uint32_t)(read_pos + span[0].total));
+    }
+
+    // 累加各流（不足一帧的流其余部分为静音）
+    memset(ctrl->mix_acc, 0, frame * sizeof(int32_t));
+    for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+        playback_stream_t *st = &ctrl->streams[i];
+        if (!st->rb) {
+            continue;
+        }
+        int32_t target = audio_dsp_volume_to_q15(st->gain);
+        if ((ducking && st->priority < top) || ctrl->ducked) {
+            target = (target * ctrl->duck_gain) >> 15;
+        }
+        size_t total = span[i].total;
+        size_t done = 0;
+        for (int k = 0; k < 2 && span[i].len[k] > 0; k++) {
+            size_t len = span[i].len[k];
+            int32_t from = st->cur_gain + (target - st->cur_gain) * (int32_t)done / (int32_t)total;
+            int32_t to = st->cur_gain + (target - st->cur_gain) * (int32_t)(done + len) / (int32_t)total;
+            audio_dsp_mix_ramp_q15(span[i].data[k], ctrl->mix_acc + done, len, from, to);
+            done += len;
+        }
+        st->cur_gain = target;
+    }
+    audio_dsp_s32_to_s16_sat(ctrl->mix_acc, ctrl->mix_out, frame, 0);
+    if (fade) {
+        playback_fade_apply(fade, ctrl->mix_out, frame, want);
+    }
+
+    // 数据已混入 mix_out：在阻塞的 I2S 写入前释放，OVERWRITE 策略下生产者不会覆盖仍在查看的区间
+    bool overwritten = false;
+    for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+        if (span[i].total == 0) {
+            continue;
+        }
+        if (i == 0 && decoded) {
+            ctrl->dec_pcm += span[0].total;
+            ctrl->dec_left -= span[0].total;
+        } else if (ring_buffer_release_read(ctrl->streams[i].rb, span[i].total) != ESP_OK) {
+            overwritten = true;
+        }
+    }
+    if (overwritten) {
+        // 混音期间被生产者覆盖：本帧混有新旧数据，丢弃（覆盖量计入缓冲区统计）
+        return true;
+    }
+
+    playback_output(ctrl, ctrl->mix_out, frame, volume);
+
+    if (!decoded && span[0].total > 0) {
+        audio_trace_mark(AUDIO_TRACE_SPK_WRITE, (uint32_t)(read_pos + span[0].total));
+        audio_trace_latency(AUDIO_TRACE_LAT_PLAY_TO_SPEAKER, AUDIO_TRACE_PLAY_WRITE, (uint32_t)(read_pos + 1));
+    }
+    return true;
+}
+
+/**
+ * @brief 主流淡出一段（非混音模式）
+ * 
+ * 取出至多一帧待播放数据，按淡出进度渐变后输出。
+ */
+static void playback_fade_step(playback_controller_t *ctrl, uint8_t volume, playback_fade_t *fade)
+{
+    size_t want = fade->total - fade->done;
+    if (want > ctrl->frame_samples) {
+        want = ctrl->frame_samples;
+    }
+
+    size_t n = 0;
+    if (ctrl->dec_left > 0) {
+        // 正在播放压缩流：淡出已解码的剩余数据
+        n = ctrl->dec_left < want ? ctrl->dec_left : want;
+        memcpy(ctrl->fade_buf, ctrl->dec_pcm, n * sizeof(int16_t));
+        ctrl->dec_pcm += n;
+        ctrl->dec_left -= n;
+    } else {
+        ring_buffer_span_t span = {0};
+        if (ring_buffer_peek_read(ctrl->playback_rb, want, &span, 0) == ESP_OK) {
+            for (int i = 0; i < 2 && span.len[i] > 0; i++) {
+                memcpy(ctrl->fade_buf + n, span.data[i], span.len[i] * sizeof(int16_t));
+                n += span.len[i];
+            }
+            if (ring_buffer_release_read(ctrl->playback_rb, span.total) != ESP_OK) {
+                // 拷贝期间被生产者覆盖：放弃本段，淡出提前结束
+                n = 0;
+            }
+        }
+    }
+
+    if (n == 0) {
+        fade->done = fade->total;
+        return;
+    }
+    playback_fade_apply(fade, ctrl->fade_buf, n, want);
+    playback_output(ctrl, ctrl->fade_buf, n, volume);
+}
+
 /**
- * @brief 播放任务函数
+ * @brief 淡出停止
  * 
- * 从播放缓冲区读取音频数据，先回采给AFE，再输出到扬声器
+ * 在 samples 个采样内把待播放数据线性渐变到静音后输出，避免直接截断产生爆音；
+ * 每段至多一帧，I2S 写入决定节奏。缓冲区提前播完时在最后一段内渐变到静音，
+ * 缓冲区为空时不输出（上一帧已自然结束）。混音模式下淡出混音结果。
+ * 
+ * @param ctrl 播放控制器上下文
+ * @param volume 音量
+ * @param samples 淡出长度（采样数）
+ */
+static void playback_fade_out(playback_controller_t *ctrl, uint8_t volume, size_t samples)
+{
+    playback_fade_t fade = { .done = 0, .total = samples };
+
+    while (fade.done < fade.total) {
+        if (ctrl->mixing) {
+            if (!playback_mix_step(ctrl, volume, &fade)) {
+                break;
+            }
+        } else {
+            playback_fade_step(ctrl, volume, &fade);
+        }
+    }
+}
+
+/**
+ * @brief 常驻播放任务
+ * 
+ * 空闲时阻塞在任务通知上，不占用 CPU；播放时直接在播放缓冲区内查看一帧
+ * 音频数据（零拷贝）输出，每帧之间检查一次命令，因此停止最多延迟一帧。
+ * OVERWRITE 策略下先拷入 fade_buf 并释放再输出，避免 I2S 阻塞期间被生产者覆盖。
  * 
  * @param arg 播放控制器上下文指针
  */
 static void playback_task(void *arg)
 {
     playback_controller_t *ctrl = (playback_controller_t *)arg;
-    
-    // 分配帧缓冲区，用于存储从环形缓冲区读取的音频数据
-    int16_t *frame = (int16_t *)malloc(ctrl->frame_samples * sizeof(int16_t));
-    if (!frame) {
-        ESP_LOGE(TAG, "播放任务内存分配失败");
-        vTaskDelete(NULL);
-        return;
-    }
+    bool playing = false;
 
-    ESP_LOGI(TAG, "播放任务启动");
+    ESP_LOGI(TAG, "播放任务就绪");
 
-    // 主循环：持续从播放缓冲区读取数据并播放
-    while (ctrl->running) {
-        // 从播放缓冲区读取一帧音频数据，超时时间200ms
-        size_t got = ring_buffer_read(ctrl->playback_rb, frame, ctrl->frame_samples, 200);
+    while (1) {
+        // 播放中只检查命令不等待；空闲时一直等待命令
+        uint32_t cmd = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &cmd, playing ? 0 : portMAX_DELAY);
 
-        if (got > 0) {
-            // 先回采给 AFE（通过回调或写入缓冲区）
-            // 回采的目的是让AFE能够处理播放的音频，用于回声消除等功能
-            if (ctrl->reference_callback) {
-                // 如果设置了回调函数，直接调用回调函数传递音频数据
-                ctrl->reference_callback(frame, got, ctrl->reference_ctx);
+        // 获取音量值，如果未设置音量指针则使用默认值80
+        uint8_t volume = ctrl->volume_ptr ? *ctrl->volume_ptr : 80;
+        if (!ctrl->mixing) {
+            // 只有主流：流增益与外部闪避直接并入音量，保持零拷贝输出
+            volume = (uint8_t)((uint32_t)volume * ctrl->streams[0].gain / 100);
+            if (ctrl->ducked) {
+                volume = (uint8_t)((uint32_t)volume * ctrl->duck_percent / 100);
+            }
+        }
+        ctrl->out_volume = volume;
+
+        // STOP/FLUSH 发送方会等待应答，因此同一批中的 START 一定先于它们发出
+        if (cmd & PLAYBACK_CMD_START) {
+            playing = true;
+        }
+        if (cmd & PLAYBACK_CMD_STOP) {
+            if (playing) {
+                playback_fade_out(ctrl, volume, ctrl->frame_samples);
+            }
+            playing = false;
+        }
+        if (cmd & PLAYBACK_CMD_INTERRUPT) {
+            // 已写入 I2S 的数据照常播出，其回采留在回采对齐中按播出时刻被 AFE 取走
+            if (playing) {
+                playback_fade_out(ctrl, volume, ctrl->interrupt_fade);
+            }
+            for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+                playback_stream_flush(ctrl, i);
+            }
+            playing = false;
+        }
+        if (cmd & PLAYBACK_CMD_FLUSH) {
+            for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+                playback_stream_flush(ctrl, i);
+            }
+            if (ctrl->duplex_rb) {
+                // 输出缓冲区与回采由锁步任务消费/生产，记下截止位置交给它清空
+                size_t pos = 0;
+                ring_buffer_get_positions(ctrl->duplex_rb, &pos, NULL);
+                atomic_store_explicit(&ctrl->duplex_flush_pos, pos, memory_order_relaxed);
+                atomic_store_explicit(&ctrl->duplex_flush, true, memory_order_release);
             } else {
-                // 否则将音频数据写入回采缓冲区，供AFE读取
-                ring_buffer_write(ctrl->reference_rb, frame, got);
+                aec_reference_clear(ctrl->reference);
+            }
+        }
+        for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+            if (cmd & PLAYBACK_CMD_FLUSH_STREAM(i)) {
+                playback_stream_flush(ctrl, i);
             }
+        }
+        if (cmd & PLAYBACK_CMD_NEED_ACK) {
+            xSemaphoreGive(ctrl->cmd_done);
+        }
 
-            // 再播放音频数据到扬声器
-            // 获取音量值，如果未设置音量指针则使用默认值80
-            uint8_t volume = ctrl->volume_ptr ? *ctrl->volume_ptr : 80;
-            // 通过 BSP 将音频数据写入扬声器
-            audio_bsp_write_speaker(ctrl->bsp_handle, frame, got, volume);
+        if (!playing) {
+            continue;
         }
+
+        // 混音：所有流为空时在主流上等待（附加流写入会唤醒主流读端）
+        if (ctrl->mixing) {
+            if (!playback_mix_step(ctrl, volume, NULL)) {
+                ring_buffer_span_t idle = {0};
+                ring_buffer_peek_read(ctrl->playback_rb, 0, &idle, PLAYBACK_IDLE_WAIT_MS);
+            }
+            continue;
+        }
+
+        // 压缩流：每步解码/输出至多一帧，之后回到命令检查
+        if (playback_encoded_step(ctrl, volume)) {
+            continue;
+        }
+
+        // 查看播放缓冲区中的一帧音频数据（最多两段连续区间）；命令到达时会被提前唤醒
+        ring_buffer_span_t span = {0};
+        if (ring_buffer_peek_read(ctrl->playback_rb, ctrl->frame_samples, &span, PLAYBACK_IDLE_WAIT_MS) != ESP_OK ||
+            span.total == 0) {
+            continue;
+        }
+
+        // 跟踪：本帧在播放流中的位置（读指针在释放前不会移动）
+        size_t read_pos = 0;
+        ring_buffer_get_positions(ctrl->playback_rb, NULL, &read_pos);
+        audio_trace_mark(AUDIO_TRACE_PLAY_READ, (uint32_t)(read_pos + span.total));
+
+        if (ctrl->overrun_policy == RING_BUFFER_OVERRUN_OVERWRITE) {
+            // 生产者会覆盖未释放的数据：先拷出并释放，查看的区间不跨过阻塞的 I2S 写入
+            size_t n = 0;
+            for (int i = 0; i < 2 && span.len[i] > 0; i++) {
+                memcpy(ctrl->fade_buf + n, span.data[i], span.len[i] * sizeof(int16_t));
+                n += span.len[i];
+            }
+            if (ring_buffer_release_read(ctrl->playback_rb, span.total) != ESP_OK) {
+                // 拷贝期间被覆盖：本帧混有新旧数据，丢弃（覆盖量计入缓冲区统计）
+                continue;
+            }
+            playback_output(ctrl, ctrl->fade_buf, n, volume);
+        } else {
+            // REJECT/BLOCK 策略下生产者不会写入未释放的区间，直接零拷贝输出
+            for (int i = 0; i < 2 && span.len[i] > 0; i++) {
+                playback_output(ctrl, span.data[i], span.len[i], volume);
+            }
+            if (ring_buffer_release_read(ctrl->playback_rb, span.total) != ESP_OK) {
+                ESP_LOGW(TAG, "播放区间释放时读指针已被移动");
+            }
+        }
+
+        // 本帧第一个采样从 play_audio 写入到 I2S TX 写入完成的延迟
+        audio_trace_mark(AUDIO_TRACE_SPK_WRITE, (uint32_t)(read_pos + span.total));
+        audio_trace_latency(AUDIO_TRACE_LAT_PLAY_TO_SPEAKER, AUDIO_TRACE_PLAY_WRITE, (uint32_t)(read_pos + 1));
     }
+}
+
+/**
+ * @brief 向播放任务发送命令
+ * 
+ * STOP/FLUSH/INTERRUPT（含单流清空）需等待任务应答，返回时命令已生效；START 无需应答。
+ * 
+ * @param ctrl 播放控制器上下文
+ * @param cmd 命令位
+ * @param fade_ms INTERRUPT 的淡出时长（应答等待时间相应延长），其余命令为 0
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 等待应答超时
+ */
+static esp_err_t playback_send_cmd(playback_controller_t *ctrl, uint32_t cmd, uint32_t fade_ms)
+{
+    bool wait_done = (cmd & PLAYBACK_CMD_NEED_ACK) != 0;
+    esp_err_t ret = ESP_OK;
 
-    // 清理资源
-    free(frame);
-    ESP_LOGI(TAG, "播放任务结束");
-    vTaskDelete(NULL);
+    xSemaphoreTake(ctrl->cmd_lock, portMAX_DELAY);
+
+    if (cmd & PLAYBACK_CMD_INTERRUPT) {
+        ctrl->interrupt_fade = fade_ms > 0 ? (size_t)ctrl->sample_rate * fade_ms / 1000 : ctrl->frame_samples;
+    }
+
+    xTaskNotify(ctrl->playback_task, cmd, eSetBits);
+    // 播放任务可能正阻塞在播放缓冲区上，唤醒以便立即处理命令
+    ring_buffer_wake_reader(ctrl->playback_rb);
+
+    if (wait_done && xSemaphoreTake(ctrl->cmd_done, pdMS_TO_TICKS(PLAYBACK_CMD_TIMEOUT_MS + fade_ms)) != pdTRUE) {
+        ESP_LOGW(TAG, "播放任务应答超时: cmd=0x%02x", (unsigned)cmd);
+        ret = ESP_ERR_TIMEOUT;
+    }
+
+    xSemaphoreGive(ctrl->cmd_lock);
+    return ret;
 }
 
 /**
@@ -102,38 +776,148 @@ playback_controller_handle_t playback_controller_create(const playback_controlle
     }
 
     // 分配播放控制器内存
-    playback_controller_t *ctrl = (playback_controller_t *)calloc(1, sizeof(playback_controller_t));
+    playback_controller_t *ctrl = (playback_controller_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                                              sizeof(playback_controller_t));
     if (!ctrl) {
         ESP_LOGE(TAG, "播放控制器分配失败");
         return NULL;
     }
 
     // 初始化配置参数
+    ctrl->arena = config->arena;
     ctrl->bsp_handle = config->bsp_handle;
     ctrl->frame_samples = config->frame_samples;
     ctrl->reference_callback = config->reference_callback;
     ctrl->reference_ctx = config->reference_ctx;
     ctrl->volume_ptr = config->volume_ptr;
+    ctrl->out_volume = config->volume_ptr ? *config->volume_ptr : 80;
+    ctrl->overrun_policy = config->overrun_policy;
+    ctrl->write_timeout_ms = config->write_timeout_ms;
+    ctrl->sample_rate = config->sample_rate > 0 ? config->sample_rate : 16000;
 
-    // 创建播放缓冲区（阻塞模式）
-    ctrl->playback_rb = ring_buffer_create(config->playback_buffer_samples, true);
+    ring_buffer_config_t playback_rb_cfg;
+    aec_reference_config_t reference_cfg;
+    playback_controller_ring_configs(config, &playback_rb_cfg, &reference_cfg);
+    atomic_init(&ctrl->duplex_flush, false);
+    atomic_init(&ctrl->duplex_flush_pos, 0);
+
+    // 创建播放缓冲区
+    ctrl->playback_rb = ring_buffer_create_with_config(&playback_rb_cfg);
     if (!ctrl->playback_rb) {
         ESP_LOGE(TAG, "播放缓冲区创建失败");
-        free(ctrl);
-        return NULL;
+        goto fail;
     }
 
-    // 创建回采缓冲区（非阻塞模式）
-    ctrl->reference_rb = ring_buffer_create(config->reference_buffer_samples, false);
-    if (!ctrl->reference_rb) {
-        ESP_LOGE(TAG, "回采缓冲区创建失败");
-        ring_buffer_destroy(ctrl->playback_rb);
-        free(ctrl);
-        return NULL;
+    // 创建回采对齐
+    ctrl->reference = aec_reference_create(&reference_cfg);
+    if (!ctrl->reference) {
+        ESP_LOGE(TAG, "回采对齐创建失败");
+        goto fail;
+    }
+
+    // 混音流：流 0 即播放缓冲区，附加流各自独立缓冲区
+    ctrl->mixing = playback_controller_mixing(config);
+    ctrl->duck_gain = audio_dsp_volume_to_q15(config->duck_gain);
+    ctrl->duck_percent = config->duck_gain > 100 ? 100 : config->duck_gain;
+    for (int i = 0; i < PLAYBACK_MAX_STREAMS; i++) {
+        playback_stream_t *st = &ctrl->streams[i];
+        st->priority = config->streams[i].priority;
+        st->gain = config->streams[i].gain;
+        st->cur_gain = audio_dsp_volume_to_q15(st->gain);
+        if (i == 0) {
+            st->rb = ctrl->playback_rb;
+        } else if (config->streams[i].buffer_samples > 0) {
+            ring_buffer_config_t stream_cfg;
+            playback_controller_stream_config(config, i, &stream_cfg);
+            st->rb = ring_buffer_create_with_config(&stream_cfg);
+            if (!st->rb) {
+                ESP_LOGE(TAG, "混音流 %d 缓冲区创建失败", i);
+                goto fail;
+            }
+        }
+    }
+    if (ctrl->mixing) {
+        ctrl->mix_acc = (int32_t *)audio_arena_calloc(ctrl->arena, AUDIO_ARENA_INTERNAL,
+                                                      ctrl->frame_samples * sizeof(int32_t));
+        ctrl->mix_out = (int16_t *)audio_arena_calloc(ctrl->arena, AUDIO_ARENA_INTERNAL,
+                                                      ctrl->frame_samples * sizeof(int16_t));
+        if (!ctrl->mix_acc || !ctrl->mix_out) {
+            ESP_LOGE(TAG, "混音缓冲区分配失败");
+            goto fail;
+        }
+    }
+
+    // 全双工：输出缓冲区（锁步任务按 I2S 时钟取出）
+    if (config->full_duplex) {
+        ring_buffer_config_t duplex_cfg;
+        playback_controller_duplex_config(config, &duplex_cfg);
+        ctrl->duplex_rb = ring_buffer_create_with_config(&duplex_cfg);
+        if (!ctrl->duplex_rb) {
+            ESP_LOGE(TAG, "全双工输出缓冲区创建失败");
+            goto fail;
+        }
+    }
+
+    // 格式转换：重采样器按最大抽取比一次分配，切换输入格式不再分配
+    if (config->format_convert) {
+        audio_resampler_config_t resampler_cfg;
+        playback_controller_resampler_config(config, &resampler_cfg);
+        ctrl->resampler = audio_resampler_create(&resampler_cfg);
+        if (!ctrl->resampler) {
+            ESP_LOGE(TAG, "重采样器创建失败");
+            goto fail;
+        }
+    }
+
+    // 命令同步与淡出缓冲区
+    ctrl->cmd_lock = audio_arena_create_mutex(ctrl->arena);
+    ctrl->cmd_done = audio_arena_create_binary(ctrl->arena);
+    ctrl->fade_buf = (int16_t *)audio_arena_calloc(ctrl->arena, AUDIO_ARENA_INTERNAL,
+                                                   ctrl->frame_samples * sizeof(int16_t));
+    if (!ctrl->cmd_lock || !ctrl->cmd_done || !ctrl->fade_buf) {
+        ESP_LOGE(TAG, "播放命令资源创建失败");
+        goto fail;
+    }
+
+    // 压缩播放：压缩数据缓冲区（存储区位于 PSRAM）+ 解码器
+    if (config->encoded_buffer_bytes > 0) {
+        audio_decoder_config_t decoder_cfg;
+        playback_controller_decoder_config(config, &decoder_cfg);
+
+        ctrl->encoded_rb_struct = (StaticRingbuffer_t *)audio_arena_calloc(ctrl->arena, AUDIO_ARENA_INTERNAL,
+                                                                           sizeof(StaticRingbuffer_t));
+        ctrl->encoded_rb_storage = (uint8_t *)audio_arena_calloc(ctrl->arena, AUDIO_ARENA_PSRAM,
+                                                                 config->encoded_buffer_bytes);
+        if (!ctrl->encoded_rb_struct || !ctrl->encoded_rb_storage) {
+            ESP_LOGE(TAG, "压缩数据缓冲区分配失败");
+            goto fail;
+        }
+        ctrl->encoded_rb = xRingbufferCreateStatic(config->encoded_buffer_bytes, RINGBUF_TYPE_NOSPLIT,
+                                                   ctrl->encoded_rb_storage, ctrl->encoded_rb_struct);
+        ctrl->decoder = audio_decoder_create(&decoder_cfg);
+        if (!ctrl->encoded_rb || !ctrl->decoder) {
+            ESP_LOGE(TAG, "压缩播放初始化失败");
+            goto fail;
+        }
+    }
+
+    // 创建常驻播放任务，固定到 task_core（默认与 AFE feed 同在实时核），优先级7（启用压缩播放时栈加大到 16KB）
+    // 启动/停止只发送命令，不再反复创建删除任务
+    ctrl->task_stack_bytes = playback_controller_stack_size(config);
+    ctrl->playback_task = audio_arena_create_task(ctrl->arena, playback_task, "playback",
+                                                  ctrl->task_stack_bytes, ctrl, 7,
+                                                  AUDIO_ARENA_INTERNAL, config->task_core);
+    if (!ctrl->playback_task) {
+        ESP_LOGE(TAG, "播放任务创建失败");
+        goto fail;
     }
 
     ESP_LOGI(TAG, "✅ 播放控制器创建成功");
     return ctrl;
+
+fail:
+    playback_controller_destroy(ctrl);
+    return NULL;
 }
 
 /**
@@ -147,28 +931,121 @@ void playback_controller_destroy(playback_controller_handle_t controller)
 {
     if (!controller) return;
 
-    // 先停止播放任务
-    playback_controller_stop(controller);
+    // 先停止播放，再删除常驻任务（此时任务阻塞在任务通知上，不持有任何资源）
+    if (controller->playback_task) {
+        playback_controller_stop(controller);
+        vTaskDelete(controller->playback_task);
+        controller->playback_task = NULL;
+    }
+
+    if (controller->cmd_lock) {
+        vSemaphoreDelete(controller->cmd_lock);
+    }
+    if (controller->cmd_done) {
+        vSemaphoreDelete(controller->cmd_done);
+    }
+    audio_arena_free(controller->arena, controller->fade_buf);
+
+    // 销毁压缩播放资源（播放任务已删除，未归还的条目随缓冲区一并释放）
+    if (controller->encoded_rb) {
+        vRingbufferDelete(controller->encoded_rb);
+    }
+    audio_arena_free(controller->arena, controller->encoded_rb_storage);
+    audio_arena_free(controller->arena, controller->encoded_rb_struct);
+    audio_decoder_destroy(controller->decoder);
+
+    // 销毁附加混音流（流 0 即播放缓冲区）
+    for (int i = 1; i < PLAYBACK_MAX_STREAMS; i++) {
+        if (controller->streams[i].rb) {
+            ring_buffer_destroy(controller->streams[i].rb);
+        }
+    }
+    audio_arena_free(controller->arena, controller->mix_out);
+    audio_arena_free(controller->arena, controller->mix_acc);
 
     // 销毁播放缓冲区
     if (controller->playback_rb) {
         ring_buffer_destroy(controller->playback_rb);
     }
 
-    // 销毁回采缓冲区
-    if (controller->reference_rb) {
-        ring_buffer_destroy(controller->reference_rb);
+    if (controller->duplex_rb) {
+        ring_buffer_destroy(controller->duplex_rb);
     }
+    audio_resampler_destroy(controller->resampler);
+
+    // 销毁回采对齐
+    aec_reference_destroy(controller->reference);
 
     // 释放控制器内存
-    free(controller);
+    audio_arena_free(controller->arena, controller);
     ESP_LOGI(TAG, "播放控制器已销毁");
 }
 
+/**
+ * @brief 累加创建播放控制器所需的内存占用
+ * 
+ * 包括控制器上下文、播放/回采缓冲区、淡出缓冲区、命令同步对象、常驻播放任务，
+ * 以及启用时的全双工输出缓冲区、重采样器、附加混音流、压缩数据缓冲区和解码器（不含编解码库内部状态）。
+ * 
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void playback_controller_get_footprint(const playback_controller_config_t *config,
+                                       audio_arena_footprint_t *fp)
+{
+    if (!config) {
+        return;
+    }
+
+    ring_buffer_config_t playback_rb_cfg;
+    aec_reference_config_t reference_cfg;
+    playback_controller_ring_configs(config, &playback_rb_cfg, &reference_cfg);
+
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(playback_controller_t));
+    ring_buffer_get_footprint(&playback_rb_cfg, fp);
+    aec_reference_get_footprint(&reference_cfg, fp);
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, config->frame_samples * sizeof(int16_t));
+    audio_arena_footprint_add_semaphore(fp);
+    audio_arena_footprint_add_semaphore(fp);
+    audio_arena_footprint_add_task(fp, AUDIO_ARENA_INTERNAL, playback_controller_stack_size(config));
+
+    if (config->full_duplex) {
+        ring_buffer_config_t duplex_cfg;
+        playback_controller_duplex_config(config, &duplex_cfg);
+        ring_buffer_get_footprint(&duplex_cfg, fp);
+    }
+
+    if (config->format_convert) {
+        audio_resampler_config_t resampler_cfg;
+        playback_controller_resampler_config(config, &resampler_cfg);
+        audio_resampler_get_footprint(&resampler_cfg, fp);
+    }
+
+    if (playback_controller_mixing(config)) {
+        for (int i = 1; i < PLAYBACK_MAX_STREAMS; i++) {
+            if (config->streams[i].buffer_samples > 0) {
+                ring_buffer_config_t stream_cfg;
+                playback_controller_stream_config(config, i, &stream_cfg);
+                ring_buffer_get_footprint(&stream_cfg, fp);
+            }
+        }
+        audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, config->frame_samples * sizeof(int32_t));
+        audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, config->frame_samples * sizeof(int16_t));
+    }
+
+    if (config->encoded_buffer_bytes > 0) {
+        audio_decoder_config_t decoder_cfg;
+        playback_controller_decoder_config(config, &decoder_cfg);
+        audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(StaticRingbuffer_t));
+        audio_arena_footprint_add(fp, AUDIO_ARENA_PSRAM, config->encoded_buffer_bytes);
+        audio_decoder_get_footprint(&decoder_cfg, fp);
+    }
+}
+
 /**
  * @brief 启动播放控制器
  * 
- * 创建并启动播放任务
+ * 通知常驻播放任务开始播放，不等待应答，下一帧即开始输出
  * 
  * @param controller 播放控制器句柄
  * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
@@ -186,22 +1063,17 @@ esp_err_t playback_controller_start(playback_controller_handle_t controller)
 
     ESP_LOGI(TAG, "▶️ 启动播放器");
     controller->running = true;
-
-    // 创建播放任务，固定到 Core 1
-    // 任务优先级7，栈大小5KB
-    xTaskCreatePinnedToCore(playback_task, "playback", 5 * 1024, controller, 
-                            7, &controller->playback_task, 1);
-
-    return ESP_OK;
+    return playback_send_cmd(controller, PLAYBACK_CMD_START, 0);
 }
 
 /**
  * @brief 停止播放控制器
  * 
- * 停止播放任务
+ * 通知播放任务淡出当前帧后停止并等待应答，最多延迟一帧（一次 I2S DMA 写入）。
+ * 播放缓冲区中剩余的数据保留，如需丢弃请调用 playback_controller_clear()。
  * 
  * @param controller 播放控制器句柄
- * @return ESP_OK 成功
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 播放任务应答超时
  */
 esp_err_t playback_controller_stop(playback_controller_handle_t controller)
 {
@@ -211,13 +1083,47 @@ esp_err_t playback_controller_stop(playback_controller_handle_t controller)
 
     ESP_LOGI(TAG, "⏹️ 停止播放器");
     controller->running = false;
+    return playback_send_cmd(controller, PLAYBACK_CMD_STOP, 0);
+}
 
-    // 等待任务结束
-    if (controller->playback_task) {
-        vTaskDelay(pdMS_TO_TICKS(300));
-        controller->playback_task = NULL;
+/**
+ * @brief 打断播放
+ * 
+ * 通知播放任务在 fade_ms 内淡出后停止，并丢弃所有混音流中待播放的数据（PCM 与压缩数据）。
+ * 与 stop + clear 不同，回采对齐不清空：已写入 I2S 的音频仍会播出，
+ * 其回采按播出时刻继续提供给 AEC，打断瞬间用户说话时回声仍可被消除。
+ * 
+ * @param controller 播放控制器句柄
+ * @param fade_ms 淡出时长（毫秒，0 表示一帧）
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 播放任务应答超时
+ */
+esp_err_t playback_controller_interrupt(playback_controller_handle_t controller, uint32_t fade_ms)
+{
+    if (!controller) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "✋ 打断播放（淡出 %u ms）", (unsigned)fade_ms);
+    controller->running = false;
+    return playback_send_cmd(controller, PLAYBACK_CMD_INTERRUPT, fade_ms);
+}
+
+/**
+ * @brief 设置外部闪避
+ * 
+ * 混音模式下所有流在下一帧内渐变到闪避增益；只有主流时按帧切换到闪避音量。
+ * 
+ * @param controller 播放控制器句柄
+ * @param ducked true 闪避，false 恢复
+ * @return ESP_OK 成功
+ */
+esp_err_t playback_controller_set_ducked(playback_controller_handle_t controller, bool ducked)
+{
+    if (!controller) {
+        return ESP_ERR_INVALID_ARG;
     }
 
+    controller->ducked = ducked;
     return ESP_OK;
 }
 
@@ -225,11 +1131,18 @@ esp_err_t playback_controller_stop(playback_controller_handle_t controller)
  * @brief 写入音频数据到播放缓冲区
  * 
  * 将PCM音频数据写入播放缓冲区，供播放任务读取
+ * 播放缓冲区为无锁 SPSC 模式，同一时刻只能有一个任务调用本接口
  * 
  * @param controller 播放控制器句柄
  * @param pcm_data PCM音频数据指针
  * @param sample_count 采样点数
- * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_NO_MEM: 缓冲区已满，数据被拒绝（REJECT 策略）
+ *   - ESP_ERR_TIMEOUT: 等待空间超时，数据被拒绝（BLOCK 策略）
+ * 
+ * @note 返回错误时本次数据整块未写入，调用方可稍后重试（背压）
  */
 esp_err_t playback_controller_write(playback_controller_handle_t controller, 
                                      const int16_t *pcm_data, size_t sample_count)
@@ -238,18 +1151,242 @@ esp_err_t playback_controller_write(playback_controller_handle_t controller,
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 将音频数据写入播放缓冲区
-    ring_buffer_write(controller->playback_rb, pcm_data, sample_count);
+    // 将音频数据写入播放缓冲区（按溢出策略覆盖/拒绝/阻塞）
+    if (ring_buffer_write(controller->playback_rb, pcm_data, sample_count) == 0) {
+        return controller->overrun_policy == RING_BUFFER_OVERRUN_BLOCK ? ESP_ERR_TIMEOUT : ESP_ERR_NO_MEM;
+    }
+
+    if (audio_trace_is_enabled()) {
+        size_t write_pos = 0;
+        ring_buffer_get_positions(controller->playback_rb, &write_pos, NULL);
+        audio_trace_mark(AUDIO_TRACE_PLAY_WRITE, (uint32_t)write_pos);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 按指定格式写入 PCM
+ * 
+ * 按转换后的采样数一次预留播放缓冲区空间（遵循溢出策略），重采样/下混结果直接写入
+ * 预留区间（回绕时分两段），不经过中间缓冲区。预留失败时重采样状态不变，可原样重试。
+ * 
+ * @param controller 播放控制器句柄
+ * @param pcm_data PCM 数据（多声道交织）
+ * @param frames 帧数
+ * @param format 输入格式
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_NOT_SUPPORTED: 未启用格式转换，或采样率/声道数不支持
+ *   - ESP_ERR_NO_MEM: 缓冲区已满（REJECT 策略）
+ *   - ESP_ERR_TIMEOUT: 等待空间超时（BLOCK 策略）
+ *   - ESP_ERR_INVALID_SIZE: 转换后超出播放缓冲区容量
+ */
+esp_err_t playback_controller_write_format(playback_controller_handle_t controller,
+                                           const int16_t *pcm_data, size_t frames,
+                                           const playback_pcm_format_t *format)
+{
+    if (!controller || !pcm_data || frames == 0 || !format) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 已是输出格式：直接写入
+    if (format->sample_rate == controller->sample_rate && format->channels == 1) {
+        return playback_controller_write(controller, pcm_data, frames);
+    }
+    if (!controller->resampler) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    esp_err_t ret = audio_resampler_set_input(controller->resampler, format->sample_rate, format->channels);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // 输入不足一个输出采样（如 8kHz 只送 1 帧）：只收入重采样历史
+    size_t total = audio_resampler_get_output_size(controller->resampler, frames);
+    if (total == 0) {
+        audio_resampler_process(controller->resampler, pcm_data, frames, NULL, NULL, 0);
+        return ESP_OK;
+    }
+
+    ring_buffer_span_t span = {0};
+    ret = ring_buffer_acquire_write(controller->playback_rb, total, &span);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t used = 0;
+    size_t done = audio_resampler_process(controller->resampler, pcm_data, frames, &used,
+                                          span.data[0], span.len[0]);
+    if (span.len[1] > 0) {
+        const int16_t *rest = pcm_data + used * format->channels;
+        done += audio_resampler_process(controller->resampler, rest, frames - used, NULL,
+                                        span.data[1], span.len[1]);
+    }
+    ring_buffer_commit_write(controller->playback_rb, done);
+
+    if (audio_trace_is_enabled()) {
+        size_t write_pos = 0;
+        ring_buffer_get_positions(controller->playback_rb, &write_pos, NULL);
+        audio_trace_mark(AUDIO_TRACE_PLAY_WRITE, (uint32_t)write_pos);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 写入音频数据到指定混音流
+ * 
+ * 附加流写入后唤醒可能阻塞在主流上的播放任务（混音时播放任务只在主流上等待）。
+ * 
+ * @param controller 播放控制器句柄
+ * @param stream 流编号
+ * @param pcm_data PCM 音频数据指针
+ * @param sample_count 采样点数
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_NOT_FOUND: 流未启用
+ *   - ESP_ERR_NO_MEM: 缓冲区已满，数据被拒绝（REJECT 策略）
+ *   - ESP_ERR_TIMEOUT: 等待空间超时，数据被拒绝（BLOCK 策略）
+ */
+esp_err_t playback_controller_write_stream(playback_controller_handle_t controller, uint8_t stream,
+                                           const int16_t *pcm_data, size_t sample_count)
+{
+    if (!controller || !pcm_data || sample_count == 0 || stream >= PLAYBACK_MAX_STREAMS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (stream == 0) {
+        return playback_controller_write(controller, pcm_data, sample_count);
+    }
+    if (!controller->streams[stream].rb) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (ring_buffer_write(controller->streams[stream].rb, pcm_data, sample_count) == 0) {
+        return controller->overrun_policy == RING_BUFFER_OVERRUN_BLOCK ? ESP_ERR_TIMEOUT : ESP_ERR_NO_MEM;
+    }
+    ring_buffer_wake_reader(controller->playback_rb);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置混音流增益
+ * 
+ * 播放任务在下一帧读取并在该帧内渐变到新增益。
+ * 
+ * @param controller 播放控制器句柄
+ * @param stream 流编号
+ * @param gain 增益（0-100）
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_NOT_FOUND 流未启用
+ */
+esp_err_t playback_controller_set_stream_gain(playback_controller_handle_t controller, uint8_t stream,
+                                              uint8_t gain)
+{
+    if (!controller || stream >= PLAYBACK_MAX_STREAMS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!controller->streams[stream].rb) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    controller->streams[stream].gain = gain > 100 ? 100 : gain;
+    return ESP_OK;
+}
+
+/**
+ * @brief 清空指定混音流
+ * 
+ * 只丢弃该流待播放的数据，回采与其他流不受影响（如只打断提示音而保留 TTS）。
+ * 
+ * @param controller 播放控制器句柄
+ * @param stream 流编号
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_NOT_FOUND 流未启用；
+ *         ESP_ERR_TIMEOUT 播放任务应答超时
+ */
+esp_err_t playback_controller_clear_stream(playback_controller_handle_t controller, uint8_t stream)
+{
+    if (!controller || stream >= PLAYBACK_MAX_STREAMS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!controller->streams[stream].rb) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    return playback_send_cmd(controller, PLAYBACK_CMD_FLUSH_STREAM(stream), 0);
+}
+
+/**
+ * @brief 获取指定混音流缓冲区可用空间
+ * 
+ * @param controller 播放控制器句柄
+ * @param stream 流编号
+ * @return 可用空间（样本数）
+ */
+size_t playback_controller_get_stream_free_space(playback_controller_handle_t controller, uint8_t stream)
+{
+    if (!controller || stream >= PLAYBACK_MAX_STREAMS || !controller->streams[stream].rb) {
+        return 0;
+    }
+
+    ring_buffer_handle_t rb = controller->streams[stream].rb;
+    size_t total_size = ring_buffer_get_size(rb);
+    size_t used_size = ring_buffer_available(rb);
+    return (total_size > used_size) ? (total_size - used_size) : 0;
+}
+
+/**
+ * @brief 写入压缩音频数据
+ * 
+ * 条目头与数据直接写入压缩缓冲区申请到的空间（一次拷贝），
+ * 写入后唤醒可能阻塞在播放缓冲区上的播放任务。
+ * 
+ * @param controller 播放控制器句柄
+ * @param codec 压缩格式
+ * @param data 压缩数据
+ * @param len 字节数
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_NOT_SUPPORTED: 未启用压缩播放
+ *   - ESP_ERR_NO_MEM: 缓冲区已满（OVERWRITE/REJECT 策略）
+ *   - ESP_ERR_TIMEOUT: 等待空间超时（BLOCK 策略）
+ */
+esp_err_t playback_controller_write_encoded(playback_controller_handle_t controller,
+                                            audio_decoder_codec_t codec,
+                                            const uint8_t *data, size_t len)
+{
+    if (!controller || !data || len == 0 || codec >= AUDIO_DECODER_CODEC_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!controller->encoded_rb) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    bool block = controller->overrun_policy == RING_BUFFER_OVERRUN_BLOCK;
+    TickType_t wait = block ? pdMS_TO_TICKS(controller->write_timeout_ms) : 0;
+    playback_encoded_hdr_t hdr = { .codec = (uint32_t)codec };
+    void *item = NULL;
+
+    if (xRingbufferSendAcquire(controller->encoded_rb, &item, sizeof(hdr) + len, wait) != pdTRUE || !item) {
+        return block ? ESP_ERR_TIMEOUT : ESP_ERR_NO_MEM;
+    }
+    memcpy(item, &hdr, sizeof(hdr));
+    memcpy((uint8_t *)item + sizeof(hdr), data, len);
+    xRingbufferSendComplete(controller->encoded_rb, item);
+
+    ring_buffer_wake_reader(controller->playback_rb);
     return ESP_OK;
 }
 
 /**
  * @brief 清空播放缓冲区
  * 
- * 清空播放缓冲区和回采缓冲区中的所有数据
+ * 清空播放缓冲区、回采缓冲区以及压缩数据缓冲区中的所有数据。
+ * 由播放任务（消费者）执行清空并应答，返回时正在播放的帧已释放，不会残留旧数据。
  * 
  * @param controller 播放控制器句柄
- * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效，ESP_ERR_TIMEOUT 播放任务应答超时
  */
 esp_err_t playback_controller_clear(playback_controller_handle_t controller)
 {
@@ -257,14 +1394,10 @@ esp_err_t playback_controller_clear(playback_controller_handle_t controller)
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 清空播放缓冲区
-    esp_err_t ret = ring_buffer_clear(controller->playback_rb);
+    esp_err_t ret = playback_send_cmd(controller, PLAYBACK_CMD_FLUSH, 0);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "🗑️ 已清空播放缓冲区");
     }
-
-    // 清空回采缓冲区
-    ring_buffer_clear(controller->reference_rb);
     return ret;
 }
 
@@ -301,15 +1434,102 @@ size_t playback_controller_get_free_space(playback_controller_handle_t controlle
 }
 
 /**
- * @brief 获取回采缓冲区句柄
+ * @brief 取出一帧待输出的音频（全双工）
  * 
- * 返回回采缓冲区句柄，供AFE读取回采的音频数据
+ * 由锁步任务在每次写入 I2S TX 前调用：先执行播放任务转交的清空请求
+ * （丢弃截止位置之前的输出并清空回采，本任务是两者唯一的消费者/生产者），
+ * 再非阻塞取出至多 count 个采样，数据不足时由调用方补静音以保持锁步。
  * 
  * @param controller 播放控制器句柄
- * @return 回采缓冲区句柄，参数无效返回NULL
+ * @param out 输出缓冲区
+ * @param count 期望采样点数
+ * @param volume 输出当前生效音量（与播放任务直接写 I2S 时相同，含主流增益与闪避）
+ * @return 实际取出的采样点数
  */
-ring_buffer_handle_t playback_controller_get_reference_buffer(playback_controller_handle_t controller)
+size_t playback_controller_pull(playback_controller_handle_t controller, int16_t *out, size_t count,
+                                uint8_t *volume)
 {
-    return controller ? controller->reference_rb : NULL;
+    if (!controller || !controller->duplex_rb || !out || count == 0) {
+        return 0;
+    }
+
+    if (atomic_exchange_explicit(&controller->duplex_flush, false, memory_order_acquire)) {
+        size_t pos = atomic_load_explicit(&controller->duplex_flush_pos, memory_order_relaxed);
+        size_t read = 0;
+        ring_buffer_get_positions(controller->duplex_rb, NULL, &read);
+        // 有符号距离：读端已越过截止位置时无需丢弃，避免无符号下溢后丢掉清空之后写入的数据
+        ptrdiff_t behind = (ptrdiff_t)(pos - read);
+        ring_buffer_span_t span = {0};
+        if (behind > 0 && (size_t)behind <= ring_buffer_available(controller->duplex_rb) &&
+            ring_buffer_peek_read(controller->duplex_rb, (size_t)behind, &span, 0) == ESP_OK) {
+            ring_buffer_release_read(controller->duplex_rb, span.total);
+        }
+        aec_reference_clear(controller->reference);
+    }
+
+    if (volume) {
+        *volume = controller->out_volume;
+    }
+    return ring_buffer_read(controller->duplex_rb, out, count, 0);
 }
 
+/**
+ * @brief 获取回采对齐句柄
+ * 
+ * 返回回采对齐句柄，供AFE按麦克风采集时刻读取回采的音频数据
+ * 
+ * @param controller 播放控制器句柄
+ * @return 回采对齐句柄，参数无效返回NULL
+ */
+aec_reference_handle_t playback_controller_get_reference(playback_controller_handle_t controller)
+{
+    return controller ? controller->reference : NULL;
+}
+
+
+/**
+ * @brief 获取播放/回采缓冲区运行统计
+ * 
+ * @param controller 播放控制器句柄
+ * @param playback 输出播放缓冲区统计，NULL 表示不需要
+ * @param reference 输出回采缓冲区统计，NULL 表示不需要
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t playback_controller_get_stats(playback_controller_handle_t controller,
+                                        ring_buffer_stats_t *playback,
+                                        ring_buffer_stats_t *reference)
+{
+    if (!controller) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (playback) {
+        ring_buffer_get_stats(controller->playback_rb, playback);
+    }
+    if (reference) {
+        aec_reference_get_stats(controller->reference, reference, NULL);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取常驻播放任务信息
+ *
+ * @param controller 播放控制器句柄
+ * @param info 输出任务信息（控制器无效时清零）
+ */
+void playback_controller_get_task_info(playback_controller_handle_t controller,
+                                       audio_arena_task_info_t *info)
+{
+    if (!info) {
+        return;
+    }
+    memset(info, 0, sizeof(*info));
+    if (!controller) {
+        return;
+    }
+    info->handle = controller->playback_task;
+    info->stack_bytes = controller->task_stack_bytes;
+    info->stack_psram = false;
+    info->is_static = controller->arena != NULL;
+}
@@ -11,7 +11,10 @@
 #include "ring_buffer.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "freertos/task.h"
 #include <string.h>
+#include <stdatomic.h>
+#include <stddef.h>
 
 static const char *TAG = "RING_BUFFER";
 
@@ -21,19 +24,180 @@ static const char *TAG = "RING_BUFFER";
  * 线程安全的环形缓冲区实现，用于音频数据的临时存储。
  * 特性：
  * - 使用 PSRAM 存储大容量音频数据
- * - 支持多线程并发访问（互斥锁保护）
+ * - 互斥锁模式：支持多线程并发访问（互斥锁保护）
+ * - 无锁模式：单生产者/单消费者，head/tail 为单调递增的原子计数，
+ *   容量为 2 的幂，读写各最多两次 memcpy
  * - 可选的阻塞读取机制（信号量）
- * - 缓冲区满时自动覆盖旧数据
+ * - 缓冲区满时按策略覆盖旧数据、拒绝写入或阻塞等待空间
+ * - 运行统计使用原子计数，读写路径上不打印日志
  */
 typedef struct ring_buffer_s {
+    audio_arena_handle_t arena;   ///< 所属内存区（NULL 表示堆分配）
     int16_t *buffer;              ///< 数据缓冲区（PSRAM），存储音频采样点
     size_t size;                  ///< 缓冲区大小（采样点数）
-    volatile size_t write_pos;    ///< 写位置索引（生产者）
-    volatile size_t read_pos;     ///< 读位置索引（消费者）
-    SemaphoreHandle_t mutex;      ///< 互斥锁，保护读写位置的原子性
+    size_t mask;                  ///< 无锁模式下的索引掩码（size - 1）
+    bool lock_free;               ///< 是否为无锁 SPSC 模式
+    volatile size_t write_pos;    ///< 写位置索引（生产者，互斥锁模式）
+    volatile size_t read_pos;     ///< 读位置索引（消费者，互斥锁模式）
+    atomic_size_t head;           ///< 累计写入量（仅生产者推进，无锁模式）
+    atomic_size_t tail;           ///< 累计读取量（消费者推进，覆盖/清空时 CAS 推进，无锁模式）
+    size_t write_reserved;        ///< 已预留未提交的写入量（零拷贝写入，仅生产者访问）
+    size_t peek_tail;             ///< 查看区间起点（零拷贝读取，仅消费者访问）
+    size_t peek_len;              ///< 查看区间长度（零拷贝读取，仅消费者访问）
+    SemaphoreHandle_t mutex;      ///< 互斥锁，保护读写位置的原子性（仅互斥锁模式）
     SemaphoreHandle_t data_sem;   ///< 数据可用信号量（可选），用于阻塞读取
+    SemaphoreHandle_t space_sem;  ///< 空间可用信号量（仅 BLOCK 策略），消费者释放空间后触发
+    ring_buffer_overrun_policy_t overrun_policy;  ///< 缓冲区满时的写入策略
+    uint32_t write_timeout_ms;    ///< BLOCK 策略下的最长等待时间（毫秒）
+
+    /* 运行统计（原子计数，任意任务可读） */
+    atomic_uint overrun_samples;  ///< 被覆盖的最旧采样点数
+    atomic_uint rejected_samples; ///< 被拒绝写入的采样点数
+    atomic_uint underrun_reads;   ///< 数据不足的读取次数
+    atomic_uint lock_timeouts;    ///< 获取互斥锁超时次数
+    atomic_size_t high_water;     ///< 历史最高占用量
 } ring_buffer_t;
 
+/**
+ * @brief 向上取整到 2 的幂
+ */
+static size_t ring_buffer_round_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/**
+ * @brief 将 n 个采样点复制到环形存储的 offset 处（自动处理回绕，最多两次 memcpy）
+ */
+static inline void ring_buffer_copy_in(ring_buffer_t *rb, size_t offset, const int16_t *data, size_t n)
+{
+    size_t first = rb->size - offset;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(rb->buffer + offset, data, first * sizeof(int16_t));
+    if (n > first) {
+        memcpy(rb->buffer, data + first, (n - first) * sizeof(int16_t));
+    }
+}
+
+/**
+ * @brief 从环形存储的 offset 处复制 n 个采样点（自动处理回绕，最多两次 memcpy）
+ */
+static inline void ring_buffer_copy_out(const ring_buffer_t *rb, size_t offset, int16_t *out, size_t n)
+{
+    size_t first = rb->size - offset;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(out, rb->buffer + offset, first * sizeof(int16_t));
+    if (n > first) {
+        memcpy(out + first, rb->buffer, (n - first) * sizeof(int16_t));
+    }
+}
+
+/**
+ * @brief 将从 offset 开始的 n 个采样点描述为最多两段连续区间
+ */
+static inline void ring_buffer_fill_span(ring_buffer_t *rb, size_t offset, size_t n, ring_buffer_span_t *span)
+{
+    size_t first = rb->size - offset;
+    if (first > n) {
+        first = n;
+    }
+    span->data[0] = rb->buffer + offset;
+    span->len[0] = first;
+    span->data[1] = (n > first) ? rb->buffer : NULL;
+    span->len[1] = n - first;
+    span->total = n;
+}
+
+/**
+ * @brief 累加统计计数（relaxed 原子操作，不引入额外同步）
+ */
+static inline void ring_buffer_stat_add(atomic_uint *counter, size_t n)
+{
+    atomic_fetch_add_explicit(counter, (unsigned)n, memory_order_relaxed);
+}
+
+/**
+ * @brief 更新高水位（reset 可能在其他任务并发执行，使用 CAS）
+ */
+static inline void ring_buffer_note_level(ring_buffer_t *rb, size_t used)
+{
+    size_t hw = atomic_load_explicit(&rb->high_water, memory_order_relaxed);
+    while (used > hw &&
+           !atomic_compare_exchange_weak_explicit(&rb->high_water, &hw, used,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 消费者释放空间后唤醒阻塞中的生产者（仅 BLOCK 策略）
+ */
+static inline void ring_buffer_notify_space(ring_buffer_t *rb)
+{
+    if (rb->space_sem) {
+        xSemaphoreGive(rb->space_sem);
+    }
+}
+
+/**
+ * @brief 写入空间不足时等待消费者释放空间
+ * 
+ * @param start 本次写入开始等待的时刻
+ * @return true 已等待，调用方应重新检查空间；false 非 BLOCK 策略或已超时，应拒绝写入
+ */
+static bool ring_buffer_wait_space(ring_buffer_t *rb, TickType_t start)
+{
+    if (rb->overrun_policy != RING_BUFFER_OVERRUN_BLOCK) {
+        return false;
+    }
+
+    TickType_t wait = pdMS_TO_TICKS(rb->write_timeout_ms);
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (elapsed >= wait) {
+        return false;
+    }
+
+    xSemaphoreTake(rb->space_sem, wait - elapsed);
+    return true;
+}
+
+/**
+ * @brief 互斥锁模式下计算可读数据量（调用方已持有互斥锁）
+ */
+static inline size_t ring_buffer_used_locked(const ring_buffer_t *rb)
+{
+    return (rb->write_pos >= rb->read_pos)
+           ? (rb->write_pos - rb->read_pos)
+           : (rb->size - rb->read_pos + rb->write_pos);
+}
+
+/**
+ * @brief 无锁模式下计算可读数据量
+ */
+static inline size_t ring_buffer_used_lock_free(const ring_buffer_t *rb, size_t tail)
+{
+    size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t used = head - tail;
+    return (used > rb->size) ? rb->size : used;
+}
+
+/**
+ * @brief 无锁模式下的剩余空间（仅生产者调用时结果不会变小）
+ */
+static inline size_t ring_buffer_free_lock_free(const ring_buffer_t *rb)
+{
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    return rb->size - ring_buffer_used_lock_free(rb, tail);
+}
+
 /**
  * @brief 创建环形缓冲区
  * 
@@ -45,67 +209,142 @@ typedef struct ring_buffer_s {
  *                 - false: 仅支持非阻塞读取
  * 
  * @return 环形缓冲区句柄，失败返回 NULL
+ */
+ring_buffer_handle_t ring_buffer_create(size_t samples, bool with_sem)
+{
+    ring_buffer_config_t config = RING_BUFFER_DEFAULT_CONFIG(samples);
+    config.with_sem = with_sem;
+    return ring_buffer_create_with_config(&config);
+}
+
+/**
+ * @brief 按配置创建环形缓冲区
+ * 
+ * @param config 配置参数
+ * @return 环形缓冲区句柄，失败返回 NULL
  * 
  * @note 失败原因可能包括：
  *       - samples == 0（无效参数）
+ *       - overrun_policy 无效
  *       - 内存不足（PSRAM 或 IRAM）
  *       - 互斥锁/信号量创建失败
+ * @note 无锁模式下容量向上取整为 2 的幂，便于用掩码代替取模
  */
-ring_buffer_handle_t ring_buffer_create(size_t samples, bool with_sem)
+ring_buffer_handle_t ring_buffer_create_with_config(const ring_buffer_config_t *config)
 {
-    if (samples == 0) {
+    if (!config || config->samples == 0) {
         ESP_LOGE(TAG, "无效的缓冲区大小");
         return NULL;
     }
+    if (config->overrun_policy > RING_BUFFER_OVERRUN_BLOCK) {
+        ESP_LOGE(TAG, "无效的溢出策略: %d", (int)config->overrun_policy);
+        return NULL;
+    }
 
-    // 分配句柄结构体（使用 IRAM）
-    ring_buffer_t *rb = (ring_buffer_t *)malloc(sizeof(ring_buffer_t));
+    // 分配句柄结构体（必须在内部 RAM：原子 CAS 不支持 PSRAM 地址）
+    ring_buffer_t *rb = (ring_buffer_t *)audio_arena_calloc(config->arena, AUDIO_ARENA_INTERNAL,
+                                                            sizeof(ring_buffer_t));
     if (!rb) {
         ESP_LOGE(TAG, "环形缓冲区句柄分配失败");
         return NULL;
     }
+    rb->arena = config->arena;
+
+    size_t samples = config->lock_free ? ring_buffer_round_pow2(config->samples) : config->samples;
 
-    // 分配缓冲区内存（优先使用 PSRAM，降低 IRAM 压力）
-    rb->buffer = (int16_t *)heap_caps_malloc(samples * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    // 分配缓冲区内存（使用 PSRAM，降低 IRAM 压力）
+    rb->buffer = (int16_t *)audio_arena_calloc(rb->arena, AUDIO_ARENA_PSRAM, samples * sizeof(int16_t));
     if (!rb->buffer) {
         ESP_LOGE(TAG, "环形缓冲区分配失败: %d samples", (int)samples);
-        free(rb);
-        return NULL;
+        goto fail;
     }
 
     // 初始化读写位置
     rb->size = samples;
+    rb->mask = samples - 1;
+    rb->lock_free = config->lock_free;
     rb->write_pos = 0;
     rb->read_pos = 0;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    rb->overrun_policy = config->overrun_policy;
+    rb->write_timeout_ms = config->write_timeout_ms;
+    atomic_init(&rb->overrun_samples, 0);
+    atomic_init(&rb->rejected_samples, 0);
+    atomic_init(&rb->underrun_reads, 0);
+    atomic_init(&rb->lock_timeouts, 0);
+    atomic_init(&rb->high_water, 0);
 
-    // 创建互斥锁（保护并发访问）
-    rb->mutex = xSemaphoreCreateMutex();
-    if (!rb->mutex) {
-        ESP_LOGE(TAG, "互斥锁创建失败");
-        heap_caps_free(rb->buffer);
-        free(rb);
-        return NULL;
+    // 创建互斥锁（保护并发访问，无锁模式不需要）
+    rb->mutex = NULL;
+    if (!rb->lock_free) {
+        rb->mutex = audio_arena_create_mutex(rb->arena);
+        if (!rb->mutex) {
+            ESP_LOGE(TAG, "互斥锁创建失败");
+            goto fail;
+        }
     }
 
     // 可选：创建数据可用信号量（用于阻塞读取）
     rb->data_sem = NULL;
-    if (with_sem) {
-        rb->data_sem = xSemaphoreCreateBinary();
+    if (config->with_sem) {
+        rb->data_sem = audio_arena_create_binary(rb->arena);
         if (!rb->data_sem) {
             ESP_LOGE(TAG, "信号量创建失败");
-            vSemaphoreDelete(rb->mutex);
-            heap_caps_free(rb->buffer);
-            free(rb);
-            return NULL;
+            goto fail;
+        }
+    }
+
+    // BLOCK 策略：创建空间可用信号量（消费者释放空间后唤醒生产者）
+    rb->space_sem = NULL;
+    if (rb->overrun_policy == RING_BUFFER_OVERRUN_BLOCK) {
+        rb->space_sem = audio_arena_create_binary(rb->arena);
+        if (!rb->space_sem) {
+            ESP_LOGE(TAG, "空间信号量创建失败");
+            goto fail;
         }
     }
 
-    ESP_LOGI(TAG, "环形缓冲区创建成功: %d samples (%.1f KB) at %s",
+    ESP_LOGI(TAG, "环形缓冲区创建成功: %d samples (%.1f KB) at %s, %s",
              (int)samples, 
              (samples * sizeof(int16_t)) / 1024.0f,
-             esp_ptr_external_ram(rb->buffer) ? "PSRAM" : "IRAM");
+             esp_ptr_external_ram(rb->buffer) ? "PSRAM" : "IRAM",
+             rb->lock_free ? "lock-free SPSC" : "mutex");
 
     return rb;
+
+fail:
+    ring_buffer_destroy(rb);
+    return NULL;
+}
+
+/**
+ * @brief 累加按配置创建环形缓冲区所需的内存占用
+ * 
+ * 与 ring_buffer_create_with_config() 的分配一一对应：句柄与同步对象在内部 RAM，
+ * 数据缓冲区在 PSRAM。
+ * 
+ * @param config 配置参数
+ * @param fp 占用统计（累加）
+ */
+void ring_buffer_get_footprint(const ring_buffer_config_t *config, audio_arena_footprint_t *fp)
+{
+    if (!config || config->samples == 0) {
+        return;
+    }
+
+    size_t samples = config->lock_free ? ring_buffer_round_pow2(config->samples) : config->samples;
+    audio_arena_footprint_add(fp, AUDIO_ARENA_INTERNAL, sizeof(ring_buffer_t));
+    audio_arena_footprint_add(fp, AUDIO_ARENA_PSRAM, samples * sizeof(int16_t));
+    if (!config->lock_free) {
+        audio_arena_footprint_add_semaphore(fp);
+    }
+    if (config->with_sem) {
+        audio_arena_footprint_add_semaphore(fp);
+    }
+    if (config->overrun_policy == RING_BUFFER_OVERRUN_BLOCK) {
+        audio_arena_footprint_add_semaphore(fp);
+    }
 }
 
 /**
@@ -131,29 +370,123 @@ void ring_buffer_destroy(ring_buffer_handle_t rb)
     if (rb->data_sem) {
         vSemaphoreDelete(rb->data_sem);
     }
-    
-    // 释放缓冲区内存
-    if (rb->buffer) {
-        heap_caps_free(rb->buffer);
+    if (rb->space_sem) {
+        vSemaphoreDelete(rb->space_sem);
     }
     
+    // 释放缓冲区内存（内存区模式下随内存区统一归还）
+    audio_arena_free(rb->arena, rb->buffer);
+    
     // 释放句柄
-    free(rb);
+    audio_arena_free(rb->arena, rb);
+}
+
+/**
+ * @brief 无锁模式下为 samples 个采样点腾出空间（仅限单一生产者）
+ * 
+ * 空间不足时通过 CAS 推进 tail 丢弃最旧数据（消费者可能同时推进，失败则重试）。
+ * 
+ * @return 被覆盖的最旧采样点数
+ */
+static size_t ring_buffer_reserve_lock_free(ring_buffer_t *rb, size_t head, size_t samples)
+{
+    size_t overrun_count = 0;
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+
+    while (head + samples - tail > rb->size) {
+        size_t new_tail = head + samples - rb->size;
+        if (atomic_compare_exchange_weak_explicit(&rb->tail, &tail, new_tail,
+                                                  memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+            overrun_count += new_tail - tail;
+            break;
+        }
+    }
+
+    return overrun_count;
+}
+
+/**
+ * @brief 无锁模式写入（仅限单一生产者）
+ * 
+ * 空间不足时先丢弃最旧数据，再拷贝新数据并发布 head。
+ * 
+ * @return 被覆盖的最旧采样点数
+ */
+static size_t ring_buffer_write_lock_free(ring_buffer_t *rb, const int16_t *data, size_t samples)
+{
+    size_t overrun_count = 0;
+
+    // 单次写入超过容量：只保留最新的 size 个采样点
+    if (samples > rb->size) {
+        overrun_count += samples - rb->size;
+        data += samples - rb->size;
+        samples = rb->size;
+    }
+
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    overrun_count += ring_buffer_reserve_lock_free(rb, head, samples);
+
+    ring_buffer_copy_in(rb, head & rb->mask, data, samples);
+
+    // 发布新数据（release 保证数据先于 head 可见）
+    atomic_store_explicit(&rb->head, head + samples, memory_order_release);
+
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    ring_buffer_note_level(rb, ring_buffer_used_lock_free(rb, tail));
+
+    return overrun_count;
+}
+
+/**
+ * @brief 互斥锁模式写入（调用方已持有互斥锁）
+ * 
+ * @return 被覆盖的最旧采样点数
+ */
+static size_t ring_buffer_write_locked(ring_buffer_t *rb, const int16_t *data, size_t samples)
+{
+    // 互斥锁模式下 write_pos == read_pos 表示空，最多容纳 size - 1 个采样点
+    const size_t capacity = rb->size - 1;
+    size_t overrun_count = 0;
+
+    if (samples > capacity) {
+        overrun_count += samples - capacity;
+        data += samples - capacity;
+        samples = capacity;
+    }
+
+    size_t used = ring_buffer_used_locked(rb);
+
+    ring_buffer_copy_in(rb, rb->write_pos, data, samples);
+    rb->write_pos = (rb->write_pos + samples) % rb->size;
+
+    // 检测缓冲区满：丢弃最旧数据，读指针紧跟写指针
+    if (used + samples > capacity) {
+        overrun_count += used + samples - capacity;
+        rb->read_pos = (rb->write_pos + 1) % rb->size;
+    }
+
+    ring_buffer_note_level(rb, ring_buffer_used_locked(rb));
+
+    return overrun_count;
 }
 
 /**
  * @brief 写入数据到环形缓冲区
  * 
- * 将音频采样数据写入缓冲区。如果缓冲区满，会覆盖最旧的数据。
+ * 将音频采样数据写入缓冲区。缓冲区满时按 overrun_policy 处理：
+ * - OVERWRITE: 覆盖最旧的数据，计入 overrun_samples
+ * - REJECT: 空间不足时整块拒绝，计入 rejected_samples
+ * - BLOCK: 等待消费者释放空间，最长 write_timeout_ms，超时后按 REJECT 处理
  * 
  * @param rb 环形缓冲区句柄
  * @param data 待写入的数据指针（int16_t 数组）
  * @param samples 采样点数
  * 
- * @return 实际写入的采样点数（通常等于 samples）
+ * @return 实际写入的采样点数（samples，或被拒绝/锁超时时为 0）
  * 
- * @note 线程安全：内部使用互斥锁保护
- * @note 缓冲区溢出时会打印警告日志
+ * @note 线程安全：互斥锁模式内部使用互斥锁保护；无锁模式仅允许单一生产者
+ * @note 溢出只更新统计计数，不打印日志（避免在音频路径上引入延迟）
  * @note 写入后会触发 data_sem 信号量（如果存在）
  */
 size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t samples)
@@ -162,32 +495,44 @@ size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t sa
         return 0;
     }
 
-    // 获取互斥锁（超时 10ms）
-    if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return 0;
-    }
-
+    const bool keep_newest = (rb->overrun_policy == RING_BUFFER_OVERRUN_OVERWRITE);
+    const size_t capacity = rb->lock_free ? rb->size : rb->size - 1;
+    TickType_t start = xTaskGetTickCount();
     size_t overrun_count = 0;  // 记录被覆盖的样本数
 
-    // 逐个写入采样点
-    for (size_t i = 0; i < samples; i++) {
-        rb->buffer[rb->write_pos] = data[i];
-        rb->write_pos = (rb->write_pos + 1) % rb->size;
+    if (!keep_newest && samples > capacity) {
+        goto reject;
+    }
 
-        // 检测缓冲区满：写指针追上读指针
-        if (rb->write_pos == rb->read_pos) {
-            rb->read_pos = (rb->read_pos + 1) % rb->size;  // 丢弃最旧数据
-            overrun_count++;
+    if (rb->lock_free) {
+        // 单一生产者：检查后剩余空间只会变大，无需重复确认
+        while (!keep_newest && ring_buffer_free_lock_free(rb) < samples) {
+            if (!ring_buffer_wait_space(rb, start)) {
+                goto reject;
+            }
         }
+        overrun_count = ring_buffer_write_lock_free(rb, data, samples);
+    } else {
+        while (true) {
+            // 获取互斥锁（超时 10ms）
+            if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+                ring_buffer_stat_add(&rb->lock_timeouts, 1);
+                return 0;
+            }
+            if (keep_newest || capacity - ring_buffer_used_locked(rb) >= samples) {
+                break;
+            }
+            xSemaphoreGive(rb->mutex);
+            if (!ring_buffer_wait_space(rb, start)) {
+                goto reject;
+            }
+        }
+        overrun_count = ring_buffer_write_locked(rb, data, samples);
+        xSemaphoreGive(rb->mutex);
     }
 
-    xSemaphoreGive(rb->mutex);
-
-    // 缓冲区溢出警告（假设 16kHz 采样率）
     if (overrun_count > 0) {
-        ESP_LOGW(TAG, "⚠️ 缓冲区溢出！丢弃 %u 样本 (%.1f ms)", 
-                 (unsigned)overrun_count, 
-                 (float)overrun_count / 16.0f);
+        ring_buffer_stat_add(&rb->overrun_samples, overrun_count);
     }
 
     // 通知有数据可读（触发阻塞读取）
@@ -196,6 +541,38 @@ size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t sa
     }
 
     return samples;
+
+reject:
+    ring_buffer_stat_add(&rb->rejected_samples, samples);
+    return 0;
+}
+
+/**
+ * @brief 无锁模式读取（仅限单一消费者）
+ * 
+ * 先拷贝再以 CAS 推进 tail；若期间生产者因覆盖推进了 tail，
+ * 说明拷贝的数据可能已被改写，丢弃后重新读取。
+ */
+static size_t ring_buffer_read_lock_free(ring_buffer_t *rb, int16_t *out, size_t samples)
+{
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+
+    while (true) {
+        size_t avail = ring_buffer_used_lock_free(rb, tail);
+        size_t n = (samples > avail) ? avail : samples;
+        if (n == 0) {
+            return 0;
+        }
+
+        ring_buffer_copy_out(rb, tail & rb->mask, out, n);
+
+        if (atomic_compare_exchange_strong_explicit(&rb->tail, &tail, tail + n,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            return n;
+        }
+        // CAS 失败时 tail 已更新为最新值，重新读取
+    }
 }
 
 /**
@@ -212,8 +589,9 @@ size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t sa
  * 
  * @return 实际读取的采样点数（可能小于 samples）
  * 
- * @note 线程安全：内部使用互斥锁保护
+ * @note 线程安全：互斥锁模式内部使用互斥锁保护；无锁模式仅允许单一消费者
  * @note 如果缓冲区为空且 timeout_ms > 0，会阻塞等待新数据
+ * @note 读取量不足 samples 时计入 underrun_reads
  */
 size_t ring_buffer_read(ring_buffer_handle_t rb, int16_t *out, size_t samples, uint32_t timeout_ms)
 {
@@ -222,34 +600,220 @@ size_t ring_buffer_read(ring_buffer_handle_t rb, int16_t *out, size_t samples, u
     }
 
     // 如果缓冲区为空且有信号量，等待数据
-    if (rb->read_pos == rb->write_pos && rb->data_sem && timeout_ms > 0) {
+    if (rb->data_sem && timeout_ms > 0 && ring_buffer_available(rb) == 0) {
         xSemaphoreTake(rb->data_sem, pdMS_TO_TICKS(timeout_ms));
     }
 
-    // 获取互斥锁（超时 10ms）
-    if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return 0;
+    size_t n;
+    if (rb->lock_free) {
+        n = ring_buffer_read_lock_free(rb, out, samples);
+    } else {
+        // 获取互斥锁（超时 10ms）
+        if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+            ring_buffer_stat_add(&rb->lock_timeouts, 1);
+            return 0;
+        }
+
+        // 限制读取量为可用数据量
+        size_t avail = ring_buffer_used_locked(rb);
+        n = (samples > avail) ? avail : samples;
+
+        // 读取数据（回绕时分两段拷贝）
+        ring_buffer_copy_out(rb, rb->read_pos, out, n);
+        rb->read_pos = (rb->read_pos + n) % rb->size;
+
+        xSemaphoreGive(rb->mutex);
     }
 
-    // 计算可用数据量
-    size_t avail = (rb->write_pos >= rb->read_pos)
-                   ? (rb->write_pos - rb->read_pos)
-                   : (rb->size - rb->read_pos + rb->write_pos);
+    if (n < samples) {
+        ring_buffer_stat_add(&rb->underrun_reads, 1);
+    }
+    if (n > 0) {
+        ring_buffer_notify_space(rb);
+    }
 
-    // 限制读取量为可用数据量
-    if (samples > avail) {
-        samples = avail;
+    return n;
+}
+
+/**
+ * @brief 预留写入空间（零拷贝写入）
+ * 
+ * 在缓冲区内预留 samples 个采样点的连续区间（回绕时两段），
+ * 生产者直接写入后调用 ring_buffer_commit_write() 发布。
+ * 
+ * @param rb 环形缓冲区句柄（无锁模式）
+ * @param samples 预留采样点数
+ * @param span 输出区间
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_NOT_SUPPORTED: 互斥锁模式不支持零拷贝访问
+ *   - ESP_ERR_INVALID_SIZE: samples 超过缓冲区容量
+ *   - ESP_ERR_NO_MEM: REJECT 策略下空间不足
+ *   - ESP_ERR_TIMEOUT: BLOCK 策略下等待空间超时
+ * 
+ * @note 仅允许单一生产者调用；空间不足时与 ring_buffer_write() 一样按 overrun_policy 处理
+ */
+esp_err_t ring_buffer_acquire_write(ring_buffer_handle_t rb, size_t samples, ring_buffer_span_t *span)
+{
+    if (!rb || !span || samples == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!rb->lock_free) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (samples > rb->size) {
+        return ESP_ERR_INVALID_SIZE;
     }
 
-    // 读取数据
-    for (size_t i = 0; i < samples; i++) {
-        out[i] = rb->buffer[rb->read_pos];
-        rb->read_pos = (rb->read_pos + 1) % rb->size;
+    if (rb->overrun_policy != RING_BUFFER_OVERRUN_OVERWRITE) {
+        TickType_t start = xTaskGetTickCount();
+        while (ring_buffer_free_lock_free(rb) < samples) {
+            if (!ring_buffer_wait_space(rb, start)) {
+                ring_buffer_stat_add(&rb->rejected_samples, samples);
+                return (rb->overrun_policy == RING_BUFFER_OVERRUN_BLOCK) ? ESP_ERR_TIMEOUT : ESP_ERR_NO_MEM;
+            }
+        }
     }
 
-    xSemaphoreGive(rb->mutex);
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t overrun_count = ring_buffer_reserve_lock_free(rb, head, samples);
+    if (overrun_count > 0) {
+        ring_buffer_stat_add(&rb->overrun_samples, overrun_count);
+    }
 
-    return samples;
+    rb->write_reserved = samples;
+    ring_buffer_fill_span(rb, head & rb->mask, samples, span);
+    return ESP_OK;
+}
+
+/**
+ * @brief 提交已写入的预留区间
+ * 
+ * @param rb 环形缓冲区句柄
+ * @param samples 实际写入的采样点数（0 表示放弃本次预留）
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_INVALID_SIZE: 超过预留量
+ */
+esp_err_t ring_buffer_commit_write(ring_buffer_handle_t rb, size_t samples)
+{
+    if (!rb || !rb->lock_free) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (samples > rb->write_reserved) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    rb->write_reserved = 0;
+    if (samples == 0) {
+        return ESP_OK;
+    }
+
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    atomic_store_explicit(&rb->head, head + samples, memory_order_release);
+
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    ring_buffer_note_level(rb, ring_buffer_used_lock_free(rb, tail));
+
+    if (rb->data_sem) {
+        xSemaphoreGive(rb->data_sem);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 查看可读数据区间（零拷贝读取）
+ * 
+ * 返回最多 samples 个可读采样点所在的区间，不移动读指针。
+ * 消费者直接处理后调用 ring_buffer_release_read() 释放。
+ * 
+ * @param rb 环形缓冲区句柄（无锁模式）
+ * @param samples 期望的最大采样点数
+ * @param span 输出区间，total 为 0 表示当前无数据
+ * @param timeout_ms 缓冲区为空时的等待时间（需要 data_sem 信号量）
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_NOT_SUPPORTED: 互斥锁模式不支持零拷贝访问
+ * 
+ * @note 仅允许单一消费者调用；查看量不足 samples 时计入 underrun_reads
+ */
+esp_err_t ring_buffer_peek_read(ring_buffer_handle_t rb, size_t samples,
+                                ring_buffer_span_t *span, uint32_t timeout_ms)
+{
+    if (!rb || !span) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!rb->lock_free) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // 如果缓冲区为空且有信号量，等待数据
+    if (rb->data_sem && timeout_ms > 0 && ring_buffer_available(rb) == 0) {
+        xSemaphoreTake(rb->data_sem, pdMS_TO_TICKS(timeout_ms));
+    }
+
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t avail = ring_buffer_used_lock_free(rb, tail);
+    size_t n = (samples > avail) ? avail : samples;
+
+    if (n < samples) {
+        ring_buffer_stat_add(&rb->underrun_reads, 1);
+    }
+
+    rb->peek_tail = tail;
+    rb->peek_len = n;
+    ring_buffer_fill_span(rb, tail & rb->mask, n, span);
+    return ESP_OK;
+}
+
+/**
+ * @brief 释放已消费的查看区间
+ * 
+ * @param rb 环形缓冲区句柄
+ * @param samples 实际消费的采样点数
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ *   - ESP_ERR_INVALID_SIZE: 超过查看量
+ *   - ESP_ERR_INVALID_STATE: 查看期间生产者覆盖了该区间（或缓冲区被清空），
+ *                            已读取的数据可能不完整，读指针保持生产者推进后的位置
+ */
+esp_err_t ring_buffer_release_read(ring_buffer_handle_t rb, size_t samples)
+{
+    if (!rb || !rb->lock_free) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (samples > rb->peek_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t expected = rb->peek_tail;
+    size_t target = rb->peek_tail + samples;
+    rb->peek_len = 0;
+    if (samples == 0) {
+        return ESP_OK;
+    }
+
+    if (atomic_compare_exchange_strong_explicit(&rb->tail, &expected, target,
+                                                memory_order_acq_rel,
+                                                memory_order_acquire)) {
+        ring_buffer_notify_space(rb);
+        return ESP_OK;
+    }
+
+    // tail 已被生产者/清空操作推进：若仍落后于已消费位置则补齐，避免重复读取
+    while ((ptrdiff_t)(target - expected) > 0) {
+        if (atomic_compare_exchange_weak_explicit(&rb->tail, &expected, target,
+                                                  memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+            break;
+        }
+    }
+    ring_buffer_notify_space(rb);
+    return ESP_ERR_INVALID_STATE;
 }
 
 /**
@@ -260,7 +824,7 @@ size_t ring_buffer_read(ring_buffer_handle_t rb, int16_t *out, size_t samples, u
  * @param rb 环形缓冲区句柄
  * @return 可用的采样点数
  * 
- * @note 线程安全：内部使用互斥锁保护
+ * @note 线程安全：互斥锁模式内部使用互斥锁保护，无锁模式直接读取原子索引
  * @note 返回值为瞬时快照，可能在返回后立即改变
  */
 size_t ring_buffer_available(ring_buffer_handle_t rb)
@@ -269,15 +833,19 @@ size_t ring_buffer_available(ring_buffer_handle_t rb)
         return 0;
     }
 
+    if (rb->lock_free) {
+        size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+        return ring_buffer_used_lock_free(rb, tail);
+    }
+
     // 获取互斥锁（超时 10ms）
     if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        ring_buffer_stat_add(&rb->lock_timeouts, 1);
         return 0;
     }
 
     // 计算可用数据量（处理环形回绕）
-    size_t avail = (rb->write_pos >= rb->read_pos)
-                   ? (rb->write_pos - rb->read_pos)
-                   : (rb->size - rb->read_pos + rb->write_pos);
+    size_t avail = ring_buffer_used_locked(rb);
 
     xSemaphoreGive(rb->mutex);
 
@@ -295,8 +863,10 @@ size_t ring_buffer_available(ring_buffer_handle_t rb)
  *   - ESP_ERR_INVALID_ARG: rb 为 NULL
  *   - ESP_ERR_TIMEOUT: 获取互斥锁超时
  * 
- * @note 线程安全：内部使用互斥锁保护
+ * @note 线程安全：互斥锁模式内部使用互斥锁保护；
+ *       无锁模式通过 CAS 将 tail 推进到 head，可在任意任务调用
  * @note 不会清零缓冲区内存，只重置指针
+ * @note 重置后释放 space_sem，BLOCK 策略下因缓冲区满而等待的生产者立即重新检查空间
  */
 esp_err_t ring_buffer_clear(ring_buffer_handle_t rb)
 {
@@ -304,8 +874,22 @@ esp_err_t ring_buffer_clear(ring_buffer_handle_t rb)
         return ESP_ERR_INVALID_ARG;
     }
 
+    if (rb->lock_free) {
+        size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+        size_t head;
+        do {
+            head = atomic_load_explicit(&rb->head, memory_order_acquire);
+        } while (!atomic_compare_exchange_weak_explicit(&rb->tail, &tail, head,
+                                                        memory_order_acq_rel,
+                                                        memory_order_acquire));
+        // 空间已全部腾出：唤醒等待空间的生产者
+        ring_buffer_notify_space(rb);
+        return ESP_OK;
+    }
+
     // 获取互斥锁（超时 100ms）
     if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        ring_buffer_stat_add(&rb->lock_timeouts, 1);
         return ESP_ERR_TIMEOUT;
     }
 
@@ -314,10 +898,64 @@ esp_err_t ring_buffer_clear(ring_buffer_handle_t rb)
     rb->write_pos = 0;
 
     xSemaphoreGive(rb->mutex);
+    // 空间已全部腾出：唤醒等待空间的生产者
+    ring_buffer_notify_space(rb);
 
     return ESP_OK;
 }
 
+/**
+ * @brief 唤醒阻塞等待数据的消费者
+ * 
+ * 直接释放 data_sem，使等待中的读取/查看提前返回（可能读到 0 个采样）。
+ * 
+ * @param rb 环形缓冲区句柄
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: rb 为 NULL
+ *   - ESP_ERR_NOT_SUPPORTED: 未启用 data_sem
+ */
+esp_err_t ring_buffer_wake_reader(ring_buffer_handle_t rb)
+{
+    if (!rb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!rb->data_sem) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    xSemaphoreGive(rb->data_sem);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取累计写入/读取位置
+ * 
+ * 仅无锁模式维护单调递增的 head/tail，互斥锁模式的读写索引会回绕到容量内。
+ * 
+ * @param rb 环形缓冲区句柄
+ * @param written 输出累计写入量
+ * @param read 输出累计读取量
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 非无锁模式
+ */
+esp_err_t ring_buffer_get_positions(ring_buffer_handle_t rb, size_t *written, size_t *read)
+{
+    if (!rb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!rb->lock_free) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (written) {
+        *written = atomic_load_explicit(&rb->head, memory_order_acquire);
+    }
+    if (read) {
+        *read = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    }
+    return ESP_OK;
+}
+
 /**
  * @brief 获取环形缓冲区的容量
  * 
@@ -335,3 +973,56 @@ size_t ring_buffer_get_size(ring_buffer_handle_t rb)
     }
     return rb->size;
 }
+
+/**
+ * @brief 获取运行统计快照
+ * 
+ * @param rb 环形缓冲区句柄
+ * @param stats 输出统计数据
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: 参数无效
+ * 
+ * @note 只读取原子计数，不加锁，可在任意任务调用
+ */
+esp_err_t ring_buffer_get_stats(ring_buffer_handle_t rb, ring_buffer_stats_t *stats)
+{
+    if (!rb || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stats->overrun_samples = atomic_load_explicit(&rb->overrun_samples, memory_order_relaxed);
+    stats->rejected_samples = atomic_load_explicit(&rb->rejected_samples, memory_order_relaxed);
+    stats->underrun_reads = atomic_load_explicit(&rb->underrun_reads, memory_order_relaxed);
+    stats->lock_timeouts = atomic_load_explicit(&rb->lock_timeouts, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&rb->high_water, memory_order_relaxed);
+    stats->level = ring_buffer_available(rb);
+    stats->capacity = rb->lock_free ? rb->size : rb->size - 1;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 清零运行统计
+ * 
+ * @param rb 环形缓冲区句柄
+ * @return 
+ *   - ESP_OK: 成功
+ *   - ESP_ERR_INVALID_ARG: rb 为 NULL
+ * 
+ * @note 高水位重置为当前占用量，而不是 0
+ */
+esp_err_t ring_buffer_reset_stats(ring_buffer_handle_t rb)
+{
+    if (!rb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    atomic_store_explicit(&rb->overrun_samples, 0, memory_order_relaxed);
+    atomic_store_explicit(&rb->rejected_samples, 0, memory_order_relaxed);
+    atomic_store_explicit(&rb->underrun_reads, 0, memory_order_relaxed);
+    atomic_store_explicit(&rb->lock_timeouts, 0, memory_order_relaxed);
+    atomic_store_explicit(&rb->high_water, ring_buffer_available(rb), memory_order_relaxed);
+
+    return ESP_OK;
+}
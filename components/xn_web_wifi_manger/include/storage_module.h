@@ -7,6 +7,19 @@
  * @Description: WiFi 存储模块（基于 NVS 的 WiFi 列表管理接口）
  *
  * 仅负责“存 / 取 / 删”WiFi 配置，不直接操作 WiFi 连接。
+ *
+ * 条目为完整的 wifi_config_t，除 SSID / 密码外，管理层还利用其中的
+ * sta.bssid_set / sta.bssid / sta.channel / sta.threshold.authmode
+ * 记录“上次成功连接的 AP”，用于下次单信道快速重连（bssid_set 为 true 表示记录有效）。
+ *
+ * 存储布局与写入策略：
+ *  - 列表常驻 RAM，读取不访问 flash；
+ *  - 每个条目单独一个 key（"wifi_0"、"wifi_1"...），顺序单独保存为下标数组（"wifi_order"），
+ *    调整顺序只重写几个字节，条目内容变化只重写该条目；
+ *  - 修改只标记脏，延迟 commit_delay_ms 后合并成一次提交，期间的多次变化只写一次 flash；
+ *    定时器到期只通过 commit_cb 通知调用方，由其任务调用 wifi_storage_flush() 写入，
+ *    不在 esp_timer 任务中访问 flash；
+ *  - 旧版本整表 blob（"wifi_list"）在初始化时自动迁移。
  */
 
 #ifndef STORAGE_MODULE_H
@@ -18,27 +31,45 @@
 #include "esp_err.h"
 #include "esp_wifi.h"  /* 提供 wifi_config_t 类型 */
 
+/**
+ * @brief 延迟提交到期回调
+ *
+ * 在 esp_timer 任务中调用，只应通知（如 xTaskNotifyGive）执行提交的任务，
+ * 由该任务调用 wifi_storage_flush()；不要在回调中阻塞或写 flash。
+ */
+typedef void (*wifi_storage_commit_cb_t)(void);
+
 /**
  * @brief WiFi 存储模块配置
  *
- * - nvs_namespace : 使用的 NVS 命名空间（建议单独使用一个命名空间）；
- * - max_wifi_num  : 最多保存的 WiFi 条目数量（>0，按“最近成功连接优先”排序）。
+ * - nvs_namespace   : 使用的 NVS 命名空间（建议单独使用一个命名空间）；
+ * - max_wifi_num    : 最多保存的 WiFi 条目数量（>0，按“最近成功连接优先”排序）；
+ * - commit_delay_ms : 修改后延迟多久写入 flash（合并窗口）；
+ * - commit_cb       : 合并窗口到期时的通知回调（为 NULL 时不做延迟，每次修改立即写入）。
  */
 typedef struct {
     const char *nvs_namespace;  ///< NVS 命名空间名（只保存字符串指针，不拷贝）
-    uint8_t     max_wifi_num;   ///< WiFi 最大保存数量（0 时内部会强制设为 1）
+    uint8_t     max_wifi_num;   ///< WiFi 最大保存数量（0 时内部会强制设为 1，最大 WIFI_STORAGE_MAX_NUM）
+    uint32_t    commit_delay_ms; ///< 延迟提交时间（ms，0 表示每次修改立即写入）
+    wifi_storage_commit_cb_t commit_cb; ///< 延迟提交到期通知（esp_timer 任务中调用）
 } wifi_storage_config_t;
 
+/** 最多保存的条目数上限 */
+#define WIFI_STORAGE_MAX_NUM    32
+
 /**
  * @brief WiFi 存储模块默认配置
  *
  * - 命名空间： "wifi_store"
  * - 最多保存： 5 条 WiFi 配置
+ * - 延迟提交： 3 秒（需设置 commit_cb 才生效）
  */
 #define WIFI_STORAGE_DEFAULT_CONFIG()        \
     (wifi_storage_config_t){                 \
         .nvs_namespace = "wifi_store",       \
         .max_wifi_num  = 5,                  \
+        .commit_delay_ms = 3000,             \
+        .commit_cb     = NULL,               \
     }
 
 /**
@@ -46,13 +77,14 @@ typedef struct {
  *
  * 负责：
  *  - 初始化 NVS（若空间不足或版本不兼容会自动擦除重建）；
- *  - 保存配置参数，用于后续读写 WiFi 列表。
+ *  - 将已保存列表读入 RAM（必要时迁移旧格式）。
  *
  * @param config 外部配置；可为 NULL，NULL 时使用 WIFI_STORAGE_DEFAULT_CONFIG。
  *
  * @return
  *  - ESP_OK                 : 成功（可重复调用，后续调用直接返回 ESP_OK）
  *  - ESP_ERR_INVALID_ARG    : 配置非法（理论上不会出现，内部已做兜底）
+ *  - ESP_ERR_NO_MEM         : 列表缓存分配失败
  *  - 其它 esp_err_t         : NVS 初始化相关错误
  */
 esp_err_t wifi_storage_init(const wifi_storage_config_t *config);
@@ -71,7 +103,6 @@ esp_err_t wifi_storage_init(const wifi_storage_config_t *config);
  *  - ESP_OK              : 读取成功（包括无任何配置的情况）
  *  - ESP_ERR_INVALID_ARG : 参数为空
  *  - ESP_ERR_INVALID_STATE : 模块未初始化
- *  - 其它 esp_err_t      : NVS 读失败 / 数据格式异常等
  */
 esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out);
 
@@ -81,18 +112,21 @@ esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out);
  * 一般在“STA 成功获取 IP”事件中调用，用于维护“最近成功连接”的有序列表。
  *
  * 策略：
- *  - 已存在同名 SSID：对应条目移动到首位，保持其余顺序不变；
+ *  - 已存在同名 SSID：以 config 覆盖对应条目并移动到首位，保持其余顺序不变
+ *    （已在首位且内容相同则不写 flash）；
  *  - 不存在该 SSID：
  *      - 若列表未满：将该配置插入首位；
  *      - 若列表已满：将该配置插入首位并丢弃最后一条。
  *
+ * 只更新 RAM 并安排延迟提交，不在调用方上下文中写 flash（commit_delay_ms 为 0 时除外）。
+ *
  * @param[in] config 本次成功连接使用的 wifi_config_t（完整结构体）
  *
  * @return
  *  - ESP_OK               : 更新成功
  *  - ESP_ERR_INVALID_ARG  : config 为空
  *  - ESP_ERR_INVALID_STATE: 模块未初始化
- *  - 其它 esp_err_t       : NVS 写失败等
+ *  - 其它 esp_err_t       : 立即写入模式下 NVS 写失败等
  */
 esp_err_t wifi_storage_on_connected(const wifi_config_t *config);
 
@@ -100,7 +134,7 @@ esp_err_t wifi_storage_on_connected(const wifi_config_t *config);
  * @brief 按 SSID 删除已保存的 WiFi 配置
  *
  * 精确匹配 SSID（区分大小写），忽略密码等其它字段。
- * 若删除后列表为空，将擦除对应 NVS key。
+ * 与 wifi_storage_on_connected() 相同，按延迟提交策略写入（擦除该条目的 key）。
  *
  * @param[in] ssid 要删除的 WiFi SSID（以 '\0' 结尾的字符串）
  *
@@ -108,8 +142,21 @@ esp_err_t wifi_storage_on_connected(const wifi_config_t *config);
  *  - ESP_OK               : 删除成功（包括未找到目标时）
  *  - ESP_ERR_INVALID_ARG  : ssid 为空或空字符串
  *  - ESP_ERR_INVALID_STATE: 模块未初始化
- *  - 其它 esp_err_t       : NVS 读/写失败等
+ *  - 其它 esp_err_t       : 立即写入模式下 NVS 写失败等
  */
 esp_err_t wifi_storage_delete_by_ssid(const char *ssid);
 
+/**
+ * @brief 立即将未提交的修改写入 flash
+ *
+ * 收到 commit_cb 通知后由调用方任务调用；延迟提交窗口内若需要重启 / 断电
+ * （如 OTA 完成后），也应先调用本接口。
+ *
+ * @return
+ *  - ESP_OK               : 成功（无待写修改时直接返回）
+ *  - ESP_ERR_INVALID_STATE: 模块未初始化
+ *  - 其它 esp_err_t       : NVS 写失败（修改保持为脏，下次提交时重试）
+ */
+esp_err_t wifi_storage_flush(void);
+
 #endif /* STORAGE_MODULE_H */
@@ -21,6 +21,8 @@
 
 #include "esp_err.h"
 
+#include "web_ws.h"
+
 /**
  * @brief Web 配网模块关注的 WiFi 状态视图
  *
@@ -57,6 +59,14 @@ typedef struct {
     int8_t rssi;     ///< 信号强度（dBm）
 } web_scan_result_t;
 
+/**
+ * @brief Web 端展示用的“扫描状态”
+ */
+typedef struct {
+    bool     scanning; ///< 是否有扫描正在进行（前端据此稍后再次拉取）
+    uint32_t age_ms;   ///< 返回结果距上次扫描完成的时间（ms）
+} web_scan_info_t;
+
 /**
  * @brief Web 模块查询 WiFi 状态的回调
  *
@@ -79,12 +89,18 @@ typedef esp_err_t (*web_get_status_cb_t)(web_wifi_status_t *out_status);
 typedef esp_err_t (*web_get_saved_list_cb_t)(web_saved_wifi_info_t *list, size_t *inout_cnt);
 
 /**
- * @brief Web 模块触发一次 WiFi 扫描并获取结果的回调
+ * @brief Web 模块获取 WiFi 扫描结果的回调
+ *
+ * 在 httpd 任务中调用，实现不得阻塞等待扫描：应立即返回缓存结果，
+ * 缓存过期（或 refresh）时在后台发起新扫描并通过 info->scanning 告知前端。
  *
+ * @param[in]     refresh   是否强制发起新扫描（忽略缓存有效期）
  * @param[in,out] list      Web 模块提供的缓存数组
  * @param[in,out] inout_cnt 入口为缓存容量，出口为实际填充数量
+ * @param[out]    info      扫描状态
  */
-typedef esp_err_t (*web_scan_cb_t)(web_scan_result_t *list, size_t *inout_cnt);
+typedef esp_err_t (*web_scan_cb_t)(bool refresh, web_scan_result_t *list, size_t *inout_cnt,
+                                   web_scan_info_t *info);
 
 /**
  * @brief 删除已保存 WiFi 的回调（按 SSID 匹配）
@@ -110,10 +126,12 @@ typedef struct {
     int                   http_port;        ///< HTTP 监听端口（典型为 80/8080，<=0 时使用默认 80）
     web_get_status_cb_t   get_status_cb;    ///< 查询当前 WiFi 状态回调
     web_get_saved_list_cb_t get_saved_list_cb; ///< 获取已保存 WiFi 列表回调
-    web_scan_cb_t         scan_cb;          ///< 执行一次 WiFi 扫描并返回结果的回调
+    web_scan_cb_t         scan_cb;          ///< 获取 WiFi 扫描结果（缓存 + 后台扫描）的回调
     web_delete_saved_cb_t delete_saved_cb;  ///< 删除已保存 WiFi 的回调
     web_connect_saved_cb_t connect_saved_cb; ///< 连接已保存 WiFi 的回调
     web_connect_cb_t      connect_cb;       ///< 通过表单连接 WiFi 的回调
+    web_ws_config_t       ws;               ///< WebSocket 通道配置（max_clients 为 0 时不注册）
+    int                   task_core;        ///< HTTP 服务器任务绑定的核（<0 不绑定）
 } web_module_config_t;
 
 /**
@@ -128,14 +146,15 @@ typedef struct {
         .delete_saved_cb  = NULL,              \
         .connect_saved_cb = NULL,              \
         .connect_cb       = NULL,              \
+        .ws               = WEB_WS_DEFAULT_CONFIG(), \
+        .task_core        = -1,                \
     }
 
 /**
  * @brief 初始化 Web 配网模块
  *
  * 负责：
- * - 挂载 SPIFFS 分区（label: "wifi_spiffs"，base_path: "/spiffs"）；
- * - 启动 HTTP 服务器并注册静态文件路由；
+ * - 启动 HTTP 服务器并注册内置静态资源路由（构建时由 wifi_spiffs/ 下文件 gzip 生成）；
  * - 如配置了 get_status_cb，则注册 /api/wifi/status 接口。
  *
  * @param config 配置指针，可为 NULL，NULL 时使用 WEB_MODULE_DEFAULT_CONFIG。
@@ -143,7 +162,7 @@ typedef struct {
  * @return
  *  - ESP_OK                 : 初始化成功（可重复调用，后续调用直接返回 ESP_OK）
  *  - ESP_ERR_NO_MEM 等      : 内部资源不足
- *  - 其它 esp_err_t         : SPIFFS / HTTP 服务器相关错误
+ *  - 其它 esp_err_t         : HTTP 服务器相关错误
  */
 esp_err_t web_module_init(const web_module_config_t *config);
 
@@ -0,0 +1,138 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 15:10:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 15:10:00
+ * @FilePath: \xn_esp32_audio\components\xn_web_wifi_manger\include\web_ws.h
+ * @Description: Web 模块的 WebSocket 通道（挂在配网 HTTP 服务器上，如 /ws/audio）
+ *
+ * 设计要点：
+ * - 只负责帧的收发，不理解内容，由上层（如音频调试桥）注册接收回调、推送数据；
+ * - 发送为“共享帧 + 引用计数”：生产者写一次，所有客户端引用同一块内存，不逐客户端拷贝；
+ * - 每个客户端一个有界发送队列，满时丢弃新帧并计数，慢客户端不会阻塞生产者任务；
+ * - 实际 socket 发送在 httpd 任务中进行（httpd_queue_work），生产者只做入队；
+ *   socket 不可写的客户端跳过、单帧发送超时很短，慢客户端也不会长时间占住 httpd 任务。
+ */
+
+#ifndef WEB_WS_H
+#define WEB_WS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/** 发送帧句柄（来自共享帧池） */
+typedef struct web_ws_frame_s web_ws_frame_t;
+
+/**
+ * @brief WebSocket 接收回调（在 httpd 任务中调用）
+ *
+ * @param binary   true 为二进制帧，false 为文本帧（data 以 '\0' 结尾）
+ * @param data     帧数据，仅在回调期间有效
+ * @param len      字节数
+ * @param user_ctx 注册时传入的上下文
+ */
+typedef void (*web_ws_rx_cb_t)(bool binary, const uint8_t *data, size_t len, void *user_ctx);
+
+/**
+ * @brief WebSocket 通道配置
+ */
+typedef struct {
+    const char *uri;          ///< 端点路径（如 "/ws/audio"）
+    uint8_t     max_clients;  ///< 最大并发客户端数（0 表示不注册 WebSocket 端点）
+    uint8_t     queue_depth;  ///< 每个客户端发送队列深度（帧），满时丢弃新帧
+    uint8_t     frame_count;  ///< 共享发送帧池帧数（所有客户端共用）
+    size_t      frame_size;   ///< 每帧最大字节数
+    size_t      rx_max;       ///< 接收帧最大字节数（超出时关闭该连接）
+} web_ws_config_t;
+
+#define WEB_WS_DEFAULT_CONFIG()                \
+    (web_ws_config_t){                         \
+        .uri         = "/ws/audio",            \
+        .max_clients = 2,                      \
+        .queue_depth = 8,                      \
+        .frame_count = 16,                     \
+        .frame_size  = 2048,                   \
+        .rx_max      = 4096,                   \
+    }
+
+/**
+ * @brief WebSocket 运行统计
+ */
+typedef struct {
+    uint8_t  clients;         ///< 当前客户端数
+    uint32_t sent_frames;     ///< 已发送帧数（按客户端计）
+    uint32_t dropped_frames;  ///< 客户端队列满被丢弃的帧数（按客户端计）
+    uint32_t pool_empty;      ///< 帧池耗尽导致 acquire 失败的次数
+    uint32_t lock_busy;       ///< 客户端表正在更新导致 commit 放弃的帧数
+    uint32_t rx_frames;       ///< 收到的数据帧数
+} web_ws_stats_t;
+
+/**
+ * @brief 在 HTTP 服务器上注册 WebSocket 端点并分配帧池
+ *
+ * 由 web_module 在启动 HTTP 服务器时调用。
+ *
+ * @param server 已启动的 httpd 句柄
+ * @param config 配置（max_clients 为 0 时直接返回 ESP_OK）
+ * @return
+ *  - ESP_OK              : 成功
+ *  - ESP_ERR_INVALID_ARG : 参数非法
+ *  - ESP_ERR_NO_MEM      : 帧池 / 队列分配失败
+ */
+esp_err_t web_ws_start(httpd_handle_t server, const web_ws_config_t *config);
+
+/**
+ * @brief 注册接收回调（可在任意时刻调用，NULL 表示丢弃收到的数据）
+ */
+void web_ws_set_rx_cb(web_ws_rx_cb_t cb, void *user_ctx);
+
+/**
+ * @brief 当前已连接的客户端数（无客户端时生产者可跳过组帧）
+ */
+uint8_t web_ws_client_count(void);
+
+/**
+ * @brief 从共享帧池取一帧，生产者直接写入返回的缓冲区（不阻塞）
+ *
+ * @param[out] buf      帧数据区
+ * @param[out] capacity 帧数据区容量（frame_size），可为 NULL
+ * @return 帧句柄；无客户端、帧池耗尽或未启动时返回 NULL
+ */
+web_ws_frame_t *web_ws_acquire(uint8_t **buf, size_t *capacity);
+
+/**
+ * @brief 提交一帧，按引用入队到所有客户端并在 httpd 任务中发送（不阻塞）
+ *
+ * @param frame  web_ws_acquire() 返回的帧（提交后不可再访问）
+ * @param len    实际字节数（<= frame_size）
+ * @param binary true 二进制帧，false 文本帧
+ * @return
+ *  - ESP_OK                : 至少入队到一个客户端
+ *  - ESP_ERR_INVALID_ARG   : 参数非法（帧已归还）
+ *  - ESP_ERR_NOT_FOUND     : 所有客户端队列均已满（帧已归还）
+ *  - ESP_ERR_TIMEOUT       : httpd 任务正在增删客户端，本帧放弃（帧已归还，计入 lock_busy）
+ */
+esp_err_t web_ws_commit(web_ws_frame_t *frame, size_t len, bool binary);
+
+/**
+ * @brief 放弃已取出但不再提交的帧（归还帧池）
+ */
+void web_ws_discard(web_ws_frame_t *frame);
+
+/**
+ * @brief 便捷发送：acquire + 拷贝 + commit
+ *
+ * @return ESP_ERR_NO_MEM 帧池耗尽 / 无客户端；ESP_ERR_INVALID_SIZE 超出 frame_size；其余同 web_ws_commit()
+ */
+esp_err_t web_ws_send(const void *data, size_t len, bool binary);
+
+/**
+ * @brief 获取运行统计
+ */
+void web_ws_get_stats(web_ws_stats_t *stats);
+
+#endif /* WEB_WS_H */
@@ -8,8 +8,10 @@
  *
  * 上层（如 wifi_manage）通过：
  *  - wifi_module_init()  配置并初始化 WiFi 驱动、STA/AP 接口；
- *  - wifi_module_connect()  发起一次 STA 连接流程；
- *  - wifi_module_scan()     执行同步扫描，获取附近 AP 列表；
+ *  - wifi_module_connect()  发起一次 STA 连接流程（wifi_module_connect_ex 可带上次 AP 信息快速重连）；
+ *  - wifi_module_scan_request() / wifi_module_scan_get_cached()
+ *                           异步扫描 + 带有效期的结果缓存（可在 httpd 任务中调用）；
+ *  - wifi_module_scan()     阻塞等待一次扫描完成后取结果（仅限后台任务）；
  * 以及注册的 event_cb 获取 WiFi 状态变化。
  */
 
@@ -64,8 +66,24 @@ typedef struct {
     uint8_t ap_channel;                     ///< AP 信道（1~13，非法值由实现做修正）
     uint8_t max_sta_conn;                   ///< AP 可同时接入的 STA 数量
     wifi_module_event_cb_t event_cb;        ///< 事件回调，可为 NULL（不回调）
+    bool  scan_passive;                     ///< 扫描方式：true 被动监听 Beacon，false 主动发送 Probe
+    uint16_t scan_dwell_ms;                 ///< 每个信道驻留时间（ms，0 使用驱动默认）
+    uint8_t scan_home_dwell_ms;             ///< 已连接时每扫一个信道后回到工作信道的停留时间（ms，0 使用驱动默认）
+    uint32_t scan_cache_ttl_ms;             ///< 扫描结果缓存有效期（ms），过期后下次请求自动重新扫描
 } wifi_module_config_t;
 
+/**
+ * @brief 上次成功连接的 AP 信息（用于单信道快速重连）
+ *
+ * 由 wifi_module_get_ap_hint() 在连接成功后读取，上层持久化后在下次连接时传回。
+ */
+typedef struct {
+    bool    valid;       ///< 信息是否有效（false 时按 SSID 全信道扫描连接）
+    uint8_t bssid[6];    ///< AP BSSID
+    uint8_t channel;     ///< AP 主信道
+    uint8_t authmode;    ///< AP 加密方式（wifi_auth_mode_t），作为连接时的最低加密阈值
+} wifi_module_ap_hint_t;
+
 /* -------------------------------------------------------------------------- */
 /*                                扫描结果结构体                               */
 /* -------------------------------------------------------------------------- */
@@ -78,6 +96,18 @@ typedef struct {
     int8_t rssi;       ///< RSSI（dBm）
 } wifi_module_scan_result_t;
 
+/** 扫描结果缓存最多保留的 AP 条数 */
+#define WIFI_MODULE_SCAN_MAX_AP 32
+
+/**
+ * @brief 扫描缓存状态
+ */
+typedef struct {
+    bool     in_progress;  ///< 是否有扫描正在进行
+    bool     valid;        ///< 缓存中是否有至少一次成功扫描的结果
+    uint32_t age_ms;       ///< 缓存结果距今时间（ms，valid 为 false 时为 0）
+} wifi_module_scan_info_t;
+
 /* -------------------------------------------------------------------------- */
 /*                                  默认配置                                   */
 /* -------------------------------------------------------------------------- */
@@ -98,6 +128,10 @@ typedef struct {
         .ap_channel   = 1,                                      \
         .max_sta_conn = 4,                                      \
         .event_cb     = NULL,                                   \
+        .scan_passive = false,                                  \
+        .scan_dwell_ms = 60,                                    \
+        .scan_home_dwell_ms = 60,                               \
+        .scan_cache_ttl_ms = 30000,                             \
     }
 
 /* -------------------------------------------------------------------------- */
@@ -137,10 +171,65 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config);
  */
 esp_err_t wifi_module_connect(const char *ssid, const char *password);
 
+/**
+ * @brief 以 STA 模式连接指定 AP，可指定上次成功连接的 AP 信息
+ *
+ * - hint 有效：锁定 BSSID，仅在记录的信道上快速扫描（WIFI_FAST_SCAN），通常数百毫秒内完成关联；
+ *   AP 更换信道或下线时本次连接失败（STA_CONNECT_FAILED），由上层回退为全信道连接；
+ * - hint 为 NULL 或无效：全信道扫描，按信号强度选择同名 AP。
+ *
+ * @param ssid     目标 AP SSID，必须非 NULL 且非空
+ * @param password 目标 AP 密码，可为 NULL/空串 表示开放网络
+ * @param hint     上次成功连接的 AP 信息，可为 NULL
+ * @return 同 wifi_module_connect()
+ */
+esp_err_t wifi_module_connect_ex(const char *ssid, const char *password,
+                                 const wifi_module_ap_hint_t *hint);
+
+/**
+ * @brief 读取当前已连接 AP 的信息，供下次快速重连使用
+ *
+ * @param[out] hint 输出 AP 信息，不可为 NULL
+ * @return
+ *      - ESP_OK                 读取成功（hint->valid 为 true）
+ *      - ESP_ERR_INVALID_ARG    hint 为 NULL
+ *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化或 STA 未连接
+ */
+esp_err_t wifi_module_get_ap_hint(wifi_module_ap_hint_t *hint);
+
+/**
+ * @brief 请求一次异步扫描（立即返回）
+ *
+ * 扫描在 WiFi 驱动中进行，完成后由 WIFI_EVENT_SCAN_DONE 事件刷新缓存；
+ * 已连接时驱动每扫一个信道就回到工作信道停留 scan_home_dwell_ms，STA 链路不中断。
+ *
+ * @param force true：缓存未过期也重新扫描；false：缓存仍在有效期内则不扫描
+ * @return
+ *      - ESP_OK                 已发起扫描，或已有扫描在进行 / 缓存仍有效
+ *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化或未启用 STA
+ *      - 其它 esp_err_t         驱动拒绝扫描（如 STA 正在连接），具体见日志
+ */
+esp_err_t wifi_module_scan_request(bool force);
+
+/**
+ * @brief 读取扫描缓存（不触发扫描、不阻塞）
+ *
+ * @param results     结果数组指针，可为 NULL（仅查询状态）
+ * @param count_inout 输入：数组容量；输出：实际写入条目数（results 为 NULL 时可为 NULL）
+ * @param info        输出缓存状态，可为 NULL
+ * @return
+ *      - ESP_OK                 读取成功（缓存为空时条目数为 0）
+ *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化
+ */
+esp_err_t wifi_module_scan_get_cached(wifi_module_scan_result_t *results,
+                                      uint16_t *count_inout,
+                                      wifi_module_scan_info_t *info);
+
 /**
  * @brief 同步扫描附近可见的 WiFi 列表
  *
- * 内部会发起一次阻塞式扫描，完成后将结果拷贝到调用方提供的数组中。
+ * 发起一次扫描（已有扫描在进行时复用），阻塞等待完成后从缓存拷贝结果。
+ * 会阻塞数秒，不可在 httpd / 事件循环任务中调用，Web 接口请使用异步接口。
  *
  * @param results     结果数组指针，不可为 NULL
  * @param count_inout 输入：数组容量；输出：实际写入条目数
@@ -148,6 +237,7 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password);
  *      - ESP_OK                 扫描成功
  *      - ESP_ERR_INVALID_ARG    参数为 NULL 或容量为 0
  *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化
+ *      - ESP_ERR_TIMEOUT        等待扫描完成超时
  *      - 其它 esp_err_t         具体错误见日志
  */
 esp_err_t wifi_module_scan(wifi_module_scan_result_t *results, uint16_t *count_inout);
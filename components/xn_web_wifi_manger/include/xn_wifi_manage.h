@@ -6,7 +6,7 @@
  * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\include\xn_wifi_manage.h
  * @Description: WiFi 管理模块对外接口（封装 WiFi / 存储 / Web 配网）
  *
- * - 负责自动重连、连接结果上报；
+ * - 负责自动重连（上次 AP 单信道快速重连 + 失败后指数退避）、连接结果上报；
  * - 可选保存多组 WiFi 配置并轮询尝试；
  * - 内置 AP + Web 配网能力。
  *
@@ -16,6 +16,8 @@
 #ifndef XN_WIFI_MANAGE_H
 #define XN_WIFI_MANAGE_H
 
+#include <stdbool.h>
+
 #include "esp_err.h"
 
 /**
@@ -55,13 +57,19 @@ typedef void (*wifi_event_cb_t)(wifi_manage_state_t state);
  */
 typedef struct {
     int  max_retry_count;          ///< 单个 AP 最多连续重试次数（<=0 表示只尝试一次）
-    int  reconnect_interval_ms;    ///< 整轮失败后等待多久再自动重试；<0 表示关闭自动重试
+    int  reconnect_interval_ms;    ///< 首轮失败后等待多久再自动重试，此后每轮翻倍；<0 表示关闭自动重试
+    int  reconnect_max_interval_ms; ///< 指数退避的等待上限（ms，小于 reconnect_interval_ms 时按后者）
     char ap_ssid[32];              ///< 配网 AP SSID（最长 31 字符，需手动保证 '\0' 结尾）
     char ap_password[64];          ///< 配网 AP 密码（8~63 字符，留 1 字节给 '\0'）
     char ap_ip[16];                ///< 配网 AP 网口 IP 地址，如 "192.168.4.1"
     wifi_event_cb_t wifi_event_cb; ///< 状态变化回调，可为 NULL 表示不关心
     int  save_wifi_count;          ///< 最多保存的 WiFi 条数（<=0 使用 1；值越大占用更多 NVS/堆内存）
     int  web_port;                 ///< Web 配网页面 HTTP 监听端口（典型为 80/8080）
+    int  web_ws_clients;           ///< Web 服务器 WebSocket 通道（/ws/audio）最大客户端数，0 表示不开启
+    bool web_on_demand;            ///< 按需启动 Web 配网服务器：无已保存 WiFi 或整轮连接失败时才启动
+                                   ///< （开启 WebSocket 通道时忽略，服务器随初始化启动）
+    int  task_core;                ///< 管理任务与 HTTP 服务器任务绑定的核（<0 不绑定；可与 WiFi 协议栈同核，
+                                   ///< 避免与另一核上的实时音频任务抢占）
 } wifi_manage_config_t;
 
 /**
@@ -77,13 +85,17 @@ typedef struct {
 #define WIFI_MANAGE_DEFAULT_CONFIG()                       \
     (wifi_manage_config_t){                                \
         .max_retry_count       = 5,                        \
-        .reconnect_interval_ms = 10000,                    \
+        .reconnect_interval_ms = 2000,                     \
+        .reconnect_max_interval_ms = 60000,                \
         .ap_ssid               = "XN-ESP32-AP",            \
         .ap_password           = "12345678",               \
         .ap_ip                 = "192.168.4.1",            \
         .wifi_event_cb         = NULL,                     \
         .save_wifi_count       = 5,                        \
         .web_port              = 80,                       \
+        .web_ws_clients        = 0,                        \
+        .web_on_demand         = false,                    \
+        .task_core             = -1,                       \
     }
 
 /**
@@ -102,4 +114,16 @@ typedef struct {
  */
 esp_err_t wifi_manage_init(const wifi_manage_config_t *config);
 
+/**
+ * @brief 请求启动 Web 配网服务器
+ *
+ * 用于 web_on_demand 模式下由应用主动进入配网（如长按按键）；
+ * 服务器已启动时无副作用。实际启动在管理任务中异步完成。
+ *
+ * @return
+ *      - ESP_OK                : 已提交请求
+ *      - ESP_ERR_INVALID_STATE : 尚未调用 wifi_manage_init
+ */
+esp_err_t wifi_manage_start_provisioning(void);
+
 #endif /* XN_WIFI_MANAGE_H */
@@ -2,17 +2,27 @@
  * @Author: 星年 && jixingnian@gmail.com
  * @Date: 2025-11-22 18:20:00
  * @LastEditors: xingnian jixingnian@gmail.com
- * @LastEditTime: 2025-11-22 20:05:14
+ * @LastEditTime: 2025-12-09 18:30:00
  * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\src\storage_module.c
  * @Description: WiFi 存储模块实现（基于 NVS，保存常用 WiFi 列表）
- * 
+ *
+ * 列表常驻 RAM：每个条目占一个固定槽位（NVS key "wifi_<槽位>"），
+ * 顺序为槽位下标数组（key "wifi_order"）。修改只标记脏槽位 / 脏顺序，
+ * 一次性定时器在 commit_delay_ms 后通知调用方任务，由其调用 wifi_storage_flush()
+ * 合并写入并只 commit 一次（flash 写入不占用 esp_timer 任务）。
+ *
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 #include "storage_module.h"
@@ -24,8 +34,22 @@ static const char *TAG = "wifi_storage";
 static wifi_storage_config_t s_storage_cfg;
 static bool                  s_storage_inited = false;
 
-/* NVS 中保存 WiFi 列表使用的 key 名称 */
-static const char *WIFI_LIST_KEY = "wifi_list";
+/* NVS key：条目顺序（槽位下标数组）/ 单个条目前缀 / 旧版本整表 blob */
+static const char *WIFI_ORDER_KEY  = "wifi_order";
+static const char *WIFI_SLOT_FMT   = "wifi_%u";
+static const char *WIFI_LIST_KEY   = "wifi_list";
+
+/* RAM 缓存：s_slots[槽位] 为条目，s_order[0..s_count) 为按优先级排列的槽位下标 */
+static wifi_config_t    *s_slots       = NULL;
+static uint8_t           s_order[WIFI_STORAGE_MAX_NUM];
+static uint8_t           s_count       = 0;
+
+/* 待写入状态：脏槽位位图（槽位不在 s_order 中表示需擦除）与顺序脏标志 */
+static uint32_t          s_dirty_slots = 0;
+static bool              s_dirty_order = false;
+
+static SemaphoreHandle_t s_storage_lock = NULL;
+static esp_timer_handle_t s_commit_timer = NULL;
 
 /**
  * @brief 初始化 NVS（供存储模块使用）
@@ -56,57 +80,171 @@ static bool wifi_storage_is_same_ssid(const wifi_config_t *a, const wifi_config_
     return memcmp(a->sta.ssid, b->sta.ssid, sizeof(a->sta.ssid)) == 0;
 }
 
+static void wifi_storage_slot_key(uint8_t slot, char *key, size_t key_len)
+{
+    snprintf(key, key_len, WIFI_SLOT_FMT, (unsigned)slot);
+}
+
+/** 槽位是否被当前列表引用 */
+static bool wifi_storage_slot_used(uint8_t slot)
+{
+    for (uint8_t i = 0; i < s_count; ++i) {
+        if (s_order[i] == slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* -------------------- 提交（持锁调用） -------------------- */
+
 /**
- * @brief 初始化 WiFi 存储模块
+ * @brief 将脏槽位与顺序写入 NVS，并只 commit 一次
  *
- * - 可重复调用，多次调用仅第一次生效；
- * - 若 config 为 NULL，使用 WIFI_STORAGE_DEFAULT_CONFIG；
- * - 强制保证 max_wifi_num >= 1。
+ * 失败时保留脏标志，下次提交重试。
  */
-esp_err_t wifi_storage_init(const wifi_storage_config_t *config)
+static esp_err_t wifi_storage_commit_locked(void)
 {
-    if (s_storage_inited) {
+    if (s_dirty_slots == 0 && !s_dirty_order) {
         return ESP_OK;
     }
 
-    /* 加载配置：优先使用用户配置，否则使用默认 */
-    s_storage_cfg = (config == NULL) ? WIFI_STORAGE_DEFAULT_CONFIG() : *config;
+    nvs_handle_t handle;
+    esp_err_t    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open(write) failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
-    /* 防止后续申请 0 长度数组等问题 */
-    if (s_storage_cfg.max_wifi_num == 0) {
-        s_storage_cfg.max_wifi_num = 1;
+    char key[16];
+    for (uint8_t slot = 0; slot < s_storage_cfg.max_wifi_num && ret == ESP_OK; ++slot) {
+        if ((s_dirty_slots & (1UL << slot)) == 0) {
+            continue;
+        }
+        wifi_storage_slot_key(slot, key, sizeof(key));
+        if (wifi_storage_slot_used(slot)) {
+            ret = nvs_set_blob(handle, key, &s_slots[slot], sizeof(wifi_config_t));
+        } else {
+            ret = nvs_erase_key(handle, key);
+            if (ret == ESP_ERR_NVS_NOT_FOUND) {
+                ret = ESP_OK;
+            }
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "write %s failed: %s", key, esp_err_to_name(ret));
+        }
     }
 
-    /* NVS 初始化 */
-    esp_err_t ret = wifi_storage_init_nvs();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
-        return ret;
+    if (ret == ESP_OK && s_dirty_order) {
+        if (s_count > 0) {
+            ret = nvs_set_blob(handle, WIFI_ORDER_KEY, s_order, s_count);
+        } else {
+            ret = nvs_erase_key(handle, WIFI_ORDER_KEY);
+            if (ret == ESP_ERR_NVS_NOT_FOUND) {
+                ret = ESP_OK;
+            }
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "write %s failed: %s", WIFI_ORDER_KEY, esp_err_to_name(ret));
+        }
     }
 
-    s_storage_inited = true;
-    return ESP_OK;
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "nvs_commit failed: %s", esp_err_to_name(ret));
+        }
+    }
+    nvs_close(handle);
+
+    if (ret == ESP_OK) {
+        s_dirty_slots = 0;
+        s_dirty_order = false;
+    }
+    return ret;
+}
+
+/* 定时器回调只转发通知：NVS 写入 / 擦除可能耗时数十毫秒，会推迟其他 esp_timer 回调 */
+static void wifi_storage_commit_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (s_storage_cfg.commit_cb) {
+        s_storage_cfg.commit_cb();
+    }
 }
 
 /**
- * @brief 读取所有已保存 WiFi 配置
+ * @brief 安排一次延迟提交（持锁调用）
  *
- * @param configs    外部提供的数组缓冲，长度需 >= max_wifi_num
- * @param count_out  实际读取到的数量（可能小于 max_wifi_num）
- *
- * @note 若当前没有任何配置，返回 ESP_OK 且 *count_out = 0。
+ * 定时器运行中不重启，保证连续修改时最长延迟仍为 commit_delay_ms。
  */
-esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out)
+static esp_err_t wifi_storage_schedule_locked(void)
 {
-    if (!s_storage_inited) {
-        return ESP_ERR_INVALID_STATE;
+    if (s_storage_cfg.commit_delay_ms == 0 || s_commit_timer == NULL) {
+        return wifi_storage_commit_locked();
     }
-    if (configs == NULL || count_out == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (!esp_timer_is_active(s_commit_timer)) {
+        esp_timer_start_once(s_commit_timer, (uint64_t)s_storage_cfg.commit_delay_ms * 1000ULL);
+    }
+    return ESP_OK;
+}
+
+/* -------------------- 加载 / 迁移 -------------------- */
+
+/**
+ * @brief 读取旧版本整表 blob（"wifi_list"）到缓存，并标记需要按新格式写回
+ */
+static esp_err_t wifi_storage_load_legacy(nvs_handle_t handle)
+{
+    size_t    blob_size = 0;
+    esp_err_t ret       = nvs_get_blob(handle, WIFI_LIST_KEY, NULL, &blob_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* blob_size 必须是 wifi_config_t 的整数倍，且非 0 */
+    if (blob_size == 0 || (blob_size % sizeof(wifi_config_t)) != 0) {
+        ESP_LOGE(TAG, "invalid blob size: %u", (unsigned int)blob_size);
+        return ESP_FAIL;
     }
 
-    *count_out = 0;
+    uint8_t max_num    = s_storage_cfg.max_wifi_num;
+    size_t  stored_num = blob_size / sizeof(wifi_config_t);
+    uint8_t read_num   = (stored_num > max_num) ? max_num : (uint8_t)stored_num;
+
+    /* nvs_get_blob 要求缓冲区不小于 blob，整表读出后截取前 read_num 条 */
+    wifi_config_t *list = (wifi_config_t *)malloc(blob_size);
+    if (list == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ret = nvs_get_blob(handle, WIFI_LIST_KEY, list, &blob_size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_get_blob(legacy) failed: %s", esp_err_to_name(ret));
+        free(list);
+        return ret;
+    }
+    /* 槽位与原顺序一一对应 */
+    memcpy(s_slots, list, read_num * sizeof(wifi_config_t));
+    free(list);
 
+    for (uint8_t i = 0; i < read_num; ++i) {
+        s_order[i] = i;
+        s_dirty_slots |= 1UL << i;
+    }
+    s_count       = read_num;
+    s_dirty_order = true;
+    ESP_LOGI(TAG, "migrating %u saved WiFi from legacy list", (unsigned)read_num);
+    return ESP_OK;
+}
+
+/**
+ * @brief 初始化时将 NVS 中的列表读入缓存
+ *
+ * 损坏 / 缺失的条目会被剔除并标记顺序脏，由下一次提交修正。
+ */
+static esp_err_t wifi_storage_load_cache(void)
+{
     nvs_handle_t handle;
     esp_err_t    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READONLY, &handle);
     if (ret == ESP_ERR_NVS_NOT_FOUND) {
@@ -118,139 +256,229 @@ esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out)
         return ret;
     }
 
-    /* 首先获取 blob 大小，用于计算配置数量 */
-    size_t blob_size = 0;
-    ret              = nvs_get_blob(handle, WIFI_LIST_KEY, NULL, &blob_size);
+    uint8_t order[WIFI_STORAGE_MAX_NUM];
+    size_t  order_len = sizeof(order);
+    ret               = nvs_get_blob(handle, WIFI_ORDER_KEY, order, &order_len);
     if (ret == ESP_ERR_NVS_NOT_FOUND) {
-        /* 未保存过列表 */
+        ret = wifi_storage_load_legacy(handle);
         nvs_close(handle);
-        return ESP_OK;
+        if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            return ESP_OK;
+        }
+        if (ret == ESP_OK) {
+            /* 迁移：先写入新格式，成功后再删除旧整表（初始化阶段无并发，无需持锁） */
+            ret = wifi_storage_commit_locked();
+            if (ret == ESP_OK && nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, &handle) == ESP_OK) {
+                if (nvs_erase_key(handle, WIFI_LIST_KEY) == ESP_OK) {
+                    (void)nvs_commit(handle);
+                }
+                nvs_close(handle);
+            }
+        }
+        return ret;
     }
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_get_blob(size) failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "nvs_get_blob(order) failed: %s", esp_err_to_name(ret));
         nvs_close(handle);
         return ret;
     }
 
-    /* blob_size 必须是 wifi_config_t 的整数倍，且非 0 */
-    if (blob_size == 0 || (blob_size % sizeof(wifi_config_t)) != 0) {
-        ESP_LOGE(TAG, "invalid blob size: %u", (unsigned int)blob_size);
-        nvs_close(handle);
-        return ESP_FAIL;
-    }
+    char key[16];
+    for (size_t i = 0; i < order_len && s_count < s_storage_cfg.max_wifi_num; ++i) {
+        uint8_t slot = order[i];
+        if (slot >= s_storage_cfg.max_wifi_num || wifi_storage_slot_used(slot)) {
+            s_dirty_order = true;
+            continue;
+        }
 
-    uint8_t max_num    = s_storage_cfg.max_wifi_num;
-    uint8_t stored_num = blob_size / sizeof(wifi_config_t);
-    uint8_t read_num   = (stored_num > max_num) ? max_num : stored_num;
-    size_t  read_size  = read_num * sizeof(wifi_config_t);
+        size_t len = sizeof(wifi_config_t);
+        wifi_storage_slot_key(slot, key, sizeof(key));
+        if (nvs_get_blob(handle, key, &s_slots[slot], &len) != ESP_OK || len != sizeof(wifi_config_t)) {
+            ESP_LOGW(TAG, "drop broken entry %s", key);
+            memset(&s_slots[slot], 0, sizeof(wifi_config_t));
+            s_dirty_order = true;
+            continue;
+        }
+        s_order[s_count++] = slot;
+    }
+    if (order_len > s_count) {
+        s_dirty_order = true;
+    }
 
-    ret = nvs_get_blob(handle, WIFI_LIST_KEY, configs, &read_size);
     nvs_close(handle);
+    return ESP_OK;
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+/**
+ * @brief 初始化 WiFi 存储模块
+ *
+ * - 可重复调用，多次调用仅第一次生效；
+ * - 若 config 为 NULL，使用 WIFI_STORAGE_DEFAULT_CONFIG；
+ * - 强制保证 1 <= max_wifi_num <= WIFI_STORAGE_MAX_NUM。
+ */
+esp_err_t wifi_storage_init(const wifi_storage_config_t *config)
+{
+    if (s_storage_inited) {
+        return ESP_OK;
+    }
+
+    /* 加载配置：优先使用用户配置，否则使用默认 */
+    s_storage_cfg = (config == NULL) ? WIFI_STORAGE_DEFAULT_CONFIG() : *config;
+
+    /* 防止后续申请 0 长度数组等问题；位图限制条目上限 */
+    if (s_storage_cfg.max_wifi_num == 0) {
+        s_storage_cfg.max_wifi_num = 1;
+    }
+    if (s_storage_cfg.max_wifi_num > WIFI_STORAGE_MAX_NUM) {
+        s_storage_cfg.max_wifi_num = WIFI_STORAGE_MAX_NUM;
+    }
+
+    /* NVS 初始化 */
+    esp_err_t ret = wifi_storage_init_nvs();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_get_blob(data) failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    *count_out = read_num;
+    s_slots        = (wifi_config_t *)calloc(s_storage_cfg.max_wifi_num, sizeof(wifi_config_t));
+    s_storage_lock = xSemaphoreCreateMutex();
+    if (s_slots == NULL || s_storage_lock == NULL) {
+        ret = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+
+    if (s_storage_cfg.commit_delay_ms > 0 && s_storage_cfg.commit_cb != NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback        = wifi_storage_commit_timer_cb,
+            .arg             = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name            = "wifi_store",
+        };
+        ret = esp_timer_create(&timer_args, &s_commit_timer);
+        if (ret != ESP_OK) {
+            goto fail;
+        }
+    }
+
+    s_count       = 0;
+    s_dirty_slots = 0;
+    s_dirty_order = false;
+    ret           = wifi_storage_load_cache();
+    if (ret != ESP_OK) {
+        /* 读取失败按空列表处理，不阻止联网；下次保存时覆盖 */
+        ESP_LOGW(TAG, "load saved WiFi failed, start empty: %s", esp_err_to_name(ret));
+        s_count = 0;
+    }
+
+    s_storage_inited = true;
     return ESP_OK;
+
+fail:
+    if (s_commit_timer) {
+        esp_timer_delete(s_commit_timer);
+        s_commit_timer = NULL;
+    }
+    if (s_storage_lock) {
+        vSemaphoreDelete(s_storage_lock);
+        s_storage_lock = NULL;
+    }
+    free(s_slots);
+    s_slots = NULL;
+    return ret;
 }
 
 /**
- * @brief 在 STA 成功连接后更新 WiFi 列表
+ * @brief 读取所有已保存 WiFi 配置（来自 RAM 缓存）
  *
- * 策略：
- * - 若该 SSID 已存在：移动到列表首位（保持其他顺序）；
- * - 若不存在且列表未满：插入到首位；
- * - 若不存在且列表已满：插入到首位并丢弃最后一个。
+ * @param configs    外部提供的数组缓冲，长度需 >= max_wifi_num
+ * @param count_out  实际读取到的数量（可能小于 max_wifi_num）
+ *
+ * @note 若当前没有任何配置，返回 ESP_OK 且 *count_out = 0。
  */
-esp_err_t wifi_storage_on_connected(const wifi_config_t *config)
+esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out)
 {
     if (!s_storage_inited) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (config == NULL) {
+    if (configs == NULL || count_out == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t max_num = s_storage_cfg.max_wifi_num;
-    if (max_num == 0) {
-        max_num = 1;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < s_count; ++i) {
+        configs[i] = s_slots[s_order[i]];
     }
+    *count_out = s_count;
+    xSemaphoreGive(s_storage_lock);
 
-    /* 分配工作缓冲，用于读写列表 */
-    wifi_config_t *list = (wifi_config_t *)calloc(max_num, sizeof(wifi_config_t));
-    if (list == NULL) {
-        return ESP_ERR_NO_MEM;
-    }
+    return ESP_OK;
+}
 
-    uint8_t   count = 0;
-    esp_err_t ret   = wifi_storage_load_all(list, &count);
-    if (ret != ESP_OK) {
-        free(list);
-        return ret;
+/**
+ * @brief 在 STA 成功连接后更新 WiFi 列表
+ *
+ * 策略：
+ * - 若该 SSID 已存在：以新配置覆盖并移动到列表首位（保持其他顺序）；
+ *   位置不变时不写顺序，内容不变时不写条目，两者都不变则不写 flash；
+ * - 若不存在且列表未满：占用空闲槽位并插入到首位；
+ * - 若不存在且列表已满：复用最后一个条目的槽位并插入到首位。
+ */
+esp_err_t wifi_storage_on_connected(const wifi_config_t *config)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+
     /* 查找是否已存在相同 SSID */
     int existing_index = -1;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (wifi_storage_is_same_ssid(&list[i], config)) {
+    for (uint8_t i = 0; i < s_count; ++i) {
+        if (wifi_storage_is_same_ssid(&s_slots[s_order[i]], config)) {
             existing_index = (int)i;
             break;
         }
     }
 
+    uint8_t slot;
     if (existing_index >= 0) {
-        /* 已存在：移动到首位 */
+        slot = s_order[existing_index];
         if (existing_index > 0) {
-            wifi_config_t tmp = list[existing_index];
-            memmove(&list[1], &list[0], existing_index * sizeof(wifi_config_t));
-            list[0] = tmp;
+            memmove(&s_order[1], &s_order[0], (size_t)existing_index);
+            s_order[0]    = slot;
+            s_dirty_order = true;
         }
     } else {
-        /* 不存在：插入到首位（可能挤掉最后一个） */
-        if (count < max_num) {
-            if (count > 0) {
-                memmove(&list[1], &list[0], count * sizeof(wifi_config_t));
+        if (s_count < s_storage_cfg.max_wifi_num) {
+            /* 取第一个空闲槽位 */
+            slot = 0;
+            while (wifi_storage_slot_used(slot)) {
+                slot++;
             }
-            list[0] = *config;
-            count++;
+            s_count++;
         } else {
-            if (max_num > 1) {
-                memmove(&list[1], &list[0], (max_num - 1) * sizeof(wifi_config_t));
-            }
-            list[0] = *config;
-            count   = max_num;
+            /* 列表已满：挤掉最后一个，复用其槽位 */
+            slot = s_order[s_count - 1];
         }
+        memmove(&s_order[1], &s_order[0], (size_t)(s_count - 1));
+        s_order[0]    = slot;
+        s_dirty_order = true;
     }
 
-    /* 写回 NVS */
-    nvs_handle_t handle;
-    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_open(write) failed: %s", esp_err_to_name(ret));
-        free(list);
-        return ret;
-    }
-
-    size_t blob_size = count * sizeof(wifi_config_t);
-    ret              = nvs_set_blob(handle, WIFI_LIST_KEY, list, blob_size);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_set_blob(write) failed: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        free(list);
-        return ret;
-    }
-
-    ret = nvs_commit(handle);
-    nvs_close(handle);
-    free(list);
-
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_commit(write) failed: %s", esp_err_to_name(ret));
-        return ret;
+    /* 密码或上次 AP 信息有变化时才重写该条目 */
+    if (existing_index < 0 || memcmp(&s_slots[slot], config, sizeof(wifi_config_t)) != 0) {
+        s_slots[slot] = *config;
+        s_dirty_slots |= 1UL << slot;
     }
 
-    return ESP_OK;
+    esp_err_t ret = wifi_storage_schedule_locked();
+    xSemaphoreGive(s_storage_lock);
+    return ret;
 }
 
 /**
@@ -258,7 +486,7 @@ esp_err_t wifi_storage_on_connected(const wifi_config_t *config)
  *
  * @param ssid  需要删除的 SSID 字符串（以 '\0' 结尾）
  *
- * 若删除后列表为空，则直接擦除 WIFI_LIST_KEY。
+ * 被删除条目的槽位标记为脏，提交时擦除其 key。
  */
 esp_err_t wifi_storage_delete_by_ssid(const char *ssid)
 {
@@ -269,83 +497,48 @@ esp_err_t wifi_storage_delete_by_ssid(const char *ssid)
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t max_num = s_storage_cfg.max_wifi_num;
-    if (max_num == 0) {
-        max_num = 1;
-    }
-
-    wifi_config_t *list = (wifi_config_t *)calloc(max_num, sizeof(wifi_config_t));
-    if (list == NULL) {
-        return ESP_ERR_NO_MEM;
-    }
-
-    uint8_t   count = 0;
-    esp_err_t ret   = wifi_storage_load_all(list, &count);
-    if (ret != ESP_OK) {
-        free(list);
-        return ret;
-    }
-
-    if (count == 0) {
-        free(list);
-        return ESP_OK;
-    }
-
     /* 构造一个只设置 SSID 的临时配置，复用比较函数 */
     wifi_config_t target;
     memset(&target, 0, sizeof(target));
     strncpy((char *)target.sta.ssid, ssid, sizeof(target.sta.ssid) - 1);
 
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+
     /* 过滤出保留的条目 */
     uint8_t write_idx = 0;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (wifi_storage_is_same_ssid(&list[i], &target)) {
+    for (uint8_t i = 0; i < s_count; ++i) {
+        uint8_t slot = s_order[i];
+        if (wifi_storage_is_same_ssid(&s_slots[slot], &target)) {
             /* 跳过待删除条目 */
+            memset(&s_slots[slot], 0, sizeof(wifi_config_t));
+            s_dirty_slots |= 1UL << slot;
             continue;
         }
-        if (write_idx != i) {
-            list[write_idx] = list[i];
-        }
-        write_idx++;
+        s_order[write_idx++] = slot;
     }
 
-    nvs_handle_t handle;
-    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_open(delete) failed: %s", esp_err_to_name(ret));
-        free(list);
-        return ret;
+    esp_err_t ret = ESP_OK;
+    if (write_idx != s_count) {
+        s_count       = write_idx;
+        s_dirty_order = true;
+        ret           = wifi_storage_schedule_locked();
     }
 
-    if (write_idx == 0) {
-        /* 已无任何配置：擦除 key */
-        ret = nvs_erase_key(handle, WIFI_LIST_KEY);
-        if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_LOGE(TAG, "nvs_erase_key failed: %s", esp_err_to_name(ret));
-            nvs_close(handle);
-            free(list);
-            return ret;
-        }
-    } else {
-        /* 仍有剩余配置：回写精简后的列表 */
-        size_t blob_size = write_idx * sizeof(wifi_config_t);
-        ret              = nvs_set_blob(handle, WIFI_LIST_KEY, list, blob_size);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "nvs_set_blob(delete) failed: %s", esp_err_to_name(ret));
-            nvs_close(handle);
-            free(list);
-            return ret;
-        }
-    }
-
-    ret = nvs_commit(handle);
-    nvs_close(handle);
-    free(list);
+    xSemaphoreGive(s_storage_lock);
+    return ret;
+}
 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_commit(delete) failed: %s", esp_err_to_name(ret));
-        return ret;
+esp_err_t wifi_storage_flush(void)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    return ESP_OK;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    if (s_commit_timer) {
+        esp_timer_stop(s_commit_timer);
+    }
+    esp_err_t ret = wifi_storage_commit_locked();
+    xSemaphoreGive(s_storage_lock);
+    return ret;
 }
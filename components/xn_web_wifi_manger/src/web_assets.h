@@ -0,0 +1,41 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:20:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:20:00
+ * @FilePath: \xn_esp32_audio\components\xn_web_wifi_manger\src\web_assets.h
+ * @Description: 编译进固件的 Web 静态资源表（由 tools/web_assets_gen.py 在构建时生成）
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 单个静态资源
+ *
+ * 数据位于 rodata，由 httpd 直接整块发送，请求路径上不经过文件系统。
+ */
+typedef struct {
+    const char    *name;         ///< 文件名（URI 为 "/" + name）
+    const char    *content_type; ///< Content-Type
+    const char    *etag;         ///< 原文的强 ETag（含引号），内容哈希
+    const char    *etag_gzip;    ///< gzip 表示的强 ETag（含引号）
+    const char    *version;      ///< 版本号（不含引号），index.html 以 "?v=<version>" 引用
+    const uint8_t *raw;          ///< 原文（客户端不接受 gzip 时使用）
+    size_t         raw_len;      ///< 原文长度
+    const uint8_t *gzip;         ///< gzip 压缩数据
+    size_t         gzip_len;     ///< gzip 数据长度
+    bool           versioned;    ///< 是否被 index.html 以带版本号的 URL 引用（可长期缓存）
+} web_asset_t;
+
+/** 资源表与条目数 */
+extern const web_asset_t web_assets[];
+extern const size_t      web_asset_count;
+
+#endif /* WEB_ASSETS_H */
@@ -4,10 +4,10 @@
  * @LastEditors: xingnian jixingnian@gmail.com
  * @LastEditTime: 2025-11-23 11:39:20
  * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\src\web_module.c
- * @Description: Web 配网模块实现（HTTP 服务器 + SPIFFS 静态资源）
+ * @Description: Web 配网模块实现（HTTP 服务器 + 内置静态资源）
  *
  * 仅负责：
- *  - 挂载 SPIFFS 分区并暴露静态网页资源；
+ *  - 发送编译进固件的 gzip 静态网页资源（ETag / 304 / 长缓存）；
  *  - 根据回调提供简单的状态查询接口；
  *
  * 不直接依赖 WiFi / 存储模块，由上层通过回调注入所需能力。
@@ -19,10 +19,10 @@
 #include <ctype.h>
 
 #include "esp_log.h"
-#include "esp_spiffs.h"
 #include "esp_http_server.h"
 
 #include "web_module.h"
+#include "web_assets.h"
 
 /* 日志 TAG */
 static const char *TAG = "web_module";
@@ -86,103 +86,71 @@ static void web_url_decode_inplace(char *str)
     *dst = '\0';
 }
 
-/* -------------------- SPIFFS 挂载辅助 -------------------- */
+/* -------------------- 静态资源响应辅助 -------------------- */
 
 /**
- * @brief 挂载存放网页资源的 SPIFFS 分区
+ * @brief 判断请求头中是否包含指定子串
  *
- * 分区在 partitions.csv 中命名为 "wifi_spiffs"：
- * - base_path:  "/spiffs"（HTTP 处理函数按此路径访问文件）
- * - max_files:  4（当前仅三个静态文件，预留 1 个）
+ * 头部过长（超出本地缓冲）时按“不包含”处理，仅会退化为完整响应。
  */
-static esp_err_t web_module_mount_spiffs(void)
+static bool web_module_req_hdr_contains(httpd_req_t *req, const char *field, const char *token)
 {
-    esp_vfs_spiffs_conf_t conf = {
-        .base_path              = "/spiffs",
-        .partition_label        = "wifi_spiffs",
-        .max_files              = 4,
-        .format_if_mount_failed = true,
-    };
+    char   value[128];
+    size_t len = httpd_req_get_hdr_value_len(req, field);
 
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
-
-    if (ret == ESP_ERR_INVALID_STATE) {
-        /* 已经挂载，直接视为成功 */
-        return ESP_OK;
+    if (len == 0 || len >= sizeof(value)) {
+        return false;
     }
-
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "spiffs register failed: %s", esp_err_to_name(ret));
+    if (httpd_req_get_hdr_value_str(req, field, value, sizeof(value)) != ESP_OK) {
+        return false;
     }
-
-    return ret;
+    return strstr(value, token) != NULL;
 }
 
-/* -------------------- 静态文件响应辅助 -------------------- */
-
 /**
- * @brief 以分块响应的方式发送一个静态文件
+ * @brief 内置静态资源（index.html / app.css / app.js）
  *
- * @param req          HTTP 请求对象
- * @param file_path    文件在 SPIFFS 上的完整路径（如 "/spiffs/index.html"）
- * @param content_type Content-Type 头部值
+ * - 客户端接受 gzip 时直接发送预压缩数据，否则发送原文；
+ * - 以 ETag 响应 If-None-Match，未变化时仅回 304；
+ * - index.html 以 "?v=<版本>" 引用其它资源，带当前版本号的请求可长期缓存，
+ *   其余请求（含 index.html 本身）每次用 ETag 校验，固件升级后立即生效。
  */
-static esp_err_t web_module_serve_file(httpd_req_t *req,
-                                       const char  *file_path,
-                                       const char  *content_type)
+static esp_err_t web_module_asset_get_handler(httpd_req_t *req)
 {
-    FILE *f = fopen(file_path, "r");
-    if (f == NULL) {
-        ESP_LOGE(TAG, "open file failed: %s", file_path);
-        httpd_resp_send_err(req,
-                            HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "open file failed");
-        return ESP_FAIL;
-    }
-
-    httpd_resp_set_type(req, content_type);
-    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
-
-    char  buf[512];
-    size_t n;
-    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
-        if (httpd_resp_send_chunk(req, buf, n) != ESP_OK) {
-            fclose(f);
-            httpd_resp_sendstr_chunk(req, NULL); /* 结束分块 */
-            return ESP_FAIL;
+    const web_asset_t *asset = (const web_asset_t *)req->user_ctx;
+
+    bool immutable = false;
+    if (asset->versioned) {
+        char query[48]   = {0};
+        char version[24] = {0};
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+            httpd_query_key_value(query, "v", version, sizeof(version)) == ESP_OK) {
+            immutable = (strcmp(version, asset->version) == 0);
         }
     }
 
-    fclose(f);
-    httpd_resp_send_chunk(req, NULL, 0); /* 告知响应结束 */
-    return ESP_OK;
-}
+    bool gzip = web_module_req_hdr_contains(req, "Accept-Encoding", "gzip");
+    const char *etag = gzip ? asset->etag_gzip : asset->etag;
 
-/* -------------------- 具体 URI 处理函数 -------------------- */
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control",
+                       immutable ? "public, max-age=31536000, immutable" : "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
 
-/**
- * @brief 根路径与 /index.html：返回主页面
- */
-static esp_err_t web_module_root_get_handler(httpd_req_t *req)
-{
-    return web_module_serve_file(req, "/spiffs/index.html", "text/html");
-}
+    if (web_module_req_hdr_contains(req, "If-None-Match", etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
 
-/**
- * @brief app.css：页面样式
- */
-static esp_err_t web_module_css_get_handler(httpd_req_t *req)
-{
-    return web_module_serve_file(req, "/spiffs/app.css", "text/css");
+    httpd_resp_set_type(req, asset->content_type);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, (const char *)asset->gzip, (ssize_t)asset->gzip_len);
+    }
+    return httpd_resp_send(req, (const char *)asset->raw, (ssize_t)asset->raw_len);
 }
 
-/**
- * @brief app.js：前端脚本
- */
-static esp_err_t web_module_js_get_handler(httpd_req_t *req)
-{
-    return web_module_serve_file(req, "/spiffs/app.js", "application/javascript");
-}
+/* -------------------- 具体 URI 处理函数 -------------------- */
 
 /**
  * @brief /api/wifi/status：查询当前 WiFi 状态（可选）
@@ -326,7 +294,10 @@ static esp_err_t web_module_saved_get_handler(httpd_req_t *req)
 }
 
 /**
- * @brief /api/wifi/scan：扫描附近 WiFi 列表
+ * @brief /api/wifi/scan：获取附近 WiFi 列表
+ *
+ * 立即返回缓存结果，不在 httpd 任务里等待扫描；
+ * 查询参数 refresh=1 时强制在后台重新扫描，scanning 为 true 时前端应稍后再拉取。
  */
 static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
 {
@@ -335,11 +306,20 @@ static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
 
     /* 未提供回调时返回空列表，方便前端统一处理 */
     if (s_web_cfg.scan_cb == NULL) {
-        static const char *EMPTY_JSON = "{\"items\":[]}";
+        static const char *EMPTY_JSON = "{\"scanning\":false,\"items\":[]}";
         httpd_resp_send(req, EMPTY_JSON, strlen(EMPTY_JSON));
         return ESP_OK;
     }
 
+    /* 解析可选的 refresh 参数 */
+    bool refresh   = false;
+    char query[32] = {0};
+    char value[8]  = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "refresh", value, sizeof(value)) == ESP_OK) {
+        refresh = (value[0] == '1' || value[0] == 't');
+    }
+
     /* 使用堆缓冲区承载扫描结果，具体数量由回调实现控制 */
     enum { WEB_MAX_SCAN_RESULT = 32 };
     web_scan_result_t *list = (web_scan_result_t *)malloc(WEB_MAX_SCAN_RESULT * sizeof(web_scan_result_t));
@@ -350,8 +330,9 @@ static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    size_t    cnt = WEB_MAX_SCAN_RESULT;
-    esp_err_t ret = s_web_cfg.scan_cb(list, &cnt);
+    size_t          cnt  = WEB_MAX_SCAN_RESULT;
+    web_scan_info_t info = {0};
+    esp_err_t       ret  = s_web_cfg.scan_cb(refresh, list, &cnt, &info);
     if (ret != ESP_OK) {
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
@@ -360,14 +341,7 @@ static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    if (cnt == 0) {
-        static const char *EMPTY_JSON = "{\"items\":[]}";
-        httpd_resp_send(req, EMPTY_JSON, strlen(EMPTY_JSON));
-        free(list);
-        return ESP_OK;
-    }
-
-    /* 序列化为形如 {"items":[{"index":0,"ssid":"xxx","rssi":-60}, ...]} 的 JSON
+    /* 序列化为形如 {"scanning":false,"age_ms":1200,"items":[{"index":0,"ssid":"xxx","rssi":-60}, ...]} 的 JSON
      * 最多 32 条结果，每条包括 SSID 与 RSSI。为避免占用过多栈空间，
      * 这里改为在堆上分配缓冲区。 */
     const size_t json_buf_size = 3072; /* 足够容纳 32 条典型记录 */
@@ -382,7 +356,11 @@ static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
 
     size_t offset = 0;
 
-    offset += (size_t)snprintf(json + offset, json_buf_size - offset, "{\"items\":[");
+    offset += (size_t)snprintf(json + offset,
+                               json_buf_size - offset,
+                               "{\"scanning\":%s,\"age_ms\":%u,\"items\":[",
+                               info.scanning ? "true" : "false",
+                               (unsigned)info.age_ms);
 
     for (size_t i = 0; i < cnt && offset < json_buf_size; i++) {
         const char *comma = (i == 0) ? "" : ",";
@@ -397,7 +375,7 @@ static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
 
     if (offset >= json_buf_size) {
         /* 理论上不会超出，若超出则截断为一个空列表作为兜底 */
-        const char *FALLBACK = "{\"items\":[]}";
+        const char *FALLBACK = "{\"scanning\":false,\"items\":[]}";
         httpd_resp_send(req, FALLBACK, strlen(FALLBACK));
         free(list);
         free(json);
@@ -564,12 +542,20 @@ static esp_err_t web_module_start_server(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 
     /* 默认 max_uri_handlers 较小，这里适当调大以容纳所有静态资源与 API */
-    config.max_uri_handlers = 12;
+    config.max_uri_handlers = 14;
+
+    /* WebSocket 长连接会占用会话，满员时淘汰最久未活动的连接，保证配网页面可访问 */
+    config.lru_purge_enable = true;
 
     if (s_web_cfg.http_port > 0) {
         config.server_port = (uint16_t)s_web_cfg.http_port;
     }
 
+    /* 绑核后服务器任务不会被调度到实时音频所在的核 */
+    if (s_web_cfg.task_core >= 0) {
+        config.core_id = s_web_cfg.task_core;
+    }
+
     /*
      * 若服务器已启动则直接返回成功，避免重复 start。
      */
@@ -584,39 +570,25 @@ static esp_err_t web_module_start_server(void)
         return ret;
     }
 
-    /* 静态文件路由：根路径与 /index.html 指向同一处理函数 */
-    static const httpd_uri_t uri_root = {
-        .uri      = "/",
-        .method   = HTTP_GET,
-        .handler  = web_module_root_get_handler,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_index = {
-        .uri      = "/index.html",
-        .method   = HTTP_GET,
-        .handler  = web_module_root_get_handler,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_css = {
-        .uri      = "/app.css",
-        .method   = HTTP_GET,
-        .handler  = web_module_css_get_handler,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_js = {
-        .uri      = "/app.js",
-        .method   = HTTP_GET,
-        .handler  = web_module_js_get_handler,
-        .user_ctx = NULL,
-    };
-
-    httpd_register_uri_handler(s_http_server, &uri_root);
-    httpd_register_uri_handler(s_http_server, &uri_index);
-    httpd_register_uri_handler(s_http_server, &uri_css);
-    httpd_register_uri_handler(s_http_server, &uri_js);
+    /* 静态资源路由：每个内置资源注册 "/<name>"，根路径额外指向 index.html
+     * （httpd 注册时会拷贝 URI 字符串，局部缓冲即可） */
+    for (size_t i = 0; i < web_asset_count; i++) {
+        char uri[40];
+        snprintf(uri, sizeof(uri), "/%s", web_assets[i].name);
+
+        httpd_uri_t uri_asset = {
+            .uri      = uri,
+            .method   = HTTP_GET,
+            .handler  = web_module_asset_get_handler,
+            .user_ctx = (void *)&web_assets[i],
+        };
+        httpd_register_uri_handler(s_http_server, &uri_asset);
+
+        if (strcmp(web_assets[i].name, "index.html") == 0) {
+            uri_asset.uri = "/";
+            httpd_register_uri_handler(s_http_server, &uri_asset);
+        }
+    }
 
     /* 仅在配置了回调的前提下注册状态接口，保持职责清晰 */
     if (s_web_cfg.get_status_cb != NULL) {
@@ -684,6 +656,12 @@ static esp_err_t web_module_start_server(void)
         httpd_register_uri_handler(s_http_server, &uri_saved_connect);
     }
 
+    /* WebSocket 通道（可选），失败不影响配网功能 */
+    ret = web_ws_start(s_http_server, &s_web_cfg.ws);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "websocket start failed: %s", esp_err_to_name(ret));
+    }
+
     return ESP_OK;
 }
 
@@ -703,12 +681,7 @@ esp_err_t web_module_init(const web_module_config_t *config)
         return ESP_OK;
     }
 
-    esp_err_t ret = web_module_mount_spiffs();
-    if (ret != ESP_OK) {
-        return ret;
-    }
-
-    ret = web_module_start_server();
+    esp_err_t ret = web_module_start_server();
     if (ret != ESP_OK) {
         return ret;
     }
@@ -0,0 +1,539 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 15:10:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 15:10:00
+ * @FilePath: \xn_esp32_audio\components\xn_web_wifi_manger\src\web_ws.c
+ * @Description: WebSocket 通道实现（共享帧池 + 每客户端有界队列 + httpd 任务内发送）
+ *
+ * 线程模型：
+ *  - 生产者（任意任务）：web_ws_acquire / web_ws_commit，只做取帧、入队，不阻塞
+ *    （s_ws_lock 只尝试获取，httpd 任务正在增删客户端时放弃本帧并计数）；
+ *  - httpd 任务：握手登记客户端、接收数据帧、执行发送工作（逐客户端出队发送）；
+ *    socket 不可写的客户端本轮跳过，发送超时限制为 WEB_WS_SEND_TIMEOUT_MS，慢客户端不会拖住 httpd；
+ *  - 客户端的增删只发生在 httpd 任务中，s_ws_lock 仅用于与生产者遍历客户端表互斥。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+
+#include "web_ws.h"
+
+/* 日志 TAG */
+static const char *TAG = "web_ws";
+
+#if CONFIG_HTTPD_WS_SUPPORT
+
+/* 单帧 socket 发送的最长阻塞时间（可写检查之后仍写不完时才会等待） */
+#define WEB_WS_SEND_TIMEOUT_MS  50
+
+/* 共享发送帧：refs 为持有者数（生产者 1 + 每个入队客户端 1），归零时回到帧池 */
+struct web_ws_frame_s {
+    atomic_uint refs;
+    size_t      len;
+    bool        binary;
+    uint8_t    *data;
+};
+
+/* 客户端槽位（队列在启动时一次性创建，槽位复用） */
+typedef struct {
+    bool          active;
+    int           fd;
+    QueueHandle_t txq;
+} web_ws_client_t;
+
+static web_ws_config_t   s_ws_cfg;
+static httpd_handle_t    s_ws_server  = NULL;
+static SemaphoreHandle_t s_ws_lock    = NULL;
+static QueueHandle_t     s_ws_free    = NULL;   /* 空闲帧 */
+static web_ws_frame_t   *s_ws_frames  = NULL;
+static uint8_t          *s_ws_pool    = NULL;   /* 帧数据区 frame_count * frame_size */
+static web_ws_client_t  *s_ws_clients = NULL;
+static uint8_t          *s_ws_rx_buf  = NULL;   /* 接收缓冲（仅 httpd 任务使用） */
+static volatile uint8_t  s_ws_client_num = 0;
+
+static web_ws_rx_cb_t    s_ws_rx_cb  = NULL;
+static void             *s_ws_rx_ctx = NULL;
+
+static atomic_bool       s_ws_flush_pending;
+static atomic_uint       s_ws_sent;
+static atomic_uint       s_ws_dropped;
+static atomic_uint       s_ws_pool_empty;
+static atomic_uint       s_ws_lock_busy;
+static atomic_uint       s_ws_rx_frames;
+
+/* -------------------- 帧池 -------------------- */
+
+static void web_ws_release(web_ws_frame_t *frame)
+{
+    if (atomic_fetch_sub_explicit(&frame->refs, 1, memory_order_acq_rel) == 1) {
+        (void)xQueueSend(s_ws_free, &frame, 0);
+    }
+}
+
+/* -------------------- 客户端表（仅 httpd 任务增删） -------------------- */
+
+static void web_ws_remove_client(web_ws_client_t *client)
+{
+    xSemaphoreTake(s_ws_lock, portMAX_DELAY);
+    if (client->active) {
+        client->active = false;
+        s_ws_client_num--;
+    }
+    xSemaphoreGive(s_ws_lock);
+
+    /* 出锁后生产者不会再向该队列入队，归还残留帧 */
+    web_ws_frame_t *frame;
+    while (xQueueReceive(client->txq, &frame, 0) == pdTRUE) {
+        web_ws_release(frame);
+    }
+}
+
+static esp_err_t web_ws_add_client(int fd)
+{
+    web_ws_client_t *slot = NULL;
+
+    /* 回收已断开的连接；同一 fd 重新握手视为新会话 */
+    for (uint8_t i = 0; i < s_ws_cfg.max_clients; i++) {
+        web_ws_client_t *c = &s_ws_clients[i];
+        if (c->active &&
+            (c->fd == fd || httpd_ws_get_fd_info(s_ws_server, c->fd) != HTTPD_WS_CLIENT_WEBSOCKET)) {
+            web_ws_remove_client(c);
+        }
+        if (!c->active && slot == NULL) {
+            slot = c;
+        }
+    }
+
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* 缩短发送超时（httpd 默认 send_wait_timeout 为秒级） */
+    struct timeval tv = {
+        .tv_sec  = 0,
+        .tv_usec = WEB_WS_SEND_TIMEOUT_MS * 1000,
+    };
+    (void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    xSemaphoreTake(s_ws_lock, portMAX_DELAY);
+    slot->fd     = fd;
+    slot->active = true;
+    s_ws_client_num++;
+    xSemaphoreGive(s_ws_lock);
+    return ESP_OK;
+}
+
+/* -------------------- 发送（httpd 任务） -------------------- */
+
+/* socket 发送缓冲区是否有空间（不等待） */
+static bool web_ws_writable(int fd)
+{
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    FD_SET(fd, &wfds);
+    struct timeval tv = {0};
+    return select(fd + 1, NULL, &wfds, NULL, &tv) > 0;
+}
+
+/**
+ * @brief 发送工作：逐客户端出队并写 socket
+ *
+ * 先清除调度标志再出队，期间新提交的帧会重新调度一次，不会遗漏。
+ * socket 不可写时跳过该客户端，帧留在其队列中，下次提交时重试（队列满后按慢客户端丢弃）。
+ * 发送失败（对端断开 / 超时）时关闭该连接并归还其队列中的帧。
+ */
+static void web_ws_flush_work(void *arg)
+{
+    (void)arg;
+
+    atomic_store(&s_ws_flush_pending, false);
+
+    for (uint8_t i = 0; i < s_ws_cfg.max_clients; i++) {
+        web_ws_client_t *c = &s_ws_clients[i];
+        if (!c->active) {
+            continue;
+        }
+
+        if (httpd_ws_get_fd_info(s_ws_server, c->fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            web_ws_remove_client(c);
+            continue;
+        }
+
+        web_ws_frame_t *frame;
+        while (web_ws_writable(c->fd) && xQueueReceive(c->txq, &frame, 0) == pdTRUE) {
+            httpd_ws_frame_t pkt = {
+                .final   = true,
+                .type    = frame->binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+                .payload = frame->data,
+                .len     = frame->len,
+            };
+            esp_err_t ret = httpd_ws_send_frame_async(s_ws_server, c->fd, &pkt);
+            web_ws_release(frame);
+
+            if (ret != ESP_OK) {
+                ESP_LOGW(TAG, "发送到 fd %d 失败: %s，关闭连接", c->fd, esp_err_to_name(ret));
+                (void)httpd_sess_trigger_close(s_ws_server, c->fd);
+                web_ws_remove_client(c);
+                break;
+            }
+            atomic_fetch_add_explicit(&s_ws_sent, 1, memory_order_relaxed);
+        }
+    }
+}
+
+static void web_ws_schedule_flush(void)
+{
+    if (atomic_exchange(&s_ws_flush_pending, true)) {
+        return;
+    }
+    if (httpd_queue_work(s_ws_server, web_ws_flush_work, NULL) != ESP_OK) {
+        atomic_store(&s_ws_flush_pending, false);
+    }
+}
+
+/* -------------------- URI 处理（httpd 任务） -------------------- */
+
+static esp_err_t web_ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        /* 握手完成：登记客户端，满员时返回错误由 httpd 关闭连接 */
+        int fd = httpd_req_to_sockfd(req);
+        if (web_ws_add_client(fd) != ESP_OK) {
+            ESP_LOGW(TAG, "客户端已满，拒绝 fd %d", fd);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "客户端已连接: fd=%d (%u/%u)", fd,
+                 (unsigned)s_ws_client_num, (unsigned)s_ws_cfg.max_clients);
+        return ESP_OK;
+    }
+
+    /* 先取长度再取数据，控制帧由 httpd 自动处理 */
+    httpd_ws_frame_t pkt = {0};
+    esp_err_t        ret = httpd_ws_recv_frame(req, &pkt, 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (pkt.len == 0) {
+        return ESP_OK;
+    }
+    if (pkt.len > s_ws_cfg.rx_max) {
+        ESP_LOGW(TAG, "接收帧过大: %u", (unsigned)pkt.len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pkt.payload = s_ws_rx_buf;
+    ret         = httpd_ws_recv_frame(req, &pkt, pkt.len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_ws_rx_buf[pkt.len] = '\0';
+
+    if (pkt.type != HTTPD_WS_TYPE_BINARY && pkt.type != HTTPD_WS_TYPE_TEXT) {
+        return ESP_OK;
+    }
+
+    atomic_fetch_add_explicit(&s_ws_rx_frames, 1, memory_order_relaxed);
+
+    web_ws_rx_cb_t cb  = s_ws_rx_cb;
+    void          *ctx = s_ws_rx_ctx;
+    if (cb) {
+        cb(pkt.type == HTTPD_WS_TYPE_BINARY, s_ws_rx_buf, pkt.len, ctx);
+    }
+    return ESP_OK;
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+esp_err_t web_ws_start(httpd_handle_t server, const web_ws_config_t *config)
+{
+    if (server == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->max_clients == 0) {
+        return ESP_OK;
+    }
+    if (config->uri == NULL || config->queue_depth == 0 ||
+        config->frame_count == 0 || config->frame_size == 0 || config->rx_max == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ws_server != NULL) {
+        return ESP_OK;
+    }
+
+    s_ws_cfg = *config;
+
+    s_ws_lock    = xSemaphoreCreateMutex();
+    s_ws_free    = xQueueCreate(s_ws_cfg.frame_count, sizeof(web_ws_frame_t *));
+    s_ws_frames  = calloc(s_ws_cfg.frame_count, sizeof(web_ws_frame_t));
+    s_ws_clients = calloc(s_ws_cfg.max_clients, sizeof(web_ws_client_t));
+    /* 帧数据较大且只被 lwIP 拷贝读取，优先放 PSRAM */
+    s_ws_pool = heap_caps_malloc(s_ws_cfg.frame_count * s_ws_cfg.frame_size,
+                                 MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (s_ws_pool == NULL) {
+        s_ws_pool = malloc(s_ws_cfg.frame_count * s_ws_cfg.frame_size);
+    }
+    s_ws_rx_buf = heap_caps_malloc(s_ws_cfg.rx_max + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (s_ws_rx_buf == NULL) {
+        s_ws_rx_buf = malloc(s_ws_cfg.rx_max + 1);
+    }
+    if (!s_ws_lock || !s_ws_free || !s_ws_frames || !s_ws_clients || !s_ws_pool || !s_ws_rx_buf) {
+        goto fail;
+    }
+
+    for (uint8_t i = 0; i < s_ws_cfg.max_clients; i++) {
+        s_ws_clients[i].txq = xQueueCreate(s_ws_cfg.queue_depth, sizeof(web_ws_frame_t *));
+        if (s_ws_clients[i].txq == NULL) {
+            goto fail;
+        }
+    }
+
+    for (uint8_t i = 0; i < s_ws_cfg.frame_count; i++) {
+        web_ws_frame_t *frame = &s_ws_frames[i];
+        atomic_init(&frame->refs, 0);
+        frame->data = s_ws_pool + (size_t)i * s_ws_cfg.frame_size;
+        (void)xQueueSend(s_ws_free, &frame, 0);
+    }
+
+    atomic_init(&s_ws_flush_pending, false);
+    s_ws_server = server;
+
+    httpd_uri_t uri_ws = {
+        .uri                      = s_ws_cfg.uri,
+        .method                   = HTTP_GET,
+        .handler                  = web_ws_handler,
+        .user_ctx                 = NULL,
+        .is_websocket             = true,
+        .handle_ws_control_frames = false,
+    };
+    esp_err_t ret = httpd_register_uri_handler(server, &uri_ws);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "注册 %s 失败: %s", s_ws_cfg.uri, esp_err_to_name(ret));
+        s_ws_server = NULL;
+        goto fail_ret;
+    }
+
+    ESP_LOGI(TAG, "WebSocket %s 就绪: 客户端=%u, 帧池=%ux%uB",
+             s_ws_cfg.uri, (unsigned)s_ws_cfg.max_clients,
+             (unsigned)s_ws_cfg.frame_count, (unsigned)s_ws_cfg.frame_size);
+    return ESP_OK;
+
+fail:
+    ret = ESP_ERR_NO_MEM;
+fail_ret:
+    if (s_ws_clients) {
+        for (uint8_t i = 0; i < s_ws_cfg.max_clients; i++) {
+            if (s_ws_clients[i].txq) {
+                vQueueDelete(s_ws_clients[i].txq);
+            }
+        }
+        free(s_ws_clients);
+        s_ws_clients = NULL;
+    }
+    if (s_ws_free) {
+        vQueueDelete(s_ws_free);
+        s_ws_free = NULL;
+    }
+    if (s_ws_lock) {
+        vSemaphoreDelete(s_ws_lock);
+        s_ws_lock = NULL;
+    }
+    free(s_ws_frames);
+    s_ws_frames = NULL;
+    heap_caps_free(s_ws_pool);
+    s_ws_pool = NULL;
+    heap_caps_free(s_ws_rx_buf);
+    s_ws_rx_buf = NULL;
+    return ret;
+}
+
+void web_ws_set_rx_cb(web_ws_rx_cb_t cb, void *user_ctx)
+{
+    s_ws_rx_ctx = user_ctx;
+    s_ws_rx_cb  = cb;
+}
+
+uint8_t web_ws_client_count(void)
+{
+    return s_ws_client_num;
+}
+
+web_ws_frame_t *web_ws_acquire(uint8_t **buf, size_t *capacity)
+{
+    if (buf == NULL || s_ws_server == NULL || s_ws_client_num == 0) {
+        return NULL;
+    }
+
+    web_ws_frame_t *frame = NULL;
+    if (xQueueReceive(s_ws_free, &frame, 0) != pdTRUE) {
+        atomic_fetch_add_explicit(&s_ws_pool_empty, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    atomic_store_explicit(&frame->refs, 1, memory_order_relaxed);
+    *buf = frame->data;
+    if (capacity) {
+        *capacity = s_ws_cfg.frame_size;
+    }
+    return frame;
+}
+
+esp_err_t web_ws_commit(web_ws_frame_t *frame, size_t len, bool binary)
+{
+    if (frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0 || len > s_ws_cfg.frame_size) {
+        web_ws_release(frame);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    frame->len    = len;
+    frame->binary = binary;
+
+    /* httpd 任务正在增删客户端：放弃本帧，生产者不等待 */
+    if (xSemaphoreTake(s_ws_lock, 0) != pdTRUE) {
+        atomic_fetch_add_explicit(&s_ws_lock_busy, 1, memory_order_relaxed);
+        web_ws_release(frame);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uint8_t queued = 0;
+    for (uint8_t i = 0; i < s_ws_cfg.max_clients; i++) {
+        web_ws_client_t *c = &s_ws_clients[i];
+        if (!c->active) {
+            continue;
+        }
+        atomic_fetch_add_explicit(&frame->refs, 1, memory_order_relaxed);
+        if (xQueueSend(c->txq, &frame, 0) == pdTRUE) {
+            queued++;
+        } else {
+            /* 慢客户端：丢弃本帧，不影响其它客户端和生产者 */
+            atomic_fetch_sub_explicit(&frame->refs, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&s_ws_dropped, 1, memory_order_relaxed);
+        }
+    }
+    xSemaphoreGive(s_ws_lock);
+
+    /* 释放生产者持有的引用 */
+    web_ws_release(frame);
+
+    if (queued == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    web_ws_schedule_flush();
+    return ESP_OK;
+}
+
+void web_ws_discard(web_ws_frame_t *frame)
+{
+    if (frame != NULL) {
+        web_ws_release(frame);
+    }
+}
+
+esp_err_t web_ws_send(const void *data, size_t len, bool binary)
+{
+    if (data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ws_server != NULL && len > s_ws_cfg.frame_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t        *buf   = NULL;
+    web_ws_frame_t *frame = web_ws_acquire(&buf, NULL);
+    if (frame == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memcpy(buf, data, len);
+    return web_ws_commit(frame, len, binary);
+}
+
+void web_ws_get_stats(web_ws_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    stats->clients        = s_ws_client_num;
+    stats->sent_frames    = atomic_load_explicit(&s_ws_sent, memory_order_relaxed);
+    stats->dropped_frames = atomic_load_explicit(&s_ws_dropped, memory_order_relaxed);
+    stats->pool_empty     = atomic_load_explicit(&s_ws_pool_empty, memory_order_relaxed);
+    stats->lock_busy      = atomic_load_explicit(&s_ws_lock_busy, memory_order_relaxed);
+    stats->rx_frames      = atomic_load_explicit(&s_ws_rx_frames, memory_order_relaxed);
+}
+
+#else /* !CONFIG_HTTPD_WS_SUPPORT */
+
+esp_err_t web_ws_start(httpd_handle_t server, const web_ws_config_t *config)
+{
+    (void)server;
+    if (config != NULL && config->max_clients > 0) {
+        ESP_LOGW(TAG, "未启用 CONFIG_HTTPD_WS_SUPPORT，WebSocket 不可用");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+void web_ws_set_rx_cb(web_ws_rx_cb_t cb, void *user_ctx)
+{
+    (void)cb;
+    (void)user_ctx;
+}
+
+uint8_t web_ws_client_count(void)
+{
+    return 0;
+}
+
+web_ws_frame_t *web_ws_acquire(uint8_t **buf, size_t *capacity)
+{
+    (void)buf;
+    (void)capacity;
+    return NULL;
+}
+
+esp_err_t web_ws_commit(web_ws_frame_t *frame, size_t len, bool binary)
+{
+    (void)frame;
+    (void)len;
+    (void)binary;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void web_ws_discard(web_ws_frame_t *frame)
+{
+    (void)frame;
+}
+
+esp_err_t web_ws_send(const void *data, size_t len, bool binary)
+{
+    (void)data;
+    (void)len;
+    (void)binary;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void web_ws_get_stats(web_ws_stats_t *stats)
+{
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+#endif /* CONFIG_HTTPD_WS_SUPPORT */
@@ -14,6 +14,8 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 
 #include "esp_event.h"
 #include "esp_log.h"
@@ -39,6 +41,21 @@ static bool s_connecting = false;
 static esp_netif_t *s_sta_netif = NULL;
 static esp_netif_t *s_ap_netif  = NULL;
 
+/* 扫描完成事件位（wifi_module_scan 同步等待用） */
+#define WIFI_MODULE_SCAN_DONE_BIT   (1u << 0)
+/* 扫描超时：超过该时间仍未收到 SCAN_DONE 视为丢失，允许重新发起 */
+#define WIFI_MODULE_SCAN_TIMEOUT_MS 10000
+
+/* 扫描状态与结果缓存：事件循环任务写入，httpd / 管理任务读取，由 s_scan_lock 保护 */
+static SemaphoreHandle_t  s_scan_lock        = NULL;
+static EventGroupHandle_t s_scan_events      = NULL;
+static bool               s_scan_in_progress = false;
+static bool               s_scan_valid       = false;
+static TickType_t         s_scan_start_tick  = 0;
+static TickType_t         s_scan_done_tick   = 0;
+static uint16_t           s_scan_count       = 0;
+static wifi_module_scan_result_t s_scan_cache[WIFI_MODULE_SCAN_MAX_AP];
+
 /**
  * @brief 统一转发 WiFi 模块事件到上层回调
  */
@@ -49,6 +66,65 @@ static void wifi_module_handle_event(wifi_module_event_t event)
     }
 }
 
+/**
+ * @brief 扫描完成：取出驱动中的 AP 列表并刷新缓存
+ *
+ * 在事件循环任务中执行；取记录会同时释放驱动内部的扫描列表。
+ * 扫描失败时保留上一次缓存（旧结果也比空列表有用），仅结束“扫描中”状态。
+ */
+static void wifi_module_on_scan_done(const wifi_event_sta_scan_done_t *done)
+{
+    bool              ok      = (done == NULL || done->status == 0);
+    uint16_t          ap_num  = 0;
+    wifi_ap_record_t *ap_list = NULL;
+
+    if (ok) {
+        (void)esp_wifi_scan_get_ap_num(&ap_num);
+        if (ap_num > WIFI_MODULE_SCAN_MAX_AP) {
+            ap_num = WIFI_MODULE_SCAN_MAX_AP;
+        }
+        if (ap_num > 0) {
+            ap_list = calloc(ap_num, sizeof(wifi_ap_record_t));
+            if (ap_list == NULL ||
+                esp_wifi_scan_get_ap_records(&ap_num, ap_list) != ESP_OK) {
+                ok     = false;
+                ap_num = 0;
+            }
+        }
+    }
+
+    if (!ok || ap_num == 0) {
+        /* 未取记录时驱动列表不会自动释放，这里主动清理 */
+        (void)esp_wifi_clear_ap_list();
+    }
+
+    xSemaphoreTake(s_scan_lock, portMAX_DELAY);
+    if (ok) {
+        for (uint16_t i = 0; i < ap_num; ++i) {
+            memset(s_scan_cache[i].ssid, 0, sizeof(s_scan_cache[i].ssid));
+            strncpy(s_scan_cache[i].ssid,
+                    (const char *)ap_list[i].ssid,
+                    sizeof(s_scan_cache[i].ssid) - 1);
+            s_scan_cache[i].rssi = ap_list[i].rssi;
+        }
+        s_scan_count     = ap_num;
+        s_scan_valid     = true;
+        s_scan_done_tick = xTaskGetTickCount();
+    }
+    s_scan_in_progress = false;
+    xSemaphoreGive(s_scan_lock);
+
+    xEventGroupSetBits(s_scan_events, WIFI_MODULE_SCAN_DONE_BIT);
+
+    free(ap_list);
+
+    if (ok) {
+        ESP_LOGI(TAG, "wifi scan done: found %u AP(s)", (unsigned)ap_num);
+    } else {
+        ESP_LOGW(TAG, "wifi scan failed, keep previous results");
+    }
+}
+
 /**
  * @brief WiFi 事件回调
  *
@@ -72,7 +148,8 @@ static void wifi_module_event_handler(void *arg,
         break;
 
     case WIFI_EVENT_SCAN_DONE:
-        /* 扫描完成（wifi_module_scan 为同步扫描，此处通常也不处理） */
+        /* 异步扫描完成，刷新结果缓存 */
+        wifi_module_on_scan_done((const wifi_event_sta_scan_done_t *)event_data);
         break;
 
     case WIFI_EVENT_STA_START:
@@ -319,7 +396,19 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config)
         }
     }
 
-    /* 8. 注册 WiFi / IP 事件处理函数 */
+    /* 8. 创建扫描缓存锁与完成事件（须早于事件注册，SCAN_DONE 回调会用到） */
+    if (s_scan_lock == NULL) {
+        s_scan_lock = xSemaphoreCreateMutex();
+    }
+    if (s_scan_events == NULL) {
+        s_scan_events = xEventGroupCreate();
+    }
+    if (s_scan_lock == NULL || s_scan_events == NULL) {
+        ESP_LOGE(TAG, "create scan lock failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* 9. 注册 WiFi / IP 事件处理函数 */
     ret = esp_event_handler_register(WIFI_EVENT,
                                      ESP_EVENT_ANY_ID,
                                      &wifi_module_event_handler,
@@ -340,7 +429,7 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config)
         return ret;
     }
 
-    /* 9. 启动 WiFi 驱动 */
+    /* 10. 启动 WiFi 驱动 */
     ret = esp_wifi_start();
     if (ret != ESP_OK && ret != ESP_ERR_WIFI_CONN) {
         ESP_LOGE(TAG, "esp_wifi_start failed: %s", esp_err_to_name(ret));
@@ -358,6 +447,19 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config)
  * @param password AP 密码，可为 NULL/空串 表示开放网络
  */
 esp_err_t wifi_module_connect(const char *ssid, const char *password)
+{
+    return wifi_module_connect_ex(ssid, password, NULL);
+}
+
+/**
+ * @brief 以 STA 模式连接指定 AP（可带上次 AP 信息）
+ *
+ * @param ssid     目标 AP SSID，必须非 NULL 且非空
+ * @param password AP 密码，可为 NULL/空串 表示开放网络
+ * @param hint     上次成功连接的 AP 信息，可为 NULL
+ */
+esp_err_t wifi_module_connect_ex(const char *ssid, const char *password,
+                                 const wifi_module_ap_hint_t *hint)
 {
     if (!s_wifi_inited) {
         return ESP_ERR_INVALID_STATE;
@@ -383,6 +485,22 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password)
         sta_cfg.sta.password[sizeof(sta_cfg.sta.password) - 1] = '\0';
     }
 
+    /* PMF 按能力协商，兼容要求 / 不要求 PMF 的 AP */
+    sta_cfg.sta.pmf_cfg.capable = true;
+
+    if (hint != NULL && hint->valid && hint->channel != 0) {
+        /* 快速重连：锁定 BSSID + 信道，只扫描一个信道 */
+        sta_cfg.sta.scan_method        = WIFI_FAST_SCAN;
+        sta_cfg.sta.bssid_set          = true;
+        memcpy(sta_cfg.sta.bssid, hint->bssid, sizeof(sta_cfg.sta.bssid));
+        sta_cfg.sta.channel            = hint->channel;
+        sta_cfg.sta.threshold.authmode = (wifi_auth_mode_t)hint->authmode;
+    } else {
+        /* 全信道扫描，同名多 AP 时选信号最强的一个 */
+        sta_cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        sta_cfg.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+
     esp_err_t   ret;
     wifi_mode_t mode = WIFI_MODE_NULL;
 
@@ -424,77 +542,171 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password)
         return ret;
     }
 
+    if (sta_cfg.sta.bssid_set) {
+        ESP_LOGI(TAG, "fast connect: ssid=%s ch=%u", (const char *)sta_cfg.sta.ssid,
+                 (unsigned)sta_cfg.sta.channel);
+    } else {
+        ESP_LOGI(TAG, "connect: ssid=%s (all-channel scan)", (const char *)sta_cfg.sta.ssid);
+    }
     return ESP_OK;
 }
 
 /**
- * @brief 同步扫描附近 AP
- *
- * @param results     输出数组，长度由 *count_inout 指定
- * @param count_inout 入参：results 最大容量；出参：实际返回数量
+ * @brief 读取当前已连接 AP 的 BSSID / 信道 / 加密方式
  */
-esp_err_t wifi_module_scan(wifi_module_scan_result_t *results, uint16_t *count_inout)
+esp_err_t wifi_module_get_ap_hint(wifi_module_ap_hint_t *hint)
 {
-    if (!s_wifi_inited || !s_wifi_cfg.enable_sta ||
-        results == NULL || count_inout == NULL || *count_inout == 0) {
+    if (hint == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    wifi_scan_config_t scan_cfg = {0};
+    memset(hint, 0, sizeof(*hint));
 
-    ESP_LOGI(TAG, "start wifi scan, max_out=%u", (unsigned)(*count_inout));
+    if (!s_wifi_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    /* 阻塞式扫描，直到完成 */
-    esp_err_t ret = esp_wifi_scan_start(&scan_cfg, true);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "wifi scan start failed: %s", esp_err_to_name(ret));
-        return ret;
+    wifi_ap_record_t ap_info = {0};
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    uint16_t ap_num = 0;
-    ret             = esp_wifi_scan_get_ap_num(&ap_num);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "wifi scan get num failed: %s", esp_err_to_name(ret));
-        return ret;
+    memcpy(hint->bssid, ap_info.bssid, sizeof(hint->bssid));
+    hint->channel  = ap_info.primary;
+    hint->authmode = (uint8_t)ap_info.authmode;
+    hint->valid    = (ap_info.primary != 0);
+    return ESP_OK;
+}
+
+/**
+ * @brief 请求一次异步扫描
+ *
+ * 仅在非扫描中、且缓存过期（或 force）时真正调用驱动；
+ * 扫描参数取自初始化配置中的 scan_* 字段。
+ */
+esp_err_t wifi_module_scan_request(bool force)
+{
+    if (!s_wifi_inited || !s_wifi_cfg.enable_sta) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    if (ap_num == 0) {
-        ESP_LOGI(TAG, "wifi scan done: found 0 AP");
-        *count_inout = 0;
+    TickType_t now = xTaskGetTickCount();
+
+    xSemaphoreTake(s_scan_lock, portMAX_DELAY);
+    if (s_scan_in_progress &&
+        (now - s_scan_start_tick) < pdMS_TO_TICKS(WIFI_MODULE_SCAN_TIMEOUT_MS)) {
+        /* 已有扫描在进行，结果到达后统一刷新缓存 */
+        xSemaphoreGive(s_scan_lock);
+        return ESP_OK;
+    }
+    if (!force && s_scan_valid &&
+        (now - s_scan_done_tick) < pdMS_TO_TICKS(s_wifi_cfg.scan_cache_ttl_ms)) {
+        /* 缓存仍在有效期内 */
+        xSemaphoreGive(s_scan_lock);
         return ESP_OK;
     }
+    s_scan_in_progress = true;
+    s_scan_start_tick  = now;
+    xEventGroupClearBits(s_scan_events, WIFI_MODULE_SCAN_DONE_BIT);
+    xSemaphoreGive(s_scan_lock);
 
-    uint16_t max_out = *count_inout;
-    if (max_out == 0) {
+    /* 逐信道扫描：已连接时每个信道之间回到工作信道，避免长时间离开导致链路与音频上行中断 */
+    wifi_scan_config_t scan_cfg = {0};
+    scan_cfg.show_hidden          = false;
+    scan_cfg.home_chan_dwell_time = s_wifi_cfg.scan_home_dwell_ms;
+    if (s_wifi_cfg.scan_passive) {
+        scan_cfg.scan_type         = WIFI_SCAN_TYPE_PASSIVE;
+        scan_cfg.scan_time.passive = s_wifi_cfg.scan_dwell_ms;
+    } else {
+        scan_cfg.scan_type            = WIFI_SCAN_TYPE_ACTIVE;
+        scan_cfg.scan_time.active.min = s_wifi_cfg.scan_dwell_ms;
+        scan_cfg.scan_time.active.max = s_wifi_cfg.scan_dwell_ms;
+    }
+
+    esp_err_t ret = esp_wifi_scan_start(&scan_cfg, false);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "wifi scan start failed: %s", esp_err_to_name(ret));
+        xSemaphoreTake(s_scan_lock, portMAX_DELAY);
+        s_scan_in_progress = false;
+        xSemaphoreGive(s_scan_lock);
+        xEventGroupSetBits(s_scan_events, WIFI_MODULE_SCAN_DONE_BIT);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "start wifi scan (%s, dwell=%ums)",
+             s_wifi_cfg.scan_passive ? "passive" : "active",
+             (unsigned)s_wifi_cfg.scan_dwell_ms);
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取扫描缓存
+ *
+ * @param results     输出数组，可为 NULL
+ * @param count_inout 入参：results 最大容量；出参：实际返回数量
+ * @param info        输出缓存状态，可为 NULL
+ */
+esp_err_t wifi_module_scan_get_cached(wifi_module_scan_result_t *results,
+                                      uint16_t *count_inout,
+                                      wifi_module_scan_info_t *info)
+{
+    if (!s_wifi_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (results != NULL && count_inout == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (ap_num > max_out) {
-        ap_num = max_out;
+    TickType_t now = xTaskGetTickCount();
+
+    xSemaphoreTake(s_scan_lock, portMAX_DELAY);
+    if (results != NULL) {
+        uint16_t out = s_scan_count;
+        if (out > *count_inout) {
+            out = *count_inout;
+        }
+        memcpy(results, s_scan_cache, out * sizeof(wifi_module_scan_result_t));
+        *count_inout = out;
+    }
+    if (info != NULL) {
+        info->in_progress = s_scan_in_progress;
+        info->valid       = s_scan_valid;
+        info->age_ms      = s_scan_valid
+                                ? (uint32_t)((now - s_scan_done_tick) * portTICK_PERIOD_MS)
+                                : 0;
     }
+    xSemaphoreGive(s_scan_lock);
 
-    wifi_ap_record_t *ap_list = calloc(ap_num, sizeof(wifi_ap_record_t));
-    if (ap_list == NULL) {
-        return ESP_ERR_NO_MEM;
+    return ESP_OK;
+}
+
+/**
+ * @brief 同步扫描附近 AP
+ *
+ * @param results     输出数组，长度由 *count_inout 指定
+ * @param count_inout 入参：results 最大容量；出参：实际返回数量
+ */
+esp_err_t wifi_module_scan(wifi_module_scan_result_t *results, uint16_t *count_inout)
+{
+    if (!s_wifi_inited || !s_wifi_cfg.enable_sta ||
+        results == NULL || count_inout == NULL || *count_inout == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    ret = esp_wifi_scan_get_ap_records(&ap_num, ap_list);
+    esp_err_t ret = wifi_module_scan_request(true);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "wifi scan get records failed: %s", esp_err_to_name(ret));
-        free(ap_list);
         return ret;
     }
 
-    for (uint16_t i = 0; i < ap_num; ++i) {
-        memset(results[i].ssid, 0, sizeof(results[i].ssid));
-        strncpy(results[i].ssid,
-                (const char *)ap_list[i].ssid,
-                sizeof(results[i].ssid) - 1);
-        results[i].rssi = ap_list[i].rssi;
+    EventBits_t bits = xEventGroupWaitBits(s_scan_events,
+                                           WIFI_MODULE_SCAN_DONE_BIT,
+                                           pdFALSE,
+                                           pdTRUE,
+                                           pdMS_TO_TICKS(WIFI_MODULE_SCAN_TIMEOUT_MS));
+    if ((bits & WIFI_MODULE_SCAN_DONE_BIT) == 0) {
+        ESP_LOGE(TAG, "wifi scan timeout");
+        return ESP_ERR_TIMEOUT;
     }
 
-    *count_inout = ap_num;
-    ESP_LOGI(TAG, "wifi scan done: found %u AP(s), out=%u", (unsigned)ap_num, (unsigned)(*count_inout));
-    free(ap_list);
-    return ESP_OK;
+    return wifi_module_scan_get_cached(results, count_inout, NULL);
 }
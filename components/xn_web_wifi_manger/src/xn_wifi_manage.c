@@ -47,7 +47,70 @@ static void wifi_manage_notify_state(wifi_manage_state_t new_state)
 /* 遍历已保存 WiFi 时的状态 */
 static bool       s_wifi_connecting   = false;  /* 当前是否有一次 STA 连接正在进行 */
 static uint8_t    s_wifi_try_index    = 0;      /* 本轮遍历中，正在尝试的 WiFi 下标 */
+static bool       s_wifi_try_fast     = false;  /* 当前这次连接是否为“上次 AP 单信道快速重连” */
+static bool       s_wifi_try_full     = false;  /* 当前条目快速重连已失败，下一次改用全信道连接 */
 static TickType_t s_connect_failed_ts = 0;      /* 最近一次全轮尝试失败的时间戳 */
+static uint8_t    s_backoff_round     = 0;      /* 连续整轮失败次数，决定退避等待时长 */
+static volatile bool s_retry_now      = false;  /* Web 端主动触发连接，跳过当前退避等待 */
+static bool       s_web_started       = false;  /* Web 配网服务器是否已启动 */
+static volatile bool s_web_request    = false;  /* 请求在管理任务中启动 Web 配网服务器 */
+static volatile bool s_storage_commit = false;  /* 存储延迟提交到期，在管理任务中写入 flash */
+
+/* 退避轮次上限（仅用于防止计数溢出，实际等待受 reconnect_max_interval_ms 限制） */
+#define WIFI_MANAGE_BACKOFF_ROUND_MAX 16
+
+/* 唤醒管理任务立即执行一步状态机（事件回调 / Web 回调中调用） */
+static void wifi_manage_kick(void)
+{
+    if (s_wifi_manage_task != NULL) {
+        xTaskNotifyGive(s_wifi_manage_task);
+    }
+}
+
+/* 存储模块延迟提交到期（esp_timer 任务中调用）：只置位并唤醒管理任务 */
+static void wifi_manage_on_storage_commit(void)
+{
+    s_storage_commit = true;
+    wifi_manage_kick();
+}
+
+/* 将已保存条目中的“上次 AP”字段转换为快速重连信息（bssid_set 表示记录有效） */
+static void wifi_manage_hint_from_config(const wifi_config_t *cfg, wifi_module_ap_hint_t *hint)
+{
+    memset(hint, 0, sizeof(*hint));
+    hint->valid    = cfg->sta.bssid_set && cfg->sta.channel != 0;
+    hint->channel  = cfg->sta.channel;
+    hint->authmode = (uint8_t)cfg->sta.threshold.authmode;
+    memcpy(hint->bssid, cfg->sta.bssid, sizeof(hint->bssid));
+}
+
+/* 将本次连接成功的 AP 信息写入条目，随存储列表一起持久化 */
+static void wifi_manage_hint_to_config(const wifi_module_ap_hint_t *hint, wifi_config_t *cfg)
+{
+    cfg->sta.bssid_set          = hint->valid;
+    cfg->sta.channel            = hint->valid ? hint->channel : 0;
+    cfg->sta.threshold.authmode = (wifi_auth_mode_t)(hint->valid ? hint->authmode : 0);
+    memcpy(cfg->sta.bssid, hint->bssid, sizeof(cfg->sta.bssid));
+}
+
+/* 当前退避轮次对应的等待时长：reconnect_interval_ms * 2^(round-1)，封顶 reconnect_max_interval_ms */
+static uint32_t wifi_manage_backoff_ms(void)
+{
+    uint32_t delay = (s_wifi_cfg.reconnect_interval_ms <= 0)
+                         ? 0
+                         : (uint32_t)s_wifi_cfg.reconnect_interval_ms;
+    uint32_t limit = (s_wifi_cfg.reconnect_max_interval_ms > 0)
+                         ? (uint32_t)s_wifi_cfg.reconnect_max_interval_ms
+                         : delay;
+    if (limit < delay) {
+        limit = delay;
+    }
+
+    for (uint8_t i = 1; i < s_backoff_round && delay < limit; i++) {
+        delay *= 2;
+    }
+    return (delay > limit) ? limit : delay;
+}
 
 /* -------------------- Web 回调：查询当前 WiFi 状态 -------------------- */
 /**
@@ -229,48 +292,52 @@ static esp_err_t wifi_manage_delete_web_saved(const char *ssid)
 /**
  * @brief 提供给 Web 的“扫描附近 WiFi”回调
  *
- * 通过底层 wifi_module_scan 获取一次附近 AP 列表，
- * 并转换为 Web 端展示所需的精简字段。
+ * 运行在 httpd 任务中，不等待扫描：缓存过期或 refresh 时在后台发起一次异步扫描，
+ * 随即返回当前缓存结果与“扫描中”标志，由前端稍后再次拉取。
  */
-static esp_err_t wifi_manage_scan_web(web_scan_result_t *list, size_t *inout_cnt)
+static esp_err_t wifi_manage_scan_web(bool refresh, web_scan_result_t *list, size_t *inout_cnt,
+                                      web_scan_info_t *info)
 {
-    if (list == NULL || inout_cnt == NULL || *inout_cnt == 0) {
+    if (list == NULL || inout_cnt == NULL || *inout_cnt == 0 || info == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "web scan request: max_cnt=%u", (unsigned)(*inout_cnt));
+    /* 发起失败（如 STA 正在连接时驱动拒绝扫描）不影响返回已有缓存 */
+    esp_err_t ret = wifi_module_scan_request(refresh);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "web scan request deferred: %s", esp_err_to_name(ret));
+    }
+
+    uint16_t count = (*inout_cnt < WIFI_MODULE_SCAN_MAX_AP)
+                         ? (uint16_t)(*inout_cnt)
+                         : WIFI_MODULE_SCAN_MAX_AP;
 
-    uint16_t cap = (uint16_t)(*inout_cnt);
+    /* httpd 任务栈较小，结果缓冲放在堆上 */
     wifi_module_scan_result_t *results =
-        (wifi_module_scan_result_t *)malloc(cap * sizeof(wifi_module_scan_result_t));
+        (wifi_module_scan_result_t *)malloc(count * sizeof(wifi_module_scan_result_t));
     if (results == NULL) {
         *inout_cnt = 0;
         return ESP_ERR_NO_MEM;
     }
 
-    uint16_t count = cap;
-    esp_err_t ret = wifi_module_scan(results, &count);
+    wifi_module_scan_info_t scan_info = {0};
+    ret = wifi_module_scan_get_cached(results, &count, &scan_info);
     if (ret != ESP_OK) {
         free(results);
         *inout_cnt = 0;
         return ret;
     }
 
-    ESP_LOGI(TAG, "wifi scan done: count=%u", (unsigned)count);
-
-    size_t out_cnt = (size_t)count;
-    if (out_cnt > *inout_cnt) {
-        out_cnt = *inout_cnt;
-    }
-
-    for (size_t i = 0; i < out_cnt; i++) {
+    for (size_t i = 0; i < count; i++) {
         strncpy(list[i].ssid, results[i].ssid, sizeof(list[i].ssid));
         list[i].ssid[sizeof(list[i].ssid) - 1] = '\0';
         list[i].rssi = results[i].rssi;
     }
 
     free(results);
-    *inout_cnt = out_cnt;
+    *inout_cnt     = count;
+    info->scanning = scan_info.in_progress;
+    info->age_ms   = scan_info.age_ms;
     return ESP_OK;
 }
 
@@ -337,8 +404,11 @@ static esp_err_t wifi_manage_connect_web_saved(const char *ssid)
     }
 
     /* 主动断开当前连接，让状态机在后续收到“断开”事件后，
-     * 按最新优先级从首选 WiFi 开始重新尝试连接。 */
+     * 按最新优先级从首选 WiFi 开始重新尝试连接；
+     * 若正处于失败退避中（无连接可断开），则跳过剩余等待立即重试。 */
     (void)esp_wifi_disconnect();
+    s_retry_now = true;
+    wifi_manage_kick();
 
     return ESP_OK;
 }
@@ -359,6 +429,47 @@ static esp_err_t wifi_manage_connect_web_form(const char *ssid, const char *pass
     return wifi_module_connect(ssid, pwd);
 }
 
+/* -------------------- Web 配网服务器 -------------------- */
+/**
+ * @brief 启动 Web 配网服务器（已启动时直接返回）
+ *
+ * 按需模式下由管理任务在需要配网时调用，避免每次上电都启动 httpd。
+ */
+static esp_err_t wifi_manage_start_web(void)
+{
+    if (s_web_started) {
+        return ESP_OK;
+    }
+
+    web_module_config_t web_cfg = WEB_MODULE_DEFAULT_CONFIG();
+
+    /* 端口由管理配置决定，<=0 时沿用默认值 */
+    if (s_wifi_cfg.web_port > 0) {
+        web_cfg.http_port = s_wifi_cfg.web_port;
+    }
+
+    /* WebSocket 通道按需开启，未开启时不分配帧池 */
+    web_cfg.ws.max_clients = (uint8_t)(s_wifi_cfg.web_ws_clients > 0 ? s_wifi_cfg.web_ws_clients : 0);
+    web_cfg.task_core = s_wifi_cfg.task_core;
+
+    /* 通过回调向 Web 模块暴露当前 WiFi 状态与已保存列表等能力 */
+    web_cfg.get_status_cb     = wifi_manage_get_web_status;
+    web_cfg.get_saved_list_cb = wifi_manage_get_web_saved_list;
+    web_cfg.scan_cb           = wifi_manage_scan_web;
+    web_cfg.delete_saved_cb   = wifi_manage_delete_web_saved;
+    web_cfg.connect_saved_cb  = wifi_manage_connect_web_saved;
+    web_cfg.connect_cb        = wifi_manage_connect_web_form;
+
+    esp_err_t ret = web_module_init(&web_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "web server start failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_web_started = true;
+    ESP_LOGI(TAG, "provisioning web server started");
+    return ESP_OK;
+}
+
 /* -------------------- WiFi 模块事件回调 -------------------- */
 /**
  * @brief 供 WiFi 模块调用的事件回调，用于驱动管理状态机
@@ -375,11 +486,19 @@ static void wifi_manage_on_wifi_event(wifi_module_event_t event)
         wifi_manage_notify_state(WIFI_MANAGE_STATE_CONNECTED);
         s_wifi_connecting   = false;
         s_wifi_try_index    = 0;      /* 下次自动重连从首选 WiFi 开始 */
+        s_wifi_try_fast     = false;
+        s_wifi_try_full     = false;
         s_connect_failed_ts = 0;
+        s_backoff_round     = 0;
 
-        /* 将当前配置上报给存储模块，用于调整优先级等策略 */
+        /* 将当前配置连同本次 AP 的 BSSID / 信道 / 加密方式上报给存储模块，
+         * 既调整优先级，也供下次上电或掉线时单信道快速重连 */
         wifi_config_t current_cfg = {0};
         if (esp_wifi_get_config(WIFI_IF_STA, &current_cfg) == ESP_OK) {
+            wifi_module_ap_hint_t hint;
+            if (wifi_module_get_ap_hint(&hint) == ESP_OK) {
+                wifi_manage_hint_to_config(&hint, &current_cfg);
+            }
             (void)wifi_storage_on_connected(&current_cfg);
         }
         break;
@@ -390,12 +509,23 @@ static void wifi_manage_on_wifi_event(wifi_module_event_t event)
         wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
         s_wifi_connecting   = false;
         s_wifi_try_index    = 0;
+        s_wifi_try_fast     = false;
+        s_wifi_try_full     = false;
+        wifi_manage_kick();
         break;
 
     case WIFI_MODULE_EVENT_STA_CONNECT_FAILED:
-        /* 本次尝试失败，简单移动到下一条配置 */
+        /* 快速重连失败（AP 换信道 / 更换路由器）：同一条目回退为全信道连接；
+         * 全信道连接也失败：移动到下一条配置 */
         s_wifi_connecting = false;
-        s_wifi_try_index++;
+        if (s_wifi_try_fast) {
+            s_wifi_try_fast = false;
+            s_wifi_try_full = true;
+        } else {
+            s_wifi_try_full = false;
+            s_wifi_try_index++;
+        }
+        wifi_manage_kick();
         break;
 
     default:
@@ -436,17 +566,25 @@ static void wifi_manage_step(void)
         uint8_t count = 0;
 
         if (wifi_storage_load_all(list, &count) != ESP_OK || count == 0) {
-            /* 没有可用配置，交由上层决定是否启用纯 AP 配网等逻辑 */
+            /* 没有可用配置，只能通过 AP 配网：按需模式下此时才启动 Web 服务器 */
+            (void)wifi_manage_start_web();
             free(list);
             break;
         }
 
         if (s_wifi_try_index >= count) {
-            /* 本轮所有配置均尝试过，仍未连接成功，进入“整轮失败”状态 */
+            /* 本轮所有配置均尝试过，仍未连接成功，进入“整轮失败”状态并按指数退避等待 */
+            if (s_backoff_round < WIFI_MANAGE_BACKOFF_ROUND_MAX) {
+                s_backoff_round++;
+            }
             wifi_manage_notify_state(WIFI_MANAGE_STATE_CONNECT_FAILED);
             s_connect_failed_ts = xTaskGetTickCount();
             s_wifi_try_index    = 0;
+            s_wifi_try_full     = false;
             s_wifi_connecting   = false;
+            ESP_LOGI(TAG, "all saved wifi failed, retry in %u ms", (unsigned)wifi_manage_backoff_ms());
+            /* 已保存的 WiFi 全部不可用，需要用户重新配网 */
+            (void)wifi_manage_start_web();
             free(list);
             break;
         }
@@ -455,6 +593,7 @@ static void wifi_manage_step(void)
         if (cfg->sta.ssid[0] == '\0') {
             /* 跳过无效 SSID */
             s_wifi_try_index++;
+            s_wifi_try_full = false;
             free(list);
             break;
         }
@@ -464,11 +603,20 @@ static void wifi_manage_step(void)
                                    ? NULL
                                    : (const char *)cfg->sta.password;
 
+        /* 有上次 AP 记录时先单信道快速重连，失败后同一条目再做一次全信道连接 */
+        wifi_module_ap_hint_t hint;
+        wifi_manage_hint_from_config(cfg, &hint);
+        if (s_wifi_try_full) {
+            hint.valid = false;
+        }
+
         /* 尝试发起连接，成功则等待事件回调，失败则立即切换到下一条 */
-        if (wifi_module_connect(ssid, password) == ESP_OK) {
+        if (wifi_module_connect_ex(ssid, password, &hint) == ESP_OK) {
             s_wifi_connecting = true;
+            s_wifi_try_fast   = hint.valid;
         } else {
             s_wifi_try_index++;
+            s_wifi_try_full = false;
         }
 
         free(list);
@@ -480,24 +628,26 @@ static void wifi_manage_step(void)
         break;
 
     case WIFI_MANAGE_STATE_CONNECT_FAILED: {
-        /* 一轮全部失败，根据配置的重连间隔决定何时重新遍历 */
+        /* 一轮全部失败，按指数退避决定何时重新遍历（Web 端主动连接时立即重试） */
+
+        bool retry_now = s_retry_now;
+        s_retry_now    = false;
 
-        if (s_wifi_cfg.reconnect_interval_ms < 0) {
+        if (s_wifi_cfg.reconnect_interval_ms < 0 && !retry_now) {
             /* 小于 0 表示关闭自动重连，保持在失败状态 */
             break;
         }
 
         TickType_t now   = xTaskGetTickCount();
         TickType_t delta = now - s_connect_failed_ts;
-        TickType_t need  = pdMS_TO_TICKS((s_wifi_cfg.reconnect_interval_ms <= 0)
-                                             ? 0
-                                             : s_wifi_cfg.reconnect_interval_ms);
+        TickType_t need  = pdMS_TO_TICKS(wifi_manage_backoff_ms());
 
-        if (delta >= need) {
+        if (retry_now || delta >= need) {
             /* 到达重试时间，从头开始新一轮遍历 */
             s_wifi_try_index    = 0;
             s_wifi_connecting   = false;
             wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
+            wifi_manage_kick();
         }
         break;
     }
@@ -517,8 +667,17 @@ static void wifi_manage_task(void *arg)
     (void)arg;
 
     for (;;) {
+        if (s_web_request) {
+            s_web_request = false;
+            (void)wifi_manage_start_web();
+        }
+        if (s_storage_commit) {
+            s_storage_commit = false;
+            (void)wifi_storage_flush();
+        }
         wifi_manage_step();
-        vTaskDelay(pdMS_TO_TICKS(WIFI_MANAGE_STEP_INTERVAL_MS));
+        /* 周期运行；连接结果事件到达时被提前唤醒，快速重连失败可立即回退全信道 */
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WIFI_MANAGE_STEP_INTERVAL_MS));
     }
 }
 
@@ -530,7 +689,7 @@ static void wifi_manage_task(void *arg)
  * 1. 保存并标准化上层配置
  * 2. 初始化 WiFi 模块（STA+AP）
  * 3. 初始化存储模块（保存常用 WiFi）
- * 4. 初始化 Web 配网模块（HTTP 服务与回调）
+ * 4. 初始化 Web 配网模块（HTTP 服务与回调，按需模式下延迟启动）
  * 5. 创建管理任务，启动状态机
  */
 esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
@@ -582,44 +741,34 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
     } else {
         storage_cfg.max_wifi_num = (uint8_t)s_wifi_cfg.save_wifi_count;
     }
+    storage_cfg.commit_cb = wifi_manage_on_storage_commit;
 
     ret = wifi_storage_init(&storage_cfg);
     if (ret != ESP_OK) {
         return ret;
     }
 
-    /* ---- 初始化 Web 配网模块 ---- */
-    {
-        web_module_config_t web_cfg = WEB_MODULE_DEFAULT_CONFIG();
-
-        /* 端口由管理配置决定，<=0 时沿用默认值 */
-        if (s_wifi_cfg.web_port > 0) {
-            web_cfg.http_port = s_wifi_cfg.web_port;
-        }
-
-        /* 通过回调向 Web 模块暴露当前 WiFi 状态与已保存列表等能力 */
-        web_cfg.get_status_cb     = wifi_manage_get_web_status;
-        web_cfg.get_saved_list_cb = wifi_manage_get_web_saved_list;
-        web_cfg.scan_cb           = wifi_manage_scan_web;
-        web_cfg.delete_saved_cb   = wifi_manage_delete_web_saved;
-        web_cfg.connect_saved_cb  = wifi_manage_connect_web_saved;
-        web_cfg.connect_cb        = wifi_manage_connect_web_form;
-
-        ret = web_module_init(&web_cfg);
+    /* ---- 初始化 Web 配网模块 ----
+     * 按需模式下延迟到需要配网时由管理任务启动；WebSocket 通道需要服务器常驻，仍立即启动 */
+    if (!s_wifi_cfg.web_on_demand || s_wifi_cfg.web_ws_clients > 0) {
+        ret = wifi_manage_start_web();
         if (ret != ESP_OK) {
             return ret;
         }
+    } else {
+        ESP_LOGI(TAG, "provisioning web server deferred until needed");
     }
 
     // 创建WiFi管理任务
     if (s_wifi_manage_task == NULL) {
-        BaseType_t ret_task = xTaskCreate(
+        BaseType_t ret_task = xTaskCreatePinnedToCore(
             wifi_manage_task,
             "wifi_manage",
             4096,               // 任务栈大小，可根据实际需要调整
             NULL,
             tskIDLE_PRIORITY + 1,   // 任务优先级，可根据实际需要调整
-            &s_wifi_manage_task);
+            &s_wifi_manage_task,
+            s_wifi_cfg.task_core >= 0 ? (BaseType_t)s_wifi_cfg.task_core : tskNO_AFFINITY);
 
         if (ret_task != pdPASS) {
             return ESP_ERR_NO_MEM;
@@ -628,3 +777,19 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
 
     return ESP_OK;
 }
+
+/* -------------------- 按需启动配网 -------------------- */
+/**
+ * @brief 请求启动 Web 配网服务器（按需模式下由应用触发，如长按按键）
+ *
+ * 实际启动在管理任务中完成，此处只置位请求并唤醒任务。
+ */
+esp_err_t wifi_manage_start_provisioning(void)
+{
+    if (s_wifi_manage_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_web_request = true;
+    wifi_manage_kick();
+    return ESP_OK;
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+构建期生成 Web 配网静态资源表（由组件 CMakeLists.txt 调用）
+
+- 每个文件计算内容哈希作为强 ETag；
+- index.html 中对其它资源的引用改写为 "xxx?v=<ETag>"，使其可被浏览器长期缓存；
+- 资源以 gzip -9（mtime=0，输出可复现）压缩，同时保留原文作为不支持 gzip 时的兜底；
+- 输出一个 C 源文件，定义 web_assets[] / web_asset_count（类型见 src/web_assets.h）。
+
+用法：web_assets_gen.py --out web_assets.c index.html app.css app.js
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+
+CONTENT_TYPES = {
+    '.html': 'text/html',
+    '.css': 'text/css',
+    '.js': 'application/javascript',
+    '.json': 'application/json',
+    '.svg': 'image/svg+xml',
+    '.png': 'image/png',
+    '.ico': 'image/x-icon',
+}
+
+
+def etag_of(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def c_array(name, data):
+    lines = ['static const uint8_t %s[%d] = {' % (name, max(len(data), 1))]
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--out', required=True)
+    parser.add_argument('files', nargs='+')
+    args = parser.parse_args()
+
+    assets = []
+    for path in args.files:
+        with open(path, 'rb') as f:
+            assets.append({'name': os.path.basename(path), 'raw': f.read()})
+
+    # 先确定被引用资源（非 html）的 ETag，再改写 html 中的引用
+    versions = {a['name']: etag_of(a['raw']) for a in assets if not a['name'].endswith('.html')}
+    for a in assets:
+        a['versioned'] = a['name'] in versions
+        if a['name'].endswith('.html'):
+            text = a['raw'].decode('utf-8')
+            for name, ver in versions.items():
+                text = re.sub(r'((?:href|src)\s*=\s*")%s(")' % re.escape(name),
+                              r'\g<1>%s?v=%s\g<2>' % (name, ver), text)
+            a['raw'] = text.encode('utf-8')
+        a['etag'] = etag_of(a['raw'])
+        a['gzip'] = gzip.compress(a['raw'], compresslevel=9, mtime=0)
+        ext = os.path.splitext(a['name'])[1].lower()
+        a['type'] = CONTENT_TYPES.get(ext, 'application/octet-stream')
+        a['ident'] = re.sub(r'[^0-9a-zA-Z]', '_', a['name'])
+
+    out = ['/* 由 tools/web_assets_gen.py 在构建时生成，请勿手工修改 */',
+           '#include "web_assets.h"', '']
+    for a in assets:
+        out.append(c_array('s_%s_raw' % a['ident'], a['raw']))
+        out.append(c_array('s_%s_gz' % a['ident'], a['gzip']))
+        out.append('')
+
+    out.append('const web_asset_t web_assets[] = {')
+    for a in assets:
+        out.append('    {')
+        out.append('        .name         = "%s",' % a['name'])
+        out.append('        .content_type = "%s",' % a['type'])
+        out.append('        .etag         = "\\"%s\\"",' % a['etag'])
+        out.append('        .etag_gzip    = "\\"%s-gz\\"",' % a['etag'])
+        out.append('        .version      = "%s",' % a['etag'])
+        out.append('        .raw          = s_%s_raw,' % a['ident'])
+        out.append('        .raw_len      = %d,' % len(a['raw']))
+        out.append('        .gzip         = s_%s_gz,' % a['ident'])
+        out.append('        .gzip_len     = %d,' % len(a['gzip']))
+        out.append('        .versioned    = %s,' % ('true' if a['versioned'] else 'false'))
+        out.append('    },')
+    out.append('};')
+    out.append('')
+    out.append('const size_t web_asset_count = sizeof(web_assets) / sizeof(web_assets[0]);')
+    out.append('')
+
+    text = '\n'.join(out)
+    # 内容未变化时不改写文件，避免无谓的重新编译
+    if os.path.exists(args.out):
+        with open(args.out, 'r', encoding='utf-8') as f:
+            if f.read() == text:
+                return
+    with open(args.out, 'w', encoding='utf-8') as f:
+        f.write(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -48,6 +48,12 @@
   var lastStatusState = 0;
   var lastStatusSsid = null;
 
+  // 后台扫描进行中时的轮询定时器与剩余次数
+  var scanPollTimer = null;
+  var scanPollLeft = 0;
+  var SCAN_POLL_INTERVAL_MS = 1500;
+  var SCAN_POLL_MAX = 8;
+
   /**
    * 初始化 DOM 引用。
    *
@@ -339,21 +345,17 @@
   }
 
   /**
-   * 发起一次“扫描附近 WiFi”的请求。
+   * 拉取一次扫描结果。
+   *
+   * 后端立即返回缓存结果，不等待扫描；若返回 scanning=true，
+   * 先展示已有结果，再每隔 SCAN_POLL_INTERVAL_MS 拉取一次，直到扫描结束。
+   *
+   * @param refresh 是否要求后端忽略缓存有效期、重新扫描
    */
-  function loadScanList() {
-    if (!dom.scanBody || !window.fetch) {
-      return;
-    }
+  function fetchScanList(refresh) {
+    scanPollTimer = null;
 
-    // 简单的“正在扫描”提示
-    if (dom.scanEmpty) {
-      dom.scanEmpty.textContent = '正在扫描...';
-      dom.scanEmpty.style.display = 'block';
-    }
-    dom.scanBody.innerHTML = '';
-
-    fetch('/api/wifi/scan')
+    fetch('/api/wifi/scan' + (refresh ? '?refresh=1' : ''))
       .then(function (res) {
         if (!res.ok) {
           throw new Error('http ' + res.status);
@@ -362,7 +364,22 @@
       })
       .then(function (data) {
         var items = (data && data.items) || [];
+        var scanning = !!(data && data.scanning);
+
         renderScanList(items);
+
+        if (scanning && scanPollLeft > 0) {
+          scanPollLeft--;
+          if (dom.scanEmpty && items.length === 0) {
+            dom.scanEmpty.textContent = '正在扫描...';
+            dom.scanEmpty.style.display = 'block';
+          }
+          scanPollTimer = setTimeout(function () {
+            fetchScanList(false);
+          }, SCAN_POLL_INTERVAL_MS);
+        } else if (dom.scanEmpty) {
+          dom.scanEmpty.textContent = '未发现附近 WiFi';
+        }
       })
       .catch(function () {
         if (dom.scanEmpty) {
@@ -372,6 +389,33 @@
       });
   }
 
+  /**
+   * 发起一次“扫描附近 WiFi”的请求。
+   *
+   * @param refresh 是否强制重新扫描（点击“扫描”按钮时为 true）
+   */
+  function loadScanList(refresh) {
+    if (!dom.scanBody || !window.fetch) {
+      return;
+    }
+
+    // 简单的“正在扫描”提示
+    if (dom.scanEmpty) {
+      dom.scanEmpty.textContent = '正在扫描...';
+      dom.scanEmpty.style.display = 'block';
+    }
+    dom.scanBody.innerHTML = '';
+
+    // 取消上一轮尚未结束的轮询
+    if (scanPollTimer !== null) {
+      clearTimeout(scanPollTimer);
+      scanPollTimer = null;
+    }
+    scanPollLeft = SCAN_POLL_MAX;
+
+    fetchScanList(!!refresh);
+  }
+
   /**
    * 连接一条已保存 WiFi，按 SSID 标识。
    *
@@ -501,7 +545,7 @@
     if (dom.btnScan) {
       dom.btnScan.addEventListener('click', function (event) {
         event.preventDefault();
-        loadScanList();
+        loadScanList(true);
       });
     }
 
@@ -589,7 +633,7 @@
     bindEvents();
     startStatusPolling();
     loadSavedList();
-    loadScanList();
+    loadScanList(false);
   }
 
   document.addEventListener('DOMContentLoaded', bootstrap);
@@ -58,6 +58,7 @@ void audio_config_app_build(audio_mgr_config_t *cfg,
     // ========== 唤醒词配置 ==========
     cfg->wakeup_config.enabled = false;       // 默认禁用唤醒词
     cfg->wakeup_config.wake_word_name = "小鸭小鸭";  // 唤醒词名称
+    cfg->wakeup_config.wake_model_name = "wn9_xiaoyaxiaoya_tts2"; // WakeNet 模型（与 CONFIG_SR_WN_* 一致）
     cfg->wakeup_config.model_partition = "model";    // 模型分区名称
     cfg->wakeup_config.sensitivity = 2;              // 灵敏度：中等
     cfg->wakeup_config.wakeup_timeout_ms = 8000;     // 唤醒超时 8 秒
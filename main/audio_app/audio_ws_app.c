@@ -0,0 +1,431 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 16:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 16:00:00
+ * @FilePath: \xn_esp32_audio\main\audio_app\audio_ws_app.c
+ * @Description: 音频调试桥 - 录音/编码包上行、PCM/编码包下行播放、管线统计推送
+ *
+ * 上行音频直接写入 web_ws 共享发送帧（录音回调中唯一的一次拷贝），
+ * 无客户端或帧池耗尽时立即放弃，不阻塞 AFE Fetch / 编码任务。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "audio_manager.h"
+#include "web_ws.h"
+#include "audio_ws_app.h"
+
+static const char *TAG = "audio_ws";
+
+/** 统计 JSON 缓冲区（须不大于 web_ws 的 frame_size） */
+#define AUDIO_WS_STATS_BYTES    1792
+
+/** 统计 JSON 末尾预留（用于收尾括号），任务列表写到此处为止 */
+#define AUDIO_WS_STATS_TAIL     16
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define AUDIO_WS_TASK_CPU       1
+#define AUDIO_WS_MAX_TASKS      32
+#else
+#define AUDIO_WS_TASK_CPU       0
+#endif
+
+typedef struct {
+    bool                  started;
+    audio_ws_app_config_t cfg;
+    uint8_t               enc_kind;      ///< 编码录音包的帧类型
+    uint32_t              tx_skipped;    ///< 帧池耗尽放弃的上行帧数
+    uint32_t              rx_rejected;   ///< 播放缓冲区拒收的下行帧数
+} audio_ws_app_ctx_t;
+
+static audio_ws_app_ctx_t s_ws_app;
+
+/* 统计任务专用（单任务访问，放 .bss 避免占用任务栈） */
+static char s_stats_json[AUDIO_WS_STATS_BYTES];
+
+#if AUDIO_WS_TASK_CPU
+typedef struct {
+    UBaseType_t                 number;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} audio_ws_task_sample_t;
+
+static TaskStatus_t               s_task_status[AUDIO_WS_MAX_TASKS];
+static audio_ws_task_sample_t     s_task_prev[AUDIO_WS_MAX_TASKS];
+static UBaseType_t                s_task_prev_num;
+static configRUN_TIME_COUNTER_TYPE s_total_prev;
+#endif
+
+/* -------------------- 上行音频 -------------------- */
+
+static uint8_t audio_ws_app_codec_kind(audio_mgr_codec_t codec)
+{
+    switch (codec) {
+    case AUDIO_MGR_CODEC_MP3:
+        return AUDIO_WS_KIND_MP3;
+    case AUDIO_MGR_CODEC_ADPCM:
+        return AUDIO_WS_KIND_ADPCM;
+    case AUDIO_MGR_CODEC_OPUS:
+    default:
+        return AUDIO_WS_KIND_OPUS;
+    }
+}
+
+/* 2 字节头 + 负载直接写入共享帧，按引用分发给所有客户端；帧池耗尽时放弃 */
+static bool audio_ws_app_push(uint8_t kind, const void *data, size_t len, size_t *sent)
+{
+    uint8_t        *buf = NULL;
+    size_t          cap = 0;
+    web_ws_frame_t *frame = web_ws_acquire(&buf, &cap);
+    if (frame == NULL) {
+        s_ws_app.tx_skipped++;
+        return false;
+    }
+
+    if (len > cap - AUDIO_WS_HEADER_BYTES) {
+        if (sent == NULL) {
+            /* 编码包不可拆分，超出帧容量直接丢弃 */
+            web_ws_discard(frame);
+            s_ws_app.tx_skipped++;
+            return false;
+        }
+        /* PCM 按整采样点拆分 */
+        len = (cap - AUDIO_WS_HEADER_BYTES) & ~(size_t)1;
+    }
+
+    buf[0] = kind;
+    buf[1] = 0;
+    memcpy(buf + AUDIO_WS_HEADER_BYTES, data, len);
+    (void)web_ws_commit(frame, AUDIO_WS_HEADER_BYTES + len, true);
+    if (sent) {
+        *sent = len;
+    }
+    return true;
+}
+
+void audio_ws_app_on_record(const int16_t *pcm_data, size_t sample_count)
+{
+    if (!s_ws_app.started || !s_ws_app.cfg.stream_pcm || pcm_data == NULL ||
+        sample_count == 0 || web_ws_client_count() == 0) {
+        return;
+    }
+
+    /* 默认 frame_size 2048 可容纳 1023 个采样点，一个 AFE 帧通常一帧发完 */
+    const uint8_t *data = (const uint8_t *)pcm_data;
+    size_t         left = sample_count * sizeof(int16_t);
+    while (left > 0) {
+        size_t sent = 0;
+        if (!audio_ws_app_push(AUDIO_WS_KIND_PCM, data, left, &sent)) {
+            return;
+        }
+        data += sent;
+        left -= sent;
+    }
+}
+
+static void audio_ws_app_on_encoded(const uint8_t *data, size_t len, void *user_ctx)
+{
+    (void)user_ctx;
+
+    if (data == NULL || len == 0 || web_ws_client_count() == 0) {
+        return;
+    }
+    (void)audio_ws_app_push(s_ws_app.enc_kind, data, len, NULL);
+}
+
+/* -------------------- 下行（httpd 任务） -------------------- */
+
+static void audio_ws_app_handle_cmd(const char *text)
+{
+    const char *cmd = strstr(text, "\"cmd\"");
+    if (cmd == NULL) {
+        return;
+    }
+
+    if (strstr(cmd, "\"reset_stats\"")) {
+        audio_manager_reset_latency_stats();
+        s_ws_app.tx_skipped  = 0;
+        s_ws_app.rx_rejected = 0;
+        ESP_LOGI(TAG, "📊 统计已清零");
+    } else if (strstr(cmd, "\"clear_playback\"")) {
+        audio_manager_clear_playback_buffer();
+    } else if (strstr(cmd, "\"volume\"")) {
+        const char *val = strstr(cmd, "\"value\"");
+        val = val ? strchr(val, ':') : NULL;
+        if (val) {
+            int volume = atoi(val + 1);
+            audio_manager_set_volume((uint8_t)(volume < 0 ? 0 : (volume > 100 ? 100 : volume)));
+        }
+    } else {
+        ESP_LOGW(TAG, "⚠️ 未知命令: %s", text);
+    }
+}
+
+static void audio_ws_app_on_rx(bool binary, const uint8_t *data, size_t len, void *user_ctx)
+{
+    (void)user_ctx;
+
+    if (!binary) {
+        audio_ws_app_handle_cmd((const char *)data);
+        return;
+    }
+    if (len <= AUDIO_WS_HEADER_BYTES) {
+        return;
+    }
+
+    /* 接收缓冲区按 malloc 对齐，跳过 2 字节头后 PCM 仍为 2 字节对齐 */
+    const uint8_t *payload = data + AUDIO_WS_HEADER_BYTES;
+    size_t         plen    = len - AUDIO_WS_HEADER_BYTES;
+    esp_err_t      ret;
+
+    switch (data[0]) {
+    case AUDIO_WS_KIND_PCM:
+        /* 独立播放流：与应用在其他任务中写入的主流互不干扰 */
+        ret = audio_manager_play_stream(s_ws_app.cfg.pcm_stream, (const int16_t *)payload,
+                                        plen / sizeof(int16_t));
+        break;
+    case AUDIO_WS_KIND_OPUS:
+        ret = audio_manager_play_encoded(AUDIO_MGR_CODEC_OPUS, payload, plen);
+        break;
+    case AUDIO_WS_KIND_MP3:
+        ret = audio_manager_play_encoded(AUDIO_MGR_CODEC_MP3, payload, plen);
+        break;
+    case AUDIO_WS_KIND_ADPCM:
+        ret = audio_manager_play_encoded(AUDIO_MGR_CODEC_ADPCM, payload, plen);
+        break;
+    default:
+        ret = ESP_ERR_INVALID_ARG;
+        break;
+    }
+
+    if (ret != ESP_OK) {
+        s_ws_app.rx_rejected++;
+    }
+}
+
+/* -------------------- 统计推送 -------------------- */
+
+typedef struct {
+    char  *buf;
+    size_t cap;
+    size_t len;
+} audio_ws_json_t;
+
+static void audio_ws_json_printf(audio_ws_json_t *js, const char *fmt, ...)
+{
+    if (js->len >= js->cap) {
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(js->buf + js->len, js->cap - js->len, fmt, ap);
+    va_end(ap);
+
+    js->len = (n < 0 || (size_t)n >= js->cap - js->len) ? js->cap : js->len + (size_t)n;
+}
+
+static void audio_ws_json_buffer(audio_ws_json_t *js, const char *name,
+                                 const audio_mgr_buffer_stats_t *b)
+{
+    audio_ws_json_printf(js,
+                         "\"%s\":{\"level\":%u,\"high_water\":%u,\"capacity\":%u,"
+                         "\"overrun\":%u,\"rejected\":%u,\"underrun\":%u},",
+                         name, (unsigned)b->level, (unsigned)b->high_water, (unsigned)b->capacity,
+                         (unsigned)b->overrun_samples, (unsigned)b->rejected_samples,
+                         (unsigned)b->underrun_reads);
+}
+
+static void audio_ws_json_latency(audio_ws_json_t *js, const char *name,
+                                  const audio_mgr_latency_t *l)
+{
+    audio_ws_json_printf(js, "\"%s\":[%u,%u,%u],", name,
+                         (unsigned)l->p50_us, (unsigned)l->p99_us, (unsigned)l->max_us);
+}
+
+#if AUDIO_WS_TASK_CPU
+/**
+ * @brief 追加各任务 CPU 占用（相对上次采样的增量，单位为单核百分比）
+ */
+static void audio_ws_json_tasks(audio_ws_json_t *js)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t num = uxTaskGetSystemState(s_task_status, AUDIO_WS_MAX_TASKS, &total);
+    configRUN_TIME_COUNTER_TYPE total_delta = total - s_total_prev;
+
+    audio_ws_json_printf(js, "\"tasks\":[");
+    bool first = true;
+    for (UBaseType_t i = 0; i < num && total_delta > 0; i++) {
+        const TaskStatus_t *t = &s_task_status[i];
+
+        configRUN_TIME_COUNTER_TYPE prev = t->ulRunTimeCounter;
+        for (UBaseType_t j = 0; j < s_task_prev_num; j++) {
+            if (s_task_prev[j].number == t->xTaskNumber) {
+                prev = s_task_prev[j].runtime;
+                break;
+            }
+        }
+
+        uint32_t permille = (uint32_t)((uint64_t)(t->ulRunTimeCounter - prev) * 1000 / total_delta);
+        if (permille == 0) {
+            continue;
+        }
+        if (js->len + AUDIO_WS_STATS_TAIL + 40 >= js->cap) {
+            break;
+        }
+        audio_ws_json_printf(js, "%s{\"name\":\"%s\",\"cpu\":%u.%u}", first ? "" : ",",
+                             t->pcTaskName, (unsigned)(permille / 10), (unsigned)(permille % 10));
+        first = false;
+    }
+    audio_ws_json_printf(js, "],");
+
+    for (UBaseType_t i = 0; i < num; i++) {
+        s_task_prev[i].number  = s_task_status[i].xTaskNumber;
+        s_task_prev[i].runtime = s_task_status[i].ulRunTimeCounter;
+    }
+    s_task_prev_num = num;
+    s_total_prev    = total;
+}
+#endif
+
+static size_t audio_ws_app_build_stats(char *buf, size_t cap)
+{
+    audio_ws_json_t js = {
+        .buf = buf,
+        .cap = cap - AUDIO_WS_STATS_TAIL,
+        .len = 0,
+    };
+
+    audio_mgr_stats_t         stats   = {0};
+    audio_mgr_latency_stats_t latency = {0};
+    web_ws_stats_t            ws      = {0};
+    (void)audio_manager_get_stats(&stats);
+    (void)audio_manager_get_latency_stats(&latency);
+    web_ws_get_stats(&ws);
+
+    audio_ws_json_printf(&js, "{\"type\":\"stats\",\"uptime_ms\":%u,",
+                         (unsigned)(xTaskGetTickCount() * portTICK_PERIOD_MS));
+    audio_ws_json_buffer(&js, "playback", &stats.playback);
+    audio_ws_json_buffer(&js, "reference", &stats.reference);
+    audio_ws_json_printf(&js,
+                         "\"aec\":{\"ref_offset_us\":%d,\"padded\":%u,\"dropped\":%u,\"delay_updates\":%u},",
+                         (int)stats.aec.ref_offset_us, (unsigned)stats.aec.padded_samples,
+                         (unsigned)stats.aec.dropped_samples, (unsigned)stats.aec.delay_updates);
+    audio_ws_json_printf(&js,
+                         "\"events\":{\"posted\":%u,\"dropped\":%u,\"high_water\":%u,\"capacity\":%u},",
+                         (unsigned)stats.events.posted, (unsigned)stats.events.dropped,
+                         (unsigned)stats.events.high_water, (unsigned)stats.events.capacity);
+    audio_ws_json_printf(&js,
+                         "\"governor\":{\"level\":%d,\"feed_pct\":%u,\"fetch_pct\":%u,\"backlog_ms\":%u,"
+                         "\"feed_misses\":%u,\"fetch_misses\":%u,\"degrades\":%u,\"recoveries\":%u},",
+                         (int)stats.governor.level, (unsigned)stats.governor.feed_load_pct,
+                         (unsigned)stats.governor.fetch_load_pct, (unsigned)stats.governor.backlog_ms,
+                         (unsigned)stats.governor.feed_misses, (unsigned)stats.governor.fetch_misses,
+                         (unsigned)stats.governor.degrades, (unsigned)stats.governor.recoveries);
+
+    /* 延迟统计：[p50, p99, max]（微秒） */
+    audio_ws_json_printf(&js, "\"latency_us\":{");
+    audio_ws_json_latency(&js, "mic_to_callback", &latency.mic_to_callback);
+    audio_ws_json_latency(&js, "play_to_speaker", &latency.play_to_speaker);
+    audio_ws_json_latency(&js, "event_dispatch", &latency.event_dispatch);
+    audio_ws_json_latency(&js, "feed_cpu", &latency.feed_cpu);
+    audio_ws_json_latency(&js, "fetch_cpu", &latency.fetch_cpu);
+    if (js.len < js.cap && js.buf[js.len - 1] == ',') {
+        js.len--;
+    }
+    audio_ws_json_printf(&js, "},");
+
+    audio_ws_json_printf(&js,
+                         "\"ws\":{\"clients\":%u,\"sent\":%u,\"dropped\":%u,\"pool_empty\":%u,"
+                         "\"lock_busy\":%u,\"rx\":%u,\"tx_skipped\":%u,\"rx_rejected\":%u},",
+                         (unsigned)ws.clients, (unsigned)ws.sent_frames, (unsigned)ws.dropped_frames,
+                         (unsigned)ws.pool_empty, (unsigned)ws.lock_busy, (unsigned)ws.rx_frames,
+                         (unsigned)s_ws_app.tx_skipped, (unsigned)s_ws_app.rx_rejected);
+
+    audio_ws_json_printf(&js, "\"heap\":{\"internal\":%u,\"internal_min\":%u,\"psram\":%u},",
+                         (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                         (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+                         (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+
+#if AUDIO_WS_TASK_CPU
+    audio_ws_json_tasks(&js);
+#endif
+
+    if (js.len >= js.cap) {
+        ESP_LOGW(TAG, "⚠️ 统计 JSON 超出缓冲区，已截断");
+        return 0;
+    }
+
+    /* 去掉末尾逗号并收尾（收尾使用预留区） */
+    if (js.buf[js.len - 1] == ',') {
+        js.len--;
+    }
+    buf[js.len++] = '}';
+    buf[js.len]   = '\0';
+    return js.len;
+}
+
+static void audio_ws_app_stats_task(void *arg)
+{
+    (void)arg;
+
+    TickType_t last = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(s_ws_app.cfg.stats_interval_ms));
+        if (web_ws_client_count() == 0) {
+            continue;
+        }
+
+        size_t len = audio_ws_app_build_stats(s_stats_json, sizeof(s_stats_json));
+        if (len > 0) {
+            (void)web_ws_send(s_stats_json, len, false);
+        }
+    }
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+esp_err_t audio_ws_app_start(const audio_ws_app_config_t *config)
+{
+    if (s_ws_app.started) {
+        return ESP_OK;
+    }
+
+    s_ws_app.cfg = config ? *config : AUDIO_WS_APP_DEFAULT_CONFIG();
+
+    web_ws_set_rx_cb(audio_ws_app_on_rx, NULL);
+
+    if (s_ws_app.cfg.stream_encoded) {
+        s_ws_app.enc_kind = audio_ws_app_codec_kind(s_ws_app.cfg.record_codec);
+        audio_manager_set_encoded_record_callback(audio_ws_app_on_encoded, NULL);
+    }
+
+    /* 延迟直方图依赖追踪打点 */
+    audio_manager_set_trace_enabled(true);
+
+    if (s_ws_app.cfg.stats_interval_ms > 0) {
+        BaseType_t ok = xTaskCreatePinnedToCore(audio_ws_app_stats_task, "ws_stats", 4096,
+                                                NULL, 2, NULL, 0);
+        if (ok != pdPASS) {
+            ESP_LOGE(TAG, "❌ 统计推送任务创建失败");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_ws_app.started = true;
+    ESP_LOGI(TAG, "🔌 音频调试桥就绪 (pcm=%d, encoded=%d, stats=%ums)",
+             s_ws_app.cfg.stream_pcm, s_ws_app.cfg.stream_encoded,
+             (unsigned)s_ws_app.cfg.stats_interval_ms);
+    return ESP_OK;
+}
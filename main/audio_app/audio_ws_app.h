@@ -0,0 +1,95 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 16:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 16:00:00
+ * @FilePath: \xn_esp32_audio\main\audio_app\audio_ws_app.h
+ * @Description: 音频调试桥 - 通过 Web 服务器的 /ws/audio 实时收发音频并推送管线统计
+ *
+ * 二进制帧格式（双向）：2 字节头 + 负载，头为 [kind, 0]（第 2 字节保留，使 PCM 负载 2 字节对齐）
+ *  - AUDIO_WS_KIND_PCM   : 16bit 小端 16kHz 单声道 PCM
+ *  - AUDIO_WS_KIND_OPUS  : 一个完整 Opus 包
+ *  - AUDIO_WS_KIND_MP3   : MP3 码流片段（仅下行播放）
+ *  - AUDIO_WS_KIND_ADPCM : IMA-ADPCM 完整块
+ * 文本帧：设备 -> 客户端为 {"type":"stats",...}；客户端 -> 设备为命令，如
+ *  {"cmd":"reset_stats"}、{"cmd":"clear_playback"}、{"cmd":"volume","value":80}
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "audio_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 二进制帧类型 */
+typedef enum {
+    AUDIO_WS_KIND_PCM   = 0x01,
+    AUDIO_WS_KIND_OPUS  = 0x02,
+    AUDIO_WS_KIND_MP3   = 0x03,
+    AUDIO_WS_KIND_ADPCM = 0x04,
+} audio_ws_kind_t;
+
+/** 二进制帧头长度 */
+#define AUDIO_WS_HEADER_BYTES   2
+
+/** 下行 PCM 默认写入的播放流（与应用自身写入的主流在播放任务中混音） */
+#define AUDIO_WS_PCM_STREAM         1
+
+/** 下行 PCM 播放流缓冲区（字节，约 2 秒 16kHz 单声道） */
+#define AUDIO_WS_PCM_STREAM_BYTES   (64 * 1024)
+
+/**
+ * @brief 音频调试桥配置
+ */
+typedef struct {
+    bool     stream_pcm;         ///< 上行推送录音 PCM（audio_ws_app_on_record 输入）
+    bool     stream_encoded;     ///< 上行推送编码录音包（需启用 record_encode_config）
+    audio_mgr_codec_t record_codec; ///< 编码录音格式（与 record_encode_config.codec 一致）
+    uint32_t stats_interval_ms;  ///< 统计推送周期（ms，0 表示不推送）
+    uint8_t  pcm_stream;         ///< 下行 PCM 写入的播放流（须在 playback_config.streams 中启用；
+                                 ///< 设为 0 时应用不得在其他任务中写主流）
+} audio_ws_app_config_t;
+
+#define AUDIO_WS_APP_DEFAULT_CONFIG()          \
+    (audio_ws_app_config_t){                   \
+        .stream_pcm        = true,             \
+        .stream_encoded    = false,            \
+        .record_codec      = AUDIO_MGR_CODEC_OPUS, \
+        .stats_interval_ms = 1000,             \
+        .pcm_stream        = AUDIO_WS_PCM_STREAM, \
+    }
+
+/**
+ * @brief 启动音频调试桥
+ *
+ * 需在 audio_manager_init() 与 wifi_manage_init()（开启 web_ws_clients）之后调用。
+ * 会注册 WebSocket 接收回调、按需注册编码录音回调、开启延迟追踪并创建统计推送任务。
+ *
+ * 下行数据在 httpd 任务中写入：PCM 写入独立的播放流 pcm_stream（每个流各自为单生产者），
+ * 压缩数据写入压缩缓冲区（仅本模块写入）。本模块不启动播放，应用须调用
+ * audio_manager_start_playback()；打断（STOP 策略）后播放由音频管理器自动恢复，
+ * 应用主动 audio_manager_stop_playback() 后须自行重新启动。
+ *
+ * @param config 配置，NULL 时使用 AUDIO_WS_APP_DEFAULT_CONFIG()
+ * @return ESP_OK 成功；ESP_ERR_NO_MEM 统计任务创建失败
+ */
+esp_err_t audio_ws_app_start(const audio_ws_app_config_t *config);
+
+/**
+ * @brief 录音 PCM 输入（在应用的 audio_record_callback_t 中调用）
+ *
+ * 无客户端时立即返回；否则直接写入共享发送帧，每帧只拷贝一次，不阻塞调用方。
+ */
+void audio_ws_app_on_record(const int16_t *pcm_data, size_t sample_count);
+
+#ifdef __cplusplus
+}
+#endif
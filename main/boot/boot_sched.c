@@ -0,0 +1,152 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:00:00
+ * @FilePath: \xn_esp32_audio\main\boot\boot_sched.c
+ * @Description: 启动调度器实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "boot_sched.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "boot";
+
+/** 单个阶段任务的运行上下文（位于调用方栈上，boot_sched_run 返回前一直有效） */
+typedef struct {
+    const boot_stage_t  *stage;
+    boot_stage_result_t *result;
+    const boot_stage_result_t *all_results;
+    EventGroupHandle_t   done;
+    uint32_t             bit;
+} boot_stage_ctx_t;
+
+/* 阶段任务：等待依赖完成 -> 执行 -> 记录结果 -> 置位完成标志 -> 自删除 */
+static void boot_stage_task(void *arg)
+{
+    boot_stage_ctx_t *ctx = (boot_stage_ctx_t *)arg;
+    const boot_stage_t *stage = ctx->stage;
+
+    bool deps_ok = true;
+    if (stage->deps) {
+        (void)xEventGroupWaitBits(ctx->done, stage->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+        /* 结果在置位完成标志前写入，事件组保证此处读到的是最终值 */
+        for (size_t i = 0; i < BOOT_SCHED_MAX_STAGES; i++) {
+            if ((stage->deps & BOOT_STAGE_BIT(i)) && ctx->all_results[i].result != ESP_OK) {
+                deps_ok = false;
+                break;
+            }
+        }
+    }
+
+    if (deps_ok) {
+        ctx->result->start_us = esp_timer_get_time();
+        ctx->result->result = stage->fn(stage->arg);
+        ctx->result->end_us = esp_timer_get_time();
+    } else {
+        ctx->result->skipped = true;
+        ctx->result->result = ESP_ERR_INVALID_STATE;
+    }
+
+    xEventGroupSetBits(ctx->done, ctx->bit);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_sched_run(const boot_stage_t *stages, size_t count, boot_stage_result_t *results)
+{
+    if (!stages || !results || count == 0 || count > BOOT_SCHED_MAX_STAGES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        /* 只允许依赖前面的阶段，避免环形依赖导致永久等待 */
+        if (!stages[i].fn || (stages[i].deps >> i) != 0) {
+            ESP_LOGE(TAG, "invalid stage %u (%s)", (unsigned)i, stages[i].name ? stages[i].name : "?");
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    EventGroupHandle_t done = xEventGroupCreate();
+    if (!done) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(results, 0, count * sizeof(*results));
+    boot_stage_ctx_t ctx[BOOT_SCHED_MAX_STAGES];
+    esp_err_t ret = ESP_OK;
+    uint32_t created = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        ctx[i] = (boot_stage_ctx_t){
+            .stage = &stages[i],
+            .result = &results[i],
+            .all_results = results,
+            .done = done,
+            .bit = BOOT_STAGE_BIT(i),
+        };
+        /* 优先级略高于 main 任务，使各阶段一就绪就开始执行 */
+        BaseType_t core = stages[i].core < 0 ? tskNO_AFFINITY : stages[i].core;
+        if (xTaskCreatePinnedToCore(boot_stage_task, stages[i].name, stages[i].stack_size, &ctx[i],
+                                    uxTaskPriorityGet(NULL) + 1, NULL, core) != pdPASS) {
+            ESP_LOGE(TAG, "stage task create failed: %s", stages[i].name);
+            /* 已创建的阶段可能依赖本阶段：标记失败并置位，让它们跳过后退出 */
+            results[i].result = ESP_ERR_NO_MEM;
+            results[i].skipped = true;
+            xEventGroupSetBits(done, BOOT_STAGE_BIT(i));
+            ret = ESP_ERR_NO_MEM;
+        }
+        created |= BOOT_STAGE_BIT(i);
+    }
+
+    (void)xEventGroupWaitBits(done, created, pdFALSE, pdTRUE, portMAX_DELAY);
+    vEventGroupDelete(done);
+
+    if (ret == ESP_OK) {
+        for (size_t i = 0; i < count; i++) {
+            if (results[i].result != ESP_OK) {
+                ret = ESP_FAIL;
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
+void boot_sched_print_report(const boot_stage_t *stages, const boot_stage_result_t *results, size_t count)
+{
+    if (!stages || !results) {
+        return;
+    }
+
+    int64_t first_us = 0;
+    int64_t last_us = 0;
+    int64_t serial_us = 0;
+    for (size_t i = 0; i < count; i++) {
+        const boot_stage_result_t *r = &results[i];
+        if (r->skipped) {
+            ESP_LOGW(TAG, "  %-10s skipped (dependency failed)", stages[i].name);
+            continue;
+        }
+        int64_t cost_us = r->end_us - r->start_us;
+        serial_us += cost_us;
+        if (first_us == 0 || r->start_us < first_us) {
+            first_us = r->start_us;
+        }
+        if (r->end_us > last_us) {
+            last_us = r->end_us;
+        }
+        ESP_LOGI(TAG, "  %-10s core %2d  %6lld -> %6lld ms  (%5lld ms)  %s", stages[i].name, stages[i].core,
+                 (long long)(r->start_us / 1000), (long long)(r->end_us / 1000),
+                 (long long)(cost_us / 1000), esp_err_to_name(r->result));
+    }
+    ESP_LOGI(TAG, "boot stages: %lld ms wall, %lld ms serial, done at %lld ms since boot",
+             (long long)((last_us - first_us) / 1000), (long long)(serial_us / 1000), (long long)(last_us / 1000));
+}
@@ -0,0 +1,75 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:00:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:00:00
+ * @FilePath: \xn_esp32_audio\main\boot\boot_sched.h
+ * @Description: 启动调度器 - 按依赖关系在双核上并行执行各初始化阶段，并统计每阶段耗时
+ *
+ * 每个阶段运行在独立的临时任务中（可指定 Core），依赖的阶段全部成功后才开始；
+ * 依赖失败的阶段直接跳过。时间戳取自 esp_timer（自启动起计时），可直接作为开机耗时。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 最多支持的阶段数（依赖用位掩码表示） */
+#define BOOT_SCHED_MAX_STAGES   16
+
+/** 依赖位：阶段下标 i 对应 BOOT_STAGE_BIT(i) */
+#define BOOT_STAGE_BIT(i)       (1u << (i))
+
+/** 阶段入口函数 */
+typedef esp_err_t (*boot_stage_fn_t)(void *arg);
+
+/**
+ * @brief 启动阶段描述
+ */
+typedef struct {
+    const char     *name;        ///< 阶段名（用于报告）
+    boot_stage_fn_t fn;          ///< 阶段入口
+    void           *arg;         ///< 入口参数
+    int             core;        ///< 运行的 Core（0/1，-1 表示不绑定）
+    uint32_t        stack_size;  ///< 临时任务栈大小（字节）
+    uint32_t        deps;        ///< 依赖的阶段（BOOT_STAGE_BIT 组合，只能依赖下标更小的阶段）
+} boot_stage_t;
+
+/**
+ * @brief 单个阶段的执行结果
+ */
+typedef struct {
+    int64_t   start_us;          ///< 开始时刻（自启动起，微秒；跳过时为 0）
+    int64_t   end_us;            ///< 结束时刻（自启动起，微秒）
+    esp_err_t result;            ///< 返回值；依赖失败被跳过时为 ESP_ERR_INVALID_STATE
+    bool      skipped;           ///< 是否因依赖失败被跳过
+} boot_stage_result_t;
+
+/**
+ * @brief 执行全部启动阶段并等待完成
+ *
+ * @param stages  阶段数组
+ * @param count   阶段数（不超过 BOOT_SCHED_MAX_STAGES）
+ * @param results 输出每个阶段的结果（长度为 count）
+ * @return ESP_OK 全部成功；ESP_FAIL 有阶段失败或被跳过；
+ *         ESP_ERR_INVALID_ARG 参数无效；ESP_ERR_NO_MEM 任务创建失败
+ */
+esp_err_t boot_sched_run(const boot_stage_t *stages, size_t count, boot_stage_result_t *results);
+
+/**
+ * @brief 打印每阶段耗时报告
+ */
+void boot_sched_print_report(const boot_stage_t *stages, const boot_stage_result_t *results, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
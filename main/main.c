@@ -13,6 +13,15 @@
  *  1. 供电后等待 “loopback test ready” 日志
  *  2. 说出唤醒词（默认“小鸭小鸭”）或按键唤醒
  *  3. 在 VAD 窗口讲话，结束后会立即播放刚才的录音
+ *
+ * 启用 CONFIG_APP_AUDIO_BENCH（见 sdkconfig.bench）时改为运行音频管线基准/浸泡测试，
+ * 结果以 "AUDIO_BENCH:" 开头的单行 JSON 输出到串口。
+ *
+ * 启用 CONFIG_APP_AUDIO_WS 时同时启动 WiFi 管理与 /ws/audio 调试通道，
+ * 可在局域网内实时收听录音、下发播放数据并查看管线统计。
+ *
+ * 启动阶段（NVS / 模型 / WiFi / 音频）由 boot_sched 按依赖在双核上并行执行，
+ * 结束后打印每阶段耗时与 "listening" 时刻（自启动起）。
  */
 
 #include <stdio.h>
@@ -23,11 +32,19 @@
 
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
 #include "sdkconfig.h"
 
 #include "xn_wifi_manage.h"
 #include "audio_manager.h"
 #include "audio_config_app.h"
+#include "audio_ws_app.h"
+#include "boot_sched.h"
+#if CONFIG_APP_AUDIO_BENCH
+#include "audio_bench.h"
+#endif
 
 static const char *TAG = "app";
 
@@ -43,9 +60,9 @@ typedef struct {
     TickType_t ignore_until;
 } loopback_ctx_t;
 
-static int16_t       s_loop_buffer[LOOPBACK_MAX_SAMPLES];
+// 录音缓冲区（192KB）启动时从 PSRAM 分配，不占用内部 RAM 的 .bss
 static loopback_ctx_t s_loop_ctx = {
-    .buffer = s_loop_buffer,
+    .buffer = NULL,
     .max_samples = LOOPBACK_MAX_SAMPLES,
 };
 
@@ -91,6 +108,11 @@ static void loopback_record_cb(const int16_t *pcm_data,
                                void *user_ctx)
 {
     loopback_ctx_t *ctx = (loopback_ctx_t *)user_ctx;
+
+#if CONFIG_APP_AUDIO_WS
+    audio_ws_app_on_record(pcm_data, sample_count);
+#endif
+
     if (!ctx || !ctx->capturing || !pcm_data || sample_count == 0) {
         return;
     }
@@ -146,6 +168,20 @@ static void audio_event_cb(const audio_mgr_event_t *event, void *user_ctx)
         ctx->capturing = true;
         break;
 
+    case AUDIO_MGR_EVENT_PLAYBACK_INTERRUPTED:
+        /* 待播放数据已丢弃，管理器在本次录音结束后恢复播放，回放结果照常输出 */
+        ESP_LOGI(TAG, "playback interrupted, resumes after capture");
+        ctx->ignore_until = 0;
+        break;
+
+    case AUDIO_MGR_EVENT_GOVERNOR:
+        ESP_LOGI(TAG, "governor: level %d -> %d reason=%d feed=%u%% fetch=%u%% backlog=%ums cores=%d/%d",
+                 event->data.governor.prev_level, event->data.governor.level, event->data.governor.reason,
+                 event->data.governor.feed_load_pct, event->data.governor.fetch_load_pct,
+                 event->data.governor.backlog_ms, event->data.governor.feed_core,
+                 event->data.governor.fetch_core);
+        break;
+
     default:
         break;
     }
@@ -163,11 +199,180 @@ static void cpu_usage_monitor_task(void *arg)
     }
 }
 
+#if CONFIG_APP_AUDIO_BENCH
+/* 基准固件：内核基准 + 管线浸泡，每轮输出一行 JSON 报告。 */
+static void audio_bench_main(void)
+{
+    static audio_bench_report_t report;
+    audio_mgr_config_t audio_cfg;
+    audio_config_app_build(&audio_cfg, NULL, NULL);
+
+    audio_bench_config_t bench_cfg = AUDIO_BENCH_DEFAULT_CONFIG();
+    bench_cfg.kernel_frames = CONFIG_APP_AUDIO_BENCH_KERNEL_FRAMES;
+    bench_cfg.soak_seconds = CONFIG_APP_AUDIO_BENCH_SOAK_SECONDS;
+    bench_cfg.pipeline_config = &audio_cfg;
+
+    for (int round = 0; CONFIG_APP_AUDIO_BENCH_ROUNDS == 0 || round < CONFIG_APP_AUDIO_BENCH_ROUNDS; round++) {
+        ESP_LOGI(TAG, "benchmark round %d", round);
+        esp_err_t ret = audio_bench_run(&bench_cfg, &report);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "benchmark failed: %s", esp_err_to_name(ret));
+        }
+        audio_bench_print_json(&report);
+    }
+    ESP_LOGI(TAG, "benchmark done");
+}
+#endif
+
+/* ---------------- 启动阶段（由 boot_sched 按依赖并行执行） ---------------- */
+
+static audio_mgr_config_t s_audio_cfg;
+
+/* NVS：WiFi 存储与驱动都依赖，最先初始化，避免两个模块并发初始化 */
+static esp_err_t boot_stage_nvs(void *arg)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    return ret;
+}
+
+/* 唤醒词模型：最慢的一步，与 WiFi 初始化并行 */
+static esp_err_t boot_stage_models(void *arg)
+{
+    return audio_manager_preload_models(&s_audio_cfg);
+}
+
+#if CONFIG_APP_WIFI_MANAGER
+static esp_err_t boot_stage_wifi(void *arg)
+{
+    wifi_manage_config_t wifi_cfg = WIFI_MANAGE_DEFAULT_CONFIG();
+#if CONFIG_APP_AUDIO_WS
+    wifi_cfg.web_ws_clients = CONFIG_APP_AUDIO_WS_CLIENTS;
+#endif
+#if CONFIG_APP_WIFI_WEB_ON_DEMAND
+    wifi_cfg.web_on_demand = true;
+#endif
+    /* 网络任务与 WiFi 协议栈同核，另一核留给 AFE feed 与播放 */
+    wifi_cfg.task_core = audio_manager_get_network_core();
+    return wifi_manage_init(&wifi_cfg);
+}
+#endif
+
+/* 音频管线：初始化完成并开始监听即视为“可用” */
+static esp_err_t boot_stage_audio(void *arg)
+{
+    esp_err_t ret = audio_manager_init(&s_audio_cfg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_manager_set_volume(100);
+    audio_manager_set_record_callback(loopback_record_cb, &s_loop_ctx);
+    ret = audio_manager_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ESP_LOGI(TAG, "listening at %lld ms since boot", (long long)(esp_timer_get_time() / 1000));
+    return audio_manager_start_playback(); // keep playback task alive
+}
+
+#if CONFIG_APP_AUDIO_WS
+static esp_err_t boot_stage_ws(void *arg)
+{
+    audio_ws_app_config_t ws_cfg = AUDIO_WS_APP_DEFAULT_CONFIG();
+#if CONFIG_APP_AUDIO_WS_ENCODED
+    ws_cfg.stream_pcm = false;
+    ws_cfg.stream_encoded = true;
+    ws_cfg.record_codec = s_audio_cfg.record_encode_config.codec;
+#endif
+    ws_cfg.stats_interval_ms = CONFIG_APP_AUDIO_WS_STATS_MS;
+    return audio_ws_app_start(&ws_cfg);
+}
+#endif
+
+enum {
+    BOOT_STAGE_NVS = 0,
+    BOOT_STAGE_MODELS,
+#if CONFIG_APP_WIFI_MANAGER
+    BOOT_STAGE_WIFI,
+#endif
+    BOOT_STAGE_AUDIO,
+#if CONFIG_APP_AUDIO_WS
+    BOOT_STAGE_WS,
+#endif
+    BOOT_STAGE_COUNT,
+};
+
+/* 关闭并行启动时每个阶段额外依赖前一个阶段，退化为串行（便于对比耗时） */
+#if CONFIG_APP_BOOT_PARALLEL
+#define BOOT_SERIAL_DEP(i)  0
+#else
+#define BOOT_SERIAL_DEP(i)  ((i) > 0 ? BOOT_STAGE_BIT((i) - 1) : 0)
+#endif
+
+/*
+ * 阶段划分：WiFi 驱动/协议栈在 Core 0（与 WiFi 任务同核），模型加载与音频管线在 Core 1；
+ * 音频只依赖模型，不等待 WiFi。
+ */
+static const boot_stage_t s_boot_stages[BOOT_STAGE_COUNT] = {
+    [BOOT_STAGE_NVS] = {
+        .name = "nvs", .fn = boot_stage_nvs, .core = 0, .stack_size = 3072,
+        .deps = BOOT_SERIAL_DEP(BOOT_STAGE_NVS),
+    },
+    [BOOT_STAGE_MODELS] = {
+        .name = "models", .fn = boot_stage_models, .core = 1, .stack_size = 6144,
+        .deps = BOOT_SERIAL_DEP(BOOT_STAGE_MODELS),
+    },
+#if CONFIG_APP_WIFI_MANAGER
+    [BOOT_STAGE_WIFI] = {
+        .name = "wifi", .fn = boot_stage_wifi, .core = 0, .stack_size = 6144,
+        .deps = BOOT_STAGE_BIT(BOOT_STAGE_NVS) | BOOT_SERIAL_DEP(BOOT_STAGE_WIFI),
+    },
+#endif
+    [BOOT_STAGE_AUDIO] = {
+        .name = "audio", .fn = boot_stage_audio, .core = 1, .stack_size = 8192,
+        .deps = BOOT_STAGE_BIT(BOOT_STAGE_MODELS) | BOOT_SERIAL_DEP(BOOT_STAGE_AUDIO),
+    },
+#if CONFIG_APP_AUDIO_WS
+    [BOOT_STAGE_WS] = {
+        .name = "ws", .fn = boot_stage_ws, .core = 0, .stack_size = 4096,
+        .deps = BOOT_STAGE_BIT(BOOT_STAGE_WIFI) | BOOT_STAGE_BIT(BOOT_STAGE_AUDIO),
+    },
+#endif
+};
+
 /* 应用入口：WiFi + 音频管理初始化，把录音/事件回调接入状态机。 */
 void app_main(void)
 {
-    // ESP_LOGI(TAG, "init WiFi manager");
-    // ESP_ERROR_CHECK(wifi_manage_init(NULL));
+#if CONFIG_APP_AUDIO_BENCH
+    audio_bench_main();
+    return;
+#endif
+
+    s_loop_ctx.buffer = heap_caps_malloc(LOOPBACK_MAX_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    if (!s_loop_ctx.buffer) {
+        ESP_LOGE(TAG, "loopback buffer alloc failed");
+        return;
+    }
+
+    audio_config_app_build(&s_audio_cfg, audio_event_cb, &s_loop_ctx);
+#if CONFIG_APP_AUDIO_WS
+    /* WS 下行 PCM 在 httpd 任务中写入：使用独立的播放流，回环测试保留流 0 */
+    s_audio_cfg.playback_config.streams[AUDIO_WS_PCM_STREAM] = (audio_mgr_stream_config_t){
+        .buffer_bytes = AUDIO_WS_PCM_STREAM_BYTES, .priority = 0, .gain = 100,
+    };
+#endif
+#if CONFIG_APP_AUDIO_WS_ENCODED
+    s_audio_cfg.record_encode_config.enabled = true;
+#endif
+
+    ESP_LOGI(TAG, "boot stages start at %lld ms since boot", (long long)(esp_timer_get_time() / 1000));
+    boot_stage_result_t results[BOOT_STAGE_COUNT];
+    esp_err_t ret = boot_sched_run(s_boot_stages, BOOT_STAGE_COUNT, results);
+    boot_sched_print_report(s_boot_stages, results, BOOT_STAGE_COUNT);
+    ESP_ERROR_CHECK(ret);
 
     // xTaskCreatePinnedToCore(cpu_usage_monitor_task,
     //                         "cpu_mon",
@@ -176,15 +381,6 @@ void app_main(void)
     //                         1,
     //                         NULL,
     //                         0);
-    audio_mgr_config_t audio_cfg;
-    audio_config_app_build(&audio_cfg, audio_event_cb, &s_loop_ctx);
-
-    ESP_LOGI(TAG, "init audio manager");
-    ESP_ERROR_CHECK(audio_manager_init(&audio_cfg));
-    audio_manager_set_volume(100);
-    audio_manager_set_record_callback(loopback_record_cb, &s_loop_ctx);
-    ESP_ERROR_CHECK(audio_manager_start());
-    ESP_ERROR_CHECK(audio_manager_start_playback()); // keep playback task alive
 
     ESP_LOGI(TAG, "loopback test ready: say wake word -> speak -> hear echo");
 